@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui serialport charts
+QT       += core gui serialport network charts concurrent svg
 
 include (C:/Qwt-6.1.4/features/qwt.prf)
 
@@ -24,6 +24,10 @@ DEFINES += QT_DEPRECATED_WARNINGS
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# Uncomment to count heap allocations on the per-packet path. The totals are
+# printed by the diagnostics timer.
+#DEFINES += PBM_ALLOCATION_COUNTER
+
 CONFIG += c++11
 
 SOURCES += \
@@ -32,7 +36,42 @@ SOURCES += \
     selectserialportdialog.cpp \
     cellmonitordialog.cpp \
     settingsdialog.cpp \
-    aboutdialog.cpp
+    aboutdialog.cpp \
+    packetdecoder.cpp \
+    allocationcounter.cpp \
+    sampleclock.cpp \
+    commandchannel.cpp \
+    portmanager.cpp \
+    appconfig.cpp \
+    startuptrace.cpp \
+    samplestore.cpp \
+    sessionsnapshot.cpp \
+    scrollingplotwidget.cpp \
+    slidingrange.cpp \
+    batteryestimator.cpp \
+    estimatestore.cpp \
+    spectrumanalyzer.cpp \
+    waterfallwidget.cpp \
+    spectrumdialog.cpp \
+    loadtestanalyzer.cpp \
+    logreader.cpp \
+    recordedrun.cpp \
+    comparisondialog.cpp \
+    packetsource.cpp \
+    replaysource.cpp \
+    replaydialog.cpp \
+    networksource.cpp \
+    networkbridgedialog.cpp \
+    rawcapture.cpp \
+    expression.cpp \
+    derivedchannels.cpp \
+    derivedchannelsdialog.cpp \
+    triggerengine.cpp \
+    triggerdialog.cpp \
+    reportrenderer.cpp \
+    diagnostics.cpp \
+    intervalestimator.cpp \
+    ricecoder.cpp
 
 HEADERS += \
         mainwindow.h \
@@ -40,14 +79,57 @@ HEADERS += \
     statuspacket.h \
     cellmonitordialog.h \
     settingsdialog.h \
-    aboutdialog.h
+    aboutdialog.h \
+    packetdecoder.h \
+    allocationcounter.h \
+    sampleclock.h \
+    commandchannel.h \
+    portmanager.h \
+    appconfig.h \
+    startuptrace.h \
+    sample.h \
+    samplestore.h \
+    sessionsnapshot.h \
+    scrollingplotwidget.h \
+    slidingrange.h \
+    fixedmatrix.h \
+    batteryestimator.h \
+    estimatestore.h \
+    spectrumanalyzer.h \
+    waterfallwidget.h \
+    spectrumdialog.h \
+    loadtestanalyzer.h \
+    logreader.h \
+    recordedrun.h \
+    comparisondialog.h \
+    packetsource.h \
+    replaysource.h \
+    replaydialog.h \
+    networksource.h \
+    networkbridgedialog.h \
+    rawcapture.h \
+    expression.h \
+    derivedchannels.h \
+    derivedchannelsdialog.h \
+    triggerengine.h \
+    triggerdialog.h \
+    reportrenderer.h \
+    diagnostics.h \
+    intervalestimator.h \
+    ricecoder.h
 
 FORMS += \
         mainwindow.ui \
     selectserialportdialog.ui \
     cellmonitordialog.ui \
     settingsdialog.ui \
-    aboutdialog.ui
+    aboutdialog.ui \
+    spectrumdialog.ui \
+    comparisondialog.ui \
+    replaydialog.ui \
+    networkbridgedialog.ui \
+    derivedchannelsdialog.ui \
+    triggerdialog.ui
 
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
@@ -0,0 +1,59 @@
+#include "allocationcounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef PBM_ALLOCATION_COUNTER
+
+static std::atomic<quint64> s_allocationCount(0);
+
+void *operator new(std::size_t size)
+{
+    s_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    void *ptr = std::malloc(size ? size : 1);
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void *operator new[](std::size_t size)
+{
+    s_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    void *ptr = std::malloc(size ? size : 1);
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+bool AllocationCounter::isEnabled()
+{
+    return true;
+}
+
+quint64 AllocationCounter::count()
+{
+    return s_allocationCount.load(std::memory_order_relaxed);
+}
+
+#else
+
+bool AllocationCounter::isEnabled()
+{
+    return false;
+}
+
+quint64 AllocationCounter::count()
+{
+    return 0;
+}
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <QtGlobal>
+
+//
+// Counts calls to the global operator new. Only active when the project is
+// built with PBM_ALLOCATION_COUNTER defined; otherwise count() is always 0.
+//
+namespace AllocationCounter
+{
+    bool isEnabled();
+    quint64 count();
+}
+
+#endif // ALLOCATIONCOUNTER_H
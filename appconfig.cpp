@@ -0,0 +1,76 @@
+#include "appconfig.h"
+
+#include <QSettings>
+
+AppConfig AppConfig::load()
+{
+    QSettings settings;
+    AppConfig config;
+
+    config.chargeUnit = settings.value("units/charge", config.chargeUnit).toString();
+    config.temperatureUnit = settings.value("units/temperature", config.temperatureUnit).toString();
+
+    config.voltageAxisLeft = settings.value("chart/axes/voltage/orientation", config.voltageAxisLeft).toBool();
+    config.currentAxisLeft = settings.value("chart/axes/current/orientation", config.currentAxisLeft).toBool();
+    config.chargeAxisLeft = settings.value("chart/axes/charge/orientation", config.chargeAxisLeft).toBool();
+    config.temperatureAxisLeft = settings.value("chart/axes/temperature/orientation", config.temperatureAxisLeft).toBool();
+
+    config.voltageColor = settings.value("chart/axes/voltage/lineColor", config.voltageColor).value<QColor>();
+    config.currentColor = settings.value("chart/axes/current/lineColor", config.currentColor).value<QColor>();
+    config.chargeColor = settings.value("chart/axes/charge/lineColor", config.chargeColor).value<QColor>();
+    config.temperatureColor = settings.value("chart/axes/temperature/lineColor", config.temperatureColor).value<QColor>();
+
+    config.voltageAutoScale = settings.value("chart/axes/voltage/autoScale", config.voltageAutoScale).toBool();
+    config.currentAutoScale = settings.value("chart/axes/current/autoScale", config.currentAutoScale).toBool();
+    config.chargeAutoScale = settings.value("chart/axes/charge/autoScale", config.chargeAutoScale).toBool();
+    config.temperatureAutoScale = settings.value("chart/axes/temperature/autoScale", config.temperatureAutoScale).toBool();
+
+    config.estimatesVisible = settings.value("chart/estimates/visible", config.estimatesVisible).toBool();
+    config.resistanceAutoScale = settings.value("chart/axes/resistance/autoScale", config.resistanceAutoScale).toBool();
+
+    config.plotBackend = settings.value("chart/backend", config.plotBackend).toString();
+
+    config.autoOpenPortEnabled = settings.value("port/autoOpenPortEnabled", false).toBool();
+    config.autoOpenPort.portName = settings.value("port/autoOpenPortName").toString();
+    config.autoOpenPort.serialNumber = settings.value("port/autoOpenSerialNumber").toString();
+    config.autoOpenPort.vendorId = static_cast<quint16>(settings.value("port/autoOpenVendorId", 0).toUInt());
+    config.autoOpenPort.productId = static_cast<quint16>(settings.value("port/autoOpenProductId", 0).toUInt());
+    config.fastBaudRate = settings.value("port/fastBaudRate", config.fastBaudRate).toInt();
+
+    config.adaptiveTelemetry = settings.value("telemetry/adaptiveRate", config.adaptiveTelemetry).toBool();
+    config.telemetryFastInterval = settings.value("telemetry/fastInterval", config.telemetryFastInterval).toInt();
+    config.telemetryIdleInterval = settings.value("telemetry/idleInterval", config.telemetryIdleInterval).toInt();
+    config.telemetryHoldTime = settings.value("telemetry/holdTime", config.telemetryHoldTime).toInt();
+
+    config.networkProtocol = settings.value("network/protocol", config.networkProtocol).toString();
+    config.networkHost = settings.value("network/host", config.networkHost).toString();
+    config.networkPort = static_cast<quint16>(settings.value("network/port", config.networkPort).toUInt());
+
+    config.captureSizeLimit = settings.value("capture/sizeLimit", config.captureSizeLimit).toInt();
+
+    int derivedCount = settings.beginReadArray("derived/channels");
+    for (int i = 0; i < derivedCount; i++) {
+        settings.setArrayIndex(i);
+
+        DerivedChannelDefinition definition;
+        definition.name = settings.value("name").toString();
+        definition.expression = settings.value("expression").toString();
+        definition.color = settings.value("color", QColor(Qt::darkGreen)).value<QColor>();
+        definition.alarmBelowEnabled = settings.value("alarmBelowEnabled", false).toBool();
+        definition.alarmBelow = settings.value("alarmBelow", 0.0).toDouble();
+        definition.alarmAboveEnabled = settings.value("alarmAboveEnabled", false).toBool();
+        definition.alarmAbove = settings.value("alarmAbove", 0.0).toDouble();
+        config.derivedChannels.append(definition);
+    }
+    settings.endArray();
+
+    config.trigger.condition = settings.value("trigger/condition", config.trigger.condition).toInt();
+    config.trigger.threshold = settings.value("trigger/threshold", config.trigger.threshold).toDouble();
+    config.trigger.hysteresis = settings.value("trigger/hysteresis", config.trigger.hysteresis).toDouble();
+    config.trigger.preTrigger = settings.value("trigger/preTrigger", config.trigger.preTrigger).toDouble();
+    config.trigger.postTrigger = settings.value("trigger/postTrigger", config.trigger.postTrigger).toDouble();
+    config.trigger.holdoff = settings.value("trigger/holdoff", config.trigger.holdoff).toDouble();
+    config.trigger.maximumCaptures = settings.value("trigger/maximumCaptures", config.trigger.maximumCaptures).toInt();
+
+    return config;
+}
@@ -0,0 +1,64 @@
+#ifndef APPCONFIG_H
+#define APPCONFIG_H
+
+#include "portmanager.h"
+#include "derivedchannels.h"
+#include "triggerengine.h"
+
+#include <QColor>
+#include <QString>
+#include <QVector>
+
+//
+// Typed snapshot of the application settings. It is read from QSettings in
+// one pass at startup and again after the settings dialog closes, so the
+// rest of the application never has to look keys up one by one.
+//
+struct AppConfig
+{
+    QString chargeUnit = "coulomb";
+    QString temperatureUnit = "celsius";
+
+    bool voltageAxisLeft = true;
+    bool currentAxisLeft = true;
+    bool chargeAxisLeft = true;
+    bool temperatureAxisLeft = false;
+
+    QColor voltageColor = Qt::red;
+    QColor currentColor = Qt::blue;
+    QColor chargeColor = Qt::green;
+    QColor temperatureColor = Qt::yellow;
+
+    bool voltageAutoScale = true;
+    bool currentAutoScale = true;
+    bool chargeAutoScale = true;
+    bool temperatureAutoScale = true;
+
+    bool estimatesVisible = true;
+    bool resistanceAutoScale = true;
+
+    QString plotBackend = "qtcharts";
+
+    bool autoOpenPortEnabled = false;
+    PortMatch autoOpenPort;
+    qint32 fastBaudRate = 0;
+
+    bool adaptiveTelemetry = false;
+    int telemetryFastInterval = 100;
+    int telemetryIdleInterval = 1000;
+    int telemetryHoldTime = 60;
+
+    QString networkProtocol = "tcp";
+    QString networkHost = "localhost";
+    quint16 networkPort = 2000;
+
+    int captureSizeLimit = 64;      // MiB, both rotated files together
+
+    QVector<DerivedChannelDefinition> derivedChannels;
+
+    TriggerSettings trigger;
+
+    static AppConfig load();
+};
+
+#endif // APPCONFIG_H
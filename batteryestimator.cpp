@@ -0,0 +1,184 @@
+#include "batteryestimator.h"
+
+#include <math.h>
+
+//
+// Typical Li-ion cell open-circuit voltage at 0%, 10%, ... 100% state of
+// charge.
+//
+static const int OcvPoints = 11;
+static const qreal s_cellOcv[OcvPoints] = {
+    3.00, 3.45, 3.55, 3.62, 3.68, 3.74, 3.81, 3.90, 3.98, 4.07, 4.20
+};
+
+//
+// Process noise per second of elapsed time, for SoC, RC voltage and R0.
+//
+static const qreal StateOfChargeNoise = 1e-7;
+static const qreal PolarisationNoise = 1e-5;
+static const qreal ResistanceNoise = 1e-8;
+
+static const qreal MaximumStep = 60.0;
+static const qreal MinimumResistance = 0.001;
+static const qreal MaximumResistance = 2.0;
+
+BatteryEstimator::BatteryEstimator()
+{
+}
+
+void BatteryEstimator::setParameters(const Parameters &parameters)
+{
+    m_parameters = parameters;
+    reset();
+}
+
+void BatteryEstimator::reset()
+{
+    m_initialized = false;
+}
+
+BatteryEstimate BatteryEstimator::update(const Sample &sample)
+{
+    //
+    // the pack reports current magnitude; the mode gives the direction.
+    // Discharge current is positive in the model.
+    //
+    qreal current = sample.amps();
+    if (sample.mode == MODE_CHARGING) {
+        current = -current;
+    }
+
+    qreal factor = temperatureFactor(sample.celsius());
+
+    if (!m_initialized) {
+        initialize(sample, current);
+        return estimate(factor);
+    }
+
+    qreal dt = static_cast<qreal>(sample.timestamp - m_lastTimestamp) / 1000000.0;
+    m_lastTimestamp = sample.timestamp;
+
+    //
+    // predict
+    //
+    if (dt > 0.0) {
+        if (dt > MaximumStep) {
+            dt = MaximumStep;
+        }
+
+        qreal decay = exp(-dt / m_parameters.timeConstant);
+
+        m_state(StateOfCharge, 0) -= current * dt / m_parameters.capacity;
+        m_state(StatePolarisation, 0) = (decay * m_state(StatePolarisation, 0))
+                + (m_parameters.polarisationResistance * (1.0 - decay) * current);
+
+        Covariance transition = Covariance::identity();
+        transition(StatePolarisation, StatePolarisation) = decay;
+
+        Covariance noise;
+        noise(StateOfCharge, StateOfCharge) = StateOfChargeNoise * dt;
+        noise(StatePolarisation, StatePolarisation) = PolarisationNoise * dt;
+        noise(StateResistance, StateResistance) = ResistanceNoise * dt;
+
+        m_covariance = (transition * m_covariance * transition.transposed()) + noise;
+    }
+
+    //
+    // correct against the measured pack voltage
+    //
+    qreal slope = 0.0;
+    qreal ocv = m_cellCount * cellOpenCircuitVoltage(m_state(StateOfCharge, 0), &slope);
+    qreal predicted = ocv - m_state(StatePolarisation, 0) - (current * m_state(StateResistance, 0) * factor);
+
+    FixedMatrix<1, 3> jacobian;
+    jacobian(0, StateOfCharge) = m_cellCount * slope;
+    jacobian(0, StatePolarisation) = -1.0;
+    jacobian(0, StateResistance) = -current * factor;
+
+    FixedMatrix<3, 1> crossCovariance = m_covariance * jacobian.transposed();
+    qreal innovationVariance = (jacobian * crossCovariance)(0, 0)
+            + (m_parameters.voltageNoise * m_parameters.voltageNoise);
+    FixedMatrix<3, 1> gain = crossCovariance * (1.0 / innovationVariance);
+
+    m_state = m_state + (gain * (sample.volts() - predicted));
+    m_covariance = (Covariance::identity() - (gain * jacobian)) * m_covariance;
+
+    m_state(StateOfCharge, 0) = qBound(0.0, m_state(StateOfCharge, 0), 1.0);
+    m_state(StateResistance, 0) = qBound(MinimumResistance, m_state(StateResistance, 0), MaximumResistance);
+
+    return estimate(factor);
+}
+
+//
+// Seeds the state of charge from the open-circuit voltage implied by the
+// first sample.
+//
+void BatteryEstimator::initialize(const Sample &sample, qreal current)
+{
+    m_cellCount = 0;
+    for (int i = 0; i < 6; i++) {
+        if (sample.cellVoltage[i] != 0) {
+            m_cellCount++;
+        }
+    }
+    if (m_cellCount == 0) {
+        m_cellCount = m_parameters.cellCount;
+    }
+
+    qreal restingVoltage = sample.volts() + (current * m_parameters.initialResistance);
+
+    m_state.fill(0.0);
+    m_state(StateOfCharge, 0) = cellStateOfCharge(restingVoltage / m_cellCount);
+    m_state(StateResistance, 0) = m_parameters.initialResistance;
+
+    m_covariance.fill(0.0);
+    m_covariance(StateOfCharge, StateOfCharge) = 0.1 * 0.1;
+    m_covariance(StatePolarisation, StatePolarisation) = 0.05 * 0.05;
+    m_covariance(StateResistance, StateResistance) = 0.05 * 0.05;
+
+    m_lastTimestamp = sample.timestamp;
+    m_initialized = true;
+}
+
+BatteryEstimate BatteryEstimator::estimate(qreal temperatureFactor) const
+{
+    BatteryEstimate result;
+    result.stateOfCharge = static_cast<float>(m_state(StateOfCharge, 0) * 100.0);
+    result.resistance = static_cast<float>(m_state(StateResistance, 0) * temperatureFactor * 1000.0);
+    return result;
+}
+
+qreal BatteryEstimator::cellOpenCircuitVoltage(qreal stateOfCharge, qreal *slope)
+{
+    qreal position = qBound(0.0, stateOfCharge, 1.0) * (OcvPoints - 1);
+    int index = qMin(static_cast<int>(position), OcvPoints - 2);
+    qreal fraction = position - index;
+
+    *slope = (s_cellOcv[index + 1] - s_cellOcv[index]) * (OcvPoints - 1);
+    return s_cellOcv[index] + (fraction * (s_cellOcv[index + 1] - s_cellOcv[index]));
+}
+
+qreal BatteryEstimator::cellStateOfCharge(qreal voltage)
+{
+    if (voltage <= s_cellOcv[0]) {
+        return 0.0;
+    }
+
+    for (int i = 1; i < OcvPoints; i++) {
+        if (voltage < s_cellOcv[i]) {
+            qreal fraction = (voltage - s_cellOcv[i - 1]) / (s_cellOcv[i] - s_cellOcv[i - 1]);
+            return (i - 1 + fraction) / (OcvPoints - 1);
+        }
+    }
+
+    return 1.0;
+}
+
+//
+// Rough Arrhenius-style scaling of series resistance: about 3% per degree,
+// higher when cold.
+//
+qreal BatteryEstimator::temperatureFactor(qreal celsius)
+{
+    return exp(0.03 * (25.0 - qBound(-20.0, celsius, 60.0)));
+}
@@ -0,0 +1,69 @@
+#ifndef BATTERYESTIMATOR_H
+#define BATTERYESTIMATOR_H
+
+#include "sample.h"
+#include "fixedmatrix.h"
+
+//
+// Model-based estimates for one sample, kept alongside the sample store.
+//
+struct BatteryEstimate
+{
+    float stateOfCharge;            // %
+    float resistance;               // internal resistance at pack temperature, mΩ
+};
+
+//
+// Extended Kalman filter over a first-order equivalent-circuit model: an
+// open-circuit voltage that depends on state of charge, a series resistance
+// R0 and one RC polarisation branch. The state is [SoC, RC voltage, R0];
+// R0 is tracked at 25 °C and scaled by pack temperature. All matrices have
+// compile-time dimensions, so update() is allocation-free and cheap enough
+// to run on every packet for many packs.
+//
+class BatteryEstimator
+{
+public:
+    struct Parameters {
+        qreal capacity = 11520.0;           // C
+        int cellCount = 6;
+        qreal polarisationResistance = 0.03; // Ω
+        qreal timeConstant = 30.0;          // s
+        qreal initialResistance = 0.1;      // Ω at 25 °C
+        qreal voltageNoise = 0.02;          // V
+    };
+
+    BatteryEstimator();
+
+    void setParameters(const Parameters &parameters);
+    void reset();
+    BatteryEstimate update(const Sample &sample);
+
+    bool isInitialized() const { return m_initialized; }
+
+private:
+    typedef FixedMatrix<3, 1> State;
+    typedef FixedMatrix<3, 3> Covariance;
+
+    enum StateIndex {
+        StateOfCharge = 0,
+        StatePolarisation,
+        StateResistance
+    };
+
+    void initialize(const Sample &sample, qreal current);
+    BatteryEstimate estimate(qreal temperatureFactor) const;
+
+    static qreal cellOpenCircuitVoltage(qreal stateOfCharge, qreal *slope);
+    static qreal cellStateOfCharge(qreal voltage);
+    static qreal temperatureFactor(qreal celsius);
+
+    Parameters m_parameters;
+    State m_state;
+    Covariance m_covariance;
+    int m_cellCount = 0;
+    qint64 m_lastTimestamp = 0;
+    bool m_initialized = false;
+};
+
+#endif // BATTERYESTIMATOR_H
@@ -6,6 +6,10 @@ CellMonitorDialog::CellMonitorDialog(QWidget *parent) :
     ui(new Ui::CellMonitorDialog)
 {
     ui->setupUi(this);
+
+    for (int i = 0; i < 6; i++) {
+        m_cellMillivolts[i] = -1;
+    }
 }
 
 CellMonitorDialog::~CellMonitorDialog()
@@ -18,6 +22,19 @@ void CellMonitorDialog::setCellVoltage(int cell, qreal voltage)
     QLabel *lbl;
     QProgressBar *pgb;
 
+    if (cell < 0 || cell >= 6) {
+        return;
+    }
+
+    //
+    // only touch the widgets when the value actually changed
+    //
+    int millivolts = static_cast<int>(voltage * 1000);
+    if (millivolts == m_cellMillivolts[cell]) {
+        return;
+    }
+    m_cellMillivolts[cell] = millivolts;
+
     switch (cell) {
     case 0:
         lbl = ui->lblCellVoltage1;
@@ -48,5 +65,5 @@ void CellMonitorDialog::setCellVoltage(int cell, qreal voltage)
     }
 
     lbl->setText(QString("%1 V").arg(voltage, 4, 'f', 2));
-    pgb->setValue(static_cast<int>(voltage * 1000));
+    pgb->setValue(millivolts);
 }
@@ -18,6 +18,7 @@ public:
 
 private:
     Ui::CellMonitorDialog *ui;
+    int m_cellMillivolts[6];
 };
 
 #endif // CELLMONITORDIALOG_H
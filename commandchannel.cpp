@@ -0,0 +1,113 @@
+#include "commandchannel.h"
+
+#include <QDebug>
+#include <QThread>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <termios.h>
+#endif
+
+CommandChannel::CommandChannel(QSerialPort *port, QObject *parent) :
+    QObject(parent),
+    m_port(port)
+{
+    connect(m_port, &QSerialPort::bytesWritten, this, &CommandChannel::on_portBytesWritten);
+}
+
+void CommandChannel::setTelemetryInterval(int milliseconds)
+{
+    if (milliseconds == m_telemetryInterval) {
+        return;
+    }
+
+    if (send(COMMAND_SET_INTERVAL, static_cast<quint32>(milliseconds))) {
+        m_telemetryInterval = milliseconds;
+        emit telemetryIntervalChanged(milliseconds);
+    }
+}
+
+void CommandChannel::requestSnapshot()
+{
+    send(COMMAND_SNAPSHOT, 0);
+}
+
+//
+// The pack switches speed as soon as it has received the command, so the
+// local port is only reconfigured once the command has left the UART at
+// the old rate; see drain().
+//
+void CommandChannel::setBaudRate(qint32 baudRate)
+{
+    if (baudRate == m_port->baudRate()) {
+        return;
+    }
+
+    if (send(COMMAND_SET_BAUD_RATE, static_cast<quint32>(baudRate))) {
+        m_pendingBaudRate = baudRate;
+    }
+}
+
+void CommandChannel::on_portBytesWritten(qint64 bytes)
+{
+    Q_UNUSED(bytes);
+
+    if (m_pendingBaudRate != 0 && m_port->bytesToWrite() == 0) {
+        qint32 baudRate = m_pendingBaudRate;
+        m_pendingBaudRate = 0;
+
+        drain();
+
+        if (m_port->setBaudRate(baudRate)) {
+            emit baudRateChanged(baudRate);
+        }
+        else {
+            qDebug() << "Unable to switch port to" << baudRate << "baud";
+        }
+    }
+}
+
+//
+// An empty write buffer only means the bytes have reached the driver.
+// Waiting for the driver's transmit queue to empty and then for one more
+// character time at the current rate lets the last byte clear the shift
+// register before the rate changes. The command frame is a dozen bytes,
+// so this blocks for milliseconds at most.
+//
+void CommandChannel::drain()
+{
+#ifdef Q_OS_WIN
+    FlushFileBuffers(m_port->handle());
+#else
+    tcdrain(m_port->handle());
+#endif
+
+    qint32 baudRate = qMax(m_port->baudRate(), 1200);
+    QThread::usleep(static_cast<unsigned long>(CharacterBits * 1000000 / baudRate + 1));
+}
+
+bool CommandChannel::send(quint8 command, quint32 argument)
+{
+    if (!m_port->isOpen()) {
+        return false;
+    }
+
+    char frame[2 + sizeof(command_packet_t)];
+    command_packet_t *packet = reinterpret_cast<command_packet_t *>(frame + 2);
+
+    frame[0] = 'C';
+    frame[1] = 'M';
+    packet->a = 'A';
+    packet->command = command;
+    packet->argument = argument;
+    packet->checksum = static_cast<quint8>(
+                command
+                ^ (argument & 0xff)
+                ^ ((argument >> 8) & 0xff)
+                ^ ((argument >> 16) & 0xff)
+                ^ ((argument >> 24) & 0xff));
+    packet->b = 'B';
+
+    return m_port->write(frame, sizeof(frame)) == static_cast<qint64>(sizeof(frame));
+}
@@ -0,0 +1,45 @@
+#ifndef COMMANDCHANNEL_H
+#define COMMANDCHANNEL_H
+
+#include "statuspacket.h"
+
+#include <QObject>
+#include <QSerialPort>
+
+//
+// Host to pack command channel. Commands are framed like the status
+// packets ('C','M' header, 'A'/'B' sentinels) and written to the same
+// serial port the telemetry is read from.
+//
+class CommandChannel : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CommandChannel(QSerialPort *port, QObject *parent = nullptr);
+
+    void setTelemetryInterval(int milliseconds);
+    void requestSnapshot();
+    void setBaudRate(qint32 baudRate);
+    void invalidateTelemetryInterval() { m_telemetryInterval = 0; }
+    int telemetryInterval() const { return m_telemetryInterval; }
+
+signals:
+    void baudRateChanged(qint32 baudRate);
+    void telemetryIntervalChanged(int milliseconds);
+
+private slots:
+    void on_portBytesWritten(qint64 bytes);
+
+private:
+    static const int CharacterBits = 10;    // start, 8 data, stop
+
+    bool send(quint8 command, quint32 argument);
+    void drain();
+
+    QSerialPort *m_port;
+    int m_telemetryInterval = 0;
+    qint32 m_pendingBaudRate = 0;
+};
+
+#endif // COMMANDCHANNEL_H
@@ -0,0 +1,303 @@
+#include "comparisondialog.h"
+#include "ui_comparisondialog.h"
+
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QPen>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtCharts/QChartView>
+
+#include <float.h>
+
+static const QColor s_runColors[] = {
+    Qt::red, Qt::blue, Qt::darkGreen, Qt::magenta, Qt::darkCyan,
+    Qt::darkYellow, Qt::darkRed, Qt::darkBlue, Qt::darkMagenta, Qt::black
+};
+
+static const char *s_channelTitles[RecordedRun::ChannelCount] = {
+    QT_TRANSLATE_NOOP("ComparisonDialog", "Voltage (V)"),
+    QT_TRANSLATE_NOOP("ComparisonDialog", "Current (A)"),
+    QT_TRANSLATE_NOOP("ComparisonDialog", "Temperature (C)")
+};
+
+ComparisonDialog::ComparisonDialog(QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::ComparisonDialog)
+{
+    ui->setupUi(this);
+
+    m_chart = new QChart();
+    m_chart->legend()->setVisible(true);
+    m_chart->legend()->setAlignment(Qt::AlignBottom);
+
+    m_axisX = new QValueAxis;
+    m_chart->addAxis(m_axisX, Qt::AlignBottom);
+
+    m_axisY = new QValueAxis;
+    m_chart->addAxis(m_axisY, Qt::AlignLeft);
+
+    m_axisDifference = new QValueAxis;
+    m_axisDifference->setTitleText(tr("Difference from baseline"));
+    m_axisDifference->setVisible(false);
+    m_chart->addAxis(m_axisDifference, Qt::AlignRight);
+
+    ui->chartView->setChart(m_chart);
+    ui->chartView->setRubberBand(QChartView::HorizontalRubberBand);
+
+    connect(m_axisX, &QValueAxis::rangeChanged, this, &ComparisonDialog::on_axisXRangeChanged);
+    connect(&m_loadWatcher, &QFutureWatcher<RecordedRun>::finished, this, &ComparisonDialog::on_loadWatcherFinished);
+}
+
+ComparisonDialog::~ComparisonDialog()
+{
+    m_loadWatcher.waitForFinished();
+    qDeleteAll(m_runs);
+    delete ui;
+}
+
+//
+// Loads the logs on the global thread pool, one per worker.
+//
+void ComparisonDialog::addRuns(const QStringList &fileNames)
+{
+    if (fileNames.isEmpty()) {
+        return;
+    }
+
+    if (m_loadWatcher.isRunning()) {
+        ui->lblStatus->setText(tr("Still loading the previous logs."));
+        return;
+    }
+
+    ui->lblStatus->setText(tr("Loading %n log(s)...", "", fileNames.count()));
+    ui->btnAddRuns->setEnabled(false);
+    m_loadWatcher.setFuture(QtConcurrent::mapped(fileNames, &RecordedRun::load));
+}
+
+void ComparisonDialog::on_btnAddRuns_clicked()
+{
+    addRuns(QFileDialog::getOpenFileNames(
+                this,
+                tr("Load Comparison Data"),
+                QString(),
+                tr("Data Logs (*.csv *.txt);;All Files (*)")));
+}
+
+void ComparisonDialog::on_btnRemoveRun_clicked()
+{
+    int row = ui->lstRuns->currentRow();
+    if (row < 0 || row >= m_runs.count()) {
+        return;
+    }
+
+    RunView *view = m_runs.takeAt(row);
+    m_chart->removeSeries(view->line);
+    m_chart->removeSeries(view->difference);
+    delete view->line;
+    delete view->difference;
+    delete view;
+
+    delete ui->lstRuns->takeItem(row);
+
+    updateBaselineList();
+    refreshSeries();
+}
+
+void ComparisonDialog::on_btnResetZoom_clicked()
+{
+    resetZoom();
+}
+
+void ComparisonDialog::on_cboAlignment_currentIndexChanged(int index)
+{
+    Q_UNUSED(index);
+    rebuildSeries();
+    resetZoom();
+}
+
+void ComparisonDialog::on_cboChannel_currentIndexChanged(int index)
+{
+    Q_UNUSED(index);
+    rebuildSeries();
+    refreshSeries();
+}
+
+void ComparisonDialog::on_cboBaseline_currentIndexChanged(int index)
+{
+    Q_UNUSED(index);
+    refreshSeries();
+}
+
+void ComparisonDialog::on_loadWatcherFinished()
+{
+    QStringList errors;
+
+    for (const RecordedRun &run : m_loadWatcher.future().results()) {
+        QString name = QFileInfo(run.fileName).completeBaseName();
+
+        if (!run.isValid()) {
+            errors << tr("%1: %2").arg(name, run.errorString.isEmpty() ? tr("no samples") : run.errorString);
+            continue;
+        }
+
+        QColor color = s_runColors[m_colorIndex++ % (sizeof(s_runColors) / sizeof(s_runColors[0]))];
+
+        RunView *view = new RunView;
+        view->run = run;
+
+        view->line = new QLineSeries;
+        view->line->setName(name);
+        view->line->setColor(color);
+        view->line->setUseOpenGL(true);
+        m_chart->addSeries(view->line);
+        view->line->attachAxis(m_axisX);
+        view->line->attachAxis(m_axisY);
+
+        view->difference = new QLineSeries;
+        view->difference->setName(tr("%1 - baseline").arg(name));
+        QPen pen(color);
+        pen.setStyle(Qt::DashLine);
+        view->difference->setPen(pen);
+        m_chart->addSeries(view->difference);
+        view->difference->attachAxis(m_axisX);
+        view->difference->attachAxis(m_axisDifference);
+
+        m_runs.append(view);
+        ui->lstRuns->addItem(tr("%1 (%2 samples)").arg(name).arg(run.count()));
+    }
+
+    ui->btnAddRuns->setEnabled(true);
+    ui->lblStatus->setText(errors.isEmpty() ? tr("Drag on the chart to zoom.") : errors.join("\n"));
+
+    updateBaselineList();
+    rebuildSeries();
+    resetZoom();
+}
+
+void ComparisonDialog::on_axisXRangeChanged(qreal min, qreal max)
+{
+    Q_UNUSED(min);
+    Q_UNUSED(max);
+
+    if (!m_refreshing) {
+        refreshSeries();
+    }
+}
+
+//
+// Realigns every run and rebuilds its pyramid for the selected channel,
+// one run per worker.
+//
+void ComparisonDialog::rebuildSeries()
+{
+    RecordedRun::Alignment alignment = static_cast<RecordedRun::Alignment>(ui->cboAlignment->currentIndex());
+    RecordedRun::Channel channel = static_cast<RecordedRun::Channel>(ui->cboChannel->currentIndex());
+
+    QtConcurrent::blockingMap(m_runs, [alignment, channel](RunView *view) {
+        view->series.build(view->run.alignedX(alignment), view->run.values[channel]);
+    });
+
+    m_axisX->setTitleText(alignment == RecordedRun::AlignCharge ? tr("Charge moved (Ah)") : tr("Elapsed (s)"));
+    m_axisY->setTitleText(tr(s_channelTitles[channel]));
+}
+
+//
+// Re-queries every run for the visible x range at about two points per
+// pixel, then fits the value axes to what is shown.
+//
+void ComparisonDialog::refreshSeries()
+{
+    if (m_runs.isEmpty()) {
+        return;
+    }
+
+    qreal from = m_axisX->min();
+    qreal to = m_axisX->max();
+    int buckets = qMax(static_cast<int>(m_chart->plotArea().width()), 500);
+
+    int baselineIndex = ui->cboBaseline->currentIndex() - 1;
+    const RunView *baseline = (baselineIndex >= 0 && baselineIndex < m_runs.count()) ? m_runs[baselineIndex] : nullptr;
+
+    qreal minimum = DBL_MAX;
+    qreal maximum = -DBL_MAX;
+    qreal minimumDifference = DBL_MAX;
+    qreal maximumDifference = -DBL_MAX;
+
+    for (RunView *view : m_runs) {
+        view->series.query(from, to, buckets, &m_points);
+        view->line->replace(m_points);
+
+        for (const QPointF &point : m_points) {
+            if (point.x() >= from && point.x() <= to) {
+                minimum = qMin(minimum, point.y());
+                maximum = qMax(maximum, point.y());
+            }
+        }
+
+        m_differences.clear();
+        if (baseline != nullptr && view != baseline) {
+            for (const QPointF &point : m_points) {
+                qreal reference;
+                if (baseline->series.valueAt(point.x(), &reference)) {
+                    qreal difference = point.y() - reference;
+                    m_differences.append(QPointF(point.x(), difference));
+                    minimumDifference = qMin(minimumDifference, difference);
+                    maximumDifference = qMax(maximumDifference, difference);
+                }
+            }
+        }
+        view->difference->replace(m_differences);
+        view->difference->setVisible(baseline != nullptr && view != baseline);
+    }
+
+    if (minimum <= maximum) {
+        qreal padding = qMax((maximum - minimum) * 0.05, 0.01);
+        m_axisY->setRange(minimum - padding, maximum + padding);
+    }
+
+    m_axisDifference->setVisible(baseline != nullptr);
+    if (minimumDifference <= maximumDifference) {
+        qreal padding = qMax((maximumDifference - minimumDifference) * 0.05, 0.01);
+        m_axisDifference->setRange(minimumDifference - padding, maximumDifference + padding);
+    }
+}
+
+void ComparisonDialog::resetZoom()
+{
+    if (m_runs.isEmpty()) {
+        return;
+    }
+
+    qreal from = DBL_MAX;
+    qreal to = -DBL_MAX;
+    for (const RunView *view : m_runs) {
+        if (!view->series.isEmpty()) {
+            from = qMin(from, view->series.firstX());
+            to = qMax(to, view->series.lastX());
+        }
+    }
+
+    if (from >= to) {
+        to = from + 1.0;
+    }
+
+    m_refreshing = true;
+    m_axisX->setRange(from, to);
+    m_refreshing = false;
+
+    refreshSeries();
+}
+
+void ComparisonDialog::updateBaselineList()
+{
+    int selected = ui->cboBaseline->currentIndex();
+
+    ui->cboBaseline->blockSignals(true);
+    ui->cboBaseline->clear();
+    ui->cboBaseline->addItem(tr("None"));
+    for (const RunView *view : m_runs) {
+        ui->cboBaseline->addItem(view->line->name());
+    }
+    ui->cboBaseline->setCurrentIndex(selected < ui->cboBaseline->count() ? selected : 0);
+    ui->cboBaseline->blockSignals(false);
+}
@@ -0,0 +1,73 @@
+#ifndef COMPARISONDIALOG_H
+#define COMPARISONDIALOG_H
+
+#include "recordedrun.h"
+
+#include <QDialog>
+#include <QFutureWatcher>
+#include <QList>
+#include <QColor>
+#include <QtCharts/QChart>
+#include <QtCharts/QValueAxis>
+#include <QtCharts/QLineSeries>
+
+QT_CHARTS_USE_NAMESPACE
+
+namespace Ui {
+class ComparisonDialog;
+}
+
+//
+// Overlays recorded logs against each other. Logs are loaded in parallel
+// on the global thread pool, aligned by cycle start, charge moved or time,
+// and each run is drawn from its own min/max pyramid so only about two
+// points per pixel are handed to the chart whatever the zoom level.
+// Differences against a baseline run are plotted on a second axis.
+//
+class ComparisonDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit ComparisonDialog(QWidget *parent = nullptr);
+    ~ComparisonDialog();
+
+    void addRuns(const QStringList &fileNames);
+
+private slots:
+    void on_btnAddRuns_clicked();
+    void on_btnRemoveRun_clicked();
+    void on_btnResetZoom_clicked();
+    void on_cboAlignment_currentIndexChanged(int index);
+    void on_cboChannel_currentIndexChanged(int index);
+    void on_cboBaseline_currentIndexChanged(int index);
+    void on_loadWatcherFinished();
+    void on_axisXRangeChanged(qreal min, qreal max);
+
+private:
+    struct RunView {
+        RecordedRun run;
+        DecimatedSeries series;
+        QLineSeries *line = nullptr;
+        QLineSeries *difference = nullptr;
+    };
+
+    void rebuildSeries();
+    void refreshSeries();
+    void resetZoom();
+    void updateBaselineList();
+
+    Ui::ComparisonDialog *ui;
+    QChart *m_chart = nullptr;
+    QValueAxis *m_axisX = nullptr;
+    QValueAxis *m_axisY = nullptr;
+    QValueAxis *m_axisDifference = nullptr;
+    QList<RunView *> m_runs;
+    QFutureWatcher<RecordedRun> m_loadWatcher;
+    QVector<QPointF> m_points;
+    QVector<QPointF> m_differences;
+    bool m_refreshing = false;
+    int m_colorIndex = 0;
+};
+
+#endif // COMPARISONDIALOG_H
@@ -0,0 +1,599 @@
+#include "derivedchannels.h"
+#include "ricecoder.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <float.h>
+#include <string.h>
+
+//
+// Column names of the data log, which derived channels are appended to.
+//
+static const char *s_reservedNames[] = {
+    "time",
+    "elapsed",
+    "voltage",
+    "current",
+    "charge",
+    "temperature",
+    "soc",
+    "resistance",
+    "mode",
+    "cell1",
+    "cell2",
+    "cell3",
+    "cell4",
+    "cell5",
+    "cell6"
+};
+
+//
+// A packed chunk is one channel's values as integer codes: steps of
+// 1/QuantisationLevels of the chunk's range above its minimum, or the raw
+// float bits for a chunk holding a non-finite value. The header gives the
+// encoding, the Rice parameter, the minimum and step, and the first code;
+// the bit stream holds the zigzagged deltas.
+//
+enum Encoding {
+    EncodingQuantised = 0,
+    EncodingRaw
+};
+
+static const float QuantisationLevels = 65535.0f;
+static const int HeaderSize = 2 + 2 * sizeof(float) + sizeof(qint64);
+static const int MaximumJob = 16;
+
+//
+// Worst case: every residual escaped
+//
+static const int MaximumPackedSize = HeaderSize
+        + ((DerivedChannels::ChunkSize * RiceCoder::MaximumResidualBits) / 8) + 1;
+
+static int packValues(const float *values, uchar *data)
+{
+    uchar encoding = EncodingQuantised;
+    float minimum = FLT_MAX;
+    float maximum = -FLT_MAX;
+
+    for (int i = 0; i < DerivedChannels::ChunkSize; i++) {
+        if (!qIsFinite(values[i])) {
+            encoding = EncodingRaw;
+            break;
+        }
+        minimum = qMin(minimum, values[i]);
+        maximum = qMax(maximum, values[i]);
+    }
+
+    //
+    // a range too wide for a float is stored as it is
+    //
+    if (encoding == EncodingQuantised && !qIsFinite(maximum - minimum)) {
+        encoding = EncodingRaw;
+    }
+
+    float step = 0.0f;
+    qint64 codes[DerivedChannels::ChunkSize];
+
+    if (encoding == EncodingQuantised) {
+        step = (maximum - minimum) / QuantisationLevels;
+        for (int i = 0; i < DerivedChannels::ChunkSize; i++) {
+            codes[i] = (step > 0.0f) ? qRound64((values[i] - minimum) / step) : 0;
+        }
+    }
+    else {
+        minimum = 0.0f;
+        for (int i = 0; i < DerivedChannels::ChunkSize; i++) {
+            quint32 bits;
+            memcpy(&bits, &values[i], sizeof(bits));
+            codes[i] = bits;
+        }
+    }
+
+    quint64 residuals[DerivedChannels::ChunkSize - 1];
+    for (int i = 1; i < DerivedChannels::ChunkSize; i++) {
+        residuals[i - 1] = RiceCoder::zigzag(codes[i] - codes[i - 1]);
+    }
+
+    BitWriter writer(data + HeaderSize);
+    data[0] = encoding;
+    data[1] = RiceCoder::writeColumn(&writer, residuals, DerivedChannels::ChunkSize - 1);
+    memcpy(data + 2, &minimum, sizeof(float));
+    memcpy(data + 2 + sizeof(float), &step, sizeof(float));
+    memcpy(data + 2 + 2 * sizeof(float), &codes[0], sizeof(qint64));
+
+    return static_cast<int>(writer.finish() - data);
+}
+
+DerivedChannels::DerivedChannels()
+{
+    for (int c = 0; c < MaximumChannels; c++) {
+        m_spare[c] = nullptr;
+        m_alarmState[c] = 0;
+        m_nanos[c] = 0;
+
+        for (CacheEntry &entry : m_cache[c]) {
+            entry.slot = -1;
+            entry.used = 0;
+            entry.chunk = nullptr;
+        }
+    }
+
+    for (int v = 0; v < Expression::VariableCount; v++) {
+        m_columnPointers[v] = m_columns[v];
+    }
+
+    clear();
+}
+
+DerivedChannels::~DerivedChannels()
+{
+    clear();
+
+    for (int c = 0; c < MaximumChannels; c++) {
+        delete m_spare[c];
+
+        for (CacheEntry &entry : m_cache[c]) {
+            delete entry.chunk;
+        }
+    }
+}
+
+//
+// Compiles the definitions and drops every value computed so far; the
+// caller re-evaluates the session. Definitions that don't compile are
+// skipped, since the settings may have been edited by hand.
+//
+void DerivedChannels::setDefinitions(const QVector<DerivedChannelDefinition> &definitions)
+{
+    clear();
+
+    m_definitions.clear();
+    m_channelCount = 0;
+    m_variables = 0;
+
+    for (const DerivedChannelDefinition &definition : definitions) {
+        if (m_channelCount == MaximumChannels) {
+            qDebug() << "Derived channels: ignoring" << definition.name << "- at most" << MaximumChannels << "are supported";
+            continue;
+        }
+
+        if (!isValidName(definition.name)) {
+            qDebug() << "Derived channels: ignoring" << definition.name << "- not a valid column name";
+            continue;
+        }
+
+        Expression &expression = m_expressions[m_channelCount];
+        if (!expression.compile(definition.expression)) {
+            qDebug() << "Derived channels: ignoring" << definition.name << "-" << expression.errorString();
+            continue;
+        }
+
+        m_definitions.append(definition);
+        m_variables |= expression.variables();
+        m_nanos[m_channelCount] = 0;
+        m_channelCount++;
+    }
+
+    m_evaluated = 0;
+    reserveSpare();
+}
+
+float DerivedChannels::value(int channel, qint64 index) const
+{
+    int slot = static_cast<int>(index / ChunkSize);
+    const Chunk *chunk = m_slots[channel][slot].chunk;
+
+    if (chunk == nullptr) {
+        chunk = unpacked(channel, slot);
+    }
+
+    return chunk->values[index % ChunkSize];
+}
+
+//
+// Memory held for the values: raw and spare chunks, packed chunks and the
+// unpack caches.
+//
+qint64 DerivedChannels::heapBytes() const
+{
+    qint64 chunks = 0;
+
+    for (int c = 0; c < MaximumChannels; c++) {
+        chunks += (m_spare[c] != nullptr) ? 1 : 0;
+
+        for (const Slot &slot : m_slots[c]) {
+            if (slot.chunk != nullptr) {
+                chunks++;
+            }
+        }
+
+        for (const CacheEntry &entry : m_cache[c]) {
+            if (entry.chunk != nullptr) {
+                chunks++;
+            }
+        }
+    }
+
+    return chunks * static_cast<qint64>(sizeof(Chunk)) + m_packedBytes;
+}
+
+//
+// Evaluates every channel for the samples up to end that have both been
+// decoded and estimated.
+//
+void DerivedChannels::evaluate(const SampleStore &samples, const EstimateStore &estimates, qint64 end)
+{
+    end = qMin(end, qMin(samples.count(), estimates.count()));
+
+    if (m_channelCount == 0) {
+        m_count = qMax(m_count, end);
+        return;
+    }
+
+    QElapsedTimer timer;
+
+    while (m_count < end) {
+        //
+        // blocks never straddle a chunk, so results are copied in one run
+        //
+        int offset = static_cast<int>(m_count % ChunkSize);
+        int count = static_cast<int>(qMin(end - m_count, static_cast<qint64>(Expression::BlockSize)));
+        count = qMin(count, ChunkSize - offset);
+
+        gather(samples, estimates, m_count, count);
+
+        for (int c = 0; c < m_channelCount; c++) {
+            if (offset == 0) {
+                Slot slot;
+                if (m_spare[c] != nullptr) {
+                    slot.chunk = m_spare[c];
+                    m_spare[c] = nullptr;
+                }
+                else {
+                    slot.chunk = new Chunk;
+                }
+                m_slots[c].append(slot);
+            }
+
+            timer.start();
+            m_expressions[c].evaluate(m_columnPointers, count, m_result);
+            m_nanos[c] += timer.nsecsElapsed();
+
+            float *values = m_slots[c].last().chunk->values + offset;
+            const DerivedChannelDefinition &definition = m_definitions[c];
+
+            for (int i = 0; i < count; i++) {
+                float value = static_cast<float>(m_result[i]);
+                values[i] = value;
+
+                if (qIsFinite(value)) {
+                    if (value < m_minimum) m_minimum = value;
+                    if (value > m_maximum) m_maximum = value;
+                }
+            }
+
+            if (!definition.alarmBelowEnabled && !definition.alarmAboveEnabled) {
+                continue;
+            }
+
+            for (int i = 0; i < count; i++) {
+                int state = 0;
+                if (definition.alarmBelowEnabled && m_result[i] < definition.alarmBelow) {
+                    state = -1;
+                }
+                else if (definition.alarmAboveEnabled && m_result[i] > definition.alarmAbove) {
+                    state = 1;
+                }
+
+                if (state != m_alarmState[c]) {
+                    DerivedAlarm alarm = { c, state, m_timestamps[i], m_result[i] };
+                    m_alarms.append(alarm);
+                    m_alarmState[c] = state;
+                }
+            }
+        }
+
+        m_count += count;
+        m_evaluated += count;
+    }
+}
+
+//
+// Called from timers outside the read path so the next chunk of every
+// channel is ready before the current one fills up.
+//
+void DerivedChannels::reserveSpare()
+{
+    for (int c = 0; c < m_channelCount; c++) {
+        if (m_spare[c] == nullptr) {
+            m_spare[c] = new Chunk;
+        }
+
+        if (m_slots[c].count() == m_slots[c].capacity()) {
+            m_slots[c].reserve(qMax(m_slots[c].capacity() * 2, 64));
+        }
+    }
+}
+
+void DerivedChannels::releaseSpare()
+{
+    for (int c = 0; c < MaximumChannels; c++) {
+        delete m_spare[c];
+        m_spare[c] = nullptr;
+    }
+}
+
+void DerivedChannels::releaseCache()
+{
+    for (int c = 0; c < MaximumChannels; c++) {
+        for (CacheEntry &entry : m_cache[c]) {
+            delete entry.chunk;
+            entry.chunk = nullptr;
+            entry.slot = -1;
+            entry.used = 0;
+        }
+    }
+}
+
+//
+// Collects a finished packing job and starts the next one; see
+// SampleStore::compressSealed(). Every channel's chunk of a sealed block
+// goes into the same job.
+//
+void DerivedChannels::compressSealed()
+{
+    if (m_jobCount > 0) {
+        if (!m_job.isFinished()) {
+            return;
+        }
+        installPacked();
+    }
+
+    if (m_channelCount == 0) {
+        return;
+    }
+
+    int sealed = m_slots[0].count() - HotChunks;
+    if (sealed <= m_packedChunks) {
+        return;
+    }
+
+    int count = qMin(sealed - m_packedChunks, MaximumJob);
+    QVector<const Chunk *> chunks;
+    chunks.reserve(count * m_channelCount);
+    for (int i = 0; i < count; i++) {
+        for (int c = 0; c < m_channelCount; c++) {
+            chunks.append(m_slots[c][m_packedChunks + i].chunk);
+        }
+    }
+
+    m_jobCount = count;
+    m_job = QtConcurrent::run(&DerivedChannels::packChunks, chunks);
+}
+
+void DerivedChannels::clear()
+{
+    finishJob();
+
+    for (int c = 0; c < MaximumChannels; c++) {
+        for (Slot &slot : m_slots[c]) {
+            if (slot.chunk != nullptr) {
+                recycle(c, slot.chunk);
+            }
+        }
+        m_slots[c].clear();
+
+        for (CacheEntry &entry : m_cache[c]) {
+            entry.slot = -1;
+            entry.used = 0;
+        }
+
+        m_expressions[c].reset();
+        m_alarmState[c] = 0;
+    }
+
+    m_count = 0;
+    m_packedChunks = 0;
+    m_packedBytes = 0;
+    m_minimum = FLT_MAX;
+    m_maximum = -FLT_MAX;
+    m_alarms.clear();
+}
+
+QVector<DerivedAlarm> DerivedChannels::takeAlarms()
+{
+    QVector<DerivedAlarm> alarms;
+    alarms.swap(m_alarms);
+    return alarms;
+}
+
+qreal DerivedChannels::nanosPerSample(int channel) const
+{
+    if (m_evaluated == 0) {
+        return 0.0;
+    }
+
+    return static_cast<qreal>(m_nanos[channel]) / static_cast<qreal>(m_evaluated);
+}
+
+//
+// Names become log column headers, so they must be plain identifiers that
+// don't shadow a built-in column.
+//
+bool DerivedChannels::isValidName(const QString &name)
+{
+    static const QRegularExpression pattern("^[A-Za-z_][A-Za-z0-9_]*$");
+
+    if (!pattern.match(name).hasMatch()) {
+        return false;
+    }
+
+    for (const char *reserved : s_reservedNames) {
+        if (name == QLatin1String(reserved)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//
+// Copies the fields any channel reads for samples [first, first + count)
+// into the evaluation columns, in the units the expression names document.
+//
+void DerivedChannels::gather(const SampleStore &samples, const EstimateStore &estimates, qint64 first, int count)
+{
+    if (first == 0) {
+        m_timeOrigin = samples.at(0).timestamp;
+    }
+
+    for (int i = 0; i < count; i++) {
+        const Sample &sample = samples.at(first + i);
+        m_timestamps[i] = sample.timestamp;
+
+        if (m_variables & (1u << Expression::VariableTime)) {
+            m_columns[Expression::VariableTime][i] = static_cast<double>(sample.timestamp - m_timeOrigin) / 1000000.0;
+        }
+        if (m_variables & (1u << Expression::VariableVoltage)) {
+            m_columns[Expression::VariableVoltage][i] = sample.volts();
+        }
+        if (m_variables & (1u << Expression::VariableCurrent)) {
+            m_columns[Expression::VariableCurrent][i] = sample.amps();
+        }
+        if (m_variables & (1u << Expression::VariableCharge)) {
+            m_columns[Expression::VariableCharge][i] = sample.coulombs();
+        }
+        if (m_variables & (1u << Expression::VariableTemperature)) {
+            m_columns[Expression::VariableTemperature][i] = sample.celsius();
+        }
+        if (m_variables & (1u << Expression::VariableMode)) {
+            m_columns[Expression::VariableMode][i] = sample.mode;
+        }
+        for (int cell = 0; cell < 6; cell++) {
+            if (m_variables & (1u << (Expression::VariableCell1 + cell))) {
+                m_columns[Expression::VariableCell1 + cell][i] = sample.cellVolts(cell);
+            }
+        }
+
+        if (m_variables & ((1u << Expression::VariableStateOfCharge) | (1u << Expression::VariableResistance))) {
+            const BatteryEstimate &estimate = estimates.at(first + i);
+            m_columns[Expression::VariableStateOfCharge][i] = estimate.stateOfCharge;
+            m_columns[Expression::VariableResistance][i] = estimate.resistance;
+        }
+    }
+}
+
+//
+// Runs on a pool thread.
+//
+QVector<QByteArray> DerivedChannels::packChunks(const QVector<const Chunk *> &chunks)
+{
+    QVector<QByteArray> packed;
+    packed.reserve(chunks.count());
+
+    QByteArray buffer(MaximumPackedSize, Qt::Uninitialized);
+    uchar *data = reinterpret_cast<uchar *>(buffer.data());
+
+    for (const Chunk *chunk : chunks) {
+        int size = packValues(chunk->values, data);
+        packed.append(QByteArray(buffer.constData(), size));
+    }
+
+    return packed;
+}
+
+void DerivedChannels::unpackChunk(const QByteArray &packed, Chunk *chunk)
+{
+    const uchar *data = reinterpret_cast<const uchar *>(packed.constData());
+    uchar encoding = data[0];
+    uchar parameter = data[1];
+    float minimum;
+    float step;
+    qint64 code;
+    memcpy(&minimum, data + 2, sizeof(float));
+    memcpy(&step, data + 2 + sizeof(float), sizeof(float));
+    memcpy(&code, data + 2 + 2 * sizeof(float), sizeof(qint64));
+
+    BitReader reader(data + HeaderSize);
+
+    for (int i = 0; i < ChunkSize; i++) {
+        if (i > 0) {
+            code += RiceCoder::readResidual(&reader, parameter);
+        }
+
+        if (encoding == EncodingQuantised) {
+            chunk->values[i] = minimum + static_cast<float>(code) * step;
+        }
+        else {
+            quint32 bits = static_cast<quint32>(code);
+            memcpy(&chunk->values[i], &bits, sizeof(float));
+        }
+    }
+}
+
+const DerivedChannels::Chunk *DerivedChannels::unpacked(int channel, int slot) const
+{
+    CacheEntry *cache = m_cache[channel];
+    CacheEntry *victim = &cache[0];
+
+    for (int i = 0; i < CacheSize; i++) {
+        CacheEntry &entry = cache[i];
+        if (entry.slot == slot) {
+            entry.used = ++m_cacheClock;
+            return entry.chunk;
+        }
+        if (entry.used < victim->used) {
+            victim = &entry;
+        }
+    }
+
+    if (victim->chunk == nullptr) {
+        victim->chunk = new Chunk;
+    }
+
+    unpackChunk(m_slots[channel][slot].packed, victim->chunk);
+    victim->slot = slot;
+    victim->used = ++m_cacheClock;
+    return victim->chunk;
+}
+
+void DerivedChannels::finishJob()
+{
+    if (m_jobCount > 0) {
+        m_job.waitForFinished();
+        installPacked();
+    }
+}
+
+void DerivedChannels::installPacked()
+{
+    QVector<QByteArray> packed = m_job.result();
+    int index = 0;
+
+    for (int i = 0; i < m_jobCount; i++) {
+        for (int c = 0; c < m_channelCount; c++) {
+            Slot &slot = m_slots[c][m_packedChunks];
+            slot.packed = packed[index++];
+            recycle(c, slot.chunk);
+            slot.chunk = nullptr;
+
+            m_packedBytes += slot.packed.size();
+        }
+        m_packedChunks++;
+    }
+
+    m_jobCount = 0;
+}
+
+void DerivedChannels::recycle(int channel, Chunk *chunk)
+{
+    if (m_spare[channel] == nullptr) {
+        m_spare[channel] = chunk;
+    }
+    else {
+        delete chunk;
+    }
+}
@@ -0,0 +1,149 @@
+#ifndef DERIVEDCHANNELS_H
+#define DERIVEDCHANNELS_H
+
+#include "expression.h"
+#include "samplestore.h"
+#include "estimatestore.h"
+
+#include <QByteArray>
+#include <QColor>
+#include <QFuture>
+#include <QString>
+#include <QVector>
+
+//
+// One user-defined channel as stored in the settings. Alarm limits are
+// only checked when enabled.
+//
+struct DerivedChannelDefinition
+{
+    QString name;
+    QString expression;
+    QColor color;
+    bool alarmBelowEnabled = false;
+    qreal alarmBelow = 0.0;
+    bool alarmAboveEnabled = false;
+    qreal alarmAbove = 0.0;
+};
+
+//
+// A derived channel leaving or re-entering its alarm limits.
+//
+struct DerivedAlarm
+{
+    int channel;
+    int state;                      // -1 below, 0 within limits, 1 above
+    qint64 timestamp;               // wall clock, microseconds since epoch
+    qreal value;
+};
+
+//
+// Values of the derived channels, index-aligned with the sample store.
+// evaluate() catches up with the sample and estimate stores in blocks of
+// Expression::BlockSize: the fields any channel reads are gathered into
+// columns once per block and every channel's program then runs over the
+// whole block. Values are kept in single precision, chunked like the
+// estimate store so appending doesn't allocate once spares are reserved.
+//
+// Sealed chunks are packed on a worker thread by compressSealed(): each
+// channel's values are quantised to 1/65535 of the chunk's range and the
+// deltas Rice coded. Alarms and the live log see the values before packing.
+// Each channel keeps its own small unpack cache, so reading every channel
+// at one index doesn't evict the others.
+//
+class DerivedChannels
+{
+public:
+    static const int MaximumChannels = 8;
+    static const int ChunkSize = 4096;
+    static const int HotChunks = 4;
+    static const int CacheSize = 2;
+
+    DerivedChannels();
+    ~DerivedChannels();
+
+    void setDefinitions(const QVector<DerivedChannelDefinition> &definitions);
+    int channelCount() const { return m_channelCount; }
+    const DerivedChannelDefinition &definition(int channel) const { return m_definitions[channel]; }
+
+    qint64 count() const { return m_count; }
+    float value(int channel, qint64 index) const;
+    bool hasRange() const { return m_minimum <= m_maximum; }
+    float minimum() const { return m_minimum; }
+    float maximum() const { return m_maximum; }
+    qint64 heapBytes() const;
+
+    void evaluate(const SampleStore &samples, const EstimateStore &estimates, qint64 end);
+    void reserveSpare();
+    void releaseSpare();
+    void releaseCache();
+    void compressSealed();
+    void clear();
+
+    bool hasAlarms() const { return !m_alarms.isEmpty(); }
+    QVector<DerivedAlarm> takeAlarms();
+
+    qreal nanosPerSample(int channel) const;
+
+    static bool isValidName(const QString &name);
+
+private:
+    Q_DISABLE_COPY(DerivedChannels)
+
+    struct Chunk {
+        float values[ChunkSize];
+    };
+
+    struct Slot {
+        Chunk *chunk;
+        QByteArray packed;
+    };
+
+    struct CacheEntry {
+        int slot;
+        quint64 used;
+        Chunk *chunk;
+    };
+
+    static QVector<QByteArray> packChunks(const QVector<const Chunk *> &chunks);
+    static void unpackChunk(const QByteArray &packed, Chunk *chunk);
+
+    const Chunk *unpacked(int channel, int slot) const;
+    void finishJob();
+    void installPacked();
+    void recycle(int channel, Chunk *chunk);
+    void gather(const SampleStore &samples, const EstimateStore &estimates, qint64 first, int count);
+
+    QVector<DerivedChannelDefinition> m_definitions;
+    Expression m_expressions[MaximumChannels];
+    int m_channelCount = 0;
+    quint32 m_variables = 0;
+
+    QVector<Slot> m_slots[MaximumChannels];
+    Chunk *m_spare[MaximumChannels];
+    qint64 m_count = 0;
+
+    QFuture<QVector<QByteArray>> m_job;
+    int m_jobCount = 0;
+    int m_packedChunks = 0;
+    qint64 m_packedBytes = 0;
+
+    mutable CacheEntry m_cache[MaximumChannels][CacheSize];
+    mutable quint64 m_cacheClock = 0;
+    float m_minimum = 0.0f;
+    float m_maximum = 0.0f;
+
+    double m_columns[Expression::VariableCount][Expression::BlockSize];
+    const double *m_columnPointers[Expression::VariableCount];
+    double m_result[Expression::BlockSize];
+    qint64 m_timestamps[Expression::BlockSize];
+    qint64 m_timeOrigin = 0;
+
+    int m_alarmState[MaximumChannels];
+    QVector<DerivedAlarm> m_alarms;
+
+    qint64 m_nanos[MaximumChannels];
+    qint64 m_evaluated = 0;
+};
+
+#endif // DERIVEDCHANNELS_H
@@ -0,0 +1,167 @@
+#include "derivedchannelsdialog.h"
+#include "ui_derivedchannelsdialog.h"
+
+#include <QHeaderView>
+#include <QSet>
+
+//
+// Line colours handed out to channels in the order they are listed.
+//
+static const Qt::GlobalColor s_colors[] = {
+    Qt::darkGreen,
+    Qt::darkMagenta,
+    Qt::darkYellow,
+    Qt::darkBlue,
+    Qt::darkRed,
+    Qt::gray,
+    Qt::cyan,
+    Qt::black
+};
+
+DerivedChannelsDialog::DerivedChannelsDialog(QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::DerivedChannelsDialog)
+{
+    ui->setupUi(this);
+    ui->tblChannels->horizontalHeader()->setSectionResizeMode(ColumnExpression, QHeaderView::Stretch);
+}
+
+DerivedChannelsDialog::~DerivedChannelsDialog()
+{
+    delete ui;
+}
+
+void DerivedChannelsDialog::setDefinitions(const QVector<DerivedChannelDefinition> &definitions)
+{
+    ui->tblChannels->setRowCount(0);
+
+    for (const DerivedChannelDefinition &definition : definitions) {
+        appendRow(definition);
+    }
+}
+
+QVector<DerivedChannelDefinition> DerivedChannelsDialog::definitions() const
+{
+    QVector<DerivedChannelDefinition> definitions;
+
+    for (int row = 0; row < ui->tblChannels->rowCount(); row++) {
+        DerivedChannelDefinition definition;
+        definition.name = cellText(row, ColumnName);
+        definition.expression = cellText(row, ColumnExpression);
+        definition.color = QColor(s_colors[row % DerivedChannels::MaximumChannels]);
+
+        QString below = cellText(row, ColumnAlarmBelow);
+        definition.alarmBelowEnabled = !below.isEmpty();
+        definition.alarmBelow = below.toDouble();
+
+        QString above = cellText(row, ColumnAlarmAbove);
+        definition.alarmAboveEnabled = !above.isEmpty();
+        definition.alarmAbove = above.toDouble();
+
+        definitions.append(definition);
+    }
+
+    return definitions;
+}
+
+void DerivedChannelsDialog::accept()
+{
+    if (validate()) {
+        QDialog::accept();
+    }
+}
+
+void DerivedChannelsDialog::on_btnAdd_clicked()
+{
+    if (ui->tblChannels->rowCount() >= DerivedChannels::MaximumChannels) {
+        ui->lblError->setText(tr("At most %1 derived channels are supported.").arg(DerivedChannels::MaximumChannels));
+        return;
+    }
+
+    DerivedChannelDefinition definition;
+    definition.name = QString("channel%1").arg(ui->tblChannels->rowCount() + 1);
+    appendRow(definition);
+
+    int row = ui->tblChannels->rowCount() - 1;
+    ui->tblChannels->setCurrentCell(row, ColumnExpression);
+    ui->tblChannels->editItem(ui->tblChannels->item(row, ColumnExpression));
+}
+
+void DerivedChannelsDialog::on_btnRemove_clicked()
+{
+    int row = ui->tblChannels->currentRow();
+    if (row >= 0) {
+        ui->tblChannels->removeRow(row);
+    }
+}
+
+void DerivedChannelsDialog::appendRow(const DerivedChannelDefinition &definition)
+{
+    int row = ui->tblChannels->rowCount();
+    ui->tblChannels->insertRow(row);
+
+    ui->tblChannels->setItem(row, ColumnName, new QTableWidgetItem(definition.name));
+    ui->tblChannels->setItem(row, ColumnExpression, new QTableWidgetItem(definition.expression));
+    ui->tblChannels->setItem(row, ColumnAlarmBelow, new QTableWidgetItem(
+                                 definition.alarmBelowEnabled ? QString::number(definition.alarmBelow) : QString()));
+    ui->tblChannels->setItem(row, ColumnAlarmAbove, new QTableWidgetItem(
+                                 definition.alarmAboveEnabled ? QString::number(definition.alarmAbove) : QString()));
+}
+
+QString DerivedChannelsDialog::cellText(int row, int column) const
+{
+    QTableWidgetItem *item = ui->tblChannels->item(row, column);
+    return (item != nullptr) ? item->text().trimmed() : QString();
+}
+
+//
+// Compiles every row so errors are reported here rather than channels
+// silently going missing from the chart.
+//
+bool DerivedChannelsDialog::validate()
+{
+    QSet<QString> names;
+
+    for (int row = 0; row < ui->tblChannels->rowCount(); row++) {
+        QString name = cellText(row, ColumnName);
+        QString error;
+        int column = ColumnName;
+
+        if (!DerivedChannels::isValidName(name)) {
+            error = tr("'%1' is not a valid name; use letters, digits and underscores, and not a built-in log column.").arg(name);
+        }
+        else if (names.contains(name)) {
+            error = tr("'%1' is used more than once.").arg(name);
+        }
+        else {
+            Expression expression;
+            if (!expression.compile(cellText(row, ColumnExpression))) {
+                error = tr("%1: %2").arg(name, expression.errorString());
+                column = ColumnExpression;
+            }
+        }
+
+        for (int limit = ColumnAlarmBelow; error.isEmpty() && limit <= ColumnAlarmAbove; limit++) {
+            QString text = cellText(row, limit);
+            bool ok = true;
+            if (!text.isEmpty()) {
+                text.toDouble(&ok);
+            }
+            if (!ok) {
+                error = tr("%1: alarm limit '%2' is not a number.").arg(name, text);
+                column = limit;
+            }
+        }
+
+        if (!error.isEmpty()) {
+            ui->lblError->setText(error);
+            ui->tblChannels->setCurrentCell(row, column);
+            return false;
+        }
+
+        names.insert(name);
+    }
+
+    ui->lblError->clear();
+    return true;
+}
@@ -0,0 +1,46 @@
+#ifndef DERIVEDCHANNELSDIALOG_H
+#define DERIVEDCHANNELSDIALOG_H
+
+#include "derivedchannels.h"
+
+#include <QDialog>
+#include <QVector>
+
+namespace Ui {
+class DerivedChannelsDialog;
+}
+
+class DerivedChannelsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit DerivedChannelsDialog(QWidget *parent = nullptr);
+    ~DerivedChannelsDialog();
+
+    void setDefinitions(const QVector<DerivedChannelDefinition> &definitions);
+    QVector<DerivedChannelDefinition> definitions() const;
+
+public slots:
+    void accept() override;
+
+private slots:
+    void on_btnAdd_clicked();
+    void on_btnRemove_clicked();
+
+private:
+    enum Column {
+        ColumnName = 0,
+        ColumnExpression,
+        ColumnAlarmBelow,
+        ColumnAlarmAbove
+    };
+
+    void appendRow(const DerivedChannelDefinition &definition);
+    QString cellText(int row, int column) const;
+    bool validate();
+
+    Ui::DerivedChannelsDialog *ui;
+};
+
+#endif // DERIVEDCHANNELSDIALOG_H
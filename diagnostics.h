@@ -0,0 +1,14 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <QLoggingCategory>
+
+//
+// Periodic and per-event diagnostics: decoder and link counters, memory,
+// plot frame rate, idle wakeups, replay and report timings. Off by
+// default; enable with QT_LOGGING_RULES="pbm.diagnostics.debug=true". The
+// diagnostics timer only runs while the category is enabled.
+//
+Q_DECLARE_LOGGING_CATEGORY(lcDiagnostics)
+
+#endif // DIAGNOSTICS_H
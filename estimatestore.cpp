@@ -0,0 +1,399 @@
+#include "estimatestore.h"
+#include "ricecoder.h"
+
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <string.h>
+
+//
+// Sealed chunks are packed field by field. Each field is stored as
+// integer codes: the value in thousandths of its unit, or the raw float
+// bits for a chunk holding a value that doesn't quantise, such as a
+// diverged filter's NaN. A field header gives the encoding, the Rice
+// parameter and the first code; the bit stream holds the zigzagged deltas.
+//
+enum Field {
+    FieldStateOfCharge = 0,
+    FieldResistance,
+    FieldCount
+};
+
+enum Encoding {
+    EncodingQuantised = 0,
+    EncodingRaw
+};
+
+static const double QuantisationScale = 1000.0;
+static const float MaximumQuantised = 1.0e9f;
+static const int FieldHeaderSize = 2 + sizeof(qint64);
+static const int HeaderSize = FieldCount * FieldHeaderSize;
+static const int MaximumJob = 16;
+
+//
+// Worst case: every residual escaped
+//
+static const int MaximumPackedSize = HeaderSize
+        + ((FieldCount * EstimateStore::ChunkSize * RiceCoder::MaximumResidualBits) / 8) + 1;
+
+static float fieldValue(const BatteryEstimate &estimate, int field)
+{
+    return (field == FieldStateOfCharge) ? estimate.stateOfCharge : estimate.resistance;
+}
+
+static void setFieldValue(BatteryEstimate *estimate, int field, float value)
+{
+    if (field == FieldStateOfCharge) {
+        estimate->stateOfCharge = value;
+    }
+    else {
+        estimate->resistance = value;
+    }
+}
+
+static qint64 encode(float value, uchar encoding)
+{
+    if (encoding == EncodingQuantised) {
+        return qRound64(value * QuantisationScale);
+    }
+
+    quint32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static float decode(qint64 code, uchar encoding)
+{
+    if (encoding == EncodingQuantised) {
+        return static_cast<float>(code / QuantisationScale);
+    }
+
+    quint32 bits = static_cast<quint32>(code);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static int packEstimates(const BatteryEstimate *estimates, uchar *data)
+{
+    BitWriter writer(data + HeaderSize);
+    qint64 codes[EstimateStore::ChunkSize];
+    quint64 residuals[EstimateStore::ChunkSize - 1];
+
+    for (int field = 0; field < FieldCount; field++) {
+        uchar encoding = EncodingQuantised;
+
+        for (int i = 0; i < EstimateStore::ChunkSize; i++) {
+            float value = fieldValue(estimates[i], field);
+            if (!qIsFinite(value) || qAbs(value) >= MaximumQuantised) {
+                encoding = EncodingRaw;
+                break;
+            }
+        }
+
+        for (int i = 0; i < EstimateStore::ChunkSize; i++) {
+            codes[i] = encode(fieldValue(estimates[i], field), encoding);
+        }
+
+        for (int i = 1; i < EstimateStore::ChunkSize; i++) {
+            residuals[i - 1] = RiceCoder::zigzag(codes[i] - codes[i - 1]);
+        }
+
+        uchar *header = data + (field * FieldHeaderSize);
+        header[0] = encoding;
+        header[1] = RiceCoder::writeColumn(&writer, residuals, EstimateStore::ChunkSize - 1);
+        memcpy(header + 2, &codes[0], sizeof(qint64));
+    }
+
+    return static_cast<int>(writer.finish() - data);
+}
+
+EstimateStore::EstimateStore()
+{
+    m_slots.reserve(1024);
+    reserveSpare();
+
+    for (CacheEntry &entry : m_cache) {
+        entry.slot = -1;
+        entry.used = 0;
+        entry.chunk = nullptr;
+    }
+}
+
+EstimateStore::~EstimateStore()
+{
+    clear();
+    delete m_spare;
+
+    for (CacheEntry &entry : m_cache) {
+        delete entry.chunk;
+    }
+}
+
+const BatteryEstimate &EstimateStore::at(qint64 index) const
+{
+    int slot = static_cast<int>(index / ChunkSize);
+    const Chunk *chunk = m_slots[slot].chunk;
+
+    if (chunk == nullptr) {
+        chunk = unpacked(slot);
+    }
+
+    return chunk->estimates[index % ChunkSize];
+}
+
+//
+// Memory held for the estimates: raw and spare chunks, packed chunks and
+// the unpack cache.
+//
+qint64 EstimateStore::heapBytes() const
+{
+    qint64 chunks = (m_spare != nullptr) ? 1 : 0;
+
+    for (const Slot &slot : m_slots) {
+        if (slot.chunk != nullptr) {
+            chunks++;
+        }
+    }
+
+    for (const CacheEntry &entry : m_cache) {
+        if (entry.chunk != nullptr) {
+            chunks++;
+        }
+    }
+
+    return chunks * static_cast<qint64>(sizeof(Chunk)) + m_packedBytes;
+}
+
+void EstimateStore::append(const BatteryEstimate &estimate)
+{
+    int offset = static_cast<int>(m_count % ChunkSize);
+
+    if (offset == 0) {
+        Slot slot;
+        if (m_spare != nullptr) {
+            slot.chunk = m_spare;
+            m_spare = nullptr;
+        }
+        else {
+            slot.chunk = new Chunk;
+        }
+        m_slots.append(slot);
+    }
+
+    m_slots.last().chunk->estimates[offset] = estimate;
+    m_count++;
+}
+
+void EstimateStore::reserveSpare()
+{
+    if (m_spare == nullptr) {
+        m_spare = new Chunk;
+    }
+
+    if (m_slots.count() == m_slots.capacity()) {
+        m_slots.reserve(m_slots.capacity() * 2);
+    }
+}
+
+void EstimateStore::releaseSpare()
+{
+    delete m_spare;
+    m_spare = nullptr;
+}
+
+void EstimateStore::releaseCache()
+{
+    for (CacheEntry &entry : m_cache) {
+        delete entry.chunk;
+        entry.chunk = nullptr;
+        entry.slot = -1;
+        entry.used = 0;
+    }
+}
+
+//
+// Collects a finished packing job and starts the next one; see
+// SampleStore::compressSealed().
+//
+void EstimateStore::compressSealed()
+{
+    if (m_jobCount > 0) {
+        if (!m_job.isFinished()) {
+            return;
+        }
+        installPacked();
+    }
+
+    int sealed = m_slots.count() - HotChunks;
+    if (sealed <= m_packedChunks) {
+        return;
+    }
+
+    int count = qMin(sealed - m_packedChunks, MaximumJob);
+    QVector<const Chunk *> chunks;
+    chunks.reserve(count);
+    for (int i = 0; i < count; i++) {
+        chunks.append(m_slots[m_packedChunks + i].chunk);
+    }
+
+    m_jobCount = count;
+    m_job = QtConcurrent::run(&EstimateStore::packChunks, chunks);
+}
+
+void EstimateStore::clear()
+{
+    finishJob();
+
+    for (Slot &slot : m_slots) {
+        if (slot.chunk != nullptr) {
+            recycle(slot.chunk);
+        }
+    }
+
+    resetCache();
+    m_slots.clear();
+    m_slots.reserve(1024);
+    m_count = 0;
+    m_packedChunks = 0;
+    m_packedBytes = 0;
+}
+
+//
+// Any packing in flight is installed first, since the job's chunks move
+// with the slots. Cached chunks stay with their store but no longer match
+// its slots.
+//
+void EstimateStore::swap(EstimateStore &other)
+{
+    finishJob();
+    other.finishJob();
+
+    m_slots.swap(other.m_slots);
+    qSwap(m_spare, other.m_spare);
+    qSwap(m_count, other.m_count);
+    qSwap(m_packedChunks, other.m_packedChunks);
+    qSwap(m_packedBytes, other.m_packedBytes);
+
+    resetCache();
+    other.resetCache();
+}
+
+//
+// Runs on a pool thread.
+//
+QVector<QByteArray> EstimateStore::packChunks(const QVector<const Chunk *> &chunks)
+{
+    QVector<QByteArray> packed;
+    packed.reserve(chunks.count());
+
+    QByteArray buffer(MaximumPackedSize, Qt::Uninitialized);
+    uchar *data = reinterpret_cast<uchar *>(buffer.data());
+
+    for (const Chunk *chunk : chunks) {
+        int size = packEstimates(chunk->estimates, data);
+        packed.append(QByteArray(buffer.constData(), size));
+    }
+
+    return packed;
+}
+
+void EstimateStore::unpackChunk(const QByteArray &packed, Chunk *chunk)
+{
+    const uchar *data = reinterpret_cast<const uchar *>(packed.constData());
+    BitReader reader(data + HeaderSize);
+
+    for (int field = 0; field < FieldCount; field++) {
+        const uchar *header = data + (field * FieldHeaderSize);
+        uchar encoding = header[0];
+        uchar parameter = header[1];
+        qint64 code;
+        memcpy(&code, header + 2, sizeof(code));
+
+        setFieldValue(&chunk->estimates[0], field, decode(code, encoding));
+
+        for (int i = 1; i < ChunkSize; i++) {
+            code += RiceCoder::readResidual(&reader, parameter);
+            setFieldValue(&chunk->estimates[i], field, decode(code, encoding));
+        }
+    }
+}
+
+const EstimateStore::Chunk *EstimateStore::unpacked(int slot) const
+{
+    CacheEntry *victim = &m_cache[0];
+
+    for (CacheEntry &entry : m_cache) {
+        if (entry.slot == slot) {
+            entry.used = ++m_cacheClock;
+            return entry.chunk;
+        }
+        if (entry.used < victim->used) {
+            victim = &entry;
+        }
+    }
+
+    if (victim->chunk == nullptr) {
+        victim->chunk = new Chunk;
+    }
+
+    unpackChunk(m_slots[slot].packed, victim->chunk);
+    victim->slot = slot;
+    victim->used = ++m_cacheClock;
+    return victim->chunk;
+}
+
+void EstimateStore::finishJob()
+{
+    if (m_jobCount > 0) {
+        m_job.waitForFinished();
+        installPacked();
+    }
+}
+
+void EstimateStore::installPacked()
+{
+    QVector<QByteArray> packed = m_job.result();
+
+    for (int i = 0; i < m_jobCount; i++) {
+        Slot &slot = m_slots[m_packedChunks];
+        slot.packed = packed[i];
+        recycle(slot.chunk);
+        slot.chunk = nullptr;
+
+        m_packedBytes += slot.packed.size();
+        m_packedChunks++;
+    }
+
+    m_jobCount = 0;
+}
+
+void EstimateStore::resetCache()
+{
+    for (CacheEntry &entry : m_cache) {
+        entry.slot = -1;
+        entry.used = 0;
+    }
+}
+
+void EstimateStore::recycle(Chunk *chunk)
+{
+    if (m_spare == nullptr) {
+        m_spare = chunk;
+    }
+    else {
+        delete chunk;
+    }
+}
+
+EstimateHistory EstimateHistory::compute(BatteryEstimator estimator, const Sample *samples, qint64 count)
+{
+    EstimateHistory history;
+    history.store.reset(new EstimateStore);
+
+    for (qint64 i = 0; i < count; i++) {
+        history.store->append(estimator.update(samples[i]));
+    }
+
+    history.estimator = estimator;
+    return history;
+}
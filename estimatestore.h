@@ -0,0 +1,101 @@
+#ifndef ESTIMATESTORE_H
+#define ESTIMATESTORE_H
+
+#include "batteryestimator.h"
+
+#include <QByteArray>
+#include <QFuture>
+#include <QSharedPointer>
+#include <QVector>
+
+//
+// Battery estimates for the session, index-aligned with the sample store.
+// Uses the same chunking as SampleStore so append() doesn't allocate once
+// a spare chunk has been reserved. Estimates are cheap to recompute, so
+// nothing is mapped from the session snapshot; see EstimateHistory.
+//
+// Sealed chunks are packed on a worker thread by compressSealed(), as in
+// the sample store: both fields are quantised to 0.001 of their unit and
+// the deltas Rice coded. References returned by at() for packed chunks
+// only stay valid until a few other packed chunks have been read.
+//
+class EstimateStore
+{
+public:
+    static const int ChunkSize = 4096;
+    static const int HotChunks = 4;
+    static const int CacheSize = 4;
+
+    EstimateStore();
+    ~EstimateStore();
+
+    qint64 count() const { return m_count; }
+    bool isEmpty() const { return m_count == 0; }
+    const BatteryEstimate &at(qint64 index) const;
+    const BatteryEstimate &last() const { return at(m_count - 1); }
+    qint64 heapBytes() const;
+
+    qint64 packedEstimates() const { return static_cast<qint64>(m_packedChunks) * ChunkSize; }
+
+    void append(const BatteryEstimate &estimate);
+    void reserveSpare();
+    void releaseSpare();
+    void releaseCache();
+    void compressSealed();
+    void clear();
+    void swap(EstimateStore &other);
+
+private:
+    Q_DISABLE_COPY(EstimateStore)
+
+    struct Chunk {
+        BatteryEstimate estimates[ChunkSize];
+    };
+
+    struct Slot {
+        Chunk *chunk;
+        QByteArray packed;
+    };
+
+    struct CacheEntry {
+        int slot;
+        quint64 used;
+        Chunk *chunk;
+    };
+
+    static QVector<QByteArray> packChunks(const QVector<const Chunk *> &chunks);
+    static void unpackChunk(const QByteArray &packed, Chunk *chunk);
+
+    const Chunk *unpacked(int slot) const;
+    void finishJob();
+    void installPacked();
+    void resetCache();
+    void recycle(Chunk *chunk);
+
+    QVector<Slot> m_slots;
+    Chunk *m_spare = nullptr;
+    qint64 m_count = 0;
+
+    QFuture<QVector<QByteArray>> m_job;
+    int m_jobCount = 0;
+    int m_packedChunks = 0;
+    qint64 m_packedBytes = 0;
+
+    mutable CacheEntry m_cache[CacheSize];
+    mutable quint64 m_cacheClock = 0;
+};
+
+//
+// Estimates for a run of samples computed on a worker thread, such as a
+// restored session, along with the estimator as it stands after the last
+// of them so live samples can carry on from it.
+//
+struct EstimateHistory
+{
+    QSharedPointer<EstimateStore> store;
+    BatteryEstimator estimator;
+
+    static EstimateHistory compute(BatteryEstimator estimator, const Sample *samples, qint64 count);
+};
+
+#endif // ESTIMATESTORE_H
@@ -0,0 +1,479 @@
+#include "expression.h"
+
+#include <QCoreApplication>
+#include <QtMath>
+
+#include <stdlib.h>
+#include <string.h>
+
+static const struct {
+    const char *name;
+    int variable;
+} s_variables[] = {
+    { "t", Expression::VariableTime },
+    { "V", Expression::VariableVoltage },
+    { "I", Expression::VariableCurrent },
+    { "Q", Expression::VariableCharge },
+    { "T", Expression::VariableTemperature },
+    { "soc", Expression::VariableStateOfCharge },
+    { "R", Expression::VariableResistance },
+    { "mode", Expression::VariableMode },
+    { "cell1", Expression::VariableCell1 },
+    { "cell2", Expression::VariableCell1 + 1 },
+    { "cell3", Expression::VariableCell1 + 2 },
+    { "cell4", Expression::VariableCell1 + 3 },
+    { "cell5", Expression::VariableCell1 + 4 },
+    { "cell6", Expression::VariableCell1 + 5 }
+};
+
+static bool isNameStart(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+static bool isNameChar(char c)
+{
+    return isNameStart(c) || (c >= '0' && c <= '9');
+}
+
+Expression::Expression()
+{
+}
+
+bool Expression::compile(const QString &text)
+{
+    m_program.clear();
+    m_derivatives.clear();
+    m_stack.clear();
+    m_errorString.clear();
+    m_variables = 0;
+
+    m_text = text.toLatin1();
+    m_position = 0;
+    m_depth = 0;
+    m_maximumDepth = 0;
+
+    bool valid = parseSum();
+    if (valid) {
+        skipSpace();
+        if (m_position < m_text.size()) {
+            valid = fail(QCoreApplication::translate("Expression", "Unexpected '%1'").arg(QChar(m_text[m_position])));
+        }
+    }
+
+    if (!valid) {
+        m_program.clear();
+        m_derivatives.clear();
+        m_variables = 0;
+        return false;
+    }
+
+    m_stack.resize(m_maximumDepth * BlockSize);
+    return true;
+}
+
+//
+// Forgets the history ddt() differentiates against, for a new session.
+//
+void Expression::reset()
+{
+    for (Derivative &derivative : m_derivatives) {
+        derivative.valid = false;
+    }
+}
+
+//
+// Evaluates up to BlockSize samples. columns holds one array per Variable;
+// only those in variables() are read.
+//
+void Expression::evaluate(const double *const *columns, int count, double *result)
+{
+    double *stack = m_stack.data();
+    double *top = stack - BlockSize;
+
+    for (const Instruction &instruction : m_program) {
+        double *a = top - BlockSize;
+        double *b = top;
+
+        switch (instruction.opcode) {
+        case OpConstant:
+            top += BlockSize;
+            for (int i = 0; i < count; i++) top[i] = instruction.constant;
+            break;
+        case OpVariable:
+            top += BlockSize;
+            memcpy(top, columns[instruction.operand], static_cast<size_t>(count) * sizeof(double));
+            break;
+        case OpAdd:
+            for (int i = 0; i < count; i++) a[i] += b[i];
+            top = a;
+            break;
+        case OpSubtract:
+            for (int i = 0; i < count; i++) a[i] -= b[i];
+            top = a;
+            break;
+        case OpMultiply:
+            for (int i = 0; i < count; i++) a[i] *= b[i];
+            top = a;
+            break;
+        case OpDivide:
+            for (int i = 0; i < count; i++) a[i] /= b[i];
+            top = a;
+            break;
+        case OpPower:
+            for (int i = 0; i < count; i++) a[i] = qPow(a[i], b[i]);
+            top = a;
+            break;
+        case OpMinimum:
+            for (int i = 0; i < count; i++) a[i] = (b[i] < a[i]) ? b[i] : a[i];
+            top = a;
+            break;
+        case OpMaximum:
+            for (int i = 0; i < count; i++) a[i] = (b[i] > a[i]) ? b[i] : a[i];
+            top = a;
+            break;
+        case OpNegate:
+            for (int i = 0; i < count; i++) b[i] = -b[i];
+            break;
+        case OpAbs:
+            for (int i = 0; i < count; i++) b[i] = qAbs(b[i]);
+            break;
+        case OpSqrt:
+            for (int i = 0; i < count; i++) b[i] = qSqrt(b[i]);
+            break;
+        case OpDerivative: {
+            //
+            // carries the previous sample across blocks; the first sample
+            // of a session, or one with no time step, reads as zero
+            //
+            Derivative &derivative = m_derivatives[instruction.operand];
+            const double *time = columns[VariableTime];
+
+            for (int i = 0; i < count; i++) {
+                double value = b[i];
+                b[i] = (derivative.valid && time[i] > derivative.time)
+                        ? (value - derivative.value) / (time[i] - derivative.time)
+                        : 0.0;
+                derivative.value = value;
+                derivative.time = time[i];
+                derivative.valid = true;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    memcpy(result, stack, static_cast<size_t>(count) * sizeof(double));
+}
+
+bool Expression::parseSum()
+{
+    if (!parseProduct()) {
+        return false;
+    }
+
+    while (true) {
+        skipSpace();
+        if (m_position >= m_text.size()) {
+            return true;
+        }
+
+        char c = m_text[m_position];
+        if (c != '+' && c != '-') {
+            return true;
+        }
+
+        m_position++;
+        if (!parseProduct()) {
+            return false;
+        }
+        emitBinary((c == '+') ? OpAdd : OpSubtract);
+    }
+}
+
+bool Expression::parseProduct()
+{
+    if (!parseUnary()) {
+        return false;
+    }
+
+    while (true) {
+        skipSpace();
+        if (m_position >= m_text.size()) {
+            return true;
+        }
+
+        char c = m_text[m_position];
+        if (c != '*' && c != '/') {
+            return true;
+        }
+
+        m_position++;
+        if (!parseUnary()) {
+            return false;
+        }
+        emitBinary((c == '*') ? OpMultiply : OpDivide);
+    }
+}
+
+bool Expression::parseUnary()
+{
+    skipSpace();
+
+    if (m_position < m_text.size() && m_text[m_position] == '-') {
+        m_position++;
+        if (!parseUnary()) {
+            return false;
+        }
+        emitUnary(OpNegate);
+        return true;
+    }
+
+    if (m_position < m_text.size() && m_text[m_position] == '+') {
+        m_position++;
+        return parseUnary();
+    }
+
+    return parsePower();
+}
+
+//
+// Right-associative, and binds tighter than unary minus: -x^2 is -(x^2).
+//
+bool Expression::parsePower()
+{
+    if (!parsePrimary()) {
+        return false;
+    }
+
+    skipSpace();
+    if (m_position < m_text.size() && m_text[m_position] == '^') {
+        m_position++;
+        if (!parseUnary()) {
+            return false;
+        }
+        emitBinary(OpPower);
+    }
+
+    return true;
+}
+
+bool Expression::parsePrimary()
+{
+    skipSpace();
+
+    if (m_position >= m_text.size()) {
+        return fail(QCoreApplication::translate("Expression", "Unexpected end of expression"));
+    }
+
+    const char *start = m_text.constData() + m_position;
+    char c = *start;
+
+    if ((c >= '0' && c <= '9') || c == '.') {
+        char *end = nullptr;
+        double value = strtod(start, &end);
+        if (end == start) {
+            return fail(QCoreApplication::translate("Expression", "Malformed number"));
+        }
+        m_position += static_cast<int>(end - start);
+        emitConstant(value);
+        return true;
+    }
+
+    if (isNameStart(c)) {
+        int first = m_position;
+        while (m_position < m_text.size() && isNameChar(m_text[m_position])) {
+            m_position++;
+        }
+        QByteArray name = m_text.mid(first, m_position - first);
+
+        skipSpace();
+        if (m_position < m_text.size() && m_text[m_position] == '(') {
+            m_position++;
+            return parseCall(name);
+        }
+
+        for (const auto &variable : s_variables) {
+            if (name == variable.name) {
+                emitVariable(variable.variable);
+                return true;
+            }
+        }
+
+        m_position = first;
+        return fail(QCoreApplication::translate("Expression", "Unknown name '%1'").arg(QString::fromLatin1(name)));
+    }
+
+    if (c == '(') {
+        m_position++;
+        if (!parseSum()) {
+            return false;
+        }
+        skipSpace();
+        if (m_position >= m_text.size() || m_text[m_position] != ')') {
+            return fail(QCoreApplication::translate("Expression", "Expected ')'"));
+        }
+        m_position++;
+        return true;
+    }
+
+    return fail(QCoreApplication::translate("Expression", "Unexpected '%1'").arg(QChar(c)));
+}
+
+//
+// min, max and mean take any number of arguments and are compiled into a
+// chain of binary operations; the rest take exactly one.
+//
+bool Expression::parseCall(const QByteArray &name)
+{
+    int opcode;
+    bool variadic = true;
+
+    if (name == "min") {
+        opcode = OpMinimum;
+    }
+    else if (name == "max") {
+        opcode = OpMaximum;
+    }
+    else if (name == "mean") {
+        opcode = OpAdd;
+    }
+    else if (name == "abs") {
+        opcode = OpAbs;
+        variadic = false;
+    }
+    else if (name == "sqrt") {
+        opcode = OpSqrt;
+        variadic = false;
+    }
+    else if (name == "ddt") {
+        opcode = OpDerivative;
+        variadic = false;
+    }
+    else {
+        return fail(QCoreApplication::translate("Expression", "Unknown function '%1'").arg(QString::fromLatin1(name)));
+    }
+
+    int arguments = 0;
+
+    while (true) {
+        if (!parseSum()) {
+            return false;
+        }
+        if (arguments > 0) {
+            emitBinary(opcode);
+        }
+        arguments++;
+
+        skipSpace();
+        if (m_position < m_text.size() && m_text[m_position] == ',') {
+            m_position++;
+            continue;
+        }
+        if (m_position < m_text.size() && m_text[m_position] == ')') {
+            m_position++;
+            break;
+        }
+        return fail(QCoreApplication::translate("Expression", "Expected ',' or ')'"));
+    }
+
+    if (!variadic) {
+        if (arguments != 1) {
+            return fail(QCoreApplication::translate("Expression", "%1() takes one argument").arg(QString::fromLatin1(name)));
+        }
+        emitUnary(opcode);
+    }
+    else if (name == "mean" && arguments > 1) {
+        emitConstant(arguments);
+        emitBinary(OpDivide);
+    }
+
+    return true;
+}
+
+bool Expression::fail(const QString &message)
+{
+    m_errorString = QCoreApplication::translate("Expression", "%1 at position %2").arg(message).arg(m_position + 1);
+    return false;
+}
+
+void Expression::skipSpace()
+{
+    while (m_position < m_text.size() && (m_text[m_position] == ' ' || m_text[m_position] == '\t')) {
+        m_position++;
+    }
+}
+
+void Expression::emitConstant(double value)
+{
+    Instruction instruction = { OpConstant, 0, value };
+    m_program.append(instruction);
+
+    m_depth++;
+    m_maximumDepth = qMax(m_maximumDepth, m_depth);
+}
+
+void Expression::emitVariable(int variable)
+{
+    Instruction instruction = { OpVariable, variable, 0.0 };
+    m_program.append(instruction);
+    m_variables |= 1u << variable;
+
+    m_depth++;
+    m_maximumDepth = qMax(m_maximumDepth, m_depth);
+}
+
+void Expression::emitUnary(int opcode)
+{
+    if (opcode == OpDerivative) {
+        Instruction instruction = { OpDerivative, m_derivatives.count(), 0.0 };
+        Derivative derivative = { 0.0, 0.0, false };
+        m_program.append(instruction);
+        m_derivatives.append(derivative);
+        m_variables |= 1u << VariableTime;
+        return;
+    }
+
+    Instruction &last = m_program.last();
+    if (last.opcode == OpConstant) {
+        if (opcode == OpNegate) last.constant = -last.constant;
+        else if (opcode == OpAbs) last.constant = qAbs(last.constant);
+        else if (opcode == OpSqrt) last.constant = qSqrt(last.constant);
+        return;
+    }
+
+    Instruction instruction = { opcode, 0, 0.0 };
+    m_program.append(instruction);
+}
+
+void Expression::emitBinary(int opcode)
+{
+    m_depth--;
+
+    int count = m_program.count();
+    if (count >= 2 && m_program[count - 2].opcode == OpConstant && m_program[count - 1].opcode == OpConstant) {
+        double a = m_program[count - 2].constant;
+        double b = m_program[count - 1].constant;
+        double value = 0.0;
+
+        switch (opcode) {
+        case OpAdd: value = a + b; break;
+        case OpSubtract: value = a - b; break;
+        case OpMultiply: value = a * b; break;
+        case OpDivide: value = a / b; break;
+        case OpPower: value = qPow(a, b); break;
+        case OpMinimum: value = qMin(a, b); break;
+        case OpMaximum: value = qMax(a, b); break;
+        default: break;
+        }
+
+        m_program.removeLast();
+        m_program.last().constant = value;
+        return;
+    }
+
+    Instruction instruction = { opcode, 0, 0.0 };
+    m_program.append(instruction);
+}
@@ -0,0 +1,105 @@
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+//
+// A user-defined formula over the decoded packet fields, compiled once
+// into stack bytecode. Every instruction works on a whole block of
+// samples, so interpretation overhead is paid per block rather than per
+// sample and each instruction's inner loop is a plain array operation the
+// compiler can vectorise. Constant subexpressions are folded at compile
+// time.
+//
+// Names:     t (s since the first sample), V, I (A), Q (C), T (°C),
+//            soc (%), R (mΩ), mode, cell1 ... cell6 (V)
+// Operators: + - * / ^, unary minus, parentheses
+// Functions: abs, sqrt, min, max, mean (any number of arguments),
+//            ddt (rate of change per second)
+//
+class Expression
+{
+public:
+    enum Variable {
+        VariableTime = 0,
+        VariableVoltage,
+        VariableCurrent,
+        VariableCharge,
+        VariableTemperature,
+        VariableStateOfCharge,
+        VariableResistance,
+        VariableMode,
+        VariableCell1,
+        VariableCount = VariableCell1 + 6
+    };
+
+    static const int BlockSize = 256;
+
+    Expression();
+
+    bool compile(const QString &text);
+    bool isValid() const { return !m_program.isEmpty(); }
+    QString errorString() const { return m_errorString; }
+    quint32 variables() const { return m_variables; }
+
+    void reset();
+    void evaluate(const double *const *columns, int count, double *result);
+
+private:
+    enum Opcode {
+        OpConstant = 0,
+        OpVariable,
+        OpAdd,
+        OpSubtract,
+        OpMultiply,
+        OpDivide,
+        OpPower,
+        OpNegate,
+        OpAbs,
+        OpSqrt,
+        OpMinimum,
+        OpMaximum,
+        OpDerivative
+    };
+
+    struct Instruction {
+        int opcode;
+        int operand;
+        double constant;
+    };
+
+    struct Derivative {
+        double value;
+        double time;
+        bool valid;
+    };
+
+    bool parseSum();
+    bool parseProduct();
+    bool parseUnary();
+    bool parsePower();
+    bool parsePrimary();
+    bool parseCall(const QByteArray &name);
+    bool fail(const QString &message);
+    void skipSpace();
+
+    void emitConstant(double value);
+    void emitVariable(int variable);
+    void emitUnary(int opcode);
+    void emitBinary(int opcode);
+
+    QVector<Instruction> m_program;
+    QVector<Derivative> m_derivatives;
+    QVector<double> m_stack;
+    QString m_errorString;
+    quint32 m_variables = 0;
+
+    QByteArray m_text;
+    int m_position = 0;
+    int m_depth = 0;
+    int m_maximumDepth = 0;
+};
+
+#endif // EXPRESSION_H
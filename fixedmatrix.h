@@ -0,0 +1,105 @@
+#ifndef FIXEDMATRIX_H
+#define FIXEDMATRIX_H
+
+#include <QtGlobal>
+
+//
+// Small dense matrix with its dimensions fixed at compile time. Storage is
+// an inline array, so matrices live on the stack or inside their owner and
+// arithmetic never allocates; mismatched dimensions fail to compile.
+//
+template <int Rows, int Cols>
+class FixedMatrix
+{
+public:
+    FixedMatrix()
+    {
+        fill(0.0);
+    }
+
+    static FixedMatrix identity()
+    {
+        FixedMatrix result;
+        for (int i = 0; i < Rows && i < Cols; i++) {
+            result(i, i) = 1.0;
+        }
+        return result;
+    }
+
+    void fill(qreal value)
+    {
+        for (int r = 0; r < Rows; r++) {
+            for (int c = 0; c < Cols; c++) {
+                m_values[r][c] = value;
+            }
+        }
+    }
+
+    qreal &operator()(int row, int col) { return m_values[row][col]; }
+    qreal operator()(int row, int col) const { return m_values[row][col]; }
+
+    FixedMatrix<Cols, Rows> transposed() const
+    {
+        FixedMatrix<Cols, Rows> result;
+        for (int r = 0; r < Rows; r++) {
+            for (int c = 0; c < Cols; c++) {
+                result(c, r) = m_values[r][c];
+            }
+        }
+        return result;
+    }
+
+    FixedMatrix operator+(const FixedMatrix &other) const
+    {
+        FixedMatrix result;
+        for (int r = 0; r < Rows; r++) {
+            for (int c = 0; c < Cols; c++) {
+                result(r, c) = m_values[r][c] + other(r, c);
+            }
+        }
+        return result;
+    }
+
+    FixedMatrix operator-(const FixedMatrix &other) const
+    {
+        FixedMatrix result;
+        for (int r = 0; r < Rows; r++) {
+            for (int c = 0; c < Cols; c++) {
+                result(r, c) = m_values[r][c] - other(r, c);
+            }
+        }
+        return result;
+    }
+
+    FixedMatrix operator*(qreal scale) const
+    {
+        FixedMatrix result;
+        for (int r = 0; r < Rows; r++) {
+            for (int c = 0; c < Cols; c++) {
+                result(r, c) = m_values[r][c] * scale;
+            }
+        }
+        return result;
+    }
+
+    template <int OtherCols>
+    FixedMatrix<Rows, OtherCols> operator*(const FixedMatrix<Cols, OtherCols> &other) const
+    {
+        FixedMatrix<Rows, OtherCols> result;
+        for (int r = 0; r < Rows; r++) {
+            for (int c = 0; c < OtherCols; c++) {
+                qreal sum = 0.0;
+                for (int k = 0; k < Cols; k++) {
+                    sum += m_values[r][k] * other(k, c);
+                }
+                result(r, c) = sum;
+            }
+        }
+        return result;
+    }
+
+private:
+    qreal m_values[Rows][Cols];
+};
+
+#endif // FIXEDMATRIX_H
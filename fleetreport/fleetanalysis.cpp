@@ -0,0 +1,320 @@
+#include "fleetanalysis.h"
+
+#include "logreader.h"
+#include "packetdecoder.h"
+#include "rawcapture.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+
+#include <algorithm>
+#include <string.h>
+
+//
+// Samples further apart than this are a gap in the recording rather than
+// something to integrate over.
+//
+static const qreal MaximumStep = 10.0;
+
+static const int CaptureBufferSize = 65536;
+
+//
+// Accumulates the figures of one file from its samples in time order.
+// Discharge segments are integrated with the rectangle rule on the newer
+// sample of each step.
+//
+class DischargeTracker
+{
+public:
+    explicit DischargeTracker(FileSummary *summary) : m_summary(summary) {}
+
+    void add(qint64 timestamp, qreal volts, qreal amps, int mode, qreal celsius, const qreal *cellVolts);
+    void finish();
+
+private:
+    FileSummary *m_summary;
+    DischargeSegment m_segment = { 0, 0.0, 0.0 };
+    bool m_discharging = false;
+    qint64 m_previous = 0;
+    bool m_hasPrevious = false;
+};
+
+void DischargeTracker::add(qint64 timestamp, qreal volts, qreal amps, int mode, qreal celsius, const qreal *cellVolts)
+{
+    m_summary->samples++;
+    m_summary->maximumTemperature = qMax(m_summary->maximumTemperature, celsius);
+
+    //
+    // a cell reading zero isn't fitted
+    //
+    if (cellVolts != nullptr) {
+        qreal lowest = 0.0;
+        qreal highest = 0.0;
+        int fitted = 0;
+        for (int cell = 0; cell < 6; cell++) {
+            if (cellVolts[cell] == 0.0) {
+                continue;
+            }
+            lowest = (fitted == 0) ? cellVolts[cell] : qMin(lowest, cellVolts[cell]);
+            highest = (fitted == 0) ? cellVolts[cell] : qMax(highest, cellVolts[cell]);
+            fitted++;
+        }
+        if (fitted > 0) {
+            m_summary->maximumImbalance = qMax(m_summary->maximumImbalance, (highest - lowest) * 1000.0);
+        }
+    }
+
+    bool discharging = (mode == MODE_DISCHARGING || mode == MODE_LOAD_TEST);
+    if (discharging && !m_discharging) {
+        m_segment.start = timestamp;
+        m_segment.ampHours = 0.0;
+        m_segment.wattHours = 0.0;
+    }
+    else if (!discharging && m_discharging) {
+        finish();
+    }
+    m_discharging = discharging;
+
+    qreal step = static_cast<qreal>(timestamp - m_previous) / 1000000.0;
+    if (discharging && m_hasPrevious && step > 0.0 && step <= MaximumStep) {
+        m_segment.ampHours += amps * step / 3600.0;
+        m_segment.wattHours += volts * amps * step / 3600.0;
+    }
+
+    m_previous = timestamp;
+    m_hasPrevious = true;
+}
+
+void DischargeTracker::finish()
+{
+    if (m_discharging && m_segment.ampHours > 0.0) {
+        m_summary->discharges.append(m_segment);
+    }
+    m_discharging = false;
+}
+
+//
+// Captures hold the bytes exactly as read from the port; they are pushed
+// through the same decoder the application uses. Every frame completed
+// by a record gets that record's timestamp.
+//
+static bool analyzeCapture(QFile *file, FileSummary *summary)
+{
+    char header[RawCapture::HeaderSize];
+    if (file->read(header, sizeof(header)) != static_cast<qint64>(sizeof(header))) {
+        summary->errorString = QCoreApplication::translate("FleetReport", "Truncated capture header");
+        return false;
+    }
+
+    qint64 wallUSecs;
+    qint64 steadyNSecs;
+    memcpy(&wallUSecs, header + sizeof(RawCapture::Magic), sizeof(wallUSecs));
+    memcpy(&steadyNSecs, header + sizeof(RawCapture::Magic) + 8, sizeof(steadyNSecs));
+
+    QByteArray buffer(CaptureBufferSize, Qt::Uninitialized);
+    PacketDecoder decoder;
+    DischargeTracker tracker(summary);
+
+    while (true) {
+        char recordHeader[RawCapture::RecordHeaderSize];
+        if (file->read(recordHeader, sizeof(recordHeader)) != static_cast<qint64>(sizeof(recordHeader))) {
+            break;
+        }
+
+        qint64 steady;
+        quint32 length;
+        memcpy(&steady, recordHeader, sizeof(steady));
+        memcpy(&length, recordHeader + 8, sizeof(length));
+
+        qint64 timestamp = wallUSecs + (steady - steadyNSecs) / 1000;
+
+        while (length > 0) {
+            qint64 wanted = qMin(static_cast<qint64>(length), static_cast<qint64>(CaptureBufferSize));
+            qint64 read = file->read(buffer.data(), wanted);
+            if (read <= 0) {
+                length = 0;
+                break;
+            }
+            length -= static_cast<quint32>(read);
+
+            for (qint64 i = 0; i < read; i++) {
+                if (!decoder.push(buffer.at(static_cast<int>(i)))) {
+                    continue;
+                }
+
+                const status_packet_t &packet = decoder.packet();
+                qreal cellVolts[6];
+                for (int cell = 0; cell < 6; cell++) {
+                    cellVolts[cell] = static_cast<qreal>(packet.cell_voltage[cell]) / 1000.0;
+                }
+
+                tracker.add(timestamp,
+                            static_cast<qreal>(packet.pack_voltage) / 1000.0,
+                            qAbs(static_cast<qreal>(packet.current) / 1000.0),
+                            packet.mode,
+                            static_cast<qreal>(packet.temperature) / 1000.0,
+                            cellVolts);
+            }
+        }
+    }
+
+    tracker.finish();
+    return true;
+}
+
+//
+// Sessions are placed by the start time recorded in the log. Logs from
+// before it was recorded only carry the time of day, so those are placed
+// by the file's modification time, taken as the moment of the last line,
+// which copying the file or a clock change throws off; the summary warns
+// when that happens. Logs without a mode column are split into charge and
+// discharge by the direction the charge counter moves, as replay does.
+//
+static bool analyzeLog(const QString &fileName, FileSummary *summary)
+{
+    LogReader reader;
+    if (!reader.open(fileName)) {
+        summary->errorString = reader.errorString();
+        return false;
+    }
+
+    DischargeTracker tracker(summary);
+    LogRecord record;
+    qreal previousCharge = -1.0;
+    int inferredMode = MODE_DISCHARGING;
+    qreal lastElapsed = 0.0;
+
+    while (reader.readNext(&record)) {
+        int mode = record.mode;
+        if (mode < 0) {
+            if (previousCharge >= 0.0 && record.charge > previousCharge) {
+                inferredMode = MODE_CHARGING;
+            }
+            else if (previousCharge >= 0.0 && record.charge < previousCharge) {
+                inferredMode = MODE_DISCHARGING;
+            }
+            mode = inferredMode;
+        }
+        previousCharge = record.charge;
+        lastElapsed = record.elapsed;
+
+        qint64 timestamp = qRound64(record.elapsed * 1000000.0);
+        if (reader.hasStartTime()) {
+            timestamp += reader.startTime();
+        }
+
+        tracker.add(timestamp,
+                    record.voltage,
+                    qAbs(record.current),
+                    mode,
+                    record.temperature,
+                    reader.hasCellVoltages() ? record.cellVoltage : nullptr);
+    }
+
+    tracker.finish();
+
+    if (reader.hasStartTime()) {
+        return true;
+    }
+
+    summary->warningString = QCoreApplication::translate("FleetReport", "No start time in the log; placed by its modification time");
+
+    qint64 origin = QFileInfo(fileName).lastModified().toMSecsSinceEpoch() * 1000 - qRound64(lastElapsed * 1000000.0);
+    for (DischargeSegment &segment : summary->discharges) {
+        segment.start += origin;
+    }
+
+    return true;
+}
+
+FileSummary analyzeFile(const QString &fileName, const QString &packId)
+{
+    FileSummary summary;
+    summary.fileName = fileName;
+    summary.packId = packId;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        summary.errorString = file.errorString();
+        return summary;
+    }
+    summary.bytes = file.size();
+
+    char magic[sizeof(RawCapture::Magic)];
+    if (file.read(magic, sizeof(magic)) == static_cast<qint64>(sizeof(magic))
+            && memcmp(magic, RawCapture::Magic, sizeof(magic)) == 0) {
+        file.seek(0);
+        analyzeCapture(&file, &summary);
+    }
+    else {
+        file.close();
+        analyzeLog(fileName, &summary);
+    }
+
+    return summary;
+}
+
+PackSummary summarizePack(const QString &packId, const QVector<const FileSummary *> &files)
+{
+    PackSummary pack;
+    pack.packId = packId;
+
+    QVector<DischargeSegment> discharges;
+
+    for (const FileSummary *file : files) {
+        pack.files++;
+        if (!file->errorString.isEmpty()) {
+            pack.failedFiles++;
+            continue;
+        }
+
+        pack.samples += file->samples;
+        pack.maximumTemperature = qMax(pack.maximumTemperature, file->maximumTemperature);
+        pack.maximumImbalance = qMax(pack.maximumImbalance, file->maximumImbalance);
+        discharges += file->discharges;
+    }
+
+    std::sort(discharges.begin(), discharges.end(), [](const DischargeSegment &a, const DischargeSegment &b) {
+        return a.start < b.start;
+    });
+
+    for (const DischargeSegment &segment : discharges) {
+        pack.capacity = qMax(pack.capacity, segment.ampHours);
+        pack.energy += segment.wattHours;
+    }
+
+    //
+    // least-squares fit of capacity against cycle number, over the cycles
+    //
+    qreal sumX = 0.0;
+    qreal sumY = 0.0;
+    qreal sumXX = 0.0;
+    qreal sumXY = 0.0;
+
+    for (const DischargeSegment &segment : discharges) {
+        if (segment.ampHours < pack.capacity * 0.5) {
+            continue;
+        }
+
+        qreal x = pack.cycles;
+        sumX += x;
+        sumY += segment.ampHours;
+        sumXX += x * x;
+        sumXY += x * segment.ampHours;
+        pack.cycles++;
+    }
+
+    if (pack.cycles >= 3) {
+        qreal n = pack.cycles;
+        qreal slope = (n * sumXY - sumX * sumY) / (n * sumXX - sumX * sumX);
+        qreal initial = (sumY - slope * sumX) / n;
+        if (initial > 0.0) {
+            pack.fade = -slope * 100.0 / initial * 100.0;
+            pack.hasFade = true;
+        }
+    }
+
+    return pack;
+}
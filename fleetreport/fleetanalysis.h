@@ -0,0 +1,66 @@
+#ifndef FLEETANALYSIS_H
+#define FLEETANALYSIS_H
+
+#include <QString>
+#include <QVector>
+
+//
+// One uninterrupted discharge (or load test) found in a recording.
+//
+struct DischargeSegment
+{
+    qint64 start;                   // wall clock, microseconds since epoch
+    qreal ampHours;
+    qreal wattHours;
+};
+
+//
+// What one log or capture contributes to its pack's summary.
+//
+struct FileSummary
+{
+    QString fileName;
+    QString packId;
+    QString errorString;
+    QString warningString;
+    qint64 samples = 0;
+    qint64 bytes = 0;
+    QVector<DischargeSegment> discharges;
+    qreal maximumTemperature = -1000.0; // °C
+    qreal maximumImbalance = -1.0;  // mV, negative if no cell voltages
+};
+
+//
+// Per-pack row of the fleet report, merged from all of the pack's files.
+//
+struct PackSummary
+{
+    QString packId;
+    int files = 0;
+    int failedFiles = 0;
+    qint64 samples = 0;
+    int cycles = 0;
+    qreal capacity = 0.0;           // Ah, the largest discharge seen
+    qreal energy = 0.0;             // Wh discharged in total
+    qreal maximumTemperature = -1000.0; // °C
+    qreal maximumImbalance = -1.0;  // mV, negative if no cell voltages
+    qreal fade = 0.0;               // % of capacity per 100 cycles
+    bool hasFade = false;
+};
+
+//
+// Streams one data log or raw capture through fixed buffers, so memory
+// use doesn't depend on the file size. Safe to call from several threads
+// at once.
+//
+FileSummary analyzeFile(const QString &fileName, const QString &packId);
+
+//
+// Merges the file summaries of one pack. Discharges are ordered by start
+// time; a discharge delivering at least half the pack's capacity counts as
+// a cycle, and the fade trend is the least-squares slope of the cycles'
+// capacity over the cycle number.
+//
+PackSummary summarizePack(const QString &packId, const QVector<const FileSummary *> &files);
+
+#endif // FLEETANALYSIS_H
@@ -0,0 +1,32 @@
+#-------------------------------------------------
+#
+# Command-line fleet summary over a directory of data logs and raw
+# captures. Shares the decoder and readers with the application.
+#
+#-------------------------------------------------
+
+QT       = core
+
+TARGET = fleetreport
+TEMPLATE = app
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += ..
+
+SOURCES += \
+        main.cpp \
+    fleetanalysis.cpp \
+    ../logreader.cpp \
+    ../packetdecoder.cpp \
+    ../rawcapture.cpp
+
+HEADERS += \
+    fleetanalysis.h \
+    ../logreader.h \
+    ../packetdecoder.h \
+    ../rawcapture.h \
+    ../statuspacket.h
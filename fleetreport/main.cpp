@@ -0,0 +1,289 @@
+#include "fleetanalysis.h"
+
+#include <QAtomicInt>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QRegularExpression>
+#include <QRunnable>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+
+//
+// Batch summary of a directory of recordings, one row per pack:
+//
+//   fleetreport [-j threads] [-o report.csv] [--pack-pattern regex] <directory>
+//
+// Data logs (*.csv, *.txt) and raw captures (*.pbmcap, *.pbmcap.1) are
+// found recursively. A file belongs to the pack named by its directory
+// relative to the root, or by its base name when it sits in the root
+// itself; --pack-pattern takes the pack from the first capture group of a
+// match on the relative path instead.
+//
+
+struct InputFile
+{
+    QString fileName;
+    QString packId;
+    qint64 size;
+};
+
+//
+// Every worker takes the next file from a shared counter until none are
+// left, so a thread that drew small files keeps pulling work while
+// another is busy with a large one. Files are queued largest first, which
+// keeps one multi-gigabyte log from being the last thing running.
+//
+class AnalysisWorker : public QRunnable
+{
+public:
+    AnalysisWorker(const QVector<InputFile> *files, QVector<FileSummary> *results, QAtomicInt *next) :
+        m_files(files),
+        m_results(results),
+        m_next(next)
+    {
+    }
+
+    void run() override
+    {
+        while (true) {
+            int index = m_next->fetchAndAddRelaxed(1);
+            if (index >= m_files->count()) {
+                return;
+            }
+
+            const InputFile &file = m_files->at(index);
+            (*m_results)[index] = analyzeFile(file.fileName, file.packId);
+        }
+    }
+
+private:
+    const QVector<InputFile> *m_files;
+    QVector<FileSummary> *m_results;
+    QAtomicInt *m_next;
+};
+
+static QVector<InputFile> findFiles(const QString &root, const QRegularExpression &packPattern)
+{
+    QVector<InputFile> files;
+    QDir rootDir(root);
+
+    QStringList filters;
+    filters << "*.csv" << "*.txt" << "*.pbmcap" << "*.pbmcap.1";
+
+    QDirIterator it(root, filters, QDir::Files, QDirIterator::Subdirectories | QDirIterator::FollowSymlinks);
+    while (it.hasNext()) {
+        QString fileName = it.next();
+        QFileInfo info = it.fileInfo();
+        QString relative = rootDir.relativeFilePath(fileName);
+
+        InputFile file;
+        file.fileName = fileName;
+        file.size = info.size();
+
+        if (packPattern.isValid() && !packPattern.pattern().isEmpty()) {
+            QRegularExpressionMatch match = packPattern.match(relative);
+            file.packId = match.hasMatch() ? match.captured(match.lastCapturedIndex() > 0 ? 1 : 0) : QString();
+        }
+        else {
+            QString directory = QFileInfo(relative).path();
+            file.packId = (directory == ".") ? info.fileName().section('.', 0, 0) : directory;
+        }
+
+        if (file.packId.isEmpty()) {
+            continue;
+        }
+
+        files.append(file);
+    }
+
+    std::sort(files.begin(), files.end(), [](const InputFile &a, const InputFile &b) {
+        return a.size > b.size;
+    });
+
+    return files;
+}
+
+static QString formatNumber(qreal value, int precision, bool valid = true)
+{
+    return valid ? QString::number(value, 'f', precision) : QString("-");
+}
+
+static QStringList formatRow(const PackSummary &pack)
+{
+    QStringList row;
+    row << pack.packId
+        << QString::number(pack.files - pack.failedFiles)
+        << QString::number(pack.samples)
+        << QString::number(pack.cycles)
+        << formatNumber(pack.capacity, 3)
+        << formatNumber(pack.energy, 2)
+        << formatNumber(pack.maximumTemperature, 1, pack.samples > 0)
+        << formatNumber(pack.maximumImbalance, 0, pack.maximumImbalance >= 0.0)
+        << formatNumber(pack.fade, 2, pack.hasFade);
+    return row;
+}
+
+static void writeTable(QTextStream &out, const QVector<PackSummary> &packs)
+{
+    QVector<QStringList> rows;
+    rows.append(QStringList() << "pack" << "files" << "samples" << "cycles" << "capacity_Ah"
+                << "energy_Wh" << "max_temp_C" << "imbalance_mV" << "fade_pct_per_100");
+    for (const PackSummary &pack : packs) {
+        rows.append(formatRow(pack));
+    }
+
+    QVector<int> widths(rows.first().count(), 0);
+    for (const QStringList &row : rows) {
+        for (int c = 0; c < row.count(); c++) {
+            widths[c] = qMax(widths[c], row[c].length());
+        }
+    }
+
+    for (const QStringList &row : rows) {
+        for (int c = 0; c < row.count(); c++) {
+            if (c == 0) {
+                out << row[c].leftJustified(widths[c]);
+            }
+            else {
+                out << "  " << row[c].rightJustified(widths[c]);
+            }
+        }
+        out << '\n';
+    }
+}
+
+static void writeCsv(QTextStream &out, const QVector<PackSummary> &packs)
+{
+    out << "pack,files,samples,cycles,capacity_Ah,energy_Wh,max_temp_C,imbalance_mV,fade_pct_per_100\n";
+    for (const PackSummary &pack : packs) {
+        QStringList row = formatRow(pack);
+        for (QString &field : row) {
+            if (field == "-") {
+                field.clear();
+            }
+        }
+        out << row.join(',') << '\n';
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("fleetreport");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Summarises a directory of Battery Pack Analyzer logs and captures per pack.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("directory", "Directory searched recursively for logs and captures.");
+
+    QCommandLineOption threadsOption("j", "Number of worker threads (default: one per core).", "threads");
+    QCommandLineOption outputOption("o", "Write the summary as CSV to <file> instead of a table on stdout.", "file");
+    QCommandLineOption packPatternOption("pack-pattern", "Take the pack from the first capture group of <regex> matched against each relative path.", "regex");
+    parser.addOption(threadsOption);
+    parser.addOption(outputOption);
+    parser.addOption(packPatternOption);
+    parser.process(app);
+
+    QTextStream err(stderr);
+
+    if (parser.positionalArguments().count() != 1) {
+        parser.showHelp(1);
+    }
+
+    QString root = parser.positionalArguments().first();
+    if (!QFileInfo(root).isDir()) {
+        err << root << ": not a directory\n";
+        return 1;
+    }
+
+    QRegularExpression packPattern(parser.value(packPatternOption));
+    if (!packPattern.isValid()) {
+        err << "--pack-pattern: " << packPattern.errorString() << '\n';
+        return 1;
+    }
+
+    int threads = QThread::idealThreadCount();
+    if (parser.isSet(threadsOption)) {
+        bool ok = false;
+        threads = parser.value(threadsOption).toInt(&ok);
+        if (!ok || threads < 1) {
+            err << "-j: expected a positive number of threads\n";
+            return 1;
+        }
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QVector<InputFile> files = findFiles(root, packPattern);
+    if (files.isEmpty()) {
+        err << root << ": no logs or captures found\n";
+        return 1;
+    }
+
+    //
+    // results are written by index, so workers never contend for anything
+    // but the counter
+    //
+    QVector<FileSummary> results(files.count());
+    QAtomicInt next(0);
+    threads = qMin(threads, files.count());
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+    for (int t = 0; t < threads; t++) {
+        pool.start(new AnalysisWorker(&files, &results, &next));
+    }
+    pool.waitForDone();
+
+    QMap<QString, QVector<const FileSummary *>> byPack;
+    qint64 bytes = 0;
+
+    for (const FileSummary &result : results) {
+        byPack[result.packId].append(&result);
+        bytes += result.bytes;
+
+        if (!result.errorString.isEmpty()) {
+            err << result.fileName << ": " << result.errorString << '\n';
+        }
+        else if (!result.warningString.isEmpty()) {
+            err << result.fileName << ": warning: " << result.warningString << '\n';
+        }
+    }
+
+    QVector<PackSummary> packs;
+    for (auto it = byPack.constBegin(); it != byPack.constEnd(); ++it) {
+        packs.append(summarizePack(it.key(), it.value()));
+    }
+
+    if (parser.isSet(outputOption)) {
+        QFile output(parser.value(outputOption));
+        if (!output.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            err << output.fileName() << ": " << output.errorString() << '\n';
+            return 1;
+        }
+        QTextStream out(&output);
+        writeCsv(out, packs);
+    }
+    else {
+        QTextStream out(stdout);
+        writeTable(out, packs);
+    }
+
+    qreal seconds = static_cast<qreal>(timer.nsecsElapsed()) / 1000000000.0;
+    err << files.count() << " files, " << packs.count() << " packs, "
+        << QString::number(static_cast<qreal>(bytes) / 1048576.0, 'f', 1) << " MiB in "
+        << QString::number(seconds, 'f', 2) << " s on " << threads << " threads ("
+        << QString::number(static_cast<qreal>(bytes) / 1048576.0 / qMax(seconds, 0.001), 'f', 1) << " MiB/s)\n";
+
+    return 0;
+}
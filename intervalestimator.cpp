@@ -0,0 +1,90 @@
+#include "intervalestimator.h"
+
+//
+// EWMA weight of each new interval, and the number of intervals needed
+// before the estimate is trusted for gap detection.
+//
+static const qreal IntervalSmoothing = 0.125;
+static const int IntervalWarmup = 8;
+
+//
+// An interval longer than this many smoothed intervals is treated as a gap
+// caused by lost events and is not folded into the estimate.
+//
+static const qreal GapThreshold = 1.5;
+
+//
+// This many gaps in a row within GapTolerance of each other are a lasting
+// change of rate, not losses, and the estimate is re-seeded from them.
+//
+static const int GapReseed = 3;
+static const qreal GapTolerance = 0.2;
+
+//
+// Records events arriving together at timestamp and returns the number
+// of events that appear to have been lost since the previous arrival. The
+// gaps that reveal a slower rate are still counted before the estimate is
+// re-seeded; the rest of the new rate is not. lateness() is left at how
+// far an on-time arrival ran past the time its events account for, or
+// zero.
+//
+int IntervalEstimator::record(qint64 timestamp, int events)
+{
+    int lost = 0;
+    m_lateness = 0;
+
+    if (events < 1) {
+        return 0;
+    }
+
+    if (m_last >= 0) {
+        qreal interval = static_cast<qreal>(timestamp - m_last);
+        qreal expected = m_interval * events;
+
+        if (m_samples >= IntervalWarmup && interval > expected + m_interval * (GapThreshold - 1.0)) {
+            if (m_gapCount > 0 && qAbs(interval - m_gapInterval) <= m_gapInterval * GapTolerance) {
+                m_gapCount++;
+                m_gapInterval += (interval - m_gapInterval) / m_gapCount;
+            }
+            else {
+                m_gapCount = 1;
+                m_gapInterval = interval;
+            }
+
+            if (m_gapCount >= GapReseed) {
+                m_interval = m_gapInterval / events;
+                m_samples = 1;
+                m_gapCount = 0;
+            }
+            else {
+                lost = qMax(qRound(interval / m_interval) - events, 1);
+            }
+        }
+        else if (m_samples == 0) {
+            m_interval = interval / events;
+            m_samples += events;
+            m_gapCount = 0;
+        }
+        else {
+            if (m_samples >= IntervalWarmup && interval > expected) {
+                m_lateness = static_cast<qint64>(interval - expected);
+            }
+
+            m_interval += (interval / events - m_interval) * IntervalSmoothing;
+            m_samples += events;
+            m_gapCount = 0;
+        }
+    }
+
+    m_last = timestamp;
+    return lost;
+}
+
+void IntervalEstimator::reset()
+{
+    m_last = -1;
+    m_interval = 0.0;
+    m_samples = 0;
+    m_lateness = 0;
+    m_gapCount = 0;
+}
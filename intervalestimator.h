@@ -0,0 +1,36 @@
+#ifndef INTERVALESTIMATOR_H
+#define INTERVALESTIMATOR_H
+
+#include <QtGlobal>
+
+//
+// Smoothed interval between periodic events, such as decoded frames, and
+// the gap rule shared by the sample clock and the link statistics. Events
+// are recorded per arrival: all the frames completed by one read share its
+// timestamp, so they are recorded together, and the time since the
+// previous read is spread over them. Once warmed up, an arrival more than
+// half an interval later than its events account for is a gap; the events
+// it brought are subtracted from the ones the gap should have held, so a
+// stalled reader catching up isn't counted as losing frames. Gaps are not
+// folded in, unless a run of similar gaps shows that the rate itself has
+// changed, which re-seeds the estimate. O(1) and allocation-free.
+//
+class IntervalEstimator
+{
+public:
+    int record(qint64 timestamp, int events = 1);
+    void reset();
+
+    qreal interval() const { return m_interval; }
+    qint64 lateness() const { return m_lateness; }
+
+private:
+    qint64 m_last = -1;
+    qreal m_interval = 0.0;
+    int m_samples = 0;
+    qint64 m_lateness = 0;
+    qreal m_gapInterval = 0.0;
+    int m_gapCount = 0;
+};
+
+#endif // INTERVALESTIMATOR_H
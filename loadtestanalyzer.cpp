@@ -0,0 +1,264 @@
+#include "loadtestanalyzer.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QJsonArray>
+
+//
+// Segments shorter than this are treated as mode glitches and dropped.
+//
+static const qreal MinimumDuration = 10.0;
+
+//
+// Current change between consecutive samples that counts as a step for
+// the resistance estimate, and the longest interval integrated across;
+// longer gaps (lost packets, a stalled port) are skipped and counted.
+//
+static const qreal StepThreshold = 0.2;
+static const qreal MaximumInterval = 10.0;
+
+QJsonObject LoadTestReport::toJson() const
+{
+    QJsonObject json;
+    json["start"] = QDateTime::fromMSecsSinceEpoch(startTime / 1000).toString(Qt::ISODateWithMs);
+    json["end"] = QDateTime::fromMSecsSinceEpoch(endTime / 1000).toString(Qt::ISODateWithMs);
+    json["duration_s"] = duration();
+    json["samples"] = static_cast<double>(sampleCount);
+    json["gaps"] = gapCount;
+    json["capacity_c"] = capacity;
+    json["capacity_mah"] = capacity / 3.6;
+    json["energy_wh"] = energy / 3600.0;
+    json["average_voltage_v"] = averageVoltage;
+    json["minimum_voltage_v"] = minimumVoltage;
+    json["average_current_a"] = averageCurrent;
+    json["peak_current_a"] = peakCurrent;
+    json["maximum_temperature_c"] = maximumTemperature;
+
+    QJsonObject resistanceJson;
+    resistanceJson["steps"] = stepCount;
+    if (stepCount > 0) {
+        resistanceJson["mean_mohm"] = resistance * 1000.0;
+        resistanceJson["min_mohm"] = minimumResistance * 1000.0;
+        resistanceJson["max_mohm"] = maximumResistance * 1000.0;
+    }
+    json["internal_resistance"] = resistanceJson;
+
+    QJsonArray cellsJson;
+    for (int i = 0; i < cells; i++) {
+        QJsonObject cell;
+        cell["cell"] = i + 1;
+        cell["start_voltage_v"] = cellStartVoltage[i];
+        cell["minimum_voltage_v"] = cellMinimumVoltage[i];
+        cell["sag_v"] = cellSag[i];
+        if (stepCount > 0) {
+            cell["resistance_mohm"] = cellResistance[i] * 1000.0;
+        }
+        cellsJson.append(cell);
+    }
+    json["cells"] = cellsJson;
+
+    return json;
+}
+
+QString LoadTestReport::toHtml() const
+{
+    QString html;
+
+    html += QCoreApplication::translate("LoadTestReport", "<h3>Load Test Report</h3>");
+    html += QCoreApplication::translate("LoadTestReport", "<p>%1 to %2 (%3 min, %4 samples)</p>")
+            .arg(QDateTime::fromMSecsSinceEpoch(startTime / 1000).toString("yyyy-MM-dd h:mm:ss AP"))
+            .arg(QDateTime::fromMSecsSinceEpoch(endTime / 1000).toString("h:mm:ss AP"))
+            .arg(duration() / 60.0, 0, 'f', 1)
+            .arg(sampleCount);
+
+    html += "<table>";
+    html += QCoreApplication::translate("LoadTestReport", "<tr><td>Capacity</td><td>%1 mAh (%2 C)</td></tr>")
+            .arg(capacity / 3.6, 0, 'f', 0).arg(capacity, 0, 'f', 0);
+    html += QCoreApplication::translate("LoadTestReport", "<tr><td>Energy</td><td>%1 Wh</td></tr>")
+            .arg(energy / 3600.0, 0, 'f', 2);
+    html += QCoreApplication::translate("LoadTestReport", "<tr><td>Voltage</td><td>%1 V average, %2 V minimum</td></tr>")
+            .arg(averageVoltage, 0, 'f', 2).arg(minimumVoltage, 0, 'f', 2);
+    html += QCoreApplication::translate("LoadTestReport", "<tr><td>Current</td><td>%1 A average, %2 A peak</td></tr>")
+            .arg(averageCurrent, 0, 'f', 2).arg(peakCurrent, 0, 'f', 2);
+    html += QCoreApplication::translate("LoadTestReport", "<tr><td>Temperature</td><td>%1 C maximum</td></tr>")
+            .arg(maximumTemperature, 0, 'f', 1);
+    if (stepCount > 0) {
+        html += QCoreApplication::translate("LoadTestReport", "<tr><td>Internal resistance</td><td>%1 mOhm (%2 to %3, %4 steps)</td></tr>")
+                .arg(resistance * 1000.0, 0, 'f', 0)
+                .arg(minimumResistance * 1000.0, 0, 'f', 0)
+                .arg(maximumResistance * 1000.0, 0, 'f', 0)
+                .arg(stepCount);
+    }
+    else {
+        html += QCoreApplication::translate("LoadTestReport", "<tr><td>Internal resistance</td><td>no current steps</td></tr>");
+    }
+    html += "</table>";
+
+    html += QCoreApplication::translate("LoadTestReport", "<p><table><tr><th>Cell</th><th>Start</th><th>Minimum</th><th>Sag</th><th>Resistance</th></tr>");
+    for (int i = 0; i < cells; i++) {
+        html += QString("<tr><td>%1</td><td>%2 V</td><td>%3 V</td><td>%4 mV</td><td>%5</td></tr>")
+                .arg(i + 1)
+                .arg(cellStartVoltage[i], 0, 'f', 3)
+                .arg(cellMinimumVoltage[i], 0, 'f', 3)
+                .arg(cellSag[i] * 1000.0, 0, 'f', 0)
+                .arg(stepCount > 0 ? QString("%1 mOhm").arg(cellResistance[i] * 1000.0, 0, 'f', 0) : QString("-"));
+    }
+    html += "</table></p>";
+
+    return html;
+}
+
+LoadTestAnalyzer::LoadTestAnalyzer()
+{
+    reset();
+}
+
+//
+// Returns true when this sample ended a load-test segment and report()
+// holds its results.
+//
+bool LoadTestAnalyzer::push(const Sample &sample)
+{
+    if (sample.mode == MODE_LOAD_TEST) {
+        if (!m_running) {
+            begin(sample);
+        }
+        else {
+            accumulate(sample);
+        }
+        return false;
+    }
+
+    return finish();
+}
+
+//
+// Closes the segment in progress, e.g. when the pack goes quiet in the
+// middle of a test. Returns true if it was long enough to report.
+//
+bool LoadTestAnalyzer::finish()
+{
+    if (!m_running) {
+        return false;
+    }
+
+    m_running = false;
+
+    LoadTestReport &report = m_report;
+    qreal duration = report.duration();
+    if (duration < MinimumDuration || report.sampleCount < 2) {
+        return false;
+    }
+
+    if (m_integratedTime > 0.0) {
+        report.averageVoltage = m_voltageTime / m_integratedTime;
+        report.averageCurrent = report.capacity / m_integratedTime;
+    }
+
+    if (report.stepCount > 0) {
+        report.resistance = m_resistanceSum / report.stepCount;
+        for (int i = 0; i < report.cells; i++) {
+            report.cellResistance[i] = m_cellResistanceSum[i] / report.stepCount;
+        }
+    }
+
+    for (int i = 0; i < report.cells; i++) {
+        report.cellSag[i] = report.cellStartVoltage[i] - report.cellMinimumVoltage[i];
+    }
+
+    return true;
+}
+
+void LoadTestAnalyzer::reset()
+{
+    m_running = false;
+    m_report = LoadTestReport();
+}
+
+void LoadTestAnalyzer::begin(const Sample &sample)
+{
+    m_report = LoadTestReport();
+    m_running = true;
+    m_previous = sample;
+    m_voltageTime = 0.0;
+    m_integratedTime = 0.0;
+    m_resistanceSum = 0.0;
+
+    LoadTestReport &report = m_report;
+    report.startTime = sample.timestamp;
+    report.endTime = sample.timestamp;
+    report.sampleCount = 1;
+    report.minimumVoltage = sample.volts();
+    report.peakCurrent = sample.amps();
+    report.maximumTemperature = sample.celsius();
+
+    for (int i = 0; i < LoadTestReport::CellCount; i++) {
+        if (sample.cellVoltage[i] != 0) {
+            report.cells = i + 1;
+        }
+        report.cellStartVoltage[i] = sample.cellVolts(i);
+        report.cellMinimumVoltage[i] = sample.cellVolts(i);
+        report.cellSag[i] = 0.0;
+        report.cellResistance[i] = 0.0;
+        m_cellResistanceSum[i] = 0.0;
+    }
+}
+
+void LoadTestAnalyzer::accumulate(const Sample &sample)
+{
+    LoadTestReport &report = m_report;
+    const Sample &previous = m_previous;
+
+    qreal dt = static_cast<qreal>(sample.timestamp - previous.timestamp) / 1000000.0;
+
+    if (dt > MaximumInterval) {
+        report.gapCount++;
+    }
+    else if (dt > 0.0) {
+        qreal current = (sample.amps() + previous.amps()) / 2.0;
+        qreal voltage = (sample.volts() + previous.volts()) / 2.0;
+        qreal power = ((sample.volts() * sample.amps()) + (previous.volts() * previous.amps())) / 2.0;
+
+        report.capacity += current * dt;
+        report.energy += power * dt;
+        m_voltageTime += voltage * dt;
+        m_integratedTime += dt;
+    }
+
+    //
+    // a current step between consecutive samples gives R = -dV/dI for the
+    // pack and for every cell; across a gap the voltage has had time to
+    // relax and the ratio means nothing
+    //
+    qreal deltaCurrent = sample.amps() - previous.amps();
+    if (dt <= MaximumInterval && qAbs(deltaCurrent) >= StepThreshold) {
+        qreal resistance = -(sample.volts() - previous.volts()) / deltaCurrent;
+
+        if (report.stepCount == 0) {
+            report.minimumResistance = resistance;
+            report.maximumResistance = resistance;
+        }
+        else {
+            report.minimumResistance = qMin(report.minimumResistance, resistance);
+            report.maximumResistance = qMax(report.maximumResistance, resistance);
+        }
+
+        m_resistanceSum += resistance;
+        for (int i = 0; i < report.cells; i++) {
+            m_cellResistanceSum[i] += -(sample.cellVolts(i) - previous.cellVolts(i)) / deltaCurrent;
+        }
+        report.stepCount++;
+    }
+
+    report.endTime = sample.timestamp;
+    report.sampleCount++;
+    report.minimumVoltage = qMin(report.minimumVoltage, sample.volts());
+    report.peakCurrent = qMax(report.peakCurrent, sample.amps());
+    report.maximumTemperature = qMax(report.maximumTemperature, sample.celsius());
+
+    for (int i = 0; i < report.cells; i++) {
+        report.cellMinimumVoltage[i] = qMin(report.cellMinimumVoltage[i], sample.cellVolts(i));
+    }
+
+    m_previous = sample;
+}
@@ -0,0 +1,78 @@
+#ifndef LOADTESTANALYZER_H
+#define LOADTESTANALYZER_H
+
+#include "sample.h"
+
+#include <QString>
+#include <QJsonObject>
+
+//
+// Results for one load-test segment. Capacity and energy are integrated
+// with the trapezoid rule; internal resistance is the mean of -dV/dI over
+// every current step larger than the analyzer's step threshold.
+//
+struct LoadTestReport
+{
+    static const int CellCount = 6;
+
+    qint64 startTime = 0;           // wall clock µs
+    qint64 endTime = 0;             // wall clock µs
+    qint64 sampleCount = 0;
+    int gapCount = 0;
+
+    qreal capacity = 0.0;           // C
+    qreal energy = 0.0;             // J
+    qreal averageVoltage = 0.0;     // V, time weighted
+    qreal minimumVoltage = 0.0;     // V
+    qreal averageCurrent = 0.0;     // A, time weighted
+    qreal peakCurrent = 0.0;        // A
+    qreal maximumTemperature = 0.0; // °C
+
+    int stepCount = 0;
+    qreal resistance = 0.0;         // Ω, pack
+    qreal minimumResistance = 0.0;
+    qreal maximumResistance = 0.0;
+
+    int cells = 0;
+    qreal cellStartVoltage[CellCount] = {};
+    qreal cellMinimumVoltage[CellCount] = {};
+    qreal cellSag[CellCount] = {};  // V, start minus minimum
+    qreal cellResistance[CellCount] = {}; // Ω, from the same current steps
+
+    qreal duration() const { return static_cast<qreal>(endTime - startTime) / 1000000.0; }
+    QJsonObject toJson() const;
+    QString toHtml() const;
+};
+
+//
+// Detects MODE_LOAD_TEST segments in the live sample stream and analyses
+// them incrementally: every sample updates running sums in O(1), so the
+// report is complete the moment the pack leaves load-test mode, however
+// long the test ran.
+//
+class LoadTestAnalyzer
+{
+public:
+    LoadTestAnalyzer();
+
+    bool push(const Sample &sample);
+    bool finish();
+    void reset();
+
+    bool isRunning() const { return m_running; }
+    const LoadTestReport &report() const { return m_report; }
+
+private:
+    void begin(const Sample &sample);
+    void accumulate(const Sample &sample);
+
+    LoadTestReport m_report;
+    bool m_running = false;
+    Sample m_previous;
+    qreal m_voltageTime = 0.0;      // ∫V dt
+    qreal m_integratedTime = 0.0;   // s, excluding gaps
+    qreal m_resistanceSum = 0.0;
+    qreal m_cellResistanceSum[LoadTestReport::CellCount];
+};
+
+#endif // LOADTESTANALYZER_H
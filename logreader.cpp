@@ -0,0 +1,315 @@
+#include "logreader.h"
+
+#include <QCoreApplication>
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *s_columnNames[] = {
+    "elapsed",
+    "voltage",
+    "current",
+    "charge",
+    "temperature",
+    "soc",
+    "resistance",
+    "mode",
+    "cell1",
+    "cell2",
+    "cell3",
+    "cell4",
+    "cell5",
+    "cell6"
+};
+
+//
+// Splits a comma separated line in place and returns the number of fields.
+//
+static int splitFields(char *line, char **fields, int maximum)
+{
+    int count = 0;
+    char *field = line;
+
+    while (count < maximum) {
+        fields[count++] = field;
+
+        char *comma = strchr(field, ',');
+        if (comma == nullptr) {
+            break;
+        }
+
+        *comma = '\0';
+        field = comma + 1;
+    }
+
+    return count;
+}
+
+//
+// Seconds since midnight from an h:mm:ss AP time of day, as written by
+// legacy logs, or -1 if the field isn't one. Without AM/PM the hours are
+// taken as 24-hour.
+//
+static int parseTimeOfDay(const char *field)
+{
+    int hours = 0;
+    int minutes = 0;
+    int seconds = 0;
+    char suffix[3] = {};
+
+    int count = sscanf(field, "%d:%d:%d %2s", &hours, &minutes, &seconds, suffix);
+    if (count < 3 || minutes < 0 || minutes > 59 || seconds < 0 || seconds > 60) {
+        return -1;
+    }
+
+    if (count == 4) {
+        char meridiem = static_cast<char>(toupper(static_cast<unsigned char>(suffix[0])));
+        if ((meridiem != 'A' && meridiem != 'P') || toupper(static_cast<unsigned char>(suffix[1])) != 'M'
+                || hours < 1 || hours > 12) {
+            return -1;
+        }
+
+        hours %= 12;
+        if (meridiem == 'P') {
+            hours += 12;
+        }
+    }
+    else if (hours < 0 || hours > 23) {
+        return -1;
+    }
+
+    return hours * 3600 + minutes * 60 + seconds;
+}
+
+LogReader::LogReader()
+{
+}
+
+bool LogReader::open(const QString &fileName)
+{
+    close();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+
+    //
+    // the first line that isn't a comment must be the header
+    //
+    while (true) {
+        qint64 position = m_file.pos();
+        qint64 length = m_file.readLine(m_line, LineSize);
+        if (length <= 0) {
+            m_errorString = QCoreApplication::translate("LogReader", "No header found");
+            m_file.close();
+            return false;
+        }
+
+        if (m_line[0] == '#') {
+            parseComment(m_line);
+            continue;
+        }
+
+        if (parseHeader(m_line)) {
+            return true;
+        }
+
+        //
+        // no header, but a legacy data line; it is read again as data
+        //
+        if (m_fieldCount == LegacyFields && parseTimeOfDay(m_line) >= 0) {
+            startLegacy();
+            m_file.seek(position);
+            return true;
+        }
+
+        m_errorString = QCoreApplication::translate("LogReader", "Not a data log");
+        m_file.close();
+        return false;
+    }
+}
+
+bool LogReader::readNext(LogRecord *record)
+{
+    char *fields[MaximumFields];
+
+    while (m_file.isOpen()) {
+        qint64 length = m_file.readLine(m_line, LineSize);
+        if (length <= 0) {
+            return false;
+        }
+
+        if (m_line[0] == '#') {
+            parseComment(m_line);
+            continue;
+        }
+
+        if (m_line[0] == '\n' || m_line[0] == '\r') {
+            continue;
+        }
+
+        int count = splitFields(m_line, fields, MaximumFields);
+        if (count < m_fieldCount) {
+            m_skippedLines++;
+            continue;
+        }
+
+        qreal values[ColumnCount];
+        bool valid = true;
+
+        for (int i = 0; i < ColumnCount; i++) {
+            values[i] = 0.0;
+
+            if (m_columns[i] < 0) {
+                continue;
+            }
+
+            char *end = nullptr;
+            values[i] = strtod(fields[m_columns[i]], &end);
+            if (end == fields[m_columns[i]]) {
+                valid = false;
+                break;
+            }
+        }
+
+        if (!valid) {
+            m_skippedLines++;
+            continue;
+        }
+
+        if (m_legacy) {
+            int timeOfDay = parseTimeOfDay(fields[0]);
+            if (timeOfDay < 0) {
+                m_skippedLines++;
+                continue;
+            }
+
+            if (m_legacyOrigin < 0) {
+                m_legacyOrigin = timeOfDay;
+            }
+            else if (timeOfDay + SecondsPerDay / 2 < m_legacyPrevious) {
+                m_legacyDays++;
+            }
+            m_legacyPrevious = timeOfDay;
+
+            values[ColumnElapsed] = static_cast<qreal>(m_legacyDays * SecondsPerDay + timeOfDay - m_legacyOrigin);
+        }
+
+        record->elapsed = values[ColumnElapsed];
+        record->voltage = values[ColumnVoltage];
+        record->current = values[ColumnCurrent];
+        record->charge = values[ColumnCharge];
+        record->temperature = values[ColumnTemperature];
+        record->stateOfCharge = values[ColumnStateOfCharge];
+        record->resistance = values[ColumnResistance];
+        record->mode = (m_columns[ColumnMode] >= 0) ? static_cast<int>(values[ColumnMode]) : -1;
+        for (int cell = 0; cell < 6; cell++) {
+            record->cellVoltage[cell] = values[ColumnCell1 + cell];
+        }
+        return true;
+    }
+
+    return false;
+}
+
+void LogReader::close()
+{
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+
+    m_fieldCount = 0;
+    m_skippedLines = 0;
+    m_errorString.clear();
+    m_startTime = -1;
+    m_firstStartTime = -1;
+    m_legacy = false;
+    m_legacyOrigin = -1;
+    m_legacyPrevious = 0;
+    m_legacyDays = 0;
+}
+
+bool LogReader::parseHeader(char *line)
+{
+    char *fields[MaximumFields];
+
+    line[strcspn(line, "\r\n")] = '\0';
+    m_fieldCount = splitFields(line, fields, MaximumFields);
+
+    for (int i = 0; i < ColumnCount; i++) {
+        m_columns[i] = -1;
+
+        for (int f = 0; f < m_fieldCount; f++) {
+            if (strcmp(fields[f], s_columnNames[i]) == 0) {
+                m_columns[i] = f;
+                break;
+            }
+        }
+    }
+
+    //
+    // elapsed and voltage are the minimum for anything useful
+    //
+    return m_columns[ColumnElapsed] >= 0 && m_columns[ColumnVoltage] >= 0;
+}
+
+//
+// "# start <microseconds since epoch> <ISO 8601>"; the other comments are
+// for people reading the log.
+//
+void LogReader::parseComment(const char *line)
+{
+    static const char StartComment[] = "# start ";
+
+    if (strncmp(line, StartComment, sizeof(StartComment) - 1) != 0) {
+        return;
+    }
+
+    const char *field = line + sizeof(StartComment) - 1;
+    char *end = nullptr;
+    long long startTime = strtoll(field, &end, 10);
+    if (end != field && startTime >= 0) {
+        m_startTime = static_cast<qint64>(startTime);
+        if (m_firstStartTime < 0) {
+            m_firstStartTime = m_startTime;
+        }
+    }
+}
+
+//
+// Seconds from the first session start in the log to that of the line
+// last read; zero for logs without start times.
+//
+qreal LogReader::startOffset() const
+{
+    if (m_firstStartTime < 0) {
+        return 0.0;
+    }
+
+    return static_cast<qreal>(m_startTime - m_firstStartTime) / 1000000.0;
+}
+
+//
+// Legacy lines are time,voltage,current,charge,temperature; elapsed is
+// derived from the time column in readNext().
+//
+void LogReader::startLegacy()
+{
+    for (int i = 0; i < ColumnCount; i++) {
+        m_columns[i] = -1;
+    }
+
+    m_columns[ColumnVoltage] = 1;
+    m_columns[ColumnCurrent] = 2;
+    m_columns[ColumnCharge] = 3;
+    m_columns[ColumnTemperature] = 4;
+    m_fieldCount = LegacyFields;
+    m_legacy = true;
+    m_legacyOrigin = -1;
+    m_legacyPrevious = 0;
+    m_legacyDays = 0;
+}
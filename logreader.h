@@ -0,0 +1,98 @@
+#ifndef LOGREADER_H
+#define LOGREADER_H
+
+#include <QFile>
+#include <QString>
+
+//
+// One data line of a recorded log.
+//
+struct LogRecord
+{
+    qreal elapsed = 0.0;            // s since the session started
+    qreal voltage = 0.0;            // V
+    qreal current = 0.0;            // A
+    qreal charge = 0.0;             // C
+    qreal temperature = 0.0;        // °C
+    qreal stateOfCharge = 0.0;      // %, 0 if the log predates estimates
+    qreal resistance = 0.0;         // mΩ, 0 if the log predates estimates
+    int mode = -1;                  // MODE_*, -1 if the log predates it
+    qreal cellVoltage[6] = {};      // V, 0 if the log predates them
+};
+
+//
+// Streaming reader for the CSV data logs written by the main window. The
+// header line maps columns by name, so older logs without the estimate,
+// mode or cell columns still read; "#" comment lines (dropped samples, gaps)
+// and malformed lines are skipped. Lines are read into a fixed buffer, so
+// a multi-hour log is processed in constant memory.
+//
+// Logs written since the start time was recorded carry a "# start" comment
+// with the session's wall clock start, which elapsed counts from; it is
+// written again wherever the session was cleared mid-log, so startTime()
+// is that of the line last read, and elapsed + startOffset() keeps
+// counting from the first session across such resets.
+//
+// The first releases wrote headerless time,voltage,current,charge,
+// temperature lines with only an h:mm:ss AP time of day. Those are read
+// as legacy logs: elapsed is counted from the first line's time of day,
+// a day is added whenever the time goes back by more than half a day
+// (midnight), and resolution is one second.
+//
+class LogReader
+{
+public:
+    LogReader();
+
+    bool open(const QString &fileName);
+    bool readNext(LogRecord *record);
+    void close();
+
+    bool isOpen() const { return m_file.isOpen(); }
+    bool isLegacy() const { return m_legacy; }
+    bool hasStartTime() const { return m_startTime >= 0; }
+    qint64 startTime() const { return m_startTime; }
+    qreal startOffset() const;
+    bool hasCellVoltages() const { return m_columns[ColumnCell1] >= 0; }
+    QString errorString() const { return m_errorString; }
+    qint64 skippedLines() const { return m_skippedLines; }
+
+private:
+    enum Column {
+        ColumnElapsed = 0,
+        ColumnVoltage,
+        ColumnCurrent,
+        ColumnCharge,
+        ColumnTemperature,
+        ColumnStateOfCharge,
+        ColumnResistance,
+        ColumnMode,
+        ColumnCell1,
+        ColumnCount = ColumnCell1 + 6
+    };
+
+    static const int LineSize = 512;
+    static const int MaximumFields = 32;
+    static const int LegacyFields = 5;
+    static const int SecondsPerDay = 86400;
+
+    bool parseHeader(char *line);
+    void parseComment(const char *line);
+    void startLegacy();
+
+    QFile m_file;
+    char m_line[LineSize];
+    int m_columns[ColumnCount];
+    int m_fieldCount = 0;
+    qint64 m_skippedLines = 0;
+    QString m_errorString;
+    qint64 m_startTime = -1;        // wall clock, microseconds since epoch
+    qint64 m_firstStartTime = -1;
+
+    bool m_legacy = false;
+    int m_legacyOrigin = -1;        // s since midnight of the first line
+    int m_legacyPrevious = 0;       // s since midnight of the last line
+    int m_legacyDays = 0;
+};
+
+#endif // LOGREADER_H
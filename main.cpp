@@ -1,14 +1,65 @@
 #include "mainwindow.h"
+#include "startuptrace.h"
+#include "reportrenderer.h"
+#include "sessionsnapshot.h"
 #include <QApplication>
 #include <QStyleFactory>
 
+#include <stdio.h>
+#include <string.h>
+
+//
+// --report <file> [--snapshot <file>] renders a session report without
+// opening the window, for scheduled or remote runs.
+//
+static int renderReport(const QString &fileName, const QString &snapshotFileName)
+{
+    ReportOptions options;
+    options.fileName = fileName;
+
+    ReportResult result = ReportRenderer::render(snapshotFileName, options);
+    if (!result.isValid()) {
+        fprintf(stderr, "%s\n", qPrintable(result.errorString));
+        return 1;
+    }
+
+    printf("%s: %lld samples in %lld ms\n", qPrintable(result.fileName), result.samples, result.elapsed);
+    return 0;
+}
+
 int main(int argc, char *argv[])
 {
+    StartupTrace::start();
+
     QApplication::setOrganizationName("Robin Gingras");
     QApplication::setOrganizationDomain("robingingras.com");
     QApplication::setApplicationName("Battery Pack Analyzer");
 
+    const char *reportFileName = nullptr;
+    const char *snapshotFileName = nullptr;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--report") == 0) {
+            reportFileName = argv[++i];
+        }
+        else if (strcmp(argv[i], "--snapshot") == 0) {
+            snapshotFileName = argv[++i];
+        }
+    }
+
+    //
+    // no display is needed to paint into an image or a PDF
+    //
+    if (reportFileName != nullptr && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
     QApplication a(argc, argv);
+    StartupTrace::mark("applicationCreated");
+
+    if (reportFileName != nullptr) {
+        return renderReport(QString::fromLocal8Bit(reportFileName),
+                            snapshotFileName != nullptr ? QString::fromLocal8Bit(snapshotFileName) : SessionSnapshot::defaultPath());
+    }
 
     MainWindow w;
     w.show();
@@ -3,10 +3,15 @@
 #include "selectserialportdialog.h"
 #include "settingsdialog.h"
 #include "aboutdialog.h"
+#include "derivedchannelsdialog.h"
 #include "statuspacket.h"
+#include "allocationcounter.h"
+#include "startuptrace.h"
+#include "diagnostics.h"
 
 #include <math.h>
 #include <QApplication>
+#include <QAbstractEventDispatcher>
 #include <QDebug>
 #include <QMessageBox>
 #include <QAbstractButton>
@@ -15,21 +20,109 @@
 #include <QDateTime>
 #include <QColorDialog>
 #include <QSettings>
+#include <QStandardPaths>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QtConcurrent/QtConcurrentRun>
 
 #include <QtCharts/QChartView>
 
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+//
+// Unit conversion tables, indexed by the ChargeUnit and TemperatureUnit
+// enums. These are resolved once whenever the unit settings change so the
+// per-packet path only has to multiply by a cached factor.
+//
+struct ChargeUnitInfo {
+    const char *key;
+    qreal scale;
+    const char *suffix;
+    const char *axisTitle;
+    qreal axisMax;
+    qreal axisMinimumSpan;
+};
+
+struct TemperatureUnitInfo {
+    const char *key;
+    qreal scale;
+    qreal offset;
+    const char *suffix;
+    const char *axisTitle;
+    qreal axisMin;
+    qreal axisMax;
+    qreal axisMinimumSpan;
+};
+
+static const ChargeUnitInfo s_chargeUnits[] = {
+    { "coulomb", 1.0, "C", QT_TRANSLATE_NOOP("MainWindow", "Charge (C)"), 11520.0, 10.0 },
+    { "amphour", 1.0 / 3600.0, "Ah", QT_TRANSLATE_NOOP("MainWindow", "Charge (Ah)"), 3.2, 0.01 }
+};
+
+static const TemperatureUnitInfo s_temperatureUnits[] = {
+    { "celsius", 1.0, 0.0, "C", QT_TRANSLATE_NOOP("MainWindow", "Temperature (C)"), 18.0, 100.0, 2.0 },
+    { "farenheit", 9.0 / 5.0, 32.0, "F", QT_TRANSLATE_NOOP("MainWindow", "Temperature (F)"), 64.4, 212.0, 3.6 }
+};
+
+//
+// CPU time consumed by the whole process so far, in microseconds. Used to
+// compare the cost of the plot backends.
+//
+static qint64 processCpuTime()
+{
+#ifdef Q_OS_WIN
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+        return 0;
+    }
+
+    ULARGE_INTEGER kernel, user;
+    kernel.LowPart = kernelTime.dwLowDateTime;
+    kernel.HighPart = kernelTime.dwHighDateTime;
+    user.LowPart = userTime.dwLowDateTime;
+    user.HighPart = userTime.dwHighDateTime;
+
+    return static_cast<qint64>((kernel.QuadPart + user.QuadPart) / 10);
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+
+    return (static_cast<qint64>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000)
+            + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+#endif
+}
+
+//
+// Formats a wall clock time as "h:mm:ss AP" into a caller-supplied buffer,
+// matching QDateTime::toString("h:mm:ss AP") without allocating.
+//
+static int formatClockTime(char *buffer, int size, const QTime &time)
+{
+    int hour = time.hour() % 12;
+    if (hour == 0) hour = 12;
+
+    return qsnprintf(
+                buffer,
+                static_cast<size_t>(size),
+                "%d:%02d:%02d %s",
+                hour,
+                time.minute(),
+                time.second(),
+                time.hour() < 12 ? "AM" : "PM");
+}
+
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::MainWindow)
 {
-    bool dotest = false;
-
-    QSettings settings;
-
-    QColor defaultColor_voltage(Qt::red);
-    QColor defaultColor_current(Qt::blue);
-    QColor defaultColor_charge(Qt::green);
-    QColor defaultColor_temperature(Qt::yellow);
+    m_config = AppConfig::load();
 
     ui->setupUi(this);
 
@@ -53,88 +146,174 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(m_waitingMessageBox, &QMessageBox::buttonClicked, this, &MainWindow::on_waitingMessageBoxButtonClicked);
 
     m_sleepTimer = new QTimer(this);
-    m_sleepTimer->setInterval(2000);
+    m_sleepTimer->setInterval(SleepTimeout);
     m_sleepTimer->setSingleShot(true);
     connect(m_sleepTimer, &QTimer::timeout, this, &MainWindow::on_sleepTimerTimeout);
 
+    m_idleTimer = new QTimer(this);
+    m_idleTimer->setInterval(IdleDelay);
+    m_idleTimer->setSingleShot(true);
+    connect(m_idleTimer, &QTimer::timeout, this, &MainWindow::on_idleTimer_timeout);
+
     m_chartUpdateTimer = new QTimer(this);
     m_chartUpdateTimer->setInterval(1000);
     m_chartUpdateTimer->setSingleShot(false);
     connect(m_chartUpdateTimer, &QTimer::timeout, this, &MainWindow::on_chartUpdateTimer_timeout);
 
+    m_diagnosticsTimer = new QTimer(this);
+    m_diagnosticsTimer->setInterval(10000);
+    m_diagnosticsTimer->setSingleShot(false);
+    connect(m_diagnosticsTimer, &QTimer::timeout, this, &MainWindow::on_diagnosticsTimer_timeout);
+
+    m_portManager = new PortManager(this);
+    m_serialPort = m_portManager->port();
+
+    m_serialSource = new SerialPacketSource(m_portManager, &m_sampleClock, this);
+    connect(m_serialSource, &PacketSource::readyRead, this, &MainWindow::on_packetSourceReadyRead);
+    connect(m_serialSource, &PacketSource::opened, this, &MainWindow::on_packetSourceOpened);
+    connect(m_serialSource, &PacketSource::lost, this, &MainWindow::on_packetSourceLost);
+    m_packetSource = m_serialSource;
+    m_liveSource = m_serialSource;
+    ui->actDisconnectNetworkBridge->setEnabled(false);
+    ui->actStopRawCapture->setEnabled(false);
+
+    m_commandChannel = new CommandChannel(m_serialPort, this);
+    connect(m_commandChannel, &CommandChannel::baudRateChanged, this, &MainWindow::on_commandChannelBaudRateChanged);
+    connect(m_commandChannel, &CommandChannel::telemetryIntervalChanged, this, &MainWindow::on_commandChannelTelemetryIntervalChanged);
+
+    m_telemetryHoldTimer = new QTimer(this);
+    m_telemetryHoldTimer->setSingleShot(true);
+    connect(m_telemetryHoldTimer, &QTimer::timeout, this, &MainWindow::on_telemetryHoldTimer_timeout);
+
+    m_snapshotTimer = new QTimer(this);
+    m_snapshotTimer->setInterval(SnapshotInterval);
+    m_snapshotTimer->setSingleShot(false);
+    connect(m_snapshotTimer, &QTimer::timeout, this, &MainWindow::on_snapshotTimer_timeout);
+
+    qRegisterMetaType<QVector<Sample>>("QVector<Sample>");
+    m_snapshotWriter = new SnapshotWriter(SessionSnapshot::defaultPath());
+    m_snapshotWriter->moveToThread(&m_snapshotThread);
+    connect(&m_snapshotThread, &QThread::finished, m_snapshotWriter, &QObject::deleteLater);
+    connect(this, &MainWindow::snapshotSamplesReady, m_snapshotWriter, &SnapshotWriter::append);
+    connect(this, &MainWindow::snapshotReset, m_snapshotWriter, &SnapshotWriter::reset);
+    m_snapshotThread.start();
+
+    connect(&m_reportWatcher, &QFutureWatcher<ReportResult>::finished, this, &MainWindow::on_reportWatcherFinished);
+    connect(&m_estimateWatcher, &QFutureWatcher<EstimateHistory>::finished, this, &MainWindow::on_estimateWatcherFinished);
+
+    qRegisterMetaType<SpectrumMetrics>("SpectrumMetrics");
+    m_spectrumAnalyzer = new SpectrumAnalyzer;
+    m_spectrumAnalyzer->moveToThread(&m_spectrumThread);
+    connect(&m_spectrumThread, &QThread::started, m_spectrumAnalyzer, &SpectrumAnalyzer::start);
+    connect(&m_spectrumThread, &QThread::finished, m_spectrumAnalyzer, &QObject::deleteLater);
+    connect(m_spectrumAnalyzer, &SpectrumAnalyzer::spectrumReady, this, &MainWindow::on_spectrumAnalyzerSpectrumReady);
+    m_spectrumThread.start();
+
+    m_derivedChannels.setDefinitions(m_config.derivedChannels);
+    m_triggerEngine.setSettings(m_config.trigger);
+    restoreSession();
+
+    m_axisAutoScale[AxisPackVoltage] = m_config.voltageAutoScale;
+    m_axisAutoScale[AxisCurrent] = m_config.currentAutoScale;
+    m_axisAutoScale[AxisCharge] = m_config.chargeAutoScale;
+    m_axisAutoScale[AxisTemperature] = m_config.temperatureAutoScale;
+    ui->actPackVoltageAutoScale->setChecked(m_config.voltageAutoScale);
+    ui->actCurrentAutoScale->setChecked(m_config.currentAutoScale);
+    ui->actChargeAutoScale->setChecked(m_config.chargeAutoScale);
+    ui->actTemperatureAutoScale->setChecked(m_config.temperatureAutoScale);
+    m_axisAutoScale[AxisStateOfCharge] = false;
+    m_axisAutoScale[AxisResistance] = m_config.resistanceAutoScale;
+    ui->actEstimatesShow->setChecked(m_config.estimatesVisible);
+    ui->actResistanceAutoScale->setChecked(m_config.resistanceAutoScale);
+    m_axisScales[AxisPackVoltage].setMinimumSpan(0.5);
+    m_axisScales[AxisCurrent].setMinimumSpan(0.1);
+    m_axisScales[AxisResistance].setMinimumSpan(10.0);
+
+    applyUnitSettings();
+
+    if (lcDiagnostics().isDebugEnabled()) {
+        m_diagnosticsTimer->start();
+    }
+    m_snapshotTimer->start();
+
+    StartupTrace::mark("windowConstructed");
+}
+
+MainWindow::~MainWindow()
+{
+    m_reportWatcher.waitForFinished();
+    m_estimateWatcher.waitForFinished();
+    m_snapshotThread.quit();
+    m_snapshotThread.wait();
+    m_spectrumThread.quit();
+    m_spectrumThread.wait();
+
+    delete ui;
+}
+
+//
+// The chart is built after the first paint so the window appears and the
+// port starts decoding without waiting on QtCharts and OpenGL setup.
+// Samples decoded before then are already in the sample store.
+//
+void MainWindow::createChart()
+{
+    if (m_chart != nullptr || m_plotWidget != nullptr) {
+        return;
+    }
+
+    if (m_config.plotBackend == "software") {
+        createPlotWidget();
+        return;
+    }
+
     m_chart = new QChart();
 
     m_chart->legend()->setVisible(true);
     m_chart->legend()->setAlignment(Qt::AlignBottom);
     m_chart->legend()->setMarkerShape(QLegend::MarkerShapeFromSeries);
 
-    m_startDateTime = QDateTime::currentDateTime();
-
     m_chartAxisTime = new QDateTimeAxis;
     m_chartAxisTime->setMin(m_startDateTime);
     m_chartAxisTime->setMax(m_startDateTime.addSecs(300));
+    if (m_restoredSnapshot.isOpen()) {
+        m_chartAxisTime->setRange(
+                    QDateTime::fromMSecsSinceEpoch(m_restoredSnapshot.header().axisMin),
+                    QDateTime::fromMSecsSinceEpoch(m_restoredSnapshot.header().axisMax));
+    }
     m_chartAxisTime->setTitleText(tr("Time"));
     m_chartAxisTime->setFormat("h:mm:ss AP");
     m_chart->addAxis(m_chartAxisTime, Qt::AlignBottom);
 
     m_chartAxisCharge = new QValueAxis;
-
-    //
-    // changes to these settings only take effect on startup
-    //
-    m_chargeUnit = settings.value("units/charge", "coulomb").toString();
-    m_temperatureUnit = settings.value("units/temperature", "celsius").toString();
-
-    if (m_chargeUnit == "amphour") {
-        m_chartAxisCharge->setTitleText(tr("Charge (Ah)"));
-        m_chartAxisCharge->setMin(0);
-        m_chartAxisCharge->setMax(3.2);
-    }
-    else {
-        m_chartAxisCharge->setTitleText(tr("Charge (C)"));
-        m_chartAxisCharge->setMin(0);
-        m_chartAxisCharge->setMax(11520);
-    }
-
+    m_chartAxisCharge->setMin(0);
     m_chartAxisCharge->setTickInterval(1000);
-    m_chart->addAxis(m_chartAxisCharge, (settings.value("chart/axes/charge/orientation", true).toBool() ? Qt::AlignLeft : Qt::AlignRight));
+    m_chart->addAxis(m_chartAxisCharge, (m_config.chargeAxisLeft ? Qt::AlignLeft : Qt::AlignRight));
 
     m_chartAxisCurrent = new QValueAxis;
     m_chartAxisCurrent->setMin(0);
     m_chartAxisCurrent->setMax(10);
     m_chartAxisCurrent->setTitleText(tr("Current (A)"));
     m_chartAxisCurrent->setTickInterval(0.1);
-    m_chart->addAxis(m_chartAxisCurrent, (settings.value("chart/axes/current/orientation", true).toBool() ? Qt::AlignLeft : Qt::AlignRight));
+    m_chart->addAxis(m_chartAxisCurrent, (m_config.currentAxisLeft ? Qt::AlignLeft : Qt::AlignRight));
 
     m_chartAxisPackVoltage = new QValueAxis;
     m_chartAxisPackVoltage->setMin(0);
     m_chartAxisPackVoltage->setMax(25.4);
     m_chartAxisPackVoltage->setTitleText(tr("Voltage (V)"));
     m_chartAxisPackVoltage->setTickInterval(1.0);
-    m_chart->addAxis(m_chartAxisPackVoltage, (settings.value("chart/axes/voltage/orientation", true).toBool() ? Qt::AlignLeft : Qt::AlignRight));
+    m_chart->addAxis(m_chartAxisPackVoltage, (m_config.voltageAxisLeft ? Qt::AlignLeft : Qt::AlignRight));
 
     m_chartAxisTemperature = new QValueAxis;
-
-    if (m_temperatureUnit == "farenheit") {
-        m_chartAxisTemperature->setTitleText(tr("Temperature (F)"));
-        m_chartAxisTemperature->setMin(64.4);
-        m_chartAxisTemperature->setMax(212.0);
-    }
-    else {
-        m_chartAxisTemperature->setTitleText(tr("Temperature (C)"));
-        m_chartAxisTemperature->setMin(18.0);
-        m_chartAxisTemperature->setMax(100.0);
-    }
-
     m_chartAxisTemperature->setTickInterval(5);
-    m_chart->addAxis(m_chartAxisTemperature, (settings.value("chart/axes/temperature/orientation", false).toBool() ? Qt::AlignLeft : Qt::AlignRight));
+    m_chart->addAxis(m_chartAxisTemperature, (m_config.temperatureAxisLeft ? Qt::AlignLeft : Qt::AlignRight));
 
     m_chartSeriesPackVoltage = new QLineSeries;
     m_chartSeriesPackVoltage->setName(tr("Voltage"));
     m_chart->addSeries(m_chartSeriesPackVoltage);
     m_chartSeriesPackVoltage->attachAxis(m_chartAxisPackVoltage);
     m_chartSeriesPackVoltage->attachAxis(m_chartAxisTime);
-    m_chartSeriesPackVoltage->setColor(settings.value("chart/axes/voltage/lineColor", defaultColor_voltage).value<QColor>());
+    m_chartSeriesPackVoltage->setColor(m_config.voltageColor);
     m_chartSeriesPackVoltage->setUseOpenGL(true);
 
     m_chartSeriesCurrent = new QLineSeries;
@@ -142,7 +321,7 @@ MainWindow::MainWindow(QWidget *parent) :
     m_chart->addSeries(m_chartSeriesCurrent);
     m_chartSeriesCurrent->attachAxis(m_chartAxisCurrent);
     m_chartSeriesCurrent->attachAxis(m_chartAxisTime);
-    m_chartSeriesCurrent->setColor(settings.value("chart/axes/current/lineColor", defaultColor_current).value<QColor>());
+    m_chartSeriesCurrent->setColor(m_config.currentColor);
     m_chartSeriesCurrent->setUseOpenGL(true);
 
     m_chartSeriesCharge = new QLineSeries;
@@ -150,7 +329,7 @@ MainWindow::MainWindow(QWidget *parent) :
     m_chart->addSeries(m_chartSeriesCharge);
     m_chartSeriesCharge->attachAxis(m_chartAxisCharge);
     m_chartSeriesCharge->attachAxis(m_chartAxisTime);
-    m_chartSeriesCharge->setColor(settings.value("chart/axes/charge/lineColor", defaultColor_charge).value<QColor>());
+    m_chartSeriesCharge->setColor(m_config.chargeColor);
     m_chartSeriesCharge->setUseOpenGL(true);
 
     m_chartSeriesTemperature = new QLineSeries;
@@ -158,298 +337,2001 @@ MainWindow::MainWindow(QWidget *parent) :
     m_chart->addSeries(m_chartSeriesTemperature);
     m_chartSeriesTemperature->attachAxis(m_chartAxisTemperature);
     m_chartSeriesTemperature->attachAxis(m_chartAxisTime);
-    m_chartSeriesTemperature->setColor(settings.value("chart/axes/temperature/lineColor", defaultColor_temperature).value<QColor>());
+    m_chartSeriesTemperature->setColor(m_config.temperatureColor);
     m_chartSeriesTemperature->setUseOpenGL(true);
 
+    m_chartAxisStateOfCharge = new QValueAxis;
+    m_chartAxisStateOfCharge->setRange(0, 100);
+    m_chartAxisStateOfCharge->setTitleText(tr("State of Charge (%)"));
+    m_chartAxisStateOfCharge->setVisible(m_config.estimatesVisible);
+    m_chart->addAxis(m_chartAxisStateOfCharge, Qt::AlignRight);
+
+    m_chartAxisResistance = new QValueAxis;
+    m_chartAxisResistance->setRange(0, 200);
+    m_chartAxisResistance->setTitleText(tr("Resistance (mOhm)"));
+    m_chartAxisResistance->setVisible(m_config.estimatesVisible);
+    m_chart->addAxis(m_chartAxisResistance, Qt::AlignRight);
+
+    m_chartSeriesStateOfCharge = new QLineSeries;
+    m_chartSeriesStateOfCharge->setName(tr("State of Charge"));
+    m_chart->addSeries(m_chartSeriesStateOfCharge);
+    m_chartSeriesStateOfCharge->attachAxis(m_chartAxisStateOfCharge);
+    m_chartSeriesStateOfCharge->attachAxis(m_chartAxisTime);
+    m_chartSeriesStateOfCharge->setColor(Qt::magenta);
+    m_chartSeriesStateOfCharge->setVisible(m_config.estimatesVisible);
+    m_chartSeriesStateOfCharge->setUseOpenGL(true);
+
+    m_chartSeriesResistance = new QLineSeries;
+    m_chartSeriesResistance->setName(tr("Resistance"));
+    m_chart->addSeries(m_chartSeriesResistance);
+    m_chartSeriesResistance->attachAxis(m_chartAxisResistance);
+    m_chartSeriesResistance->attachAxis(m_chartAxisTime);
+    m_chartSeriesResistance->setColor(Qt::darkCyan);
+    m_chartSeriesResistance->setVisible(m_config.estimatesVisible);
+    m_chartSeriesResistance->setUseOpenGL(true);
+
+    createDerivedSeries();
+
+    applyChartUnits();
+
     ui->chartView->setChart(m_chart);
+    ui->chartView->viewport()->installEventFilter(this);
+
+    //
+    // plot the restored session and everything decoded before the chart
+    // existed
+    //
+    rebuildSeries();
+
+    m_chartUpdateTimer->start();
+
+    StartupTrace::mark("chartCreated");
+}
+
+//
+// Software backend: replaces the chart view with a widget that draws
+// straight from the sample store, for machines where the OpenGL series
+// are slow or unavailable.
+//
+void MainWindow::createPlotWidget()
+{
+    m_plotWidget = new ScrollingPlotWidget(this);
+
+    m_plotWidget->setChannelColor(ScrollingPlotWidget::ChannelPackVoltage, m_config.voltageColor);
+    m_plotWidget->setChannelColor(ScrollingPlotWidget::ChannelCurrent, m_config.currentColor);
+    m_plotWidget->setChannelColor(ScrollingPlotWidget::ChannelCharge, m_config.chargeColor);
+    m_plotWidget->setChannelColor(ScrollingPlotWidget::ChannelTemperature, m_config.temperatureColor);
+
+    m_plotWidget->setChannelLeftAligned(ScrollingPlotWidget::ChannelPackVoltage, m_config.voltageAxisLeft);
+    m_plotWidget->setChannelLeftAligned(ScrollingPlotWidget::ChannelCurrent, m_config.currentAxisLeft);
+    m_plotWidget->setChannelLeftAligned(ScrollingPlotWidget::ChannelCharge, m_config.chargeAxisLeft);
+    m_plotWidget->setChannelLeftAligned(ScrollingPlotWidget::ChannelTemperature, m_config.temperatureAxisLeft);
+
+    m_plotWidget->setChannelRange(ScrollingPlotWidget::ChannelPackVoltage, 0.0, 25.4);
+    m_plotWidget->setChannelRange(ScrollingPlotWidget::ChannelCurrent, 0.0, 10.0);
+
+    m_plotWidget->setChannelColor(ScrollingPlotWidget::ChannelStateOfCharge, Qt::magenta);
+    m_plotWidget->setChannelColor(ScrollingPlotWidget::ChannelResistance, Qt::darkCyan);
+    m_plotWidget->setChannelLeftAligned(ScrollingPlotWidget::ChannelStateOfCharge, false);
+    m_plotWidget->setChannelLeftAligned(ScrollingPlotWidget::ChannelResistance, false);
+    m_plotWidget->setChannelRange(ScrollingPlotWidget::ChannelStateOfCharge, 0.0, 100.0);
+    m_plotWidget->setChannelRange(ScrollingPlotWidget::ChannelResistance, 0.0, 200.0);
+    m_plotWidget->setChannelVisible(ScrollingPlotWidget::ChannelStateOfCharge, m_config.estimatesVisible);
+    m_plotWidget->setChannelVisible(ScrollingPlotWidget::ChannelResistance, m_config.estimatesVisible);
+    m_plotWidget->setEstimateStore(&m_estimateStore);
+    m_plotWidget->setDerivedChannels(&m_derivedChannels);
+    createDerivedSeries();
+
+    applyChartUnits();
+
+    ui->verticalLayout->replaceWidget(ui->chartView, m_plotWidget);
+    ui->chartView->hide();
+
+    m_plotWidget->setSampleStore(&m_sampleStore);
+
     m_chartUpdateTimer->start();
+
+    StartupTrace::mark("chartCreated");
+}
+
+void MainWindow::closeEvent(QCloseEvent *event)
+{
+    int result = QMessageBox::question(
+                this,
+                tr("Exit Application"),
+                tr("Do you really want to exit the application?"),
+                QMessageBox::Yes | QMessageBox::No);
+
+    if (result == QMessageBox::No) {
+        event->ignore();
+        return;
+    }
+
+    if (m_dataLogFile != nullptr) {
+        if (m_dataLogFile->isOpen()) {
+            m_dataLogFile->close();
+        }
+        m_dataLogFile->deleteLater();
+        m_dataLogFile = nullptr;
+    }
+
+    m_rawCapture.close();
+
+    m_packetSource->close();
+
+    if (m_loadTestAnalyzer.finish()) {
+        saveLoadTestReport(m_loadTestAnalyzer.report());
+    }
+
+    saveSession();
+    QMetaObject::invokeMethod(m_snapshotWriter, "finish", Qt::BlockingQueuedConnection);
+
+    event->accept();
+}
+
+//
+// Port discovery and opening happen in the background through the port
+// manager, so showing the window never blocks on a dialog or a retry loop.
+//
+void MainWindow::showEvent(QShowEvent *event)
+{
+    if (m_portSelectionStarted) {
+        return;
+    }
+
+    m_portSelectionStarted = true;
+
+    StartupTrace::mark("windowShown");
+    QTimer::singleShot(0, this, &MainWindow::createChart);
+
+    if (m_config.autoOpenPortEnabled) {
+        const PortMatch &match = m_config.autoOpenPort;
+
+        if (match.isValid()) {
+            m_portManager->setTarget(match);
+            m_portManager->start();
+            m_serialPortLabel->setText(tr("Waiting for %1").arg(match.portName));
+            m_waitingMessageBox->show();
+            event->accept();
+            return;
+        }
+    }
+
+    m_selectSerialPortDialog = new SelectSerialPortDialog(this);
+    m_selectSerialPortDialog->setAttribute(Qt::WA_DeleteOnClose);
+    m_selectSerialPortDialog->setAvailablePorts(m_portManager->availablePorts());
+    connect(m_portManager, &PortManager::portsChanged, m_selectSerialPortDialog, &SelectSerialPortDialog::setAvailablePorts);
+    connect(m_selectSerialPortDialog, &QDialog::accepted, this, &MainWindow::on_selectSerialPortDialogAccepted);
+    m_selectSerialPortDialog->open();
+}
+
+void MainWindow::on_selectSerialPortDialogAccepted()
+{
+    QSerialPortInfo selectedPort = m_selectSerialPortDialog->selectedPort();
+    m_selectSerialPortDialog = nullptr;
+
+    if (selectedPort.isValid()) {
+        m_portManager->setTarget(PortMatch::fromPortInfo(selectedPort));
+
+        //
+        // while a replay or network bridge is active the port is opened
+        // once the serial port is the source again
+        //
+        if (m_packetSource != m_serialSource) {
+            return;
+        }
+
+        m_portManager->start();
+        m_serialPortLabel->setText(tr("Waiting for %1").arg(selectedPort.portName()));
+        m_waitingMessageBox->show();
+    }
+}
+
+void MainWindow::on_packetSourceOpened()
+{
+    m_packetDecoder.reset();
+
+    //
+    // mark the outage in the log so the gap isn't mistaken for a flat line
+    //
+    if (m_portLostTimestamp >= 0) {
+        qreal gap = static_cast<qreal>(m_sampleClock.now() - m_portLostTimestamp) / 1000000000.0;
+        m_portLostTimestamp = -1;
+
+        if (m_dataLogFile != nullptr && m_dataLogFile->isOpen()) {
+            char line[64];
+            int length = qsnprintf(line, sizeof(line), "# gap %.3f s\n", gap);
+            m_dataLogFile->write(line, length);
+        }
+    }
+
+    if (m_packetSource == m_serialSource) {
+        onSerialPortOpened();
+    }
+    else {
+        m_serialPortLabel->setText(m_packetSource->description());
+    }
+}
+
+void MainWindow::on_packetSourceLost()
+{
+    m_portLostTimestamp = m_sampleClock.now();
+    m_sampleClock.resetIntervalEstimate();
+    m_packetSource->statistics().resetInterval();
+    m_telemetryHoldTimer->stop();
+    m_serialPortLabel->setText(tr("%1: reconnecting...").arg(m_packetSource->description()));
+
+    //
+    // reconnecting needs the port watcher and retry timers
+    //
+    if (m_idle) {
+        leaveIdleMode();
+    }
+}
+
+void MainWindow::onSerialPortOpened()
+{
+    StartupTrace::mark("portOpened");
+
+    m_serialPortLabel->setText(QString("%1:%2").arg(m_serialPort->portName()).arg(m_serialPort->baudRate()));
+
+    m_commandChannel->invalidateTelemetryInterval();
+
+    m_telemetryHoldTimer->setInterval(m_config.telemetryHoldTime * 1000);
+    m_telemetryMode = -1;
+
+    if (m_config.fastBaudRate > 0) {
+        m_commandChannel->setBaudRate(m_config.fastBaudRate);
+    }
+
+    m_commandChannel->requestSnapshot();
+}
+
+void MainWindow::on_commandChannelBaudRateChanged(qint32 baudRate)
+{
+    m_packetDecoder.reset();
+    m_serialPortLabel->setText(QString("%1:%2").arg(m_serialPort->portName()).arg(baudRate));
+}
+
+//
+// The interval estimates would otherwise take every packet at a slower
+// rate for a run of dropped ones.
+//
+void MainWindow::on_commandChannelTelemetryIntervalChanged(int milliseconds)
+{
+    Q_UNUSED(milliseconds);
+
+    m_sampleClock.resetIntervalEstimate();
+    m_packetSource->statistics().resetInterval();
+}
+
+//
+// Raises the telemetry rate on mode changes and holds it there while the
+// pack is busy; the hold timer drops back to the idle rate.
+//
+void MainWindow::updateTelemetryRate(const status_packet_t &packet)
+{
+    if (packet.mode == m_telemetryMode) {
+        return;
+    }
+
+    bool firstPacket = (m_telemetryMode == -1);
+    m_telemetryMode = packet.mode;
+
+    if (!m_config.adaptiveTelemetry) {
+        return;
+    }
+
+    if (firstPacket) {
+        m_commandChannel->setTelemetryInterval(m_config.telemetryIdleInterval);
+        return;
+    }
+
+    m_commandChannel->setTelemetryInterval(m_config.telemetryFastInterval);
+    m_telemetryHoldTimer->start();
+}
+
+void MainWindow::on_telemetryHoldTimer_timeout()
+{
+    //
+    // load tests are always recorded at the fast rate
+    //
+    if (m_telemetryMode == MODE_LOAD_TEST) {
+        m_telemetryHoldTimer->start();
+        return;
+    }
+
+    m_commandChannel->setTelemetryInterval(m_config.telemetryIdleInterval);
+}
+
+void MainWindow::on_packetSourceReadyRead()
+{
+    qint64 length;
+    qint64 timestamp;
+
+    //
+    // every frame completed by a chunk carries the time the source stamped
+    // on it, not the time it gets processed, and the frames of a chunk
+    // count as one arrival for the interval estimates
+    //
+    while ((length = m_packetSource->read(m_readBuffer, ReadBufferSize, &timestamp)) > 0) {
+        if (m_rawCapture.isOpen()) {
+            m_rawCapture.append(m_readBuffer, length, timestamp);
+        }
+
+        qint64 first = m_sampleStore.count();
+
+        for (qint64 i = 0; i < length; i++) {
+            if (m_packetDecoder.push(m_readBuffer[i])) {
+                if (m_idle) {
+                    leaveIdleMode();
+                }
+#ifdef PBM_ALLOCATION_COUNTER
+                quint64 allocations = AllocationCounter::count();
+                processPacket(m_packetDecoder.packet(), timestamp);
+                m_hotPathAllocations += AllocationCounter::count() - allocations;
+#else
+                processPacket(m_packetDecoder.packet(), timestamp);
+#endif
+                m_hotPathPackets++;
+            }
+        }
+
+        int frames = static_cast<int>(m_sampleStore.count() - first);
+        if (frames > 0) {
+            recordFrames(timestamp, frames, first);
+        }
+    }
+
+    logPendingSamples(m_sampleStore.count());
+}
+
+//
+// Losses are judged per chunk: a reader that stalled gets the late frames
+// all at once, and those make up for the gap before them.
+//
+void MainWindow::recordFrames(qint64 timestamp, int frames, qint64 first)
+{
+    m_packetSource->statistics().recordArrival(timestamp, frames);
+
+    int dropped = m_sampleClock.recordFrames(timestamp, frames);
+    if (dropped > 0 && m_dataLogFile != nullptr && m_dataLogFile->isOpen()) {
+        //
+        // the lines before the gap go out first so the comment lands
+        // between the right samples
+        //
+        logPendingSamples(first);
+
+        char line[64];
+        int length = qsnprintf(line, sizeof(line), "# %d dropped\n", dropped);
+        m_dataLogFile->write(line, length);
+    }
+}
+
+void MainWindow::processPacket(const status_packet_t &packet, qint64 timestamp)
+{
+    //
+    // the sleep timer is not restarted here, as re-arming a QTimer
+    // allocates; on_sleepTimerTimeout() re-arms it if a packet arrived
+    // while it was running
+    //
+    m_lastPacketTimer.start();
+    if (!m_sleepTimer->isActive()) {
+        m_sleepTimer->start();
+    }
+    if (m_waitingMessageBox->isVisible()) {
+        m_waitingMessageBox->hide();
+    }
+
+    Sample sample = Sample::fromPacket(packet, m_sampleClock.toWallUSecs(timestamp));
+    m_sampleStore.append(sample);
+    m_triggerEngine.push(sample);
+    //
+    // while a restored session is being estimated, live samples wait for
+    // the estimator to be handed back
+    //
+    if (m_restoringEstimates == 0) {
+        m_estimateStore.append(m_batteryEstimator.update(sample));
+    }
+    m_spectrumAnalyzer->push(sample);
+
+    if (m_loadTestAnalyzer.push(sample)) {
+        showLoadTestReport(m_loadTestAnalyzer.report());
+    }
+
+    qreal charge = convertCharge(sample.coulombs());
+    qreal temperature = convertTemperature(sample.celsius());
+
+    updateLabels(packet, charge, temperature);
+    updateTelemetryRate(packet);
+
+    if (!StartupTrace::isFinished()) {
+        StartupTrace::mark("firstSample");
+        StartupTrace::finish();
+    }
+}
+
+//
+// The time column only has the time of day, so the session's absolute
+// start goes into the log as a comment that elapsed counts from; see
+// LogReader::startTime().
+//
+void MainWindow::logSessionStart()
+{
+    if (m_dataLogFile == nullptr || !m_dataLogFile->isOpen()) {
+        return;
+    }
+
+    QByteArray start = QDateTime::fromMSecsSinceEpoch(m_sessionStart / 1000, Qt::UTC).toString(Qt::ISODate).toLatin1();
+
+    char line[96];
+    int length = qsnprintf(line, sizeof(line), "# start %lld %s\n", static_cast<long long>(m_sessionStart), start.constData());
+    m_dataLogFile->write(line, length);
+}
+
+int MainWindow::formatLogLine(char *buffer, int size, qint64 index)
+{
+    const Sample &sample = m_sampleStore.at(index);
+    const BatteryEstimate &estimate = m_estimateStore.at(index);
+
+    int length = formatClockTime(buffer, size, QTime::fromMSecsSinceStartOfDay(m_sampleClock.localMSecsSinceStartOfDay(sample.timestamp)));
+    length += qsnprintf(
+                buffer + length,
+                static_cast<size_t>(size - length),
+                ",%.3f,%g,%g,%g,%g,%.1f,%.1f,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f",
+                static_cast<qreal>(sample.timestamp - m_sessionStart) / 1000000.0,
+                sample.volts(),
+                sample.amps(),
+                sample.coulombs(),
+                sample.celsius(),
+                static_cast<double>(estimate.stateOfCharge),
+                static_cast<double>(estimate.resistance),
+                sample.mode,
+                sample.cellVolts(0),
+                sample.cellVolts(1),
+                sample.cellVolts(2),
+                sample.cellVolts(3),
+                sample.cellVolts(4),
+                sample.cellVolts(5));
+
+    for (int c = 0; c < m_derivedChannels.channelCount(); c++) {
+        length += qsnprintf(
+                    buffer + length,
+                    static_cast<size_t>(size - length),
+                    ",%g",
+                    static_cast<double>(m_derivedChannels.value(c, index)));
+    }
+
+    buffer[length++] = '\n';
+    return length;
+}
+
+//
+// Evaluates the derived channels for the samples decoded since the last
+// call and writes their log lines. Called once per read notification
+// rather than per packet, so derived channels are evaluated in blocks.
+//
+void MainWindow::logPendingSamples(qint64 end)
+{
+    end = qMin(end, m_estimateStore.count());
+    if (end <= m_loggedCount) {
+        return;
+    }
+
+    evaluateDerivedChannels(end);
+
+    if (m_dataLogFile != nullptr && m_dataLogFile->isOpen()) {
+        char line[LogLineSize];
+
+        for (qint64 i = m_loggedCount; i < end; i++) {
+            int length = formatLogLine(line, sizeof(line), i);
+            m_dataLogFile->write(line, length);
+        }
+    }
+
+    m_loggedCount = end;
+}
+
+void MainWindow::evaluateDerivedChannels(qint64 end)
+{
+    m_derivedChannels.evaluate(m_sampleStore, m_estimateStore, end);
+
+    if (m_derivedChannels.hasAlarms()) {
+        reportDerivedAlarms();
+    }
+}
+
+void MainWindow::reportDerivedAlarms()
+{
+    const QVector<DerivedAlarm> alarms = m_derivedChannels.takeAlarms();
+
+    for (const DerivedAlarm &alarm : alarms) {
+        const DerivedChannelDefinition &definition = m_derivedChannels.definition(alarm.channel);
+        QString time = QDateTime::fromMSecsSinceEpoch(alarm.timestamp / 1000).toString("h:mm:ss AP");
+        QString message;
+
+        if (alarm.state < 0) {
+            message = tr("%1 alarm: %2 below %3 at %4").arg(definition.name).arg(alarm.value).arg(definition.alarmBelow).arg(time);
+        }
+        else if (alarm.state > 0) {
+            message = tr("%1 alarm: %2 above %3 at %4").arg(definition.name).arg(alarm.value).arg(definition.alarmAbove).arg(time);
+        }
+        else {
+            message = tr("%1 back within limits at %2").arg(definition.name).arg(time);
+        }
+
+        qCDebug(lcDiagnostics) << message;
+        statusBar()->showMessage(message, AlarmMessageTimeout);
+        if (alarm.state != 0) {
+            QApplication::beep();
+        }
+    }
+}
+
+//
+// Labels are only re-formatted when the value at their displayed
+// precision changes.
+//
+void MainWindow::updateLabels(const status_packet_t &packet, qreal charge, qreal temperature)
+{
+    int second = QTime::currentTime().msecsSinceStartOfDay() / 1000;
+    if (second != m_lastSeenSecond) {
+        m_lastSeenSecond = second;
+        m_packStatusLabel->setText(tr("Last seen %1").arg(QTime::currentTime().toString("h:mm:ss AP")));
+    }
+
+    qint64 voltage = qRound64(packet.pack_voltage / 10.0);
+    if (voltage != m_displayedVoltage) {
+        m_displayedVoltage = voltage;
+        ui->lblPackVoltage->setText(QString("%1 V").arg(voltage / 100.0, 5, 'f', 2));
+    }
+
+    qint64 current = qRound64(qAbs(static_cast<qreal>(packet.current)) / 10.0);
+    if (current != m_displayedCurrent) {
+        m_displayedCurrent = current;
+        ui->lblCurrent->setText(QString("%1 A").arg(current / 100.0, 5, 'f', 2));
+    }
+
+    if (m_cellBalanceStatusForm != nullptr) {
+        for (int i = 0; i < 6; i++) {
+            qreal v = static_cast<qreal>(packet.cell_voltage[i]) / 1000.0;
+            m_cellBalanceStatusForm->setCellVoltage(i, v);
+        }
+    }
+
+    if (packet.mode != m_displayedMode) {
+        m_displayedMode = packet.mode;
+
+        switch (packet.mode) {
+        case MODE_DISCHARGING:
+            ui->lblMode->setText(tr("Discharging"));
+            break;
+        case MODE_CHARGING:
+            ui->lblMode->setText(tr("Charging"));
+            break;
+        case MODE_LOAD_TEST:
+            ui->lblMode->setText(tr("Load Test"));
+            break;
+        }
+    }
+
+    qint64 displayedCharge = qRound64(charge * 10000.0);
+    if (displayedCharge != m_displayedCharge) {
+        m_displayedCharge = displayedCharge;
+        ui->lblChargeState->setText(
+                    QString("%1 %2")
+                        .arg(charge, 6, 'f', 4)
+                        .arg(m_chargeSuffix));
+    }
+
+    qint64 displayedTemperature = qRound64(temperature * 100.0);
+    if (displayedTemperature != m_displayedTemperature) {
+        m_displayedTemperature = displayedTemperature;
+        ui->lblTemperature->setText(
+                    QString("%1 °%2")
+                        .arg(temperature, 4, 'f', 2)
+                        .arg(m_temperatureSuffix));
+    }
+}
+
+//
+// The pack counts as asleep once it has missed two packets at the
+// telemetry interval it was last asked for, and never sooner than
+// SleepTimeout.
+//
+int MainWindow::sleepTimeout() const
+{
+    return qMax(SleepTimeout, 2 * m_commandChannel->telemetryInterval() + SleepTimeout / 2);
+}
+
+void MainWindow::on_sleepTimerTimeout()
+{
+    qint64 remaining = sleepTimeout() - m_lastPacketTimer.elapsed();
+    if (remaining > 0) {
+        m_sleepTimer->start(static_cast<int>(remaining));
+        return;
+    }
+
+    m_sleepTimer->setInterval(sleepTimeout());
+
+    //
+    // a paused replay is not a pack going to sleep
+    //
+    if (m_replaySource != nullptr && m_replaySource->isPaused()) {
+        return;
+    }
+
+    m_sampleClock.resetIntervalEstimate();
+    m_packetSource->statistics().resetInterval();
+
+    //
+    // a pack that falls asleep mid-test has finished it
+    //
+    if (m_loadTestAnalyzer.finish()) {
+        showLoadTestReport(m_loadTestAnalyzer.report());
+    }
+
+    //
+    // the pack forgets its telemetry settings while asleep
+    //
+    m_telemetryMode = -1;
+    m_telemetryHoldTimer->stop();
+    m_commandChannel->invalidateTelemetryInterval();
+    m_sleepTimer->setInterval(sleepTimeout());
+
+    if (m_replaySource != nullptr) {
+        return;
+    }
+
+    m_waitingMessageBox->show();
+    m_waitingMessageBox->raise();
+    m_idleTimer->start();
+}
+
+void MainWindow::on_idleTimer_timeout()
+{
+    if (m_lastPacketTimer.isValid() && m_lastPacketTimer.elapsed() < sleepTimeout()) {
+        return;
+    }
+
+    enterIdleMode();
+}
+
+//
+// Once the pack has been asleep for IdleDelay, the periodic work is
+// stopped so the process only wakes when the port has data: the chart,
+// diagnostics and snapshot timers, the spectrum and port watcher polls,
+// the OpenGL surfaces of the chart and the memory kept ready for the next
+// samples. Event loop wakeups are counted while idle if diagnostics are
+// enabled.
+//
+void MainWindow::enterIdleMode()
+{
+    if (m_idle) {
+        return;
+    }
+
+    //
+    // bring the chart, log and snapshot up to date before stopping
+    //
+    on_chartUpdateTimer_timeout();
+    on_snapshotTimer_timeout();
+    if (m_dataLogFile != nullptr && m_dataLogFile->isOpen()) {
+        m_dataLogFile->flush();
+    }
+
+    m_idleStoppedTimers.clear();
+    for (QTimer *timer : { m_chartUpdateTimer, m_diagnosticsTimer, m_snapshotTimer }) {
+        if (timer->isActive()) {
+            timer->stop();
+            m_idleStoppedTimers.append(timer);
+        }
+    }
+
+    QMetaObject::invokeMethod(m_spectrumAnalyzer, "stop", Qt::QueuedConnection);
+    m_portManager->setWatching(false);
+    setChartOpenGL(false);
+
+    m_sampleStore.releaseCache();
+    m_sampleStore.releaseSpare();
+    m_estimateStore.releaseCache();
+    m_estimateStore.releaseSpare();
+    m_derivedChannels.releaseCache();
+    m_derivedChannels.releaseSpare();
+
+    m_idle = true;
+    m_idleWakeups = 0;
+    m_idleElapsed.start();
+    if (lcDiagnostics().isDebugEnabled()) {
+        m_idleWakeupConnection = connect(QAbstractEventDispatcher::instance(), &QAbstractEventDispatcher::awake, this, [this]() {
+            m_idleWakeups++;
+        });
+    }
+
+    qCDebug(lcDiagnostics) << "Idle: pack silent for" << (m_lastPacketTimer.isValid() ? m_lastPacketTimer.elapsed() / 1000 : 0) << "s, timers stopped";
+}
+
+//
+// Called before the first frame after idling is processed, so the spare
+// chunks it is appended into are back in place.
+//
+void MainWindow::leaveIdleMode()
+{
+    if (!m_idle) {
+        return;
+    }
+
+    disconnect(m_idleWakeupConnection);
+    m_idle = false;
+
+    qreal seconds = static_cast<qreal>(m_idleElapsed.nsecsElapsed()) / 1000000000.0;
+    qCDebug(lcDiagnostics) << "Idle:" << seconds << "s," << m_idleWakeups << "wakeups"
+             << "(" << ((seconds > 0.0) ? m_idleWakeups / seconds : 0.0) << "/s )";
+
+    m_sampleStore.reserveSpare();
+    m_estimateStore.reserveSpare();
+    m_derivedChannels.reserveSpare();
+
+    setChartOpenGL(true);
+    m_portManager->setWatching(true);
+    QMetaObject::invokeMethod(m_spectrumAnalyzer, "start", Qt::QueuedConnection);
+
+    for (QTimer *timer : m_idleStoppedTimers) {
+        timer->start();
+    }
+    m_idleStoppedTimers.clear();
+}
+
+//
+// QtCharts drops its GL widget once no series asks for OpenGL.
+//
+void MainWindow::setChartOpenGL(bool enabled)
+{
+    if (m_chart == nullptr) {
+        return;
+    }
+
+    for (QAbstractSeries *series : m_chart->series()) {
+        series->setUseOpenGL(enabled);
+    }
+}
+
+void MainWindow::on_waitingMessageBoxButtonClicked(QAbstractButton *button)
+{
+    //close();
+}
+
+void MainWindow::on_chartUpdateTimer_timeout()
+{
+    if (m_plotWidget != nullptr) {
+        evaluateDerivedChannels(m_estimateStore.count());
+        updateDerivedAxis();
+        m_plotWidget->refresh();
+    }
+    else {
+        plotPendingSamples();
+    }
+
+    updateAxisScales();
+    m_sampleStore.reserveSpare();
+    m_sampleStore.compressSealed();
+    m_estimateStore.reserveSpare();
+    m_estimateStore.compressSealed();
+    m_derivedChannels.reserveSpare();
+    m_derivedChannels.compressSealed();
+
+    if (m_triggerEngine.hasCapture()) {
+        collectTriggerCapture();
+    }
+}
+
+bool MainWindow::eventFilter(QObject *watched, QEvent *event)
+{
+    if (event->type() == QEvent::Paint && watched == ui->chartView->viewport()) {
+        m_chartFrames++;
+    }
+
+    return QMainWindow::eventFilter(watched, event);
+}
+
+void MainWindow::on_diagnosticsTimer_timeout()
+{
+    if (AllocationCounter::isEnabled()) {
+        qCDebug(lcDiagnostics) << "Hot path allocations:" << m_hotPathAllocations << "in" << m_hotPathPackets << "packets";
+    }
+
+    qCDebug(lcDiagnostics) << "Frames accepted:" << m_packetDecoder.acceptedCount() << "rejected:" << m_packetDecoder.rejectedCount();
+    qCDebug(lcDiagnostics) << "Sample interval:" << (m_sampleClock.sampleInterval() / 1000000.0) << "ms"
+             << "dropped:" << m_sampleClock.droppedSamples()
+             << "wall clock drift:" << m_sampleClock.wallClockDrift() << "ms";
+
+    if (m_rawCapture.isOpen()) {
+        qCDebug(lcDiagnostics) << "Raw capture:" << m_rawCapture.chunks() << "chunks," << m_rawCapture.bytes() << "bytes,"
+                 << m_rawCapture.rotations() << "rotations";
+    }
+
+    if (m_sampleStore.packedSamples() > 0) {
+        qCDebug(lcDiagnostics) << "Sample store:" << m_sampleStore.packedSamples() << "of" << m_sampleStore.count() << "samples packed,"
+                 << "Sample record ratio:" << m_sampleStore.compressionRatio()
+                 << "packed bytes per Sample:" << (static_cast<qreal>(m_sampleStore.packedBytes()) / m_sampleStore.packedSamples())
+                 << "cache misses:" << m_sampleStore.cacheMisses();
+    }
+
+    //
+    // everything held in memory per sample, not just the packed records;
+    // the mapped snapshot prefix is file-backed and left out
+    //
+    if (!m_sampleStore.isEmpty()) {
+        qint64 chartPoints = 0;
+        if (m_chart != nullptr) {
+            chartPoints = m_chartSeriesPackVoltage->count() + m_chartSeriesCurrent->count()
+                    + m_chartSeriesCharge->count() + m_chartSeriesTemperature->count()
+                    + m_chartSeriesStateOfCharge->count() + m_chartSeriesResistance->count();
+            for (QLineSeries *series : m_chartSeriesDerived) {
+                chartPoints += series->count();
+            }
+        }
+
+        qint64 samples = m_sampleStore.heapBytes();
+        qint64 estimates = m_estimateStore.heapBytes();
+        qint64 derived = m_derivedChannels.heapBytes();
+        qint64 chart = chartPoints * static_cast<qint64>(sizeof(QPointF));
+        qCDebug(lcDiagnostics) << "Memory:" << (samples + estimates + derived + chart) / 1024 << "KiB,"
+                 << "bytes per sample:" << (static_cast<qreal>(samples + estimates + derived + chart) / m_sampleStore.count())
+                 << "samples:" << samples / 1024 << "KiB"
+                 << "estimates:" << estimates / 1024 << "KiB"
+                 << "derived:" << derived / 1024 << "KiB"
+                 << "chart:" << chartPoints << "points," << chart / 1024 << "KiB";
+    }
+
+    if (m_triggerEngine.triggerCount() > 0) {
+        qCDebug(lcDiagnostics) << "Trigger:" << m_triggerEngine.triggerCount() << "fired,"
+                 << (m_triggerEngine.isTriggered() ? "collecting" : (m_triggerEngine.isArmed() ? "armed" : "holding"));
+    }
+
+    for (int c = 0; c < m_derivedChannels.channelCount(); c++) {
+        qCDebug(lcDiagnostics) << "Derived channel:" << m_derivedChannels.definition(c).name
+                 << "cost:" << m_derivedChannels.nanosPerSample(c) << "ns/sample";
+    }
+
+    const LinkStatistics &link = m_packetSource->statistics();
+    if (link.arrivals() > 0) {
+        qCDebug(lcDiagnostics) << "Source:" << m_packetSource->description()
+                 << "bytes:" << link.bytes()
+                 << "lost:" << link.lost()
+                 << "malformed:" << link.malformed()
+                 << "lateness: mean" << link.meanLateness() << "ms max" << link.maximumLateness() << "ms"
+                 << "connects:" << link.connects() << "disconnects:" << link.disconnects()
+                 << "connect latency:" << link.connectLatency() << "ms";
+    }
+
+    if (m_replaySource != nullptr) {
+        qreal runTime = m_replaySource->runTime();
+        qCDebug(lcDiagnostics) << "Replay:" << m_replaySource->framesDelivered() << "frames in" << runTime << "s"
+                 << "(" << ((runTime > 0.0) ? m_replaySource->framesDelivered() / runTime : 0.0) << "frames/s )";
+    }
+
+    if (!m_spectrumHistory.isEmpty()) {
+        const SpectrumMetrics &metrics = m_spectrumHistory.last();
+        qCDebug(lcDiagnostics) << "Ripple: current" << metrics.currentFrequency << "Hz" << metrics.currentAmplitude << "A"
+                 << "voltage" << metrics.voltageFrequency << "Hz" << metrics.voltageAmplitude << "V"
+                 << "queue overflows:" << m_spectrumAnalyzer->overflows();
+    }
+
+    //
+    // frame rate and process CPU load, for comparing the plot backends
+    //
+    quint64 frames = (m_plotWidget != nullptr) ? m_plotWidget->framesRendered() : m_chartFrames;
+    qint64 cpuTime = processCpuTime();
+
+    if (m_diagnosticsElapsed.isValid()) {
+        qint64 elapsed = m_diagnosticsElapsed.nsecsElapsed() / 1000;
+
+        if (elapsed > 0) {
+            qCDebug(lcDiagnostics) << "Plot backend:" << ((m_plotWidget != nullptr) ? "software" : "qtcharts")
+                     << "fps:" << ((frames - m_reportedFrames) * 1000000.0 / elapsed)
+                     << "cpu:" << ((cpuTime - m_reportedCpuTime) * 100.0 / elapsed) << "%";
+        }
+
+        if (m_plotWidget != nullptr) {
+            qCDebug(lcDiagnostics) << "Full redraws:" << m_plotWidget->fullRedraws();
+        }
+    }
+
+    m_diagnosticsElapsed.start();
+    m_reportedFrames = frames;
+    m_reportedCpuTime = cpuTime;
+
+    m_hotPathAllocations = 0;
+    m_hotPathPackets = 0;
+}
+
+void MainWindow::on_snapshotTimer_timeout()
+{
+    saveSession();
+    m_rawCapture.flush();
+    m_sampleStore.reserveSpare();
+    m_estimateStore.reserveSpare();
+    m_derivedChannels.reserveSpare();
+}
+
+//
+// Maps the snapshot left by the previous run, if any, and continues that
+// session; otherwise starts a new one.
+//
+void MainWindow::restoreSession()
+{
+    if (m_restoredSnapshot.open(SessionSnapshot::defaultPath()) && m_restoredSnapshot.count() > 0) {
+        m_sampleStore.attach(m_restoredSnapshot.samples(), m_restoredSnapshot.count());
+        m_restoringEstimates = m_restoredSnapshot.count();
+        m_estimateWatcher.setFuture(QtConcurrent::run(&EstimateHistory::compute, m_batteryEstimator,
+                                                      m_restoredSnapshot.samples(), m_restoredSnapshot.count()));
+        m_loggedCount = m_restoredSnapshot.count();
+        m_snapshotCount = m_restoredSnapshot.count();
+        m_sessionStart = m_restoredSnapshot.header().sessionStart;
+        QMetaObject::invokeMethod(m_snapshotWriter, "resume", Qt::QueuedConnection);
+    }
+    else {
+        m_restoredSnapshot.close();
+        m_sessionStart = m_sampleClock.toWallUSecs(m_sampleClock.now());
+        emit snapshotReset(m_sessionStart);
+    }
+
+    m_startDateTime = QDateTime::fromMSecsSinceEpoch(m_sessionStart / 1000);
+}
+
+//
+// Hands the samples decoded since the last call to the snapshot writer
+// thread.
+//
+void MainWindow::saveSession()
+{
+    qint64 count = m_sampleStore.count();
+    if (count == m_snapshotCount) {
+        return;
+    }
+
+    QVector<Sample> samples;
+    samples.reserve(static_cast<int>(count - m_snapshotCount));
+    for (qint64 i = m_snapshotCount; i < count; i++) {
+        samples.append(m_sampleStore.at(i));
+    }
+    m_snapshotCount = count;
+
+    qint64 axisMin = m_startDateTime.toMSecsSinceEpoch();
+    qint64 axisMax = axisMin + 300000;
+    if (m_chart != nullptr) {
+        axisMin = m_chartAxisTime->min().toMSecsSinceEpoch();
+        axisMax = m_chartAxisTime->max().toMSecsSinceEpoch();
+    }
+
+    emit snapshotSamplesReady(samples, axisMin, axisMax);
+}
+
+//
+// Series are fed from the sample store by the chart update timer, which
+// keeps series growth and chart repaints off the per-packet path.
+//
+void MainWindow::plotPendingSamples()
+{
+    if (m_chart == nullptr) {
+        return;
+    }
+
+    qint64 count = m_estimateStore.count();
+    if (count <= m_plottedCount) {
+        return;
+    }
+
+    //
+    // the series are rebuilt, and everything but the newest samples
+    // strided, whenever appending would take them past MaximumChartPoints
+    //
+    if (m_chartSeriesPackVoltage->count() + (count - m_plottedCount) > MaximumChartPoints) {
+        rebuildSeries();
+        return;
+    }
+
+    evaluateDerivedChannels(count);
+
+    for (qint64 i = m_plottedCount; i < count; i++) {
+        appendToSeries(i);
+    }
+    m_plottedCount = count;
+
+    updateTimeAxis();
+    updateDerivedAxis();
+}
+
+void MainWindow::appendToSeries(qint64 index)
+{
+    const Sample &sample = m_sampleStore.at(index);
+    const BatteryEstimate &estimate = m_estimateStore.at(index);
+    qreal timestamp = sample.timeMSecs();
+
+    m_chartSeriesPackVoltage->append(timestamp, sample.volts());
+    m_chartSeriesCurrent->append(timestamp, sample.amps());
+    m_chartSeriesCharge->append(timestamp, convertCharge(sample.coulombs()));
+    m_chartSeriesTemperature->append(timestamp, convertTemperature(sample.celsius()));
+    m_chartSeriesStateOfCharge->append(timestamp, estimate.stateOfCharge);
+    m_chartSeriesResistance->append(timestamp, estimate.resistance);
+
+    for (int c = 0; c < m_chartSeriesDerived.count(); c++) {
+        m_chartSeriesDerived[c]->append(timestamp, m_derivedChannels.value(c, index));
+    }
+}
+
+//
+// Runs the estimator over samples that arrived without going through
+// processPacket(), such as those decoded while a restored session was
+// being estimated.
+//
+void MainWindow::estimatePendingSamples()
+{
+    qint64 count = m_sampleStore.count();
+
+    for (qint64 i = m_estimateStore.count(); i < count; i++) {
+        m_estimateStore.reserveSpare();
+        m_estimateStore.append(m_batteryEstimator.update(m_sampleStore.at(i)));
+    }
+}
+
+//
+// The restored session is estimated on the global thread pool so a long
+// history doesn't hold up startup. Its estimates and the estimator state
+// after them are taken over here, and the samples decoded in the meantime
+// are estimated, logged and plotted from there.
+//
+void MainWindow::on_estimateWatcherFinished()
+{
+    qint64 restored = m_restoringEstimates;
+    if (restored == 0) {
+        return;
+    }
+
+    EstimateHistory history = m_estimateWatcher.result();
+    m_estimateStore.swap(*history.store);
+    m_batteryEstimator = history.estimator;
+    m_restoringEstimates = 0;
+
+    estimatePendingSamples();
+
+    //
+    // limits crossed in recorded history are not news
+    //
+    m_derivedChannels.evaluate(m_sampleStore, m_estimateStore, restored);
+    m_derivedChannels.takeAlarms();
+
+    logPendingSamples(m_sampleStore.count());
+    rebuildSeries();
+
+    //
+    // the plot widget skipped the estimate and derived traces while they
+    // were missing
+    //
+    if (m_plotWidget != nullptr) {
+        evaluateDerivedChannels(m_estimateStore.count());
+        updateDerivedAxis();
+        m_plotWidget->redraw();
+    }
+}
+
+//
+// Replots the session from the stores. The newest RebuildPoints samples
+// are plotted in full; everything before them is strided down to about
+// RebuildPoints more, so rebuilding after a restore or a unit change
+// costs the same however long the session is. Samples decoded after the
+// rebuild are appended in full by plotPendingSamples() until the series
+// reach MaximumChartPoints, when they are rebuilt again, so the chart
+// never holds more than that many points per series.
+//
+void MainWindow::rebuildSeries()
+{
+    if (m_chart == nullptr) {
+        return;
+    }
+
+    qint64 count = m_estimateStore.count();
+    evaluateDerivedChannels(count);
+
+    qint64 full = qMax(static_cast<qint64>(0), count - RebuildPoints);
+    qint64 stride = qMax(static_cast<qint64>(1), full / RebuildPoints);
+    int points = static_cast<int>(qMin(count, 2 * static_cast<qint64>(RebuildPoints) + 1));
+
+    QVector<QPointF> voltage;
+    QVector<QPointF> current;
+    QVector<QPointF> charge;
+    QVector<QPointF> temperature;
+    QVector<QPointF> stateOfCharge;
+    QVector<QPointF> resistance;
+    voltage.reserve(points);
+    current.reserve(points);
+    charge.reserve(points);
+    temperature.reserve(points);
+    stateOfCharge.reserve(points);
+    resistance.reserve(points);
+
+    QVector<QVector<QPointF>> derived(m_chartSeriesDerived.count());
+    for (QVector<QPointF> &series : derived) {
+        series.reserve(points);
+    }
+
+    for (qint64 i = 0; i < count; i += (i < full) ? stride : 1) {
+        const Sample &sample = m_sampleStore.at(i);
+        qreal timestamp = sample.timeMSecs();
+        voltage.append(QPointF(timestamp, sample.volts()));
+        current.append(QPointF(timestamp, sample.amps()));
+        charge.append(QPointF(timestamp, convertCharge(sample.coulombs())));
+        temperature.append(QPointF(timestamp, convertTemperature(sample.celsius())));
+
+        const BatteryEstimate &estimate = m_estimateStore.at(i);
+        stateOfCharge.append(QPointF(timestamp, estimate.stateOfCharge));
+        resistance.append(QPointF(timestamp, estimate.resistance));
+
+        for (int c = 0; c < derived.count(); c++) {
+            derived[c].append(QPointF(timestamp, m_derivedChannels.value(c, i)));
+        }
+    }
+
+    m_chartSeriesPackVoltage->replace(voltage);
+    m_chartSeriesCurrent->replace(current);
+    m_chartSeriesCharge->replace(charge);
+    m_chartSeriesTemperature->replace(temperature);
+    m_chartSeriesStateOfCharge->replace(stateOfCharge);
+    m_chartSeriesResistance->replace(resistance);
+    for (int c = 0; c < derived.count(); c++) {
+        m_chartSeriesDerived[c]->replace(derived[c]);
+    }
+    m_plottedCount = count;
+
+    updateTimeAxis();
+    updateDerivedAxis();
+}
+
+void MainWindow::updateTimeAxis()
+{
+    if (m_sampleStore.isEmpty()) {
+        return;
+    }
+
+    qint64 timestamp = m_sampleStore.last().timestamp / 1000;
+
+    if ((timestamp - m_startDateTime.toMSecsSinceEpoch()) > 300000) {
+        m_chartAxisTime->setMax(QDateTime::fromMSecsSinceEpoch(timestamp));
+    }
+}
+
+void MainWindow::applyUnitSettings()
+{
+    ChargeUnit previousChargeUnit = m_chargeUnit;
+    TemperatureUnit previousTemperatureUnit = m_temperatureUnit;
+
+    m_chargeUnit = (m_config.chargeUnit == s_chargeUnits[ChargeUnitAmpHour].key) ? ChargeUnitAmpHour : ChargeUnitCoulomb;
+    m_temperatureUnit = (m_config.temperatureUnit == s_temperatureUnits[TemperatureUnitFarenheit].key) ? TemperatureUnitFarenheit : TemperatureUnitCelsius;
+
+    const ChargeUnitInfo &chargeUnit = s_chargeUnits[m_chargeUnit];
+    const TemperatureUnitInfo &temperatureUnit = s_temperatureUnits[m_temperatureUnit];
+
+    m_chargeScale = chargeUnit.scale;
+    m_chargeSuffix = QString::fromLatin1(chargeUnit.suffix);
+    m_temperatureScale = temperatureUnit.scale;
+    m_temperatureOffset = temperatureUnit.offset;
+    m_temperatureSuffix = QString::fromLatin1(temperatureUnit.suffix);
+
+    if (m_chargeUnit != previousChargeUnit) {
+        m_displayedCharge = -1;
+    }
+
+    if (m_temperatureUnit != previousTemperatureUnit) {
+        m_displayedTemperature = -1;
+    }
+
+    if (m_chart == nullptr && m_plotWidget == nullptr) {
+        return;
+    }
+
+    applyChartUnits();
+
+    //
+    // replot the history so it stays consistent with the new units
+    //
+    if (m_chargeUnit != previousChargeUnit || m_temperatureUnit != previousTemperatureUnit) {
+        rebuildSeries();
+    }
+}
+
+void MainWindow::applyChartUnits()
+{
+    const ChargeUnitInfo &chargeUnit = s_chargeUnits[m_chargeUnit];
+    const TemperatureUnitInfo &temperatureUnit = s_temperatureUnits[m_temperatureUnit];
+
+    if (m_plotWidget != nullptr) {
+        m_plotWidget->setChannelTransform(ScrollingPlotWidget::ChannelCharge, m_chargeScale, 0.0);
+        m_plotWidget->setChannelTransform(ScrollingPlotWidget::ChannelTemperature, m_temperatureScale, m_temperatureOffset);
+    }
+    else {
+        m_chartAxisCharge->setTitleText(tr(chargeUnit.axisTitle));
+        m_chartAxisTemperature->setTitleText(tr(temperatureUnit.axisTitle));
+    }
+
+    setAxisRange(AxisCharge, 0.0, chargeUnit.axisMax);
+    setAxisRange(AxisTemperature, temperatureUnit.axisMin, temperatureUnit.axisMax);
+
+    //
+    // autoscaled axes are refitted in the new units straight away
+    //
+    m_axisScales[AxisCharge].setMinimumSpan(chargeUnit.axisMinimumSpan);
+    m_axisScales[AxisTemperature].setMinimumSpan(temperatureUnit.axisMinimumSpan);
+    updateAxisScales();
+}
+
+//
+// Feeds samples plotted since the last call into the per-axis sliding
+// min/max, drops those that have left the visible time window and refits
+// every autoscaled axis whose range has moved past its hysteresis band.
+//
+void MainWindow::updateAxisScales()
+{
+    if (m_chart == nullptr && m_plotWidget == nullptr) {
+        return;
+    }
+
+    //
+    // samples are only ranged once they have estimates, which lag behind
+    // while a restored session is being estimated
+    //
+    qint64 count = qMin(m_sampleStore.count(), m_estimateStore.count());
+    if (count < m_rangedCount) {
+        resetAxisScales();
+    }
+
+    for (qint64 i = m_rangedCount; i < count; i++) {
+        const Sample &sample = m_sampleStore.at(i);
+        m_axisRanges[AxisPackVoltage].push(sample.timestamp, sample.volts());
+        m_axisRanges[AxisCurrent].push(sample.timestamp, sample.amps());
+        m_axisRanges[AxisCharge].push(sample.timestamp, sample.coulombs());
+        m_axisRanges[AxisTemperature].push(sample.timestamp, sample.celsius());
+
+        const BatteryEstimate &estimate = m_estimateStore.at(i);
+        m_axisRanges[AxisStateOfCharge].push(sample.timestamp, estimate.stateOfCharge);
+        m_axisRanges[AxisResistance].push(sample.timestamp, estimate.resistance);
+    }
+    m_rangedCount = count;
+
+    qint64 windowStart = (m_plotWidget != nullptr)
+            ? m_plotWidget->visibleStart()
+            : m_chartAxisTime->min().toMSecsSinceEpoch() * 1000;
+
+    for (int i = 0; i < AxisCount; i++) {
+        Axis axis = static_cast<Axis>(i);
+        SlidingRange &range = m_axisRanges[axis];
+
+        range.expire(windowStart);
+        if (!m_axisAutoScale[axis] || range.isEmpty()) {
+            continue;
+        }
+
+        //
+        // the ranges hold raw values; unit conversions are increasing so
+        // they can be applied to the extremes alone
+        //
+        qreal min = range.min();
+        qreal max = range.max();
+        if (axis == AxisCharge) {
+            min = convertCharge(min);
+            max = convertCharge(max);
+        }
+        else if (axis == AxisTemperature) {
+            min = convertTemperature(min);
+            max = convertTemperature(max);
+        }
+
+        AxisScale &scale = m_axisScales[axis];
+        if (scale.update(min, max)) {
+            setAxisRange(axis, scale.min(), scale.max());
+        }
+    }
+}
+
+void MainWindow::resetAxisScales()
+{
+    for (int i = 0; i < AxisCount; i++) {
+        m_axisRanges[i].clear();
+        m_axisScales[i].invalidate();
+    }
+    m_rangedCount = 0;
+}
+
+void MainWindow::setAxisRange(Axis axis, qreal min, qreal max)
+{
+    if (m_plotWidget != nullptr) {
+        m_plotWidget->setChannelRange(static_cast<ScrollingPlotWidget::Channel>(axis), min, max);
+        return;
+    }
+
+    QValueAxis *axes[AxisCount] = {
+        m_chartAxisPackVoltage,
+        m_chartAxisCurrent,
+        m_chartAxisCharge,
+        m_chartAxisTemperature,
+        m_chartAxisStateOfCharge,
+        m_chartAxisResistance
+    };
+
+    axes[axis]->setRange(min, max);
+}
+
+qreal MainWindow::convertTemperature(qreal temperature_c)
+{
+    return (temperature_c * m_temperatureScale) + m_temperatureOffset;
+}
+
+qreal MainWindow::convertCharge(qreal current_c)
+{
+    return current_c * m_chargeScale;
+}
+
+QString MainWindow::chargeSuffix()
+{
+    return m_chargeSuffix;
+}
+
+QString MainWindow::temperatureSuffix()
+{
+    return m_temperatureSuffix;
+}
+
+void MainWindow::on_actClearData_triggered()
+{
+    int result = QMessageBox::question(
+                this,
+                tr("Battery Pack Analyzer"),
+                tr("Do you really want to clear all data from the graph?"));
+
+    if (result == QMessageBox::Yes) {
+        clearSession();
+    }
+}
+
+//
+// One series per derived channel, sharing a single autoscaled axis.
+// Rebuilt whenever the channel definitions change. The plot widget draws
+// the channels from the DerivedChannels set itself and only needs their
+// colours; their values go on the right.
+//
+void MainWindow::createDerivedSeries()
+{
+    if (m_plotWidget != nullptr) {
+        for (int c = 0; c < m_derivedChannels.channelCount(); c++) {
+            ScrollingPlotWidget::Channel channel = static_cast<ScrollingPlotWidget::Channel>(ScrollingPlotWidget::ChannelDerived + c);
+            m_plotWidget->setChannelColor(channel, m_derivedChannels.definition(c).color);
+            m_plotWidget->setChannelLeftAligned(channel, false);
+        }
+        m_plotWidget->redraw();
+        return;
+    }
+
+    if (m_chart == nullptr) {
+        return;
+    }
+
+    for (QLineSeries *series : m_chartSeriesDerived) {
+        m_chart->removeSeries(series);
+        delete series;
+    }
+    m_chartSeriesDerived.clear();
+
+    if (m_chartAxisDerived == nullptr) {
+        m_chartAxisDerived = new QValueAxis;
+        m_chartAxisDerived->setTitleText(tr("Derived"));
+        m_chart->addAxis(m_chartAxisDerived, Qt::AlignRight);
+    }
+    m_chartAxisDerived->setVisible(m_derivedChannels.channelCount() > 0);
+
+    for (int c = 0; c < m_derivedChannels.channelCount(); c++) {
+        const DerivedChannelDefinition &definition = m_derivedChannels.definition(c);
+
+        QLineSeries *series = new QLineSeries;
+        series->setName(definition.name);
+        m_chart->addSeries(series);
+        series->attachAxis(m_chartAxisDerived);
+        series->attachAxis(m_chartAxisTime);
+        series->setColor(definition.color);
+        series->setUseOpenGL(true);
+        m_chartSeriesDerived.append(series);
+    }
+}
+
+void MainWindow::updateDerivedAxis()
+{
+    if (!m_derivedChannels.hasRange()) {
+        return;
+    }
+
+    qreal min = m_derivedChannels.minimum();
+    qreal max = m_derivedChannels.maximum();
+    qreal margin = qMax((max - min) * 0.05, 0.001);
+
+    if (m_plotWidget != nullptr) {
+        for (int c = 0; c < m_derivedChannels.channelCount(); c++) {
+            m_plotWidget->setChannelRange(static_cast<ScrollingPlotWidget::Channel>(ScrollingPlotWidget::ChannelDerived + c),
+                                          min - margin, max + margin);
+        }
+    }
+    else if (m_chartAxisDerived != nullptr) {
+        m_chartAxisDerived->setRange(min - margin, max + margin);
+    }
+}
+
+//
+// Drops every sample and analysis result and starts a new session at the
+// current time.
+//
+void MainWindow::clearSession()
+{
+    //
+    // a restored session still being estimated reads the mapping closed
+    // below; its result is dropped when it arrives
+    //
+    m_estimateWatcher.waitForFinished();
+    m_restoringEstimates = 0;
+
+    //
+    // a report being rendered has the snapshot mapped, and the reset below
+    // truncates it: SIGBUS on POSIX, a failed truncate on Windows. The
+    // writer only appends otherwise, which a mapping survives.
+    //
+    m_reportWatcher.waitForFinished();
+
+    m_sampleStore.clear();
+    m_estimateStore.clear();
+    m_derivedChannels.clear();
+    m_batteryEstimator.reset();
+    m_loadTestAnalyzer.reset();
+    m_triggerEngine.reset();
+    QMetaObject::invokeMethod(m_spectrumAnalyzer, "reset", Qt::QueuedConnection);
+    m_spectrumHistory.clear();
+    if (m_spectrumDialog != nullptr) {
+        m_spectrumDialog->clear();
+    }
+    m_restoredSnapshot.close();
+    m_plottedCount = 0;
+    m_snapshotCount = 0;
+    m_loggedCount = 0;
+
+    m_sampleClock.alignWallClock();
+    m_sampleClock.resetIntervalEstimate();
+    m_sessionStart = m_sampleClock.toWallUSecs(m_sampleClock.now());
+    m_startDateTime = QDateTime::fromMSecsSinceEpoch(m_sessionStart / 1000);
+    emit snapshotReset(m_sessionStart);
+    logSessionStart();
+    resetAxisScales();
+
+    if (m_plotWidget != nullptr) {
+        m_plotWidget->reset();
+    }
+
+    if (m_chart == nullptr) {
+        return;
+    }
+
+    m_chartSeriesCharge->clear();
+    m_chartSeriesPackVoltage->clear();
+    m_chartSeriesCurrent->clear();
+    m_chartSeriesTemperature->clear();
+    m_chartSeriesStateOfCharge->clear();
+    m_chartSeriesResistance->clear();
+    for (QLineSeries *series : m_chartSeriesDerived) {
+        series->clear();
+    }
+
+    m_chartAxisTime->setMin(m_startDateTime);
+    m_chartAxisTime->setMax(m_startDateTime.addSecs(300));
+}
+
+void MainWindow::on_actSaveData_triggered()
+{
+    QString fileName = QFileDialog::getSaveFileName(
+                this,
+                tr("Save As"));
+
+    if (!fileName.isEmpty() && m_chart != nullptr) {
+        for (int i = 0; i < m_chartSeriesPackVoltage->count(); i++) {
+
+        }
+    }
+}
+
+//
+// Writes a finished load test as JSON plus an HTML summary under the
+// application data directory and returns the path of the JSON file.
+//
+QString MainWindow::saveLoadTestReport(const LoadTestReport &report)
+{
+    QString directory = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/reports";
+    QDir().mkpath(directory);
+
+    QString baseName = directory + "/loadtest-"
+            + QDateTime::fromMSecsSinceEpoch(report.startTime / 1000).toString("yyyyMMdd-hhmmss");
+
+    QFile jsonFile(baseName + ".json");
+    if (!jsonFile.open(QIODevice::WriteOnly)) {
+        qDebug() << "Could not write load test report" << jsonFile.fileName();
+        return QString();
+    }
+    jsonFile.write(QJsonDocument(report.toJson()).toJson(QJsonDocument::Indented));
+    jsonFile.close();
+
+    QFile htmlFile(baseName + ".html");
+    if (htmlFile.open(QIODevice::WriteOnly)) {
+        htmlFile.write("<html><body>");
+        htmlFile.write(report.toHtml().toUtf8());
+        htmlFile.write("</body></html>\n");
+    }
+
+    return jsonFile.fileName();
+}
+
+void MainWindow::showLoadTestReport(const LoadTestReport &report)
+{
+    QString fileName = saveLoadTestReport(report);
+
+    //
+    // chart of the test itself next to the JSON report
+    //
+    if (!fileName.isEmpty()) {
+        ReportOptions options;
+        options.fileName = QFileInfo(fileName).path() + "/" + QFileInfo(fileName).completeBaseName() + ".png";
+        options.title = tr("Load test %1").arg(QDateTime::fromMSecsSinceEpoch(report.startTime / 1000).toString("yyyy-MM-dd hh:mm:ss"));
+        options.from = report.startTime;
+        options.to = report.endTime;
+        startReport(options);
+    }
+
+    QMessageBox *box = new QMessageBox(this);
+    box->setAttribute(Qt::WA_DeleteOnClose);
+    box->setWindowTitle(tr("Load Test Complete"));
+    box->setTextFormat(Qt::RichText);
+    box->setText(report.toHtml());
+    if (!fileName.isEmpty()) {
+        box->setInformativeText(tr("Report saved to %1").arg(QDir::toNativeSeparators(fileName)));
+    }
+    box->setStandardButtons(QMessageBox::Ok);
+    box->setModal(false);
+    box->show();
+}
+
+void MainWindow::on_spectrumAnalyzerSpectrumReady(const SpectrumMetrics &metrics)
+{
+    m_spectrumHistory.append(metrics);
+
+    if (m_spectrumDialog != nullptr) {
+        m_spectrumDialog->updateSpectrum(metrics);
+    }
+}
+
+void MainWindow::on_actSpectrum_triggered()
+{
+    if (m_spectrumDialog == nullptr) {
+        m_spectrumDialog = new SpectrumDialog(m_spectrumAnalyzer, this);
+        m_spectrumDialog->setModal(false);
+    }
+    m_spectrumDialog->show();
+    m_spectrumDialog->raise();
+}
+
+void MainWindow::on_actTriggeredCaptures_triggered()
+{
+    createTriggerDialog();
+    m_triggerDialog->show();
+    m_triggerDialog->raise();
+}
+
+void MainWindow::on_triggerDialogSettingsApplied(const TriggerSettings &trigger)
+{
+    QSettings settings;
+    settings.setValue("trigger/condition", trigger.condition);
+    settings.setValue("trigger/threshold", trigger.threshold);
+    settings.setValue("trigger/hysteresis", trigger.hysteresis);
+    settings.setValue("trigger/preTrigger", trigger.preTrigger);
+    settings.setValue("trigger/postTrigger", trigger.postTrigger);
+    settings.setValue("trigger/holdoff", trigger.holdoff);
+    settings.setValue("trigger/maximumCaptures", trigger.maximumCaptures);
+
+    m_config.trigger = trigger;
+    m_triggerEngine.setSettings(trigger);
+
+    statusBar()->showMessage(trigger.condition == TriggerEngine::ConditionOff ? tr("Trigger off") : tr("Trigger armed"), AlarmMessageTimeout);
+}
+
+//
+// The dialog also holds the captures, so it is created on the first one
+// even if it has never been shown.
+//
+void MainWindow::createTriggerDialog()
+{
+    if (m_triggerDialog != nullptr) {
+        return;
+    }
+
+    m_triggerDialog = new TriggerDialog(this);
+    m_triggerDialog->setModal(false);
+    m_triggerDialog->setSettings(m_config.trigger);
+    connect(m_triggerDialog, &TriggerDialog::settingsApplied, this, &MainWindow::on_triggerDialogSettingsApplied);
+}
+
+void MainWindow::collectTriggerCapture()
+{
+    TriggerCapture capture = m_triggerEngine.takeCapture();
+
+    createTriggerDialog();
+    //
+    // numbered by trigger, as the oldest captures are dropped from the list
+    //
+    capture.name = tr("Capture %1 - %2").arg(m_triggerEngine.triggerCount()).arg(
+                QDateTime::fromMSecsSinceEpoch(capture.triggerTimestamp / 1000).toString("hh:mm:ss"));
+    m_triggerDialog->addCapture(capture);
+
+    QString message = tr("Triggered: %1 (%2)").arg(capture.reason, capture.name);
+    qCDebug(lcDiagnostics) << message << capture.samples.count() << "samples";
+    statusBar()->showMessage(message, AlarmMessageTimeout);
 }
 
-MainWindow::~MainWindow()
+void MainWindow::on_actLoadComparisonData_triggered()
 {
-    delete ui;
+    QStringList fileNames = QFileDialog::getOpenFileNames(
+                this,
+                tr("Load Comparison Data"),
+                QString(),
+                tr("Data Logs (*.csv *.txt);;All Files (*)"));
+
+    if (fileNames.isEmpty()) {
+        return;
+    }
+
+    if (m_comparisonDialog == nullptr) {
+        m_comparisonDialog = new ComparisonDialog(this);
+        m_comparisonDialog->setModal(false);
+    }
+    m_comparisonDialog->addRuns(fileNames);
+    m_comparisonDialog->show();
+    m_comparisonDialog->raise();
 }
 
-void MainWindow::closeEvent(QCloseEvent *event)
+void MainWindow::on_actReplayLog_triggered()
 {
-    int result = QMessageBox::question(
+    QString fileName = QFileDialog::getOpenFileName(
                 this,
-                tr("Exit Application"),
-                tr("Do you really want to exit the application?"),
-                QMessageBox::Yes | QMessageBox::No);
+                tr("Replay Log"),
+                QString(),
+                tr("Data Logs (*.csv *.txt);;Raw Captures (*.pbmcap *.pbmcap.1);;Byte Dumps (*.bin *.raw);;All Files (*)"));
 
-    if (result == QMessageBox::No) {
-        event->ignore();
+    if (fileName.isEmpty()) {
         return;
     }
 
-    if (m_dataLogFile != nullptr) {
-        if (m_dataLogFile->isOpen()) {
-            m_dataLogFile->close();
-        }
-        m_dataLogFile->deleteLater();
-        m_dataLogFile = nullptr;
-    }
+    if (!m_sampleStore.isEmpty()) {
+        int result = QMessageBox::question(
+                    this,
+                    tr("Replay Log"),
+                    tr("Replaying a log replaces all data on the graph. Continue?"));
 
-    if (m_serialPort != nullptr) {
-        if (m_serialPort->isOpen()) {
-            m_serialPort->close();
+        if (result != QMessageBox::Yes) {
+            return;
         }
-        m_serialPort->deleteLater();
-        m_serialPort = nullptr;
     }
 
-    event->accept();
+    startReplay(fileName);
 }
 
-void MainWindow::showEvent(QShowEvent *event)
+//
+// Swaps the serial port for a replay of the given file. The port is
+// released for the duration and reopened by stopReplay().
+//
+void MainWindow::startReplay(const QString &fileName)
 {
-    if (m_serialPort == nullptr) {
-        QSettings settings;
-
-        if (settings.value("port/autoOpenPortEnabled").toBool()) {
-            while (true) {
-                QString portName = settings.value("port/autoOpenPortName").toString();
-                m_serialPort = new QSerialPort(portName);
-                m_serialPort->setBaudRate(115200);
-                m_serialPort->setParity(QSerialPort::NoParity);
-                m_serialPort->setDataBits(QSerialPort::Data8);
-                m_serialPort->setStopBits(QSerialPort::OneStop);
-                m_serialPort->setFlowControl(QSerialPort::NoFlowControl);
-
-                connect(m_serialPort, &QSerialPort::readyRead, this, &MainWindow::on_serialPortReadyRead);
-
-                if (!m_serialPort->open(QIODevice::ReadWrite)) {
-                    int result = QMessageBox::information(
-                                this,
-                                tr("Port Error"),
-                                tr("Unable to open serial port %1").arg(portName),
-                                QMessageBox::Retry | QMessageBox::Cancel);
-                    if (result == QMessageBox::Cancel) {
-                        break;
-                    }
-                }
-                else {
-                    m_serialPortLabel->setText(QString("%1:115200").arg(m_serialPort->portName()));
-                    m_waitingMessageBox->show();
-                    event->accept();
-                    return;
-                }
-            }
-        }
+    stopReplay();
 
-        QSerialPortInfo selectedPort = SelectSerialPortDialog::getSerialPortInfo(this);
+    ReplaySource *source = new ReplaySource(&m_sampleClock, this);
+    source->setFrameInterval(m_config.telemetryFastInterval / 1000.0);
 
-        if (selectedPort.isValid()) {
-            m_serialPort = new QSerialPort(selectedPort);
-            m_serialPort->setBaudRate(115200);
-            m_serialPort->setParity(QSerialPort::NoParity);
-            m_serialPort->setDataBits(QSerialPort::Data8);
-            m_serialPort->setStopBits(QSerialPort::OneStop);
-            m_serialPort->setFlowControl(QSerialPort::NoFlowControl);
+    if (!source->open(fileName)) {
+        QMessageBox::warning(
+                    this,
+                    tr("Replay Log"),
+                    tr("Unable to replay %1: %2").arg(QDir::toNativeSeparators(fileName), source->errorString()));
+        delete source;
+        return;
+    }
 
-            connect(m_serialPort, &QSerialPort::readyRead, this, &MainWindow::on_serialPortReadyRead);
+    activatePacketSource(source);
+    if (m_selectSerialPortDialog != nullptr) {
+        m_selectSerialPortDialog->reject();
+    }
 
-            if (!m_serialPort->open(QIODevice::ReadWrite)) {
-                QMessageBox::information(
-                            this,
-                            tr("Port Error"),
-                            tr("Unable to open serial port %1").arg(selectedPort.portName()),
-                            QMessageBox::Retry | QMessageBox::Cancel);
-            }
-            else {
-                m_serialPortLabel->setText(QString("%1:115200").arg(m_serialPort->portName()));
-                m_waitingMessageBox->show();
-                event->accept();
-                return;
-            }
-        }
+    if (m_loadTestAnalyzer.finish()) {
+        saveLoadTestReport(m_loadTestAnalyzer.report());
     }
-}
 
-void MainWindow::on_serialPortReadyRead()
-{
-    QByteArray data = m_serialPort->readAll();
+    clearSession();
 
-    qDebug() << "Got" << data.length() << "bytes";
+    m_replaySource = source;
+    connect(source, &PacketSource::readyRead, this, &MainWindow::on_packetSourceReadyRead);
+    connect(source, &ReplaySource::stateChanged, this, &MainWindow::on_replaySourceStateChanged);
+    connect(source, &ReplaySource::finished, this, &MainWindow::on_replaySourceFinished);
 
-    for (int i = 0; i < data.length(); i++) {
-        if (data.at(i) == 'D' && m_inHeader == false && m_inMessage == false) {
-            m_inHeader = true;
-        }
-        else if (data.at(i) == 'E' && m_inHeader == true) {
-            m_inHeader = false;
-            m_inMessage = true;
-            m_dataBuffer.clear();
-        }
-        else if (m_inMessage) {
-            m_dataBuffer.append(data.at(i));
-            if (m_dataBuffer.length() == sizeof(status_packet_t)) {
-                status_packet_t packet;
-                memcpy((void *)&packet, m_dataBuffer.data(), sizeof(status_packet_t));
+    m_replayDialog = new ReplayDialog(source, this);
+    m_replayDialog->setModal(false);
+    connect(m_replayDialog, &ReplayDialog::seekRequested, this, &MainWindow::on_replayDialogSeekRequested);
+    connect(m_replayDialog, &ReplayDialog::stopRequested, this, &MainWindow::stopReplay);
+    m_replayDialog->show();
 
-                if (packet.a == 'A' && packet.b == 'B') {
-                    m_waitingMessageBox->hide();
-                    m_sleepTimer->stop();
-                    m_sleepTimer->start();
-                    m_packStatusLabel->setText(tr("Last seen %1").arg(QDateTime::currentDateTime().toString("h:mm:ss AP")));
+    m_serialPortLabel->setText(source->description());
+    source->start();
+}
 
-                    qreal voltage = static_cast<qreal>(packet.pack_voltage) / 1000.0;
-                    qreal current = abs(static_cast<qreal>(packet.current) / 1000.0);
-                    qreal charge = static_cast<qreal>(packet.charge_state);
-                    qreal temperature = static_cast<qreal>(packet.temperature) / 1000.0;
+void MainWindow::stopReplay()
+{
+    if (m_replaySource == nullptr) {
+        return;
+    }
 
-                    if (m_dataLogFile != nullptr && m_dataLogFile->isOpen()) {
-                        QTextStream stream(m_dataLogFile);
-                        stream << QDateTime::currentDateTime().toString("h:mm:ss AP") << ",";
-                        stream << voltage << ",";
-                        stream << current << ",";
-                        stream << charge << ",";
-                        stream << temperature << "\n";
-                    }
+    activatePacketSource(m_liveSource);
 
-                    charge = convertCharge(charge);
-                    temperature = convertTemperature(temperature);
+    if (m_loadTestAnalyzer.finish()) {
+        showLoadTestReport(m_loadTestAnalyzer.report());
+    }
 
-                    updatePlot(
-                        voltage,
-                        current,
-                        charge,
-                        temperature
-                        );
+    m_replayDialog->hide();
+    m_replayDialog->deleteLater();
+    m_replayDialog = nullptr;
+    m_replaySource->deleteLater();
+    m_replaySource = nullptr;
 
-                    ui->lblPackVoltage->setText(QString("%1 V").arg(voltage, 5, 'f', 2));
-                    ui->lblCurrent->setText(QString("%1 A").arg(current, 5, 'f', 2));
+    startLiveSource();
+}
 
-                    for (int i = 0; i < 6; i++) {
-                        qreal v = static_cast<qreal>(packet.cell_voltage[i]) / 1000.0;
-                        if (m_cellBalanceStatusForm != nullptr) {
-                            m_cellBalanceStatusForm->setCellVoltage(i, v);
-                        }
-                    }
+void MainWindow::on_actConnectNetworkBridge_triggered()
+{
+    NetworkBridgeDialog dialog(this);
+    dialog.setProtocol(m_config.networkProtocol);
+    dialog.setHost(m_config.networkHost);
+    dialog.setPort(m_config.networkPort);
 
-                    switch (packet.mode) {
-                    case MODE_DISCHARGING:
-                        ui->lblMode->setText(tr("Discharging"));
-                        break;
-                    case MODE_CHARGING:
-                        ui->lblMode->setText(tr("Charging"));
-                        break;
-                    case MODE_LOAD_TEST:
-                        ui->lblMode->setText(tr("Load Test"));
-                        break;
-                    }
+    if (dialog.exec() != QDialog::Accepted) {
+        return;
+    }
 
-                    ui->lblChargeState->setText(
-                                QString("%1 %2")
-                                    .arg(charge, 6, 'f', 4)
-                                    .arg(chargeSuffix()));
+    QSettings settings;
+    settings.setValue("network/protocol", dialog.protocol());
+    settings.setValue("network/host", dialog.host());
+    settings.setValue("network/port", dialog.port());
+    m_config.networkProtocol = dialog.protocol();
+    m_config.networkHost = dialog.host();
+    m_config.networkPort = dialog.port();
+
+    PacketSource *source;
+    if (m_config.networkProtocol == "udp") {
+        source = new UdpPacketSource(m_config.networkHost, m_config.networkPort, &m_sampleClock, this);
+    }
+    else {
+        source = new TcpPacketSource(m_config.networkHost, m_config.networkPort, &m_sampleClock, this);
+    }
 
-                    ui->lblTemperature->setText(
-                                QString("%1 °%2")
-                                    .arg(temperature, 4, 'f', 2)
-                                    .arg(temperatureSuffix()));
-                }
+    connect(source, &PacketSource::readyRead, this, &MainWindow::on_packetSourceReadyRead);
+    connect(source, &PacketSource::opened, this, &MainWindow::on_packetSourceOpened);
+    connect(source, &PacketSource::lost, this, &MainWindow::on_packetSourceLost);
 
-                m_inMessage = false;
-                m_inHeader = false;
-                m_dataBuffer.clear();
-            }
-        }
+    if (m_selectSerialPortDialog != nullptr) {
+        m_selectSerialPortDialog->reject();
     }
+
+    setLiveSource(source);
 }
 
-void MainWindow::on_sleepTimerTimeout()
+void MainWindow::on_actDisconnectNetworkBridge_triggered()
 {
-    m_waitingMessageBox->show();
-    m_waitingMessageBox->raise();
+    setLiveSource(m_serialSource);
 }
 
-void MainWindow::on_waitingMessageBoxButtonClicked(QAbstractButton *button)
+//
+// Makes the given source the one the main window drains. The previous
+// source is closed but kept; live sources outlive replays.
+//
+void MainWindow::activatePacketSource(PacketSource *source)
 {
-    //close();
+    if (source == m_packetSource) {
+        return;
+    }
+
+    m_packetSource->close();
+    m_packetSource = source;
+
+    m_packetDecoder.reset();
+    m_sampleClock.resetIntervalEstimate();
+    m_sleepTimer->stop();
+    m_telemetryHoldTimer->stop();
+    m_waitingMessageBox->hide();
 }
 
-void MainWindow::on_chartUpdateTimer_timeout()
+//
+// Replaces the serial port or network bridge that data is taken from when
+// no replay is running. A network source is owned here and deleted when
+// it is replaced; the serial source lives as long as the window.
+//
+void MainWindow::setLiveSource(PacketSource *source)
 {
-    qreal width = m_chart->geometry().width();
-
-    qDebug() << "Chart Area Width:" << width;
+    PacketSource *previous = m_liveSource;
+    m_liveSource = source;
 
-    if (m_chartDataPackVoltage.count() > 300) {
+    if (m_replaySource == nullptr) {
+        activatePacketSource(source);
+        startLiveSource();
+    }
 
+    if (previous != m_serialSource && previous != source) {
+        previous->close();
+        previous->deleteLater();
     }
+
+    ui->actDisconnectNetworkBridge->setEnabled(m_liveSource != m_serialSource);
 }
 
-void MainWindow::updatePlot(qreal voltage, qreal current, qreal charge, qreal temperature)
+void MainWindow::startLiveSource()
 {
-    QDateTime timestamp = QDateTime::currentDateTime();
+    if (m_liveSource == m_serialSource) {
+        const PortMatch &target = m_portManager->target();
 
-    m_chartSeriesPackVoltage->append(timestamp.toMSecsSinceEpoch(), voltage);
-    m_chartSeriesCurrent->append(timestamp.toMSecsSinceEpoch(), current);
-    m_chartSeriesCharge->append(timestamp.toMSecsSinceEpoch(), charge);
-    m_chartSeriesTemperature->append(timestamp.toMSecsSinceEpoch(), temperature);
+        if (!target.isValid()) {
+            m_serialPortLabel->setText(tr("Not connected"));
+            return;
+        }
 
-    if ((timestamp.toSecsSinceEpoch() - m_startDateTime.toSecsSinceEpoch()) > 300) {
-        m_chartAxisTime->setMax(timestamp);
+        m_serialPortLabel->setText(tr("Waiting for %1").arg(target.portName));
+    }
+    else {
+        m_serialPortLabel->setText(tr("Waiting for %1").arg(m_liveSource->description()));
     }
-}
 
-qreal MainWindow::convertTemperature(qreal temperature_c)
-{
-    if (m_temperatureUnit == "farenheit") return ((temperature_c * (9.0/5.0)) + 32.0);
-    else return temperature_c;
+    m_liveSource->start();
 }
 
-qreal MainWindow::convertCharge(qreal current_c)
+void MainWindow::on_replaySourceStateChanged()
 {
-    if (m_chargeUnit == "amphour") return (current_c / 3600);
-    else return current_c;
+    m_serialPortLabel->setText(m_replaySource->description());
 }
 
-QString MainWindow::chargeSuffix()
+//
+// At full speed the replay is an end-to-end benchmark, so its throughput
+// is reported along with everything else the diagnostics print.
+//
+void MainWindow::on_replaySourceFinished()
 {
-    if (m_chargeUnit == "amphour") return QString("Ah");
-    else return QString("C");
+    if (m_loadTestAnalyzer.finish()) {
+        showLoadTestReport(m_loadTestAnalyzer.report());
+    }
+
+    qreal runTime = m_replaySource->runTime();
+    qCDebug(lcDiagnostics) << "Replay finished:" << m_replaySource->framesDelivered() << "frames in" << runTime << "s"
+             << "(" << ((runTime > 0.0) ? m_replaySource->framesDelivered() / runTime : 0.0) << "frames/s )"
+             << "speed:" << m_replaySource->speed();
+
+    m_serialPortLabel->setText(tr("Replay finished"));
 }
 
-QString MainWindow::temperatureSuffix()
+void MainWindow::on_replayDialogSeekRequested(qreal seconds)
 {
-    if (m_temperatureUnit == "farenheit") return QString("F");
-    else return QString("C");
+    if (m_loadTestAnalyzer.finish()) {
+        saveLoadTestReport(m_loadTestAnalyzer.report());
+    }
+
+    clearSession();
+    m_packetDecoder.reset();
+    m_replaySource->seek(seconds);
 }
 
-void MainWindow::on_actClearData_triggered()
+//
+// Writes the dominant ripple frequency and amplitude of every analysis
+// frame so far.
+//
+void MainWindow::on_actExportSpectrumMetrics_triggered()
 {
-    int result = QMessageBox::question(
+    QString fileName = QFileDialog::getSaveFileName(
                 this,
-                tr("Battery Pack Analyzer"),
-                tr("Do you really want to clear all data from the graph?"));
+                tr("Export Ripple Metrics"),
+                QString(),
+                tr("CSV Files (*.csv)"));
 
-    if (result == QMessageBox::Yes) {
+    if (fileName.isEmpty()) {
+        return;
+    }
 
-        m_chartSeriesCharge->clear();
-        m_chartSeriesPackVoltage->clear();
-        m_chartSeriesCurrent->clear();
-        m_chartSeriesTemperature->clear();
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        QMessageBox::critical(
+                    this,
+                    tr("File Error"),
+                    tr("Could not open file %1 for writing!").arg(fileName));
+        return;
+    }
 
-        m_startDateTime = QDateTime::currentDateTime();
-        m_chartAxisTime->setMin(m_startDateTime);
-        m_chartAxisTime->setMax(m_startDateTime.addSecs(300));
+    file.write("time,elapsed,sample_rate,current_frequency,current_amplitude,voltage_frequency,voltage_amplitude\n");
+
+    char line[160];
+    for (const SpectrumMetrics &metrics : m_spectrumHistory) {
+        int length = formatClockTime(line, sizeof(line), QTime::fromMSecsSinceStartOfDay(m_sampleClock.localMSecsSinceStartOfDay(metrics.timestamp)));
+        length += qsnprintf(
+                    line + length,
+                    static_cast<size_t>(sizeof(line) - length),
+                    ",%.3f,%.2f,%.3f,%.4f,%.3f,%.4f\n",
+                    static_cast<qreal>(metrics.timestamp - m_sessionStart) / 1000000.0,
+                    metrics.sampleRate,
+                    metrics.currentFrequency,
+                    metrics.currentAmplitude,
+                    metrics.voltageFrequency,
+                    metrics.voltageAmplitude);
+        file.write(line, length);
     }
 }
 
-void MainWindow::on_actSaveData_triggered()
+void MainWindow::on_actExportReport_triggered()
 {
+    if (m_reportWatcher.isRunning()) {
+        statusBar()->showMessage(tr("A report is already being rendered"), AlarmMessageTimeout);
+        return;
+    }
+
     QString fileName = QFileDialog::getSaveFileName(
                 this,
-                tr("Save As"));
+                tr("Export Report"),
+                "report-" + m_startDateTime.toString("yyyyMMdd-hhmmss") + ".png",
+                tr("PNG Images (*.png);;PDF Documents (*.pdf);;SVG Images (*.svg)"));
 
-    if (!fileName.isEmpty()) {
-        for (int i = 0; i < m_chartSeriesPackVoltage->count(); i++) {
+    if (fileName.isEmpty()) {
+        return;
+    }
 
-        }
+    ReportOptions options;
+    options.fileName = fileName;
+    options.title = tr("Session %1").arg(m_startDateTime.toString("yyyy-MM-dd hh:mm:ss"));
+    startReport(options);
+}
+
+//
+// Renders from the session snapshot on the global thread pool. The
+// blocking flush waits for the samples handed over by saveSession() to
+// reach the file, so the report covers everything decoded so far.
+//
+bool MainWindow::startReport(const ReportOptions &options)
+{
+    if (m_reportWatcher.isRunning()) {
+        qCDebug(lcDiagnostics) << "Report still rendering, skipped" << options.fileName;
+        return false;
+    }
+
+    saveSession();
+    QMetaObject::invokeMethod(m_snapshotWriter, "flush", Qt::BlockingQueuedConnection);
+
+    m_reportWatcher.setFuture(QtConcurrent::run(&ReportRenderer::render, SessionSnapshot::defaultPath(), options));
+    statusBar()->showMessage(tr("Rendering report %1...").arg(QDir::toNativeSeparators(options.fileName)));
+    return true;
+}
+
+void MainWindow::on_reportWatcherFinished()
+{
+    ReportResult result = m_reportWatcher.result();
+
+    if (!result.isValid()) {
+        statusBar()->clearMessage();
+        QMessageBox::warning(
+                    this,
+                    tr("Report Error"),
+                    result.errorString);
+        return;
     }
+
+    qCDebug(lcDiagnostics) << "Report" << result.fileName << result.samples << "samples in" << result.elapsed << "ms";
+    statusBar()->showMessage(tr("Report saved to %1").arg(QDir::toNativeSeparators(result.fileName)), AlarmMessageTimeout);
 }
 
 void MainWindow::on_actCellBalancing_triggered()
@@ -464,24 +2346,56 @@ void MainWindow::on_actCellBalancing_triggered()
 
 void MainWindow::on_actPackVoltageShow_triggered(bool checked)
 {
+    if (m_plotWidget != nullptr) {
+        m_plotWidget->setChannelVisible(ScrollingPlotWidget::ChannelPackVoltage, checked);
+    }
+
+    if (m_chart == nullptr) {
+        return;
+    }
+
     m_chartSeriesPackVoltage->setVisible(checked);
     m_chartAxisPackVoltage->setVisible(checked);
 }
 
 void MainWindow::on_actShowHideCurrent_triggered(bool checked)
 {
+    if (m_plotWidget != nullptr) {
+        m_plotWidget->setChannelVisible(ScrollingPlotWidget::ChannelCurrent, checked);
+    }
+
+    if (m_chart == nullptr) {
+        return;
+    }
+
     m_chartSeriesCurrent->setVisible(checked);
     m_chartAxisCurrent->setVisible(checked);
 }
 
 void MainWindow::on_actShowHideChargeLevel_triggered(bool checked)
 {
+    if (m_plotWidget != nullptr) {
+        m_plotWidget->setChannelVisible(ScrollingPlotWidget::ChannelCharge, checked);
+    }
+
+    if (m_chart == nullptr) {
+        return;
+    }
+
     m_chartSeriesCharge->setVisible(checked);
     m_chartAxisCharge->setVisible(checked);
 }
 
 void MainWindow::on_actShowHideTemperature_triggered(bool checked)
 {
+    if (m_plotWidget != nullptr) {
+        m_plotWidget->setChannelVisible(ScrollingPlotWidget::ChannelTemperature, checked);
+    }
+
+    if (m_chart == nullptr) {
+        return;
+    }
+
     m_chartSeriesTemperature->setVisible(checked);
     m_chartAxisTemperature->setVisible(checked);
 }
@@ -501,9 +2415,6 @@ void MainWindow::on_actStartLogging_triggered()
         if (!fileName.isEmpty()) {
             m_dataLogFile = new QFile(fileName);
 
-            QTextStream stream(m_dataLogFile);
-            stream << "time,voltage,current,charge,temperature\n";
-
             if (!m_dataLogFile->open(QIODevice::WriteOnly)) {
                 int result = QMessageBox::critical(
                             this,
@@ -515,6 +2426,13 @@ void MainWindow::on_actStartLogging_triggered()
                 }
             }
             else {
+                QByteArray header("time,elapsed,voltage,current,charge,temperature,soc,resistance,mode,cell1,cell2,cell3,cell4,cell5,cell6");
+                for (int c = 0; c < m_derivedChannels.channelCount(); c++) {
+                    header += ',' + m_derivedChannels.definition(c).name.toLatin1();
+                }
+                logSessionStart();
+                m_dataLogFile->write(header + '\n');
+
                 ui->actStartLogging->setEnabled(false);
                 ui->actStopLogging->setEnabled(true);
                 m_dataLogLabel->setText(tr("Logging data to %1").arg(fileName));
@@ -526,19 +2444,13 @@ void MainWindow::on_actStartLogging_triggered()
                             QMessageBox::Yes | QMessageBox::No);
 
                 if (result == QMessageBox::Yes) {
-                    for (int i = 0; i < m_chartSeriesPackVoltage->count(); i++) {
-                        qreal timestamp = m_chartSeriesPackVoltage->at(i).x();
-                        QDateTime timestampDateTime = QDateTime::fromMSecsSinceEpoch(timestamp);
-
-                        qreal voltage = m_chartSeriesPackVoltage->at(i).y();
-                        qreal current = m_chartSeriesCurrent->at(i).y();
-                        qreal charge = m_chartSeriesCharge->at(i).y();
-                        qreal temperature = m_chartSeriesTemperature->at(i).y();
-                        stream << timestampDateTime.toString("h:mm:ss AP") << ",";
-                        stream << voltage << ",";
-                        stream << current << ",";
-                        stream << charge << ",";
-                        stream << temperature << "\n";
+                    char line[LogLineSize];
+                    qint64 count = m_estimateStore.count();
+                    evaluateDerivedChannels(count);
+
+                    for (qint64 i = 0; i < count; i++) {
+                        int length = formatLogLine(line, sizeof(line), i);
+                        m_dataLogFile->write(line, length);
                     }
                 }
 
@@ -572,161 +2484,402 @@ void MainWindow::on_actStopLogging_triggered()
     }
 }
 
+void MainWindow::on_actStartRawCapture_triggered()
+{
+    QString fileName = QFileDialog::getSaveFileName(
+                this,
+                tr("Start Raw Capture"),
+                QString(),
+                tr("Raw Captures (*.pbmcap)"));
+
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    qint64 now = m_sampleClock.now();
+    qint64 sizeLimit = static_cast<qint64>(m_config.captureSizeLimit) * 1024 * 1024;
+
+    if (!m_rawCapture.open(fileName, sizeLimit, m_sampleClock.toWallUSecs(now), now)) {
+        QMessageBox::critical(
+                    this,
+                    tr("File Error"),
+                    tr("Could not open file %1 for writing!").arg(fileName));
+        return;
+    }
+
+    ui->actStartRawCapture->setEnabled(false);
+    ui->actStopRawCapture->setEnabled(true);
+}
+
+void MainWindow::on_actStopRawCapture_triggered()
+{
+    m_rawCapture.close();
+
+    qCDebug(lcDiagnostics) << "Raw capture closed:" << m_rawCapture.chunks() << "chunks," << m_rawCapture.bytes() << "bytes,"
+             << m_rawCapture.rotations() << "rotations";
+
+    ui->actStartRawCapture->setEnabled(true);
+    ui->actStopRawCapture->setEnabled(false);
+}
+
 void MainWindow::on_actCurrentShow_triggered(bool checked)
 {
-   m_chartAxisCurrent->setVisible(checked);
+    if (m_chart == nullptr) {
+        return;
+    }
+
+    m_chartAxisCurrent->setVisible(checked);
 }
 
 void MainWindow::on_actChargeShow_triggered(bool checked)
 {
+    if (m_chart == nullptr) {
+        return;
+    }
+
     m_chartAxisCharge->setVisible(checked);
 }
 
 void MainWindow::on_actTemperatureShow_triggered(bool checked)
 {
+    if (m_chart == nullptr) {
+        return;
+    }
+
     m_chartAxisTemperature->setVisible(checked);
 }
 
 void MainWindow::on_actPackVoltageColor_triggered()
 {
-    QColor oldColor = m_chartSeriesPackVoltage->color();
+    QColor oldColor = m_config.voltageColor;
     QColor newColor = QColorDialog::getColor(
                 oldColor,
                 this,
                 tr("Choose Line Color"));
 
     if (newColor.isValid()) {
-        m_chartSeriesPackVoltage->setColor(newColor);
+        if (m_chart != nullptr) {
+            m_chartSeriesPackVoltage->setColor(newColor);
+        }
+        if (m_plotWidget != nullptr) {
+            m_plotWidget->setChannelColor(ScrollingPlotWidget::ChannelPackVoltage, newColor);
+        }
 
         QSettings settings;
         settings.setValue("chart/axes/voltage/lineColor", newColor);
+        m_config.voltageColor = newColor;
     }
 }
 
 void MainWindow::on_actCurrentColor_triggered()
 {
-    QColor oldColor = m_chartSeriesCurrent->color();
+    QColor oldColor = m_config.currentColor;
     QColor newColor = QColorDialog::getColor(
                 oldColor,
                 this,
                 tr("Choose Line Color"));
 
     if (newColor.isValid()) {
-        m_chartSeriesCurrent->setColor(newColor);
+        if (m_chart != nullptr) {
+            m_chartSeriesCurrent->setColor(newColor);
+        }
+        if (m_plotWidget != nullptr) {
+            m_plotWidget->setChannelColor(ScrollingPlotWidget::ChannelCurrent, newColor);
+        }
 
         QSettings settings;
         settings.setValue("chart/axes/current/lineColor", newColor);
+        m_config.currentColor = newColor;
     }
 }
 
 void MainWindow::on_actChargeColor_triggered()
 {
-    QColor oldColor = m_chartSeriesCharge->color();
+    QColor oldColor = m_config.chargeColor;
     QColor newColor = QColorDialog::getColor(
                 oldColor,
                 this,
                 tr("Choose Line Color"));
 
     if (newColor.isValid()) {
-        m_chartSeriesCharge->setColor(newColor);
+        if (m_chart != nullptr) {
+            m_chartSeriesCharge->setColor(newColor);
+        }
+        if (m_plotWidget != nullptr) {
+            m_plotWidget->setChannelColor(ScrollingPlotWidget::ChannelCharge, newColor);
+        }
 
         QSettings settings;
         settings.setValue("chart/axes/charge/lineColor", newColor);
+        m_config.chargeColor = newColor;
     }
 }
 
 void MainWindow::on_actTemperatureColor_triggered()
 {
-    QColor oldColor = m_chartSeriesTemperature->color();
+    QColor oldColor = m_config.temperatureColor;
     QColor newColor = QColorDialog::getColor(
                 oldColor,
                 this,
                 tr("Choose Line Color"));
 
     if (newColor.isValid()) {
-        m_chartSeriesTemperature->setColor(newColor);
+        if (m_chart != nullptr) {
+            m_chartSeriesTemperature->setColor(newColor);
+        }
+        if (m_plotWidget != nullptr) {
+            m_plotWidget->setChannelColor(ScrollingPlotWidget::ChannelTemperature, newColor);
+        }
 
         QSettings settings;
         settings.setValue("chart/axes/temperature/lineColor", newColor);
+        m_config.temperatureColor = newColor;
     }
 }
 
 void MainWindow::on_actPackVoltageOrientationLeft_triggered(bool checked)
 {
-    m_chart->removeAxis(m_chartAxisPackVoltage);
-    m_chart->addAxis(m_chartAxisPackVoltage, checked ? Qt::AlignLeft : Qt::AlignRight);
+    if (m_chart != nullptr) {
+        m_chart->removeAxis(m_chartAxisPackVoltage);
+        m_chart->addAxis(m_chartAxisPackVoltage, checked ? Qt::AlignLeft : Qt::AlignRight);
+    }
+    if (m_plotWidget != nullptr) {
+        m_plotWidget->setChannelLeftAligned(ScrollingPlotWidget::ChannelPackVoltage, checked);
+    }
     ui->actPackVoltageOrientationRight->setChecked(!checked);
     QSettings settings;
     settings.setValue("chart/axes/voltage/orientation", checked);
+    m_config.voltageAxisLeft = checked;
 }
 
 void MainWindow::on_actPackVoltageOrientationRight_triggered(bool checked)
 {
-    m_chart->removeAxis(m_chartAxisPackVoltage);
-    m_chart->addAxis(m_chartAxisPackVoltage, !checked ? Qt::AlignLeft : Qt::AlignRight);
+    if (m_chart != nullptr) {
+        m_chart->removeAxis(m_chartAxisPackVoltage);
+        m_chart->addAxis(m_chartAxisPackVoltage, !checked ? Qt::AlignLeft : Qt::AlignRight);
+    }
+    if (m_plotWidget != nullptr) {
+        m_plotWidget->setChannelLeftAligned(ScrollingPlotWidget::ChannelPackVoltage, !checked);
+    }
     ui->actPackVoltageOrientationLeft->setChecked(!checked);
     QSettings settings;
     settings.setValue("chart/axes/voltage/orientation", !checked);
+    m_config.voltageAxisLeft = !checked;
 }
 
 void MainWindow::on_actCurrentOrientationLeft_triggered(bool checked)
 {
-    m_chart->removeAxis(m_chartAxisCurrent);
-    m_chart->addAxis(m_chartAxisCurrent, checked ? Qt::AlignLeft : Qt::AlignRight);
+    if (m_chart != nullptr) {
+        m_chart->removeAxis(m_chartAxisCurrent);
+        m_chart->addAxis(m_chartAxisCurrent, checked ? Qt::AlignLeft : Qt::AlignRight);
+    }
+    if (m_plotWidget != nullptr) {
+        m_plotWidget->setChannelLeftAligned(ScrollingPlotWidget::ChannelCurrent, checked);
+    }
     ui->actCurrentOrientationRight->setChecked(!checked);
     QSettings settings;
     settings.setValue("chart/axes/current/orientation", checked);
+    m_config.currentAxisLeft = checked;
 }
 
 void MainWindow::on_actCurrentOrientationRight_triggered(bool checked)
 {
-    m_chart->removeAxis(m_chartAxisCurrent);
-    m_chart->addAxis(m_chartAxisCurrent, !checked ? Qt::AlignLeft : Qt::AlignRight);
+    if (m_chart != nullptr) {
+        m_chart->removeAxis(m_chartAxisCurrent);
+        m_chart->addAxis(m_chartAxisCurrent, !checked ? Qt::AlignLeft : Qt::AlignRight);
+    }
+    if (m_plotWidget != nullptr) {
+        m_plotWidget->setChannelLeftAligned(ScrollingPlotWidget::ChannelCurrent, !checked);
+    }
     ui->actCurrentOrientationLeft->setChecked(!checked);
     QSettings settings;
     settings.setValue("chart/axes/current/orientation", !checked);
+    m_config.currentAxisLeft = !checked;
 }
 
 void MainWindow::on_actChargeOrientationLeft_triggered(bool checked)
 {
-    m_chart->removeAxis(m_chartAxisCharge);
-    m_chart->addAxis(m_chartAxisCharge, checked ? Qt::AlignLeft : Qt::AlignRight);
+    if (m_chart != nullptr) {
+        m_chart->removeAxis(m_chartAxisCharge);
+        m_chart->addAxis(m_chartAxisCharge, checked ? Qt::AlignLeft : Qt::AlignRight);
+    }
+    if (m_plotWidget != nullptr) {
+        m_plotWidget->setChannelLeftAligned(ScrollingPlotWidget::ChannelCharge, checked);
+    }
     ui->actChargeOrientationRight->setChecked(!checked);
     QSettings settings;
     settings.setValue("chart/axes/charge/orientation", checked);
+    m_config.chargeAxisLeft = checked;
 }
 
 void MainWindow::on_actChargeOrientationRight_triggered(bool checked)
 {
-    m_chart->removeAxis(m_chartAxisCharge);
-    m_chart->addAxis(m_chartAxisCharge, !checked ? Qt::AlignLeft : Qt::AlignRight);
+    if (m_chart != nullptr) {
+        m_chart->removeAxis(m_chartAxisCharge);
+        m_chart->addAxis(m_chartAxisCharge, !checked ? Qt::AlignLeft : Qt::AlignRight);
+    }
+    if (m_plotWidget != nullptr) {
+        m_plotWidget->setChannelLeftAligned(ScrollingPlotWidget::ChannelCharge, !checked);
+    }
     ui->actChargeOrientationLeft->setChecked(!checked);
     QSettings settings;
     settings.setValue("chart/axes/charge/orientation", !checked);
+    m_config.chargeAxisLeft = !checked;
 }
 
 void MainWindow::on_actTemperatureOrientationLeft_triggered(bool checked)
 {
-    m_chart->removeAxis(m_chartAxisTemperature);
-    m_chart->addAxis(m_chartAxisTemperature, checked ? Qt::AlignLeft : Qt::AlignRight);
+    if (m_chart != nullptr) {
+        m_chart->removeAxis(m_chartAxisTemperature);
+        m_chart->addAxis(m_chartAxisTemperature, checked ? Qt::AlignLeft : Qt::AlignRight);
+    }
+    if (m_plotWidget != nullptr) {
+        m_plotWidget->setChannelLeftAligned(ScrollingPlotWidget::ChannelTemperature, checked);
+    }
     ui->actTemperatureOrientationRight->setChecked(!checked);
     QSettings settings;
     settings.setValue("chart/axes/temperature/orientation", checked);
+    m_config.temperatureAxisLeft = checked;
 }
 
 void MainWindow::on_actTemperatureOrientationRight_triggered(bool checked)
 {
-    m_chart->removeAxis(m_chartAxisTemperature);
-    m_chart->addAxis(m_chartAxisTemperature, !checked ? Qt::AlignLeft : Qt::AlignRight);
+    if (m_chart != nullptr) {
+        m_chart->removeAxis(m_chartAxisTemperature);
+        m_chart->addAxis(m_chartAxisTemperature, !checked ? Qt::AlignLeft : Qt::AlignRight);
+    }
+    if (m_plotWidget != nullptr) {
+        m_plotWidget->setChannelLeftAligned(ScrollingPlotWidget::ChannelTemperature, !checked);
+    }
     ui->actTemperatureOrientationLeft->setChecked(!checked);
     QSettings settings;
     settings.setValue("chart/axes/temperature/orientation", !checked);
+    m_config.temperatureAxisLeft = !checked;
+}
+
+void MainWindow::on_actPackVoltageAutoScale_triggered(bool checked)
+{
+    m_axisAutoScale[AxisPackVoltage] = checked;
+    m_axisScales[AxisPackVoltage].invalidate();
+    updateAxisScales();
+    QSettings settings;
+    settings.setValue("chart/axes/voltage/autoScale", checked);
+    m_config.voltageAutoScale = checked;
+}
+
+void MainWindow::on_actCurrentAutoScale_triggered(bool checked)
+{
+    m_axisAutoScale[AxisCurrent] = checked;
+    m_axisScales[AxisCurrent].invalidate();
+    updateAxisScales();
+    QSettings settings;
+    settings.setValue("chart/axes/current/autoScale", checked);
+    m_config.currentAutoScale = checked;
+}
+
+void MainWindow::on_actChargeAutoScale_triggered(bool checked)
+{
+    m_axisAutoScale[AxisCharge] = checked;
+    m_axisScales[AxisCharge].invalidate();
+    updateAxisScales();
+    QSettings settings;
+    settings.setValue("chart/axes/charge/autoScale", checked);
+    m_config.chargeAutoScale = checked;
+}
+
+void MainWindow::on_actTemperatureAutoScale_triggered(bool checked)
+{
+    m_axisAutoScale[AxisTemperature] = checked;
+    m_axisScales[AxisTemperature].invalidate();
+    updateAxisScales();
+    QSettings settings;
+    settings.setValue("chart/axes/temperature/autoScale", checked);
+    m_config.temperatureAutoScale = checked;
+}
+
+void MainWindow::on_actEstimatesShow_triggered(bool checked)
+{
+    if (m_plotWidget != nullptr) {
+        m_plotWidget->setChannelVisible(ScrollingPlotWidget::ChannelStateOfCharge, checked);
+        m_plotWidget->setChannelVisible(ScrollingPlotWidget::ChannelResistance, checked);
+    }
+
+    if (m_chart != nullptr) {
+        m_chartSeriesStateOfCharge->setVisible(checked);
+        m_chartAxisStateOfCharge->setVisible(checked);
+        m_chartSeriesResistance->setVisible(checked);
+        m_chartAxisResistance->setVisible(checked);
+    }
+
+    QSettings settings;
+    settings.setValue("chart/estimates/visible", checked);
+    m_config.estimatesVisible = checked;
+}
+
+void MainWindow::on_actResistanceAutoScale_triggered(bool checked)
+{
+    m_axisAutoScale[AxisResistance] = checked;
+    m_axisScales[AxisResistance].invalidate();
+    updateAxisScales();
+    QSettings settings;
+    settings.setValue("chart/axes/resistance/autoScale", checked);
+    m_config.resistanceAutoScale = checked;
+}
+
+void MainWindow::on_actDerivedChannels_triggered()
+{
+    if (m_dataLogFile != nullptr && m_dataLogFile->isOpen()) {
+        QMessageBox::information(
+                    this,
+                    tr("Derived Channels"),
+                    tr("Stop logging before changing derived channels; a log's columns are fixed when it starts."));
+        return;
+    }
+
+    DerivedChannelsDialog dialog(this);
+    dialog.setDefinitions(m_config.derivedChannels);
+    if (dialog.exec() != QDialog::Accepted) {
+        return;
+    }
+
+    QVector<DerivedChannelDefinition> definitions = dialog.definitions();
+
+    QSettings settings;
+    settings.remove("derived/channels");
+    settings.beginWriteArray("derived/channels", definitions.count());
+    for (int i = 0; i < definitions.count(); i++) {
+        const DerivedChannelDefinition &definition = definitions[i];
+        settings.setArrayIndex(i);
+        settings.setValue("name", definition.name);
+        settings.setValue("expression", definition.expression);
+        settings.setValue("color", definition.color);
+        settings.setValue("alarmBelowEnabled", definition.alarmBelowEnabled);
+        settings.setValue("alarmBelow", definition.alarmBelow);
+        settings.setValue("alarmAboveEnabled", definition.alarmAboveEnabled);
+        settings.setValue("alarmAbove", definition.alarmAbove);
+    }
+    settings.endArray();
+    m_config.derivedChannels = definitions;
+
+    //
+    // the whole session is re-evaluated; limits crossed in its history
+    // are not reported
+    //
+    m_derivedChannels.setDefinitions(definitions);
+    m_derivedChannels.evaluate(m_sampleStore, m_estimateStore, m_estimateStore.count());
+    m_derivedChannels.takeAlarms();
+
+    createDerivedSeries();
+    rebuildSeries();
 }
 
 void MainWindow::on_actViewSettings_triggered()
 {
     SettingsDialog settings(this);
     settings.exec();
+
+    m_config = AppConfig::load();
+    applyUnitSettings();
 }
 
 void MainWindow::on_actAbout_triggered()
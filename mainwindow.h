@@ -2,6 +2,33 @@
 #define MAINWINDOW_H
 
 #include "cellmonitordialog.h"
+#include "packetdecoder.h"
+#include "sampleclock.h"
+#include "commandchannel.h"
+#include "portmanager.h"
+#include "packetsource.h"
+#include "replaysource.h"
+#include "replaydialog.h"
+#include "networksource.h"
+#include "networkbridgedialog.h"
+#include "rawcapture.h"
+#include "selectserialportdialog.h"
+#include "appconfig.h"
+#include "sample.h"
+#include "samplestore.h"
+#include "batteryestimator.h"
+#include "estimatestore.h"
+#include "derivedchannels.h"
+#include "sessionsnapshot.h"
+#include "scrollingplotwidget.h"
+#include "slidingrange.h"
+#include "spectrumanalyzer.h"
+#include "spectrumdialog.h"
+#include "comparisondialog.h"
+#include "loadtestanalyzer.h"
+#include "triggerengine.h"
+#include "triggerdialog.h"
+#include "reportrenderer.h"
 
 #include <QMainWindow>
 #include <QSerialPort>
@@ -12,7 +39,12 @@
 #include <QPointF>
 #include <QFile>
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <QLabel>
+#include <QPointer>
+#include <QList>
+#include <QThread>
+#include <QFutureWatcher>
 #include <QtCharts/QChart>
 #include <QtCharts/QValueAxis>
 #include <QtCharts/QDateTimeAxis>
@@ -35,26 +67,83 @@ public:
 protected:
     void closeEvent(QCloseEvent *event);
     void showEvent(QShowEvent *event);
-    void updatePlot(qreal voltage, qreal current, qreal charge, qreal temperature);
+    bool eventFilter(QObject *watched, QEvent *event);
+    void processPacket(const status_packet_t &packet, qint64 timestamp);
+    void recordFrames(qint64 timestamp, int frames, qint64 first);
+    int formatLogLine(char *buffer, int size, qint64 index);
+    void logPendingSamples(qint64 end);
+    void logSessionStart();
+    void evaluateDerivedChannels(qint64 end);
+    void reportDerivedAlarms();
+    void collectTriggerCapture();
+    void updateLabels(const status_packet_t &packet, qreal charge, qreal temperature);
+    void plotPendingSamples();
+    void rebuildSeries();
+    void updateTimeAxis();
+    void restoreSession();
+    void saveSession();
+    void applyUnitSettings();
+    void applyChartUnits();
+    void updateAxisScales();
+    void resetAxisScales();
+    void onSerialPortOpened();
+    void updateTelemetryRate(const status_packet_t &packet);
+    int sleepTimeout() const;
+    QString saveLoadTestReport(const LoadTestReport &report);
+    void showLoadTestReport(const LoadTestReport &report);
+    bool startReport(const ReportOptions &options);
     qreal convertTemperature(qreal temperature_c);
     qreal convertCharge(qreal current_c);
     QString chargeSuffix();
     QString temperatureSuffix();
 
+signals:
+    void snapshotSamplesReady(const QVector<Sample> &samples, qint64 axisMin, qint64 axisMax);
+    void snapshotReset(qint64 sessionStart);
+
 private slots:
-    void on_serialPortReadyRead();
+    void createChart();
+    void createPlotWidget();
+    void on_packetSourceReadyRead();
     void on_sleepTimerTimeout();
+    void on_idleTimer_timeout();
     void on_waitingMessageBoxButtonClicked(QAbstractButton *button);
     void on_chartUpdateTimer_timeout();
+    void on_diagnosticsTimer_timeout();
+    void on_snapshotTimer_timeout();
+    void on_telemetryHoldTimer_timeout();
+    void on_selectSerialPortDialogAccepted();
+    void on_packetSourceOpened();
+    void on_packetSourceLost();
+    void on_commandChannelBaudRateChanged(qint32 baudRate);
+    void on_commandChannelTelemetryIntervalChanged(int milliseconds);
+    void on_spectrumAnalyzerSpectrumReady(const SpectrumMetrics &metrics);
     void on_actClearData_triggered();
     void on_actSaveData_triggered();
     void on_actCellBalancing_triggered();
+    void on_actSpectrum_triggered();
+    void on_actTriggeredCaptures_triggered();
+    void on_triggerDialogSettingsApplied(const TriggerSettings &trigger);
+    void on_actLoadComparisonData_triggered();
+    void on_actReplayLog_triggered();
+    void on_replaySourceStateChanged();
+    void on_replaySourceFinished();
+    void on_replayDialogSeekRequested(qreal seconds);
+    void stopReplay();
+    void on_actConnectNetworkBridge_triggered();
+    void on_actDisconnectNetworkBridge_triggered();
+    void on_actExportSpectrumMetrics_triggered();
+    void on_actExportReport_triggered();
+    void on_reportWatcherFinished();
+    void on_estimateWatcherFinished();
     void on_actShowHideCurrent_triggered(bool checked);
     void on_actShowHideChargeLevel_triggered(bool checked);
     void on_actShowHideTemperature_triggered(bool checked);
     void on_actExit_triggered();
     void on_actStartLogging_triggered();
     void on_actStopLogging_triggered();
+    void on_actStartRawCapture_triggered();
+    void on_actStopRawCapture_triggered();
     void on_actPackVoltageShow_triggered(bool checked);
     void on_actCurrentShow_triggered(bool checked);
     void on_actChargeShow_triggered(bool checked);
@@ -71,18 +160,88 @@ private slots:
     void on_actChargeOrientationRight_triggered(bool checked);
     void on_actTemperatureOrientationLeft_triggered(bool checked);
     void on_actTemperatureOrientationRight_triggered(bool checked);
+    void on_actPackVoltageAutoScale_triggered(bool checked);
+    void on_actCurrentAutoScale_triggered(bool checked);
+    void on_actChargeAutoScale_triggered(bool checked);
+    void on_actTemperatureAutoScale_triggered(bool checked);
+    void on_actEstimatesShow_triggered(bool checked);
+    void on_actResistanceAutoScale_triggered(bool checked);
+    void on_actDerivedChannels_triggered();
 
     void on_actViewSettings_triggered();
 
     void on_actAbout_triggered();
 
 private:
+    enum ChargeUnit {
+        ChargeUnitCoulomb = 0,
+        ChargeUnitAmpHour
+    };
+
+    enum TemperatureUnit {
+        TemperatureUnitCelsius = 0,
+        TemperatureUnitFarenheit
+    };
+
+    //
+    // value axes, in the same order as ScrollingPlotWidget::Channel
+    //
+    enum Axis {
+        AxisPackVoltage = 0,
+        AxisCurrent,
+        AxisCharge,
+        AxisTemperature,
+        AxisStateOfCharge,
+        AxisResistance,
+        AxisCount
+    };
+
+    static const int SleepTimeout = 2000;
+    static const int IdleDelay = 30000;
+    static const int ReadBufferSize = 4096;
+    static const int SnapshotInterval = 5000;
+    static const int RebuildPoints = 4096;
+    static const int MaximumChartPoints = 4 * RebuildPoints;
+    static const int LogLineSize = 384;
+    static const int AlarmMessageTimeout = 10000;
+
+    void appendToSeries(qint64 index);
+    void createDerivedSeries();
+    void createTriggerDialog();
+    void updateDerivedAxis();
+    void estimatePendingSamples();
+    void clearSession();
+    void startReplay(const QString &fileName);
+    void activatePacketSource(PacketSource *source);
+    void setLiveSource(PacketSource *source);
+    void startLiveSource();
+    void setAxisRange(Axis axis, qreal min, qreal max);
+    void enterIdleMode();
+    void leaveIdleMode();
+    void setChartOpenGL(bool enabled);
+
     Ui::MainWindow *ui;
     CellMonitorDialog *m_cellBalanceStatusForm = nullptr;
+    SpectrumDialog *m_spectrumDialog = nullptr;
+    ComparisonDialog *m_comparisonDialog = nullptr;
+    TriggerDialog *m_triggerDialog = nullptr;
+    PortManager *m_portManager = nullptr;
     QSerialPort *m_serialPort = nullptr;
+    SerialPacketSource *m_serialSource = nullptr;
+    PacketSource *m_packetSource = nullptr;
+    PacketSource *m_liveSource = nullptr;
+    ReplaySource *m_replaySource = nullptr;
+    ReplayDialog *m_replayDialog = nullptr;
+    QPointer<SelectSerialPortDialog> m_selectSerialPortDialog;
     QTimer *m_sleepTimer = nullptr;
     QTimer *m_chartUpdateTimer = nullptr;
+    QTimer *m_diagnosticsTimer = nullptr;
+    QTimer *m_snapshotTimer = nullptr;
+    QTimer *m_telemetryHoldTimer = nullptr;
+    QTimer *m_idleTimer = nullptr;
+    CommandChannel *m_commandChannel = nullptr;
     QChart *m_chart = nullptr;
+    ScrollingPlotWidget *m_plotWidget = nullptr;
     QFile *m_dataLogFile = nullptr;
     QValueAxis *m_chartAxisTemperature;
     QValueAxis *m_chartAxisCurrent;
@@ -93,17 +252,74 @@ private:
     QLineSeries *m_chartSeriesCurrent;
     QLineSeries *m_chartSeriesCharge;
     QLineSeries *m_chartSeriesTemperature;
+    QValueAxis *m_chartAxisStateOfCharge;
+    QValueAxis *m_chartAxisResistance;
+    QLineSeries *m_chartSeriesStateOfCharge;
+    QLineSeries *m_chartSeriesResistance;
+    QValueAxis *m_chartAxisDerived = nullptr;
+    QVector<QLineSeries *> m_chartSeriesDerived;
     QMessageBox *m_waitingMessageBox = nullptr;
     QLabel *m_packStatusLabel = nullptr;
     QLabel *m_dataLogLabel = nullptr;
     QLabel *m_serialPortLabel = nullptr;
-    QByteArray m_dataBuffer;
+    PacketDecoder m_packetDecoder;
+    SampleClock m_sampleClock;
+    qint64 m_sessionStart = 0;
+    qint64 m_portLostTimestamp = -1;
+    bool m_portSelectionStarted = false;
+    char m_readBuffer[ReadBufferSize];
+    SampleStore m_sampleStore;
+    BatteryEstimator m_batteryEstimator;
+    EstimateStore m_estimateStore;
+    QFutureWatcher<EstimateHistory> m_estimateWatcher;
+    qint64 m_restoringEstimates = 0;
+    DerivedChannels m_derivedChannels;
+    qint64 m_loggedCount = 0;
+    qint64 m_plottedCount = 0;
+    SessionSnapshot m_restoredSnapshot;
+    QThread m_snapshotThread;
+    SnapshotWriter *m_snapshotWriter = nullptr;
+    qint64 m_snapshotCount = 0;
+    QThread m_spectrumThread;
+    SpectrumAnalyzer *m_spectrumAnalyzer = nullptr;
+    QVector<SpectrumMetrics> m_spectrumHistory;
+    LoadTestAnalyzer m_loadTestAnalyzer;
+    TriggerEngine m_triggerEngine;
+    QFutureWatcher<ReportResult> m_reportWatcher;
+    RawCapture m_rawCapture;
+    AppConfig m_config;
     QVector<QPointF> m_chartDataPackVoltage;
-    bool m_inHeader = false;
-    bool m_inMessage = false;
+    QElapsedTimer m_lastPacketTimer;
     QDateTime m_startDateTime;
-    QString m_chargeUnit;
-    QString m_temperatureUnit;
+    ChargeUnit m_chargeUnit = ChargeUnitCoulomb;
+    TemperatureUnit m_temperatureUnit = TemperatureUnitCelsius;
+    qreal m_chargeScale = 1.0;
+    qreal m_temperatureScale = 1.0;
+    qreal m_temperatureOffset = 0.0;
+    QString m_chargeSuffix;
+    QString m_temperatureSuffix;
+    int m_lastSeenSecond = -1;
+    int m_displayedMode = -1;
+    int m_telemetryMode = -1;
+    qint64 m_displayedVoltage = -1;
+    qint64 m_displayedCurrent = -1;
+    qint64 m_displayedCharge = -1;
+    qint64 m_displayedTemperature = -1;
+    quint64 m_hotPathPackets = 0;
+    quint64 m_hotPathAllocations = 0;
+    SlidingRange m_axisRanges[AxisCount];
+    AxisScale m_axisScales[AxisCount];
+    bool m_axisAutoScale[AxisCount];
+    qint64 m_rangedCount = 0;
+    quint64 m_chartFrames = 0;
+    quint64 m_reportedFrames = 0;
+    qint64 m_reportedCpuTime = 0;
+    QElapsedTimer m_diagnosticsElapsed;
+    bool m_idle = false;
+    QList<QTimer *> m_idleStoppedTimers;
+    QMetaObject::Connection m_idleWakeupConnection;
+    QElapsedTimer m_idleElapsed;
+    quint64 m_idleWakeups = 0;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,63 @@
+#include "networkbridgedialog.h"
+#include "ui_networkbridgedialog.h"
+
+static const char *s_protocols[] = { "tcp", "udp" };
+
+NetworkBridgeDialog::NetworkBridgeDialog(QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::NetworkBridgeDialog)
+{
+    ui->setupUi(this);
+    on_cboProtocol_currentIndexChanged(ui->cboProtocol->currentIndex());
+}
+
+NetworkBridgeDialog::~NetworkBridgeDialog()
+{
+    delete ui;
+}
+
+void NetworkBridgeDialog::setProtocol(const QString &protocol)
+{
+    ui->cboProtocol->setCurrentIndex(protocol == s_protocols[1] ? 1 : 0);
+}
+
+QString NetworkBridgeDialog::protocol() const
+{
+    return QString::fromLatin1(s_protocols[ui->cboProtocol->currentIndex() == 1 ? 1 : 0]);
+}
+
+void NetworkBridgeDialog::setHost(const QString &host)
+{
+    ui->txtHost->setText(host);
+}
+
+QString NetworkBridgeDialog::host() const
+{
+    return ui->txtHost->text().trimmed();
+}
+
+void NetworkBridgeDialog::setPort(quint16 port)
+{
+    ui->spnPort->setValue(port);
+}
+
+quint16 NetworkBridgeDialog::port() const
+{
+    return static_cast<quint16>(ui->spnPort->value());
+}
+
+//
+// A TCP bridge is connected to; UDP datagrams are received on a local
+// address, where blank means any interface.
+//
+void NetworkBridgeDialog::on_cboProtocol_currentIndexChanged(int index)
+{
+    if (index == 1) {
+        ui->lblHost->setText(tr("Listen address"));
+        ui->txtHost->setPlaceholderText(tr("Any"));
+    }
+    else {
+        ui->lblHost->setText(tr("Host"));
+        ui->txtHost->setPlaceholderText(QString());
+    }
+}
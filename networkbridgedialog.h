@@ -0,0 +1,33 @@
+#ifndef NETWORKBRIDGEDIALOG_H
+#define NETWORKBRIDGEDIALOG_H
+
+#include <QDialog>
+#include <QString>
+
+namespace Ui {
+class NetworkBridgeDialog;
+}
+
+class NetworkBridgeDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit NetworkBridgeDialog(QWidget *parent = nullptr);
+    ~NetworkBridgeDialog();
+
+    void setProtocol(const QString &protocol);
+    QString protocol() const;
+    void setHost(const QString &host);
+    QString host() const;
+    void setPort(quint16 port);
+    quint16 port() const;
+
+private slots:
+    void on_cboProtocol_currentIndexChanged(int index);
+
+private:
+    Ui::NetworkBridgeDialog *ui;
+};
+
+#endif // NETWORKBRIDGEDIALOG_H
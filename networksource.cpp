@@ -0,0 +1,292 @@
+#include "networksource.h"
+
+#include <QDebug>
+
+static const int MinimumBackoff = 250;
+static const int MaximumBackoff = 5000;
+static const int ConnectTimeout = 5000;
+
+TcpPacketSource::TcpPacketSource(const QString &host, quint16 port, const SampleClock *clock, QObject *parent) :
+    PacketSource(parent),
+    m_host(host),
+    m_port(port),
+    m_clock(clock)
+{
+    m_socket = new QTcpSocket(this);
+    connect(m_socket, &QTcpSocket::connected, this, &TcpPacketSource::on_socketConnected);
+    connect(m_socket, &QTcpSocket::disconnected, this, &TcpPacketSource::on_socketDisconnected);
+    connect(m_socket, static_cast<void (QAbstractSocket::*)(QAbstractSocket::SocketError)>(&QAbstractSocket::error),
+            this, &TcpPacketSource::on_socketErrorOccurred);
+    connect(m_socket, &QTcpSocket::readyRead, this, &TcpPacketSource::on_socketReadyRead);
+
+    m_retryTimer = new QTimer(this);
+    m_retryTimer->setSingleShot(true);
+    connect(m_retryTimer, &QTimer::timeout, this, &TcpPacketSource::on_retryTimer_timeout);
+
+    m_connectTimer = new QTimer(this);
+    m_connectTimer->setSingleShot(true);
+    m_connectTimer->setInterval(ConnectTimeout);
+    connect(m_connectTimer, &QTimer::timeout, this, &TcpPacketSource::on_connectTimer_timeout);
+}
+
+QString TcpPacketSource::description() const
+{
+    return QString("tcp://%1:%2").arg(m_host).arg(m_port);
+}
+
+bool TcpPacketSource::isOpen() const
+{
+    return m_connected;
+}
+
+qint64 TcpPacketSource::read(char *data, qint64 maxSize, qint64 *timestamp)
+{
+    qint64 length = m_socket->read(data, maxSize);
+    *timestamp = m_clock->now();
+    if (length > 0) {
+        m_statistics.recordBytes(length);
+    }
+    return length;
+}
+
+void TcpPacketSource::start()
+{
+    m_running = true;
+    m_backoff = 0;
+    tryConnect();
+}
+
+void TcpPacketSource::close()
+{
+    m_running = false;
+    m_retryTimer->stop();
+    m_connectTimer->stop();
+    m_connected = false;
+    m_socket->abort();
+}
+
+void TcpPacketSource::on_socketConnected()
+{
+    m_connectTimer->stop();
+    m_connected = true;
+    m_backoff = 0;
+
+    //
+    // frames are small and latency matters more than throughput
+    //
+    m_socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    m_socket->setSocketOption(QAbstractSocket::KeepAliveOption, 1);
+
+    m_statistics.recordConnect(m_connectClock.nsecsElapsed());
+    emit opened();
+}
+
+void TcpPacketSource::on_socketDisconnected()
+{
+    if (!m_connected) {
+        return;
+    }
+
+    m_connected = false;
+    m_statistics.recordDisconnect();
+    qDebug() << "Lost bridge connection" << description();
+    emit lost();
+    scheduleRetry();
+}
+
+void TcpPacketSource::on_socketErrorOccurred(QAbstractSocket::SocketError error)
+{
+    Q_UNUSED(error);
+
+    //
+    // errors on an established connection are followed by disconnected()
+    //
+    if (m_connected) {
+        return;
+    }
+
+    qDebug() << "Unable to connect to bridge" << description() << m_socket->errorString();
+    m_connectTimer->stop();
+    m_socket->abort();
+    scheduleRetry();
+}
+
+void TcpPacketSource::on_socketReadyRead()
+{
+    emit readyRead();
+}
+
+void TcpPacketSource::on_retryTimer_timeout()
+{
+    tryConnect();
+}
+
+void TcpPacketSource::on_connectTimer_timeout()
+{
+    qDebug() << "Timed out connecting to bridge" << description();
+    m_socket->abort();
+    scheduleRetry();
+}
+
+void TcpPacketSource::tryConnect()
+{
+    if (!m_running || m_socket->state() != QAbstractSocket::UnconnectedState) {
+        return;
+    }
+
+    m_connectClock.start();
+    m_connectTimer->start();
+    m_socket->connectToHost(m_host, m_port);
+}
+
+void TcpPacketSource::scheduleRetry()
+{
+    if (!m_running) {
+        return;
+    }
+
+    m_backoff = (m_backoff == 0) ? MinimumBackoff : qMin(m_backoff * 2, MaximumBackoff);
+    m_retryTimer->start(m_backoff);
+}
+
+UdpPacketSource::UdpPacketSource(const QString &address, quint16 port, const SampleClock *clock, QObject *parent) :
+    PacketSource(parent),
+    m_address(address),
+    m_port(port),
+    m_clock(clock)
+{
+    m_socket = new QUdpSocket(this);
+    connect(m_socket, static_cast<void (QAbstractSocket::*)(QAbstractSocket::SocketError)>(&QAbstractSocket::error),
+            this, &UdpPacketSource::on_socketErrorOccurred);
+    connect(m_socket, &QUdpSocket::readyRead, this, &UdpPacketSource::on_socketReadyRead);
+
+    m_retryTimer = new QTimer(this);
+    m_retryTimer->setSingleShot(true);
+    connect(m_retryTimer, &QTimer::timeout, this, &UdpPacketSource::on_retryTimer_timeout);
+}
+
+QString UdpPacketSource::description() const
+{
+    return QString("udp://%1:%2").arg(m_address.isEmpty() ? QString("*") : m_address).arg(m_port);
+}
+
+bool UdpPacketSource::isOpen() const
+{
+    return m_receiving;
+}
+
+//
+// One datagram per call; the sender address is not asked for, as
+// resolving it would allocate on every packet. Malformed datagrams are
+// dropped rather than decoded: the decoder is a byte stream, and a
+// truncated frame would leave it part way through one, taking the next
+// good datagram with it.
+//
+qint64 UdpPacketSource::read(char *data, qint64 maxSize, qint64 *timestamp)
+{
+    while (m_socket->hasPendingDatagrams()) {
+        qint64 size = m_socket->pendingDatagramSize();
+
+        if (size > maxSize) {
+            m_socket->readDatagram(nullptr, 0);
+            m_statistics.recordMalformed();
+            continue;
+        }
+
+        qint64 length = m_socket->readDatagram(data, maxSize);
+        if (length <= 0) {
+            continue;
+        }
+
+        if ((length % FrameSize) != 0 || data[0] != 'D' || data[1] != 'E') {
+            m_statistics.recordMalformed();
+            continue;
+        }
+
+        m_statistics.recordBytes(length);
+        *timestamp = m_clock->now();
+        return length;
+    }
+
+    return 0;
+}
+
+void UdpPacketSource::start()
+{
+    m_running = true;
+    m_backoff = 0;
+    tryBind();
+}
+
+void UdpPacketSource::close()
+{
+    m_running = false;
+    m_receiving = false;
+    m_retryTimer->stop();
+    m_socket->abort();
+}
+
+void UdpPacketSource::on_socketErrorOccurred(QAbstractSocket::SocketError error)
+{
+    //
+    // ICMP port unreachable replies and the like don't affect receiving
+    //
+    if (m_socket->state() == QAbstractSocket::BoundState) {
+        qDebug() << "Bridge socket error" << description() << error;
+        return;
+    }
+
+    qDebug() << "Lost bridge socket" << description() << m_socket->errorString();
+
+    if (m_receiving) {
+        m_receiving = false;
+        m_statistics.recordDisconnect();
+        emit lost();
+    }
+
+    m_socket->abort();
+    scheduleRetry();
+}
+
+void UdpPacketSource::on_socketReadyRead()
+{
+    if (!m_receiving) {
+        m_receiving = true;
+        m_statistics.recordConnect(0);
+        emit opened();
+    }
+
+    emit readyRead();
+}
+
+void UdpPacketSource::on_retryTimer_timeout()
+{
+    tryBind();
+}
+
+void UdpPacketSource::tryBind()
+{
+    if (!m_running || m_socket->state() == QAbstractSocket::BoundState) {
+        return;
+    }
+
+    QHostAddress address = m_address.isEmpty() ? QHostAddress(QHostAddress::Any) : QHostAddress(m_address);
+
+    if (!m_socket->bind(address, m_port, QAbstractSocket::ShareAddress | QAbstractSocket::ReuseAddressHint)) {
+        qDebug() << "Unable to bind bridge socket" << description() << m_socket->errorString();
+        scheduleRetry();
+        return;
+    }
+
+    m_backoff = 0;
+}
+
+void UdpPacketSource::scheduleRetry()
+{
+    if (!m_running) {
+        return;
+    }
+
+    m_backoff = (m_backoff == 0) ? MinimumBackoff : qMin(m_backoff * 2, MaximumBackoff);
+    m_retryTimer->start(m_backoff);
+}
@@ -0,0 +1,97 @@
+#ifndef NETWORKSOURCE_H
+#define NETWORKSOURCE_H
+
+#include "packetsource.h"
+#include "statuspacket.h"
+
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUdpSocket>
+
+//
+// Raw byte stream from a serial-over-TCP bridge such as ser2net. The
+// bytes are exactly what the pack wrote to its UART, so they go through
+// the decoder unchanged. The connection is retried with exponential
+// backoff whenever it fails or drops, like the serial port manager does.
+//
+class TcpPacketSource : public PacketSource
+{
+    Q_OBJECT
+
+public:
+    TcpPacketSource(const QString &host, quint16 port, const SampleClock *clock, QObject *parent = nullptr);
+
+    QString description() const override;
+    bool isOpen() const override;
+    qint64 read(char *data, qint64 maxSize, qint64 *timestamp) override;
+    void start() override;
+    void close() override;
+
+private slots:
+    void on_socketConnected();
+    void on_socketDisconnected();
+    void on_socketErrorOccurred(QAbstractSocket::SocketError error);
+    void on_socketReadyRead();
+    void on_retryTimer_timeout();
+    void on_connectTimer_timeout();
+
+private:
+    void tryConnect();
+    void scheduleRetry();
+
+    QString m_host;
+    quint16 m_port;
+    const SampleClock *m_clock;
+    QTcpSocket *m_socket = nullptr;
+    QTimer *m_retryTimer = nullptr;
+    QTimer *m_connectTimer = nullptr;
+    QElapsedTimer m_connectClock;
+    int m_backoff = 0;
+    bool m_running = false;
+    bool m_connected = false;
+};
+
+//
+// 'D','E' framed status packets carried in UDP datagrams, one or more
+// whole frames per datagram. Datagrams that are not a whole number of
+// frames are counted as malformed and dropped, so the decoder always
+// starts the next datagram at a frame boundary. The source counts as
+// opened once the first datagram arrives after binding.
+//
+class UdpPacketSource : public PacketSource
+{
+    Q_OBJECT
+
+public:
+    UdpPacketSource(const QString &address, quint16 port, const SampleClock *clock, QObject *parent = nullptr);
+
+    QString description() const override;
+    bool isOpen() const override;
+    qint64 read(char *data, qint64 maxSize, qint64 *timestamp) override;
+    void start() override;
+    void close() override;
+
+private slots:
+    void on_socketErrorOccurred(QAbstractSocket::SocketError error);
+    void on_socketReadyRead();
+    void on_retryTimer_timeout();
+
+private:
+    static const int FrameSize = 2 + sizeof(status_packet_t);
+
+    void tryBind();
+    void scheduleRetry();
+
+    QString m_address;
+    quint16 m_port;
+    const SampleClock *m_clock;
+    QUdpSocket *m_socket = nullptr;
+    QTimer *m_retryTimer = nullptr;
+    int m_backoff = 0;
+    bool m_running = false;
+    bool m_receiving = false;
+};
+
+#endif // NETWORKSOURCE_H
@@ -0,0 +1,50 @@
+#include "packetdecoder.h"
+
+#include <string.h>
+
+PacketDecoder::PacketDecoder()
+{
+    memset(&m_packet, 0, sizeof(m_packet));
+}
+
+//
+// Returns true when the byte completes a frame with valid 'A'/'B'
+// sentinels; the decoded frame is then available from packet().
+//
+bool PacketDecoder::push(char byte)
+{
+    if (byte == 'D' && m_inHeader == false && m_inMessage == false) {
+        m_inHeader = true;
+    }
+    else if (byte == 'E' && m_inHeader == true) {
+        m_inHeader = false;
+        m_inMessage = true;
+        m_frameLength = 0;
+    }
+    else if (m_inMessage) {
+        m_frame[m_frameLength++] = byte;
+        if (m_frameLength == static_cast<int>(sizeof(status_packet_t))) {
+            m_inMessage = false;
+            m_inHeader = false;
+            m_frameLength = 0;
+
+            const status_packet_t *frame = reinterpret_cast<const status_packet_t *>(m_frame);
+            if (frame->a == 'A' && frame->b == 'B') {
+                memcpy(&m_packet, m_frame, sizeof(status_packet_t));
+                m_acceptedCount++;
+                return true;
+            }
+
+            m_rejectedCount++;
+        }
+    }
+
+    return false;
+}
+
+void PacketDecoder::reset()
+{
+    m_frameLength = 0;
+    m_inHeader = false;
+    m_inMessage = false;
+}
@@ -0,0 +1,35 @@
+#ifndef PACKETDECODER_H
+#define PACKETDECODER_H
+
+#include "statuspacket.h"
+
+#include <QtGlobal>
+
+//
+// Incremental decoder for the 'D','E' framed status packets sent by the
+// pack. Bytes are pushed one at a time into a fixed-size frame buffer so
+// decoding never touches the heap.
+//
+class PacketDecoder
+{
+public:
+    PacketDecoder();
+
+    bool push(char byte);
+    void reset();
+
+    const status_packet_t &packet() const { return m_packet; }
+    quint64 acceptedCount() const { return m_acceptedCount; }
+    quint64 rejectedCount() const { return m_rejectedCount; }
+
+private:
+    status_packet_t m_packet;
+    char m_frame[sizeof(status_packet_t)];
+    int m_frameLength = 0;
+    bool m_inHeader = false;
+    bool m_inMessage = false;
+    quint64 m_acceptedCount = 0;
+    quint64 m_rejectedCount = 0;
+};
+
+#endif // PACKETDECODER_H
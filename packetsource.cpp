@@ -0,0 +1,100 @@
+#include "packetsource.h"
+
+LinkStatistics::LinkStatistics()
+{
+
+}
+
+void LinkStatistics::recordArrival(qint64 timestamp, int frames)
+{
+    m_arrivals += static_cast<quint64>(frames);
+    m_lost += static_cast<quint64>(m_intervalEstimator.record(timestamp, frames));
+
+    qint64 lateness = m_intervalEstimator.lateness();
+    if (lateness > 0) {
+        m_latenessSum += lateness;
+        m_latenessCount++;
+        m_maximumLateness = qMax(m_maximumLateness, lateness);
+    }
+}
+
+void LinkStatistics::recordConnect(qint64 latency)
+{
+    m_connects++;
+    m_connectLatency = latency;
+    resetInterval();
+}
+
+//
+// Called across silences that are not losses, such as the pack sleeping
+// or the link reconnecting.
+//
+void LinkStatistics::resetInterval()
+{
+    m_intervalEstimator.reset();
+}
+
+qreal LinkStatistics::meanLateness() const
+{
+    if (m_latenessCount == 0) {
+        return 0.0;
+    }
+
+    return static_cast<qreal>(m_latenessSum) / static_cast<qreal>(m_latenessCount) / 1000000.0;
+}
+
+PacketSource::PacketSource(QObject *parent) :
+    QObject(parent)
+{
+
+}
+
+SerialPacketSource::SerialPacketSource(PortManager *portManager, const SampleClock *clock, QObject *parent) :
+    PacketSource(parent),
+    m_portManager(portManager),
+    m_port(portManager->port()),
+    m_clock(clock)
+{
+    connect(m_port, &QSerialPort::readyRead, this, &SerialPacketSource::on_portReadyRead);
+    connect(m_portManager, &PortManager::portOpened, this, &PacketSource::opened);
+    connect(m_portManager, &PortManager::portLost, this, &PacketSource::lost);
+}
+
+QString SerialPacketSource::description() const
+{
+    return m_port->portName();
+}
+
+bool SerialPacketSource::isOpen() const
+{
+    return m_portManager->isOpen();
+}
+
+//
+// Every frame completed by a chunk is stamped with the time its bytes were
+// read, not the time it gets processed.
+//
+qint64 SerialPacketSource::read(char *data, qint64 maxSize, qint64 *timestamp)
+{
+    qint64 length = m_port->read(data, maxSize);
+    *timestamp = m_clock->now();
+    if (length > 0) {
+        m_statistics.recordBytes(length);
+    }
+    return length;
+}
+
+void SerialPacketSource::on_portReadyRead()
+{
+    emit readyRead();
+}
+
+void SerialPacketSource::start()
+{
+    m_portManager->start();
+}
+
+void SerialPacketSource::close()
+{
+    m_portManager->close();
+}
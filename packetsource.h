@@ -0,0 +1,113 @@
+#ifndef PACKETSOURCE_H
+#define PACKETSOURCE_H
+
+#include "portmanager.h"
+#include "sampleclock.h"
+#include "intervalestimator.h"
+
+#include <QObject>
+#include <QString>
+
+//
+// Link quality for one source. Bytes are counted as the source reads
+// them; arrivals are the decoded frames, recorded by the main window for
+// each read with the number of frames it completed and the time its bytes
+// were read, so the figures don't depend on how the OS splits a byte
+// stream. Frames are expected one smoothed interval apart: later ones
+// count towards the lateness figures, and gaps count as lost frames by
+// the same IntervalEstimator rule as SampleClock.
+// Everything is O(1) per arrival.
+//
+class LinkStatistics
+{
+public:
+    LinkStatistics();
+
+    void recordArrival(qint64 timestamp, int frames);
+    void recordBytes(qint64 bytes) { m_bytes += static_cast<quint64>(bytes); }
+    void recordMalformed() { m_malformed++; }
+    void recordConnect(qint64 latency);
+    void recordDisconnect() { m_disconnects++; }
+    void resetInterval();
+
+    quint64 bytes() const { return m_bytes; }
+    quint64 arrivals() const { return m_arrivals; }
+    quint64 lost() const { return m_lost; }
+    quint64 malformed() const { return m_malformed; }
+    int connects() const { return m_connects; }
+    int disconnects() const { return m_disconnects; }
+    qreal connectLatency() const { return static_cast<qreal>(m_connectLatency) / 1000000.0; }
+    qreal meanLateness() const;
+    qreal maximumLateness() const { return static_cast<qreal>(m_maximumLateness) / 1000000.0; }
+
+private:
+    quint64 m_bytes = 0;
+    quint64 m_arrivals = 0;
+    quint64 m_lost = 0;
+    quint64 m_malformed = 0;
+    int m_connects = 0;
+    int m_disconnects = 0;
+    qint64 m_connectLatency = 0;    // ns, most recent connection
+    IntervalEstimator m_intervalEstimator;
+    qint64 m_latenessSum = 0;       // ns
+    quint64 m_latenessCount = 0;
+    qint64 m_maximumLateness = 0;   // ns
+};
+
+//
+// Where status packet bytes come from. The main window drains whichever
+// source is active into its decoder, so the serial port and recorded logs
+// drive exactly the same decode, analysis, logging and chart path. Every
+// chunk is stamped on the sample clock with the time its bytes arrived.
+//
+class PacketSource : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PacketSource(QObject *parent = nullptr);
+
+    virtual QString description() const = 0;
+    virtual bool isOpen() const = 0;
+    virtual qint64 read(char *data, qint64 maxSize, qint64 *timestamp) = 0;
+    virtual void start() = 0;
+    virtual void close() = 0;
+
+    LinkStatistics &statistics() { return m_statistics; }
+    const LinkStatistics &statistics() const { return m_statistics; }
+
+signals:
+    void readyRead();
+    void opened();
+    void lost();
+
+protected:
+    LinkStatistics m_statistics;
+};
+
+//
+// The pack's serial adapter, kept open by the port manager.
+//
+class SerialPacketSource : public PacketSource
+{
+    Q_OBJECT
+
+public:
+    SerialPacketSource(PortManager *portManager, const SampleClock *clock, QObject *parent = nullptr);
+
+    QString description() const override;
+    bool isOpen() const override;
+    qint64 read(char *data, qint64 maxSize, qint64 *timestamp) override;
+    void start() override;
+    void close() override;
+
+private slots:
+    void on_portReadyRead();
+
+private:
+    PortManager *m_portManager;
+    QSerialPort *m_port;
+    const SampleClock *m_clock;
+};
+
+#endif // PACKETSOURCE_H
@@ -0,0 +1,235 @@
+#include "portmanager.h"
+
+#include <QDebug>
+#include <QMetaType>
+
+static const int PollInterval = 500;
+static const int MinimumBackoff = 50;
+static const int MaximumBackoff = 5000;
+
+PortMatch PortMatch::fromPortInfo(const QSerialPortInfo &info)
+{
+    PortMatch match;
+    match.portName = info.portName();
+    match.serialNumber = info.serialNumber();
+    if (info.hasVendorIdentifier() && info.hasProductIdentifier()) {
+        match.vendorId = info.vendorIdentifier();
+        match.productId = info.productIdentifier();
+    }
+    return match;
+}
+
+bool PortMatch::isValid() const
+{
+    return !portName.isEmpty() || !serialNumber.isEmpty() || (vendorId != 0 && productId != 0);
+}
+
+bool PortMatch::matches(const QSerialPortInfo &info) const
+{
+    if (!serialNumber.isEmpty()) {
+        return info.serialNumber() == serialNumber;
+    }
+
+    if (vendorId != 0 && productId != 0) {
+        return info.hasVendorIdentifier()
+                && info.hasProductIdentifier()
+                && info.vendorIdentifier() == vendorId
+                && info.productIdentifier() == productId;
+    }
+
+    return info.portName() == portName;
+}
+
+PortWatcher::PortWatcher(QObject *parent) :
+    QObject(parent)
+{
+
+}
+
+void PortWatcher::start()
+{
+    if (m_pollTimer == nullptr) {
+        m_pollTimer = new QTimer(this);
+        m_pollTimer->setInterval(PollInterval);
+        connect(m_pollTimer, &QTimer::timeout, this, &PortWatcher::on_pollTimer_timeout);
+    }
+
+    m_pollTimer->start();
+    on_pollTimer_timeout();
+}
+
+void PortWatcher::stop()
+{
+    if (m_pollTimer != nullptr) {
+        m_pollTimer->stop();
+    }
+}
+
+void PortWatcher::on_pollTimer_timeout()
+{
+    QList<QSerialPortInfo> ports = QSerialPortInfo::availablePorts();
+    QStringList knownPorts;
+
+    for (const QSerialPortInfo &info : ports) {
+        knownPorts << info.systemLocation() + info.serialNumber();
+    }
+
+    if (knownPorts != m_knownPorts) {
+        m_knownPorts = knownPorts;
+        emit portsChanged(ports);
+    }
+}
+
+PortManager::PortManager(QObject *parent) :
+    QObject(parent)
+{
+    qRegisterMetaType<QList<QSerialPortInfo>>("QList<QSerialPortInfo>");
+
+    m_port = new QSerialPort(this);
+    connect(m_port, &QSerialPort::errorOccurred, this, &PortManager::on_portErrorOccurred);
+
+    m_retryTimer = new QTimer(this);
+    m_retryTimer->setSingleShot(true);
+    connect(m_retryTimer, &QTimer::timeout, this, &PortManager::on_retryTimer_timeout);
+
+    m_watcher = new PortWatcher;
+    m_watcher->moveToThread(&m_watcherThread);
+    connect(&m_watcherThread, &QThread::started, m_watcher, &PortWatcher::start);
+    connect(&m_watcherThread, &QThread::finished, m_watcher, &QObject::deleteLater);
+    connect(m_watcher, &PortWatcher::portsChanged, this, &PortManager::on_watcherPortsChanged);
+    m_watcherThread.start();
+}
+
+PortManager::~PortManager()
+{
+    m_watcherThread.quit();
+    m_watcherThread.wait();
+}
+
+void PortManager::setTarget(const PortMatch &match)
+{
+    m_target = match;
+    m_backoff = 0;
+}
+
+void PortManager::start()
+{
+    m_running = true;
+    m_backoff = 0;
+    tryOpen();
+}
+
+void PortManager::close()
+{
+    m_running = false;
+    m_retryTimer->stop();
+
+    if (m_port->isOpen()) {
+        m_port->close();
+    }
+}
+
+//
+// Port enumeration can be paused while the open port is all that
+// matters; a lost port is still reported by the port itself.
+//
+void PortManager::setWatching(bool watching)
+{
+    QMetaObject::invokeMethod(m_watcher, watching ? "start" : "stop", Qt::QueuedConnection);
+}
+
+void PortManager::on_watcherPortsChanged(const QList<QSerialPortInfo> &ports)
+{
+    m_availablePorts = ports;
+    emit portsChanged(ports);
+
+    if (!m_running) {
+        return;
+    }
+
+    //
+    // the adapter came back; don't wait for the backoff to expire
+    //
+    if (!m_port->isOpen()) {
+        for (const QSerialPortInfo &info : ports) {
+            if (m_target.matches(info)) {
+                m_backoff = 0;
+                m_retryTimer->stop();
+                tryOpen();
+                return;
+            }
+        }
+    }
+}
+
+void PortManager::on_portErrorOccurred(QSerialPort::SerialPortError error)
+{
+    if (error == QSerialPort::NoError || !m_port->isOpen()) {
+        return;
+    }
+
+    if (error == QSerialPort::ResourceError || error == QSerialPort::PermissionError) {
+        qDebug() << "Lost serial port" << m_port->portName() << m_port->errorString();
+        m_port->close();
+        emit portLost();
+        scheduleRetry();
+    }
+}
+
+void PortManager::on_retryTimer_timeout()
+{
+    tryOpen();
+}
+
+void PortManager::tryOpen()
+{
+    if (!m_running || m_port->isOpen() || !m_target.isValid()) {
+        return;
+    }
+
+    QString portName;
+
+    for (const QSerialPortInfo &info : m_availablePorts) {
+        if (m_target.matches(info)) {
+            portName = info.portName();
+            break;
+        }
+    }
+
+    //
+    // until the first enumeration arrives, fall back to the stored name
+    //
+    if (portName.isEmpty()) {
+        if (!m_availablePorts.isEmpty() || m_target.portName.isEmpty()) {
+            scheduleRetry();
+            return;
+        }
+        portName = m_target.portName;
+    }
+
+    m_port->setPortName(portName);
+    m_port->setBaudRate(115200);
+    m_port->setParity(QSerialPort::NoParity);
+    m_port->setDataBits(QSerialPort::Data8);
+    m_port->setStopBits(QSerialPort::OneStop);
+    m_port->setFlowControl(QSerialPort::NoFlowControl);
+
+    if (!m_port->open(QIODevice::ReadWrite)) {
+        qDebug() << "Unable to open serial port" << portName << m_port->errorString();
+        scheduleRetry();
+        return;
+    }
+
+    m_backoff = 0;
+    emit portOpened();
+}
+
+void PortManager::scheduleRetry()
+{
+    if (!m_running) {
+        return;
+    }
+
+    m_backoff = (m_backoff == 0) ? MinimumBackoff : qMin(m_backoff * 2, MaximumBackoff);
+    m_retryTimer->start(m_backoff);
+}
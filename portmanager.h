@@ -0,0 +1,102 @@
+#ifndef PORTMANAGER_H
+#define PORTMANAGER_H
+
+#include <QObject>
+#include <QSerialPort>
+#include <QSerialPortInfo>
+#include <QList>
+#include <QString>
+#include <QThread>
+#include <QTimer>
+
+//
+// Identifies the pack's serial adapter. Ports are matched by USB serial
+// number first, then by VID/PID, and only fall back to the port name when
+// neither is known, so the adapter is found again after being re-plugged
+// into a different port.
+//
+struct PortMatch
+{
+    QString portName;
+    QString serialNumber;
+    quint16 vendorId = 0;
+    quint16 productId = 0;
+
+    static PortMatch fromPortInfo(const QSerialPortInfo &info);
+    bool isValid() const;
+    bool matches(const QSerialPortInfo &info) const;
+};
+
+//
+// Polls the list of available ports on a worker thread so enumeration
+// never blocks the UI.
+//
+class PortWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PortWatcher(QObject *parent = nullptr);
+
+public slots:
+    void start();
+    void stop();
+
+signals:
+    void portsChanged(const QList<QSerialPortInfo> &ports);
+
+private slots:
+    void on_pollTimer_timeout();
+
+private:
+    QTimer *m_pollTimer = nullptr;
+    QStringList m_knownPorts;
+};
+
+//
+// Owns the serial port. Keeps the configured adapter open, reopening it
+// with exponential backoff whenever it disappears or fails.
+//
+class PortManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PortManager(QObject *parent = nullptr);
+    ~PortManager();
+
+    void setTarget(const PortMatch &match);
+    PortMatch target() const { return m_target; }
+    QSerialPort *port() const { return m_port; }
+    QList<QSerialPortInfo> availablePorts() const { return m_availablePorts; }
+    bool isOpen() const { return m_port->isOpen(); }
+
+    void start();
+    void close();
+    void setWatching(bool watching);
+
+signals:
+    void portOpened();
+    void portLost();
+    void portsChanged(const QList<QSerialPortInfo> &ports);
+
+private slots:
+    void on_watcherPortsChanged(const QList<QSerialPortInfo> &ports);
+    void on_portErrorOccurred(QSerialPort::SerialPortError error);
+    void on_retryTimer_timeout();
+
+private:
+    void tryOpen();
+    void scheduleRetry();
+
+    QSerialPort *m_port = nullptr;
+    QThread m_watcherThread;
+    PortWatcher *m_watcher = nullptr;
+    QTimer *m_retryTimer = nullptr;
+    QList<QSerialPortInfo> m_availablePorts;
+    PortMatch m_target;
+    int m_backoff = 0;
+    bool m_running = false;
+};
+
+#endif // PORTMANAGER_H
@@ -0,0 +1,135 @@
+#include "rawcapture.h"
+
+#include <QDebug>
+
+#include <string.h>
+
+const char RawCapture::Magic[8] = { 'P', 'B', 'M', 'C', 'A', 'P', '0', '1' };
+
+RawCapture::RawCapture()
+{
+}
+
+RawCapture::~RawCapture()
+{
+    close();
+}
+
+bool RawCapture::open(const QString &fileName, qint64 sizeLimit, qint64 wallUSecs, qint64 steadyNSecs)
+{
+    close();
+
+    m_fileName = fileName;
+    m_sizeLimit = sizeLimit;
+    m_wallUSecs = wallUSecs;
+    m_steadyNSecs = steadyNSecs;
+    m_chunks = 0;
+    m_bytes = 0;
+    m_rotations = 0;
+
+    return openSegment();
+}
+
+void RawCapture::append(const char *data, qint64 length, qint64 timestamp)
+{
+    if (!m_file.isOpen() || length <= 0) {
+        return;
+    }
+
+    qint64 recordSize = RecordHeaderSize + length;
+    if (m_buffered + recordSize > BufferSize) {
+        flush();
+    }
+
+    quint32 recordLength = static_cast<quint32>(length);
+
+    //
+    // chunks never come close to the buffer size, but don't lose one if
+    // they ever do
+    //
+    if (recordSize > BufferSize) {
+        char header[RecordHeaderSize];
+        memcpy(header, &timestamp, sizeof(timestamp));
+        memcpy(header + 8, &recordLength, sizeof(recordLength));
+        m_file.write(header, RecordHeaderSize);
+        m_file.write(data, length);
+        m_segmentSize += recordSize;
+    }
+    else {
+        char *record = m_buffer + m_buffered;
+        memcpy(record, &timestamp, sizeof(timestamp));
+        memcpy(record + 8, &recordLength, sizeof(recordLength));
+        memcpy(record + RecordHeaderSize, data, static_cast<size_t>(length));
+        m_buffered += static_cast<int>(recordSize);
+    }
+
+    m_chunks++;
+    m_bytes += static_cast<quint64>(length);
+}
+
+void RawCapture::flush()
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    if (m_buffered > 0) {
+        if (m_file.write(m_buffer, m_buffered) != m_buffered) {
+            qDebug() << "Raw capture write failed:" << m_file.errorString();
+        }
+        m_segmentSize += m_buffered;
+        m_buffered = 0;
+    }
+
+    if (m_segmentSize >= m_sizeLimit / 2) {
+        rotate();
+    }
+}
+
+void RawCapture::close()
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    if (m_buffered > 0) {
+        m_file.write(m_buffer, m_buffered);
+        m_buffered = 0;
+    }
+
+    m_file.close();
+}
+
+bool RawCapture::openSegment()
+{
+    m_file.setFileName(m_fileName);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+        return false;
+    }
+
+    char header[HeaderSize];
+    memcpy(header, Magic, sizeof(Magic));
+    memcpy(header + 8, &m_wallUSecs, sizeof(m_wallUSecs));
+    memcpy(header + 16, &m_steadyNSecs, sizeof(m_steadyNSecs));
+    m_file.write(header, HeaderSize);
+
+    m_segmentSize = HeaderSize;
+    m_buffered = 0;
+    return true;
+}
+
+void RawCapture::rotate()
+{
+    m_file.close();
+
+    QString previous = m_fileName + ".1";
+    QFile::remove(previous);
+    QFile::rename(m_fileName, previous);
+
+    if (!openSegment()) {
+        qDebug() << "Raw capture rotation failed:" << m_file.errorString();
+        return;
+    }
+
+    m_rotations++;
+}
@@ -0,0 +1,62 @@
+#ifndef RAWCAPTURE_H
+#define RAWCAPTURE_H
+
+#include <QFile>
+#include <QString>
+
+//
+// Append-only capture of the bytes read from the active packet source,
+// for working out afterwards why the decoder rejected frames. Every read
+// chunk is stored exactly as it arrived, with its sample clock timestamp:
+//
+//   header   "PBMCAP01", qint64 wall clock µs, qint64 steady ns
+//   record   qint64 steady ns, quint32 length, <length> bytes
+//
+// in host byte order; the header pair maps steady time to wall time.
+// Records are packed into a fixed buffer and written out in large
+// unbuffered writes, so a chunk costs one memcpy and no allocation. When
+// the file reaches half the size limit it is renamed to "<name>.1",
+// replacing the previous one, so the two together stay within the limit.
+//
+class RawCapture
+{
+public:
+    static const char Magic[8];
+    static const int HeaderSize = 24;
+    static const int RecordHeaderSize = 12;
+
+    RawCapture();
+    ~RawCapture();
+
+    bool open(const QString &fileName, qint64 sizeLimit, qint64 wallUSecs, qint64 steadyNSecs);
+    void append(const char *data, qint64 length, qint64 timestamp);
+    void flush();
+    void close();
+
+    bool isOpen() const { return m_file.isOpen(); }
+    QString fileName() const { return m_fileName; }
+    QString errorString() const { return m_file.errorString(); }
+    quint64 chunks() const { return m_chunks; }
+    quint64 bytes() const { return m_bytes; }
+    int rotations() const { return m_rotations; }
+
+private:
+    static const int BufferSize = 65536;
+
+    bool openSegment();
+    void rotate();
+
+    QFile m_file;
+    QString m_fileName;
+    qint64 m_sizeLimit = 0;
+    qint64 m_wallUSecs = 0;
+    qint64 m_steadyNSecs = 0;
+    qint64 m_segmentSize = 0;
+    char m_buffer[BufferSize];
+    int m_buffered = 0;
+    quint64 m_chunks = 0;
+    quint64 m_bytes = 0;
+    int m_rotations = 0;
+};
+
+#endif // RAWCAPTURE_H
@@ -0,0 +1,232 @@
+#include "recordedrun.h"
+#include "logreader.h"
+
+#include <QFileInfo>
+
+//
+// Current above which a run is considered to have started its cycle.
+//
+static const float CycleThreshold = 0.1f;
+
+//
+// Index of the first sample drawing or delivering current, or 0 if the run
+// never does.
+//
+int RecordedRun::cycleStart() const
+{
+    const QVector<float> &current = values[ChannelCurrent];
+
+    for (int i = 0; i < current.count(); i++) {
+        if (current[i] > CycleThreshold) {
+            return i;
+        }
+    }
+
+    return 0;
+}
+
+//
+// X coordinates for the given alignment: seconds since the log started,
+// seconds since the cycle started, or Ah moved since the cycle started.
+// Charge is made non-decreasing so the result can be searched.
+//
+QVector<float> RecordedRun::alignedX(Alignment alignment) const
+{
+    QVector<float> x(count());
+    if (x.isEmpty()) {
+        return x;
+    }
+
+    int start = (alignment == AlignTime) ? 0 : cycleStart();
+
+    if (alignment == AlignCharge) {
+        float reference = charge[start];
+        float moved = 0.0f;
+
+        for (int i = 0; i < count(); i++) {
+            if (i > start) {
+                moved = qMax(moved, qAbs(charge[i] - reference) / 3600.0f);
+            }
+            x[i] = moved;
+        }
+    }
+    else {
+        float origin = elapsed[start];
+
+        for (int i = 0; i < count(); i++) {
+            x[i] = elapsed[i] - origin;
+        }
+    }
+
+    return x;
+}
+
+//
+// Reads a whole log; safe to call from worker threads.
+//
+RecordedRun RecordedRun::load(const QString &fileName)
+{
+    RecordedRun run;
+    run.fileName = fileName;
+
+    LogReader reader;
+    if (!reader.open(fileName)) {
+        run.errorString = reader.errorString();
+        return run;
+    }
+
+    //
+    // reserve from the file size; a log line is roughly 60 bytes
+    //
+    int estimate = static_cast<int>(qMin(QFileInfo(fileName).size() / 60, static_cast<qint64>(1 << 26)));
+    run.elapsed.reserve(estimate);
+    run.charge.reserve(estimate);
+    for (int c = 0; c < ChannelCount; c++) {
+        run.values[c].reserve(estimate);
+    }
+
+    //
+    // elapsed restarts wherever the session was cleared mid-log; the start
+    // offset carries it on, and a wall clock stepped back between sessions
+    // is held flat, as the series must not go backwards
+    //
+    LogRecord record;
+    qreal previous = 0.0;
+    while (reader.readNext(&record)) {
+        qreal elapsed = qMax(previous, record.elapsed + reader.startOffset());
+        previous = elapsed;
+
+        run.elapsed.append(static_cast<float>(elapsed));
+        run.charge.append(static_cast<float>(record.charge));
+        run.values[ChannelVoltage].append(static_cast<float>(record.voltage));
+        run.values[ChannelCurrent].append(static_cast<float>(record.current));
+        run.values[ChannelTemperature].append(static_cast<float>(record.temperature));
+    }
+
+    return run;
+}
+
+DecimatedSeries::DecimatedSeries()
+{
+}
+
+void DecimatedSeries::build(const QVector<float> &x, const QVector<float> &y)
+{
+    m_x = x;
+    m_y = y;
+    m_levels.clear();
+
+    //
+    // level 1 pairs raw points; each further level pairs the one below
+    //
+    int count = m_x.count();
+    QVector<Bucket> previous;
+    previous.reserve(count);
+    for (int i = 0; i < count; i++) {
+        Bucket bucket = { i, i };
+        previous.append(bucket);
+    }
+
+    while (previous.count() > 1) {
+        QVector<Bucket> level;
+        level.reserve((previous.count() + 1) / 2);
+
+        for (int i = 0; i < previous.count(); i += 2) {
+            Bucket bucket = previous[i];
+            if (i + 1 < previous.count()) {
+                const Bucket &other = previous[i + 1];
+                if (m_y[other.minIndex] < m_y[bucket.minIndex]) bucket.minIndex = other.minIndex;
+                if (m_y[other.maxIndex] > m_y[bucket.maxIndex]) bucket.maxIndex = other.maxIndex;
+            }
+            level.append(bucket);
+        }
+
+        m_levels.append(level);
+        previous.swap(level);
+    }
+}
+
+//
+// Appends about 2 * buckets points covering [from, to], plus one point on
+// either side so lines run to the edges of the view.
+//
+void DecimatedSeries::query(qreal from, qreal to, int buckets, QVector<QPointF> *points) const
+{
+    points->clear();
+    if (m_x.isEmpty() || buckets < 1) {
+        return;
+    }
+
+    int first = qMax(lowerBound(from) - 1, 0);
+    int last = qMin(lowerBound(to) + 1, m_x.count());
+    int count = last - first;
+
+    int level = 0;
+    while (level < m_levels.count() && (count >> (level + 1)) >= buckets) {
+        level++;
+    }
+
+    if (level == 0) {
+        for (int i = first; i < last; i++) {
+            points->append(QPointF(m_x[i], m_y[i]));
+        }
+        return;
+    }
+
+    const QVector<Bucket> &levelBuckets = m_levels[level - 1];
+    int firstBucket = first >> level;
+    int lastBucket = qMin((last - 1) >> level, levelBuckets.count() - 1);
+
+    for (int b = firstBucket; b <= lastBucket; b++) {
+        const Bucket &bucket = levelBuckets[b];
+        int a = qMin(bucket.minIndex, bucket.maxIndex);
+        int c = qMax(bucket.minIndex, bucket.maxIndex);
+        points->append(QPointF(m_x[a], m_y[a]));
+        if (c != a) {
+            points->append(QPointF(m_x[c], m_y[c]));
+        }
+    }
+}
+
+//
+// Linear interpolation at x; false outside the series.
+//
+bool DecimatedSeries::valueAt(qreal x, qreal *value) const
+{
+    if (m_x.isEmpty() || x < m_x.first() || x > m_x.last()) {
+        return false;
+    }
+
+    int i = lowerBound(x);
+    if (i >= m_x.count()) {
+        i = m_x.count() - 1;
+    }
+    if (i == 0 || m_x[i] == x) {
+        *value = m_y[i];
+        return true;
+    }
+
+    qreal x0 = m_x[i - 1];
+    qreal x1 = m_x[i];
+    qreal fraction = (x1 > x0) ? (x - x0) / (x1 - x0) : 0.0;
+    *value = m_y[i - 1] + (fraction * (m_y[i] - m_y[i - 1]));
+    return true;
+}
+
+int DecimatedSeries::lowerBound(qreal x) const
+{
+    int low = 0;
+    int high = m_x.count();
+
+    while (low < high) {
+        int middle = low + ((high - low) / 2);
+        if (m_x[middle] < x) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
@@ -0,0 +1,73 @@
+#ifndef RECORDEDRUN_H
+#define RECORDEDRUN_H
+
+#include <QString>
+#include <QVector>
+#include <QPointF>
+
+//
+// A whole recorded log held in memory for comparison, one column per
+// channel. Single precision keeps ten multi-hour runs comfortably small.
+//
+struct RecordedRun
+{
+    enum Channel {
+        ChannelVoltage = 0,
+        ChannelCurrent,
+        ChannelTemperature,
+        ChannelCount
+    };
+
+    enum Alignment {
+        AlignCycleStart = 0,
+        AlignCharge,
+        AlignTime
+    };
+
+    QString fileName;
+    QString errorString;
+    QVector<float> elapsed;         // s
+    QVector<float> charge;          // C
+    QVector<float> values[ChannelCount];
+
+    bool isValid() const { return !elapsed.isEmpty(); }
+    int count() const { return elapsed.count(); }
+    int cycleStart() const;
+    QVector<float> alignedX(Alignment alignment) const;
+
+    static RecordedRun load(const QString &fileName);
+};
+
+//
+// Min/max pyramid over one (x, y) series. Level k stores the minimum and
+// maximum of every 2^k consecutive points, so any visible range can be
+// reduced to about the requested number of buckets by scanning a level
+// of that size instead of the raw points. x must be non-decreasing.
+//
+class DecimatedSeries
+{
+public:
+    DecimatedSeries();
+
+    void build(const QVector<float> &x, const QVector<float> &y);
+    void query(qreal from, qreal to, int buckets, QVector<QPointF> *points) const;
+    bool valueAt(qreal x, qreal *value) const;
+
+    bool isEmpty() const { return m_x.isEmpty(); }
+    qreal firstX() const { return m_x.first(); }
+    qreal lastX() const { return m_x.last(); }
+
+private:
+    struct Bucket {
+        int minIndex;
+        int maxIndex;
+    };
+
+    int lowerBound(qreal x) const;
+
+    QVector<float> m_x;
+    QVector<float> m_y;
+    QVector<QVector<Bucket>> m_levels;
+};
+
+#endif // RECORDEDRUN_H
@@ -0,0 +1,104 @@
+#include "replaydialog.h"
+#include "ui_replaydialog.h"
+
+#include <QFileInfo>
+
+static const qreal s_speeds[] = { 1.0, 2.0, 10.0, 100.0, 0.0 };
+
+static QString formatDuration(qreal seconds)
+{
+    int total = static_cast<int>(seconds);
+    return QString("%1:%2:%3")
+            .arg(total / 3600)
+            .arg((total / 60) % 60, 2, 10, QChar('0'))
+            .arg(total % 60, 2, 10, QChar('0'));
+}
+
+ReplayDialog::ReplayDialog(ReplaySource *source, QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::ReplayDialog),
+    m_source(source)
+{
+    ui->setupUi(this);
+
+    QString format;
+    switch (m_source->format()) {
+    case ReplaySource::FormatRaw: format = tr("raw bytes"); break;
+    case ReplaySource::FormatCapture: format = tr("timed capture"); break;
+    default: format = tr("decoded"); break;
+    }
+
+    ui->lblFile->setText(tr("%1 (%2)")
+                         .arg(QFileInfo(m_source->fileName()).fileName())
+                         .arg(format));
+    ui->sldPosition->setRange(0, static_cast<int>(m_source->duration()));
+
+    m_updateTimer = new QTimer(this);
+    m_updateTimer->setInterval(250);
+    connect(m_updateTimer, &QTimer::timeout, this, &ReplayDialog::on_updateTimer_timeout);
+    m_updateTimer->start();
+
+    connect(m_source, &ReplaySource::finished, this, &ReplayDialog::on_sourceFinished);
+
+    on_updateTimer_timeout();
+}
+
+ReplayDialog::~ReplayDialog()
+{
+    delete ui;
+}
+
+void ReplayDialog::reject()
+{
+    emit stopRequested();
+}
+
+void ReplayDialog::on_cboSpeed_currentIndexChanged(int index)
+{
+    if (index >= 0 && index < static_cast<int>(sizeof(s_speeds) / sizeof(s_speeds[0]))) {
+        m_source->setSpeed(s_speeds[index]);
+    }
+}
+
+void ReplayDialog::on_btnPause_toggled(bool checked)
+{
+    m_source->setPaused(checked);
+    ui->btnPause->setText(checked ? tr("Resume") : tr("Pause"));
+}
+
+void ReplayDialog::on_btnStop_clicked()
+{
+    emit stopRequested();
+}
+
+void ReplayDialog::on_sldPosition_sliderReleased()
+{
+    emit seekRequested(static_cast<qreal>(ui->sldPosition->value()));
+    m_updateTimer->start();
+}
+
+void ReplayDialog::on_updateTimer_timeout()
+{
+    if (!ui->sldPosition->isSliderDown()) {
+        ui->sldPosition->setValue(static_cast<int>(m_source->position()));
+    }
+
+    ui->lblPosition->setText(tr("%1 / %2")
+                             .arg(formatDuration(m_source->position()))
+                             .arg(formatDuration(m_source->duration())));
+
+    qreal runTime = m_source->runTime();
+    if (runTime > 0.0) {
+        ui->lblThroughput->setText(tr("%1 frames in %2 s, %3 frames/s")
+                                   .arg(m_source->framesDelivered())
+                                   .arg(runTime, 0, 'f', 1)
+                                   .arg(static_cast<qreal>(m_source->framesDelivered()) / runTime, 0, 'f', 0));
+    }
+}
+
+void ReplayDialog::on_sourceFinished()
+{
+    on_updateTimer_timeout();
+    m_updateTimer->stop();
+    ui->lblPosition->setText(tr("Finished, %1").arg(formatDuration(m_source->duration())));
+}
@@ -0,0 +1,47 @@
+#ifndef REPLAYDIALOG_H
+#define REPLAYDIALOG_H
+
+#include "replaysource.h"
+
+#include <QDialog>
+#include <QTimer>
+
+namespace Ui {
+class ReplayDialog;
+}
+
+//
+// Transport controls for a replay: speed, pause, seek and the delivered
+// frame rate. Seeking and stopping are left to the main window, which has
+// to clear or restore the live session around them.
+//
+class ReplayDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit ReplayDialog(ReplaySource *source, QWidget *parent = nullptr);
+    ~ReplayDialog();
+
+signals:
+    void seekRequested(qreal seconds);
+    void stopRequested();
+
+protected:
+    void reject();
+
+private slots:
+    void on_cboSpeed_currentIndexChanged(int index);
+    void on_btnPause_toggled(bool checked);
+    void on_btnStop_clicked();
+    void on_sldPosition_sliderReleased();
+    void on_updateTimer_timeout();
+    void on_sourceFinished();
+
+private:
+    Ui::ReplayDialog *ui;
+    ReplaySource *m_source;
+    QTimer *m_updateTimer = nullptr;
+};
+
+#endif // REPLAYDIALOG_H
@@ -0,0 +1,414 @@
+#include "replaysource.h"
+#include "rawcapture.h"
+#include "packetdecoder.h"
+
+#include <QFileInfo>
+
+#include <float.h>
+#include <string.h>
+
+ReplaySource::ReplaySource(const SampleClock *clock, QObject *parent) :
+    PacketSource(parent),
+    m_clock(clock)
+{
+    m_paceTimer = new QTimer(this);
+    m_paceTimer->setTimerType(Qt::PreciseTimer);
+    m_paceTimer->setInterval(PaceInterval);
+    connect(m_paceTimer, &QTimer::timeout, this, &ReplaySource::on_paceTimer_timeout);
+}
+
+//
+// Raw captures are recognised by their header and anything with a data
+// log header is replayed as decoded samples. Any other file is taken to
+// be bytes dumped from the serial port, as long as its first RawProbeSize
+// bytes hold at least one whole frame; text and other unrelated files are
+// refused rather than replayed as noise.
+//
+bool ReplaySource::open(const QString &fileName)
+{
+    close();
+
+    m_fileName = fileName;
+    m_errorString.clear();
+    m_duration = 0.0;
+
+    m_rawFile.setFileName(fileName);
+    if (!m_rawFile.open(QIODevice::ReadOnly)) {
+        m_errorString = m_rawFile.errorString();
+        return false;
+    }
+
+    char magic[sizeof(RawCapture::Magic)];
+    if (m_rawFile.read(magic, sizeof(magic)) == static_cast<qint64>(sizeof(magic))
+            && memcmp(magic, RawCapture::Magic, sizeof(magic)) == 0) {
+        m_format = FormatCapture;
+        m_rawFile.seek(RawCapture::HeaderSize);
+
+        //
+        // walk the record headers for the time span, skipping payloads
+        //
+        char header[RawCapture::RecordHeaderSize];
+        qint64 first = -1;
+        qint64 last = 0;
+
+        while (m_rawFile.read(header, sizeof(header)) == static_cast<qint64>(sizeof(header))) {
+            qint64 timestamp;
+            quint32 length;
+            memcpy(&timestamp, header, sizeof(timestamp));
+            memcpy(&length, header + 8, sizeof(length));
+
+            if (first < 0) {
+                first = timestamp;
+            }
+            last = timestamp;
+
+            if (!m_rawFile.seek(m_rawFile.pos() + length)) {
+                break;
+            }
+        }
+
+        m_captureOrigin = (first < 0) ? 0 : first;
+        m_duration = static_cast<qreal>(last - m_captureOrigin) / 1000000000.0;
+    }
+    else if (m_reader.open(fileName)) {
+        m_rawFile.close();
+        m_format = FormatDecoded;
+
+        //
+        // one pass up front for the duration, so playback can be sought
+        //
+        LogReader scan;
+        LogRecord record;
+        if (scan.open(fileName)) {
+            while (scan.readNext(&record)) {
+                m_duration = qMax(m_duration, record.elapsed + scan.startOffset());
+            }
+        }
+    }
+    else {
+        m_rawFile.seek(0);
+        QByteArray probe = m_rawFile.read(RawProbeSize);
+        PacketDecoder decoder;
+        bool framed = false;
+
+        for (int i = 0; i < probe.size() && !framed; i++) {
+            framed = decoder.push(probe.at(i));
+        }
+
+        if (!framed) {
+            m_errorString = tr("Not a data log, raw capture or serial port dump");
+            m_rawFile.close();
+            return false;
+        }
+
+        m_format = FormatRaw;
+        m_duration = static_cast<qreal>(m_rawFile.size() / FrameSize) * m_frameInterval;
+    }
+
+    if (!rewind()) {
+        return false;
+    }
+
+    loadNext();
+    if (!m_hasChunk) {
+        m_errorString = tr("The file contains no samples");
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+//
+// Raw captures carry no timing, so each frame's worth of bytes is paced
+// at this interval.
+//
+void ReplaySource::setFrameInterval(qreal seconds)
+{
+    m_frameInterval = seconds;
+
+    if (m_format == FormatRaw && m_rawFile.isOpen()) {
+        m_duration = static_cast<qreal>(m_rawFile.size() / FrameSize) * m_frameInterval;
+    }
+}
+
+void ReplaySource::setSpeed(qreal speed)
+{
+    m_speed = qMax(speed, 0.0);
+    m_paceTimer->setInterval(m_speed > 0.0 ? PaceInterval : 0);
+    rebase();
+    emit stateChanged();
+}
+
+void ReplaySource::setPaused(bool paused)
+{
+    if (paused == m_paused) {
+        return;
+    }
+
+    m_paused = paused;
+
+    if (m_paused) {
+        if (m_paceClock.isValid()) {
+            m_runNanos += m_paceClock.nsecsElapsed();
+            m_paceClock.invalidate();
+        }
+        m_paceTimer->stop();
+    }
+    else {
+        rebase();
+        if (m_running && m_hasChunk) {
+            m_paceTimer->start();
+        }
+    }
+
+    emit stateChanged();
+}
+
+//
+// Repositions playback at the given recorded time. The caller clears the
+// session first; timestamps restart from the current time so the sample
+// store stays in order.
+//
+void ReplaySource::seek(qreal seconds)
+{
+    seconds = qBound(0.0, seconds, m_duration);
+
+    if (m_format == FormatRaw) {
+        m_rawIndex = static_cast<qint64>(seconds / m_frameInterval);
+        m_rawFile.seek(m_rawIndex * FrameSize);
+        m_chunkTime = 0.0;
+        loadNext();
+    }
+    else {
+        if (!m_hasChunk || seconds < m_chunkTime) {
+            rewind();
+            loadNext();
+        }
+
+        while (m_hasChunk && m_chunkTime < seconds) {
+            loadNext();
+        }
+    }
+
+    m_finished = false;
+    m_timeOrigin = m_clock->now() - static_cast<qint64>(m_chunkTime * 1000000000.0);
+    rebase();
+
+    if (m_running && !m_paused && m_hasChunk) {
+        m_paceTimer->start();
+    }
+}
+
+qreal ReplaySource::runTime() const
+{
+    qint64 nanos = m_runNanos;
+    if (m_paceClock.isValid()) {
+        nanos += m_paceClock.nsecsElapsed();
+    }
+    return static_cast<qreal>(nanos) / 1000000000.0;
+}
+
+QString ReplaySource::description() const
+{
+    QString speed = (m_speed > 0.0) ? tr("%1×").arg(m_speed) : tr("max speed");
+
+    return tr("Replay %1 (%2%3)")
+            .arg(QFileInfo(m_fileName).fileName())
+            .arg(speed)
+            .arg(m_paused ? tr(", paused") : QString());
+}
+
+bool ReplaySource::isOpen() const
+{
+    return m_reader.isOpen() || m_rawFile.isOpen();
+}
+
+//
+// Hands out one frame at a time, each stamped with its own recorded time,
+// until playback catches up with the pace or the batch is used up.
+//
+qint64 ReplaySource::read(char *data, qint64 maxSize, qint64 *timestamp)
+{
+    if (!m_hasChunk || m_batchRemaining <= 0 || m_chunkTime > m_target) {
+        return 0;
+    }
+
+    qint64 length = qMin(m_chunkLength, maxSize);
+    memcpy(data, m_chunk, static_cast<size_t>(length));
+    *timestamp = m_timeOrigin + static_cast<qint64>(m_chunkTime * 1000000000.0);
+
+    m_framesDelivered++;
+    m_batchRemaining--;
+    loadNext();
+
+    return length;
+}
+
+void ReplaySource::start()
+{
+    m_running = true;
+    m_finished = false;
+    m_timeOrigin = m_clock->now() - static_cast<qint64>(m_chunkTime * 1000000000.0);
+    rebase();
+
+    if (!m_paused && m_hasChunk) {
+        m_paceTimer->start();
+    }
+}
+
+void ReplaySource::close()
+{
+    m_paceTimer->stop();
+    m_paceClock.invalidate();
+    m_running = false;
+    m_hasChunk = false;
+
+    m_reader.close();
+    if (m_rawFile.isOpen()) {
+        m_rawFile.close();
+    }
+}
+
+void ReplaySource::on_paceTimer_timeout()
+{
+    if (m_paused || !m_hasChunk) {
+        return;
+    }
+
+    m_target = (m_speed > 0.0) ? m_paceStart + ((static_cast<qreal>(m_paceClock.nsecsElapsed()) / 1000000000.0) * m_speed) : DBL_MAX;
+    m_batchRemaining = MaximumBatch;
+
+    if (m_chunkTime <= m_target) {
+        emit readyRead();
+    }
+
+    if (!m_hasChunk && !m_finished) {
+        m_finished = true;
+        m_runNanos += m_paceClock.nsecsElapsed();
+        m_paceClock.invalidate();
+        m_paceTimer->stop();
+        emit finished();
+    }
+}
+
+bool ReplaySource::rewind()
+{
+    m_previousCharge = -1.0;
+    m_inferredMode = MODE_DISCHARGING;
+    m_chunkTime = 0.0;
+    m_rawIndex = 0;
+
+    if (m_format == FormatRaw) {
+        return m_rawFile.seek(0);
+    }
+
+    if (m_format == FormatCapture) {
+        return m_rawFile.seek(RawCapture::HeaderSize);
+    }
+
+    if (!m_reader.open(m_fileName)) {
+        m_errorString = m_reader.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+void ReplaySource::loadNext()
+{
+    m_hasChunk = false;
+
+    if (m_format == FormatDecoded) {
+        LogRecord record;
+        if (m_reader.readNext(&record)) {
+            //
+            // elapsed restarts where the session was cleared mid-log
+            //
+            encodeFrame(record);
+            m_chunkTime = qMax(m_chunkTime, record.elapsed + m_reader.startOffset());
+            m_hasChunk = true;
+        }
+    }
+    else if (m_format == FormatCapture) {
+        char header[RawCapture::RecordHeaderSize];
+        if (m_rawFile.read(header, sizeof(header)) == static_cast<qint64>(sizeof(header))) {
+            qint64 timestamp;
+            quint32 length;
+            memcpy(&timestamp, header, sizeof(timestamp));
+            memcpy(&length, header + 8, sizeof(length));
+
+            if (length <= static_cast<quint32>(MaximumChunk) && m_rawFile.read(m_chunk, length) == static_cast<qint64>(length)) {
+                m_chunkLength = length;
+                m_chunkTime = qMax(m_chunkTime, static_cast<qreal>(timestamp - m_captureOrigin) / 1000000000.0);
+                m_hasChunk = true;
+            }
+        }
+    }
+    else if (m_rawFile.isOpen()) {
+        qint64 length = m_rawFile.read(m_chunk, FrameSize);
+        if (length > 0) {
+            m_chunkLength = length;
+            m_chunkTime = static_cast<qreal>(m_rawIndex) * m_frameInterval;
+            m_rawIndex++;
+            m_hasChunk = true;
+        }
+    }
+}
+
+//
+// Logs written before the mode column existed only say which way the
+// charge moved, so charging and discharging are inferred from that; load
+// tests cannot be told apart from discharges. Logs written before the cell
+// columns existed show each cell as an even share of the pack voltage.
+//
+void ReplaySource::encodeFrame(const LogRecord &record)
+{
+    int mode = record.mode;
+    if (mode < 0) {
+        if (m_previousCharge >= 0.0 && record.charge > m_previousCharge) {
+            m_inferredMode = MODE_CHARGING;
+        }
+        else if (m_previousCharge >= 0.0 && record.charge < m_previousCharge) {
+            m_inferredMode = MODE_DISCHARGING;
+        }
+        mode = m_inferredMode;
+    }
+    m_previousCharge = record.charge;
+
+    status_packet_t packet;
+    packet.a = 'A';
+    packet.mode = static_cast<uint8_t>(mode);
+    packet.current = static_cast<int16_t>(qBound(-32768, qRound(record.current * 1000.0), 32767));
+    packet.temperature = static_cast<uint16_t>(qBound(0, qRound(record.temperature * 1000.0), 65535));
+    packet.charge_state = static_cast<uint16_t>(qBound(0, qRound(record.charge), 65535));
+    packet.pack_voltage = static_cast<uint16_t>(qBound(0, qRound(record.voltage * 1000.0), 65535));
+    for (int i = 0; i < 6; i++) {
+        packet.cell_voltage[i] = m_reader.hasCellVoltages()
+                ? static_cast<uint16_t>(qBound(0, qRound(record.cellVoltage[i] * 1000.0), 65535))
+                : static_cast<uint16_t>(packet.pack_voltage / 6);
+    }
+    packet.b = 'B';
+
+    m_chunk[0] = 'D';
+    m_chunk[1] = 'E';
+    memcpy(m_chunk + 2, &packet, sizeof(packet));
+    m_chunkLength = FrameSize;
+}
+
+void ReplaySource::rebase()
+{
+    if (m_paceClock.isValid()) {
+        m_runNanos += m_paceClock.nsecsElapsed();
+    }
+
+    m_paceStart = m_chunkTime;
+    m_target = m_chunkTime;
+
+    if (m_running && !m_paused && !m_finished) {
+        m_paceClock.start();
+    }
+    else {
+        m_paceClock.invalidate();
+    }
+}
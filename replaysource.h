@@ -0,0 +1,114 @@
+#ifndef REPLAYSOURCE_H
+#define REPLAYSOURCE_H
+
+#include "packetsource.h"
+#include "logreader.h"
+#include "statuspacket.h"
+
+#include <QFile>
+#include <QElapsedTimer>
+#include <QTimer>
+
+//
+// Plays a recorded session back through the live pipeline. Decoded CSV
+// logs are re-encoded into 'D','E' frames, timed raw captures are fed
+// back in exactly the chunks they were read in, and untimed byte dumps
+// are fed a frame's worth at a time; all of them go through the same
+// decoder as the serial port. Chunks are stamped with their recorded time
+// offset from the start of playback, so the sample clock, drop detection
+// and analysis see the original timing at any replay speed.
+//
+// A speed of 0 replays as fast as possible, in batches that still let the
+// event loop draw the chart and run its timers; the delivered frame rate
+// is then an end-to-end throughput figure for the whole application.
+//
+class ReplaySource : public PacketSource
+{
+    Q_OBJECT
+
+public:
+    enum Format {
+        FormatDecoded = 0,
+        FormatRaw,
+        FormatCapture
+    };
+
+    explicit ReplaySource(const SampleClock *clock, QObject *parent = nullptr);
+
+    bool open(const QString &fileName);
+    QString fileName() const { return m_fileName; }
+    QString errorString() const { return m_errorString; }
+    Format format() const { return m_format; }
+
+    void setFrameInterval(qreal seconds);
+    void setSpeed(qreal speed);
+    void setPaused(bool paused);
+    void seek(qreal seconds);
+
+    qreal speed() const { return m_speed; }
+    bool isPaused() const { return m_paused; }
+    bool atEnd() const { return !m_hasChunk; }
+    qreal duration() const { return m_duration; }
+    qreal position() const { return m_chunkTime; }
+    quint64 framesDelivered() const { return m_framesDelivered; }
+    qreal runTime() const;
+
+    QString description() const override;
+    bool isOpen() const override;
+    qint64 read(char *data, qint64 maxSize, qint64 *timestamp) override;
+    void start() override;
+    void close() override;
+
+signals:
+    void stateChanged();
+    void finished();
+
+private slots:
+    void on_paceTimer_timeout();
+
+private:
+    static const int FrameSize = 2 + sizeof(status_packet_t);
+    static const int RawProbeSize = 65536;
+    static const int MaximumBatch = 2000;
+    static const int PaceInterval = 10;
+    static const int MaximumChunk = 4096;
+
+    bool rewind();
+    void loadNext();
+    void encodeFrame(const LogRecord &record);
+    void rebase();
+
+    const SampleClock *m_clock;
+    QString m_fileName;
+    QString m_errorString;
+    Format m_format = FormatDecoded;
+    LogReader m_reader;
+    QFile m_rawFile;
+    qreal m_frameInterval = 0.1;
+    qreal m_duration = 0.0;
+    qreal m_previousCharge = -1.0;
+    int m_inferredMode = MODE_DISCHARGING;
+    qint64 m_rawIndex = 0;
+    qint64 m_captureOrigin = 0;
+
+    char m_chunk[MaximumChunk];
+    qint64 m_chunkLength = 0;
+    qreal m_chunkTime = 0.0;
+    bool m_hasChunk = false;
+
+    QTimer *m_paceTimer = nullptr;
+    QElapsedTimer m_paceClock;
+    qreal m_paceStart = 0.0;
+    qreal m_target = 0.0;
+    qint64 m_timeOrigin = 0;
+    int m_batchRemaining = 0;
+    qreal m_speed = 1.0;
+    bool m_paused = false;
+    bool m_running = false;
+    bool m_finished = false;
+
+    quint64 m_framesDelivered = 0;
+    qint64 m_runNanos = 0;
+};
+
+#endif // REPLAYSOURCE_H
@@ -0,0 +1,532 @@
+#include "reportrenderer.h"
+#include "sessionsnapshot.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QImage>
+#include <QPainter>
+#include <QPdfWriter>
+#include <QPolygonF>
+#include <QStringList>
+#include <QSvgGenerator>
+#include <QVector>
+
+#include <float.h>
+#include <limits.h>
+
+enum ReportChannel {
+    ReportVoltage = 0,
+    ReportCurrent,
+    ReportTemperature,
+    ReportChannelCount
+};
+
+static const char *s_channelTitles[ReportChannelCount] = {
+    QT_TRANSLATE_NOOP("ReportRenderer", "Pack voltage (V)"),
+    QT_TRANSLATE_NOOP("ReportRenderer", "Current (A)"),
+    QT_TRANSLATE_NOOP("ReportRenderer", "Temperature (°C)")
+};
+
+static const QColor s_channelColors[ReportChannelCount] = {
+    Qt::red, Qt::blue, QColor(0xd0, 0x90, 0x00)
+};
+
+//
+// Steps longer than this are a gap in the recording, not something to
+// integrate over.
+//
+static const qreal MaximumStep = 10.0;
+
+//
+// Everything one horizontal device pixel of the plots shows.
+//
+struct ReportBucket
+{
+    float minimum[ReportChannelCount];
+    float maximum[ReportChannelCount];
+    double cellSum[6];
+    int cellCount[6];
+    int count;
+};
+
+struct ReportSummary
+{
+    qint64 first = 0;
+    qint64 last = 0;
+    qint64 samples = 0;
+    int gaps = 0;
+    qreal minimumVoltage = DBL_MAX;
+    qreal maximumVoltage = -DBL_MAX;
+    qreal peakCurrent = 0.0;
+    qreal maximumTemperature = -DBL_MAX;
+    qreal dischargedAh = 0.0;
+    qreal dischargedWh = 0.0;
+    qreal chargedAh = 0.0;
+    int maximumImbalance = 0;       // mV
+};
+
+static QString tr(const char *text)
+{
+    return QCoreApplication::translate("ReportRenderer", text);
+}
+
+static qint64 lowerBound(const Sample *samples, qint64 count, qint64 timestamp)
+{
+    qint64 low = 0;
+    qint64 high = count;
+
+    while (low < high) {
+        qint64 middle = low + (high - low) / 2;
+        if (samples[middle].timestamp < timestamp) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+//
+// One pass over [first, end): min/max per bucket for the plots, cell sums
+// for the heatmap and the running figures for the summary.
+//
+static void reduce(const Sample *samples, qint64 first, qint64 end, qint64 from, qint64 to,
+                   QVector<ReportBucket> *buckets, ReportSummary *summary)
+{
+    int bucketCount = buckets->count();
+    ReportBucket *bucket = buckets->data();
+    qint64 span = qMax(to - from, static_cast<qint64>(1));
+
+    for (int b = 0; b < bucketCount; b++) {
+        for (int c = 0; c < ReportChannelCount; c++) {
+            bucket[b].minimum[c] = FLT_MAX;
+            bucket[b].maximum[c] = -FLT_MAX;
+        }
+        for (int cell = 0; cell < 6; cell++) {
+            bucket[b].cellSum[cell] = 0.0;
+            bucket[b].cellCount[cell] = 0;
+        }
+        bucket[b].count = 0;
+    }
+
+    summary->first = samples[first].timestamp;
+    summary->last = samples[end - 1].timestamp;
+    summary->samples = end - first;
+
+    for (qint64 i = first; i < end; i++) {
+        const Sample &sample = samples[i];
+
+        int index = static_cast<int>((sample.timestamp - from) * bucketCount / span);
+        ReportBucket &target = bucket[qBound(0, index, bucketCount - 1)];
+
+        float values[ReportChannelCount] = {
+            static_cast<float>(sample.volts()),
+            static_cast<float>(sample.amps()),
+            static_cast<float>(sample.celsius())
+        };
+        for (int c = 0; c < ReportChannelCount; c++) {
+            target.minimum[c] = qMin(target.minimum[c], values[c]);
+            target.maximum[c] = qMax(target.maximum[c], values[c]);
+        }
+        target.count++;
+
+        int lowest = INT_MAX;
+        int highest = 0;
+        for (int cell = 0; cell < 6; cell++) {
+            int millivolts = sample.cellVoltage[cell];
+            if (millivolts == 0) {
+                continue;
+            }
+            target.cellSum[cell] += millivolts;
+            target.cellCount[cell]++;
+            lowest = qMin(lowest, millivolts);
+            highest = qMax(highest, millivolts);
+        }
+        if (highest > 0) {
+            summary->maximumImbalance = qMax(summary->maximumImbalance, highest - lowest);
+        }
+
+        summary->minimumVoltage = qMin(summary->minimumVoltage, sample.volts());
+        summary->maximumVoltage = qMax(summary->maximumVoltage, sample.volts());
+        summary->peakCurrent = qMax(summary->peakCurrent, sample.amps());
+        summary->maximumTemperature = qMax(summary->maximumTemperature, sample.celsius());
+
+        if (i > first) {
+            qreal step = static_cast<qreal>(sample.timestamp - samples[i - 1].timestamp) / 1000000.0;
+            if (step > MaximumStep) {
+                summary->gaps++;
+            }
+            else if (step > 0.0) {
+                qreal ampHours = sample.amps() * step / 3600.0;
+                if (sample.mode == MODE_CHARGING) {
+                    summary->chargedAh += ampHours;
+                }
+                else {
+                    summary->dischargedAh += ampHours;
+                    summary->dischargedWh += ampHours * sample.volts();
+                }
+            }
+        }
+    }
+}
+
+//
+// Tick spacing giving at most about eight labels across the time axis.
+//
+static qint64 timeStep(qint64 span)
+{
+    static const qint64 steps[] = {
+        1, 2, 5, 10, 15, 30, 60, 120, 300, 600, 900, 1800, 3600, 7200,
+        10800, 21600, 43200, 86400, 172800, 604800
+    };
+
+    for (qint64 step : steps) {
+        if (span / (step * 1000000) <= 8) {
+            return step * 1000000;
+        }
+    }
+
+    return 2419200000000LL;
+}
+
+static void paintPane(QPainter *painter, const QRectF &area, qreal labelWidth, qreal lineWidth,
+                      const QVector<ReportBucket> &buckets, int channel)
+{
+    float minimum = FLT_MAX;
+    float maximum = -FLT_MAX;
+    for (const ReportBucket &bucket : buckets) {
+        if (bucket.count > 0) {
+            minimum = qMin(minimum, bucket.minimum[channel]);
+            maximum = qMax(maximum, bucket.maximum[channel]);
+        }
+    }
+    if (minimum > maximum) {
+        minimum = 0.0f;
+        maximum = 1.0f;
+    }
+
+    qreal padding = qMax((maximum - minimum) * 0.05, 0.01);
+    qreal low = minimum - padding;
+    qreal high = maximum + padding;
+
+    painter->setPen(QPen(QColor(0xc8, 0xc8, 0xc8), lineWidth));
+    painter->drawRect(area);
+    for (int i = 1; i < 4; i++) {
+        qreal y = area.top() + area.height() * i / 4.0;
+        painter->drawLine(QPointF(area.left(), y), QPointF(area.right(), y));
+    }
+
+    painter->setPen(Qt::black);
+    for (int i = 0; i <= 4; i++) {
+        qreal y = area.top() + area.height() * i / 4.0;
+        qreal value = high - (high - low) * i / 4.0;
+        QRectF label(area.left() - labelWidth, y - labelWidth, labelWidth * 0.9, labelWidth * 2.0);
+        painter->drawText(label, Qt::AlignRight | Qt::AlignVCenter, QString::number(value, 'f', 2));
+    }
+
+    painter->setPen(s_channelColors[channel]);
+    painter->drawText(area.adjusted(lineWidth * 4.0, lineWidth * 2.0, 0.0, 0.0), Qt::AlignLeft | Qt::AlignTop, tr(s_channelTitles[channel]));
+
+    //
+    // two points per bucket trace the min/max envelope; empty buckets
+    // break the line
+    //
+    painter->setPen(QPen(s_channelColors[channel], lineWidth));
+    qreal scaleX = area.width() / buckets.count();
+    qreal scaleY = area.height() / (high - low);
+    QPolygonF line;
+
+    for (int b = 0; b <= buckets.count(); b++) {
+        if (b == buckets.count() || buckets[b].count == 0) {
+            if (line.count() > 1) {
+                painter->drawPolyline(line);
+            }
+            line.clear();
+            continue;
+        }
+
+        qreal x = area.left() + (b + 0.5) * scaleX;
+        line << QPointF(x, area.bottom() - (buckets[b].minimum[channel] - low) * scaleY)
+             << QPointF(x, area.bottom() - (buckets[b].maximum[channel] - low) * scaleY);
+    }
+}
+
+//
+// Each cell's mean over the bucket against the mean of all fitted cells,
+// blue below and red above; cells that never report are left out.
+//
+static void paintHeatmap(QPainter *painter, const QRectF &area, qreal labelWidth, qreal lineWidth,
+                         const QVector<ReportBucket> &buckets)
+{
+    int cells[6];
+    int rows = 0;
+    for (int cell = 0; cell < 6; cell++) {
+        for (const ReportBucket &bucket : buckets) {
+            if (bucket.cellCount[cell] > 0) {
+                cells[rows++] = cell;
+                break;
+            }
+        }
+    }
+
+    painter->setPen(Qt::black);
+    if (rows == 0) {
+        painter->drawText(area, Qt::AlignCenter, tr("No cell voltages recorded"));
+        return;
+    }
+
+    QVector<float> deviations(buckets.count() * rows, 0.0f);
+    float largest = 5.0f;
+
+    for (int b = 0; b < buckets.count(); b++) {
+        const ReportBucket &bucket = buckets[b];
+        double total = 0.0;
+        int fitted = 0;
+        for (int r = 0; r < rows; r++) {
+            if (bucket.cellCount[cells[r]] > 0) {
+                total += bucket.cellSum[cells[r]] / bucket.cellCount[cells[r]];
+                fitted++;
+            }
+        }
+        if (fitted == 0) {
+            continue;
+        }
+
+        double mean = total / fitted;
+        for (int r = 0; r < rows; r++) {
+            if (bucket.cellCount[cells[r]] > 0) {
+                float deviation = static_cast<float>(bucket.cellSum[cells[r]] / bucket.cellCount[cells[r]] - mean);
+                deviations[r * buckets.count() + b] = deviation;
+                largest = qMax(largest, qAbs(deviation));
+            }
+        }
+    }
+
+    QImage image(buckets.count(), rows, QImage::Format_RGB32);
+    for (int r = 0; r < rows; r++) {
+        QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(r));
+        for (int b = 0; b < buckets.count(); b++) {
+            if (buckets[b].cellCount[cells[r]] == 0) {
+                line[b] = qRgb(0xe0, 0xe0, 0xe0);
+                continue;
+            }
+
+            qreal t = qBound(-1.0, static_cast<qreal>(deviations[r * buckets.count() + b] / largest), 1.0);
+            int fade = 255 - qRound(qAbs(t) * 255.0);
+            line[b] = (t < 0.0) ? qRgb(fade, fade, 255) : qRgb(255, fade, fade);
+        }
+    }
+
+    painter->drawImage(area, image);
+
+    painter->setPen(QPen(QColor(0xc8, 0xc8, 0xc8), lineWidth));
+    painter->drawRect(area);
+
+    painter->setPen(Qt::black);
+    qreal rowHeight = area.height() / rows;
+    for (int r = 0; r < rows; r++) {
+        QRectF label(area.left() - labelWidth, area.top() + r * rowHeight, labelWidth * 0.9, rowHeight);
+        painter->drawText(label, Qt::AlignRight | Qt::AlignVCenter, tr("Cell %1").arg(cells[r] + 1));
+    }
+
+    painter->drawText(QRectF(area.left(), area.top() - labelWidth, area.width(), labelWidth),
+                      Qt::AlignLeft | Qt::AlignBottom,
+                      tr("Cell deviation from the mean, blue -%1 mV to red +%1 mV").arg(largest, 0, 'f', 0));
+}
+
+static void paintTimeAxis(QPainter *painter, const QRectF &plots, qreal labelHeight, qreal lineWidth, qint64 from, qint64 to)
+{
+    qint64 span = qMax(to - from, static_cast<qint64>(1));
+    qint64 step = timeStep(span);
+
+    QString format = "hh:mm:ss";
+    if (span > 2LL * 86400 * 1000000) {
+        format = "MMM d hh:mm";
+    }
+    else if (span > 600LL * 1000000) {
+        format = "hh:mm";
+    }
+
+    //
+    // ticks on round local times
+    //
+    qint64 offset = static_cast<qint64>(QDateTime::fromMSecsSinceEpoch(from / 1000).offsetFromUtc()) * 1000000;
+    qint64 tick = ((from + offset + step - 1) / step) * step - offset;
+
+    for (; tick <= to; tick += step) {
+        qreal x = plots.left() + plots.width() * static_cast<qreal>(tick - from) / static_cast<qreal>(span);
+
+        painter->setPen(QPen(QColor(0xe4, 0xe4, 0xe4), lineWidth, Qt::DashLine));
+        painter->drawLine(QPointF(x, plots.top()), QPointF(x, plots.bottom()));
+
+        painter->setPen(Qt::black);
+        QRectF label(x - labelHeight * 4.0, plots.bottom(), labelHeight * 8.0, labelHeight);
+        painter->drawText(label, Qt::AlignCenter, QDateTime::fromMSecsSinceEpoch(tick / 1000).toString(format));
+    }
+}
+
+static void paintSummary(QPainter *painter, const QRectF &area, const ReportSummary &summary)
+{
+    qint64 seconds = (summary.last - summary.first) / 1000000;
+    QString duration = tr("%1 d %2 h %3 min").arg(seconds / 86400).arg((seconds / 3600) % 24).arg((seconds / 60) % 60);
+
+    QStringList columns[3];
+    columns[0] << tr("Start: %1").arg(QDateTime::fromMSecsSinceEpoch(summary.first / 1000).toString("yyyy-MM-dd hh:mm:ss"))
+               << tr("End: %1").arg(QDateTime::fromMSecsSinceEpoch(summary.last / 1000).toString("yyyy-MM-dd hh:mm:ss"))
+               << tr("Duration: %1").arg(duration)
+               << tr("Samples: %1, %2 gap(s)").arg(summary.samples).arg(summary.gaps);
+    columns[1] << tr("Voltage: %1 to %2 V").arg(summary.minimumVoltage, 0, 'f', 3).arg(summary.maximumVoltage, 0, 'f', 3)
+               << tr("Peak current: %1 A").arg(summary.peakCurrent, 0, 'f', 3)
+               << tr("Maximum temperature: %1 °C").arg(summary.maximumTemperature, 0, 'f', 1);
+    columns[2] << tr("Discharged: %1 Ah, %2 Wh").arg(summary.dischargedAh, 0, 'f', 3).arg(summary.dischargedWh, 0, 'f', 2)
+               << tr("Charged: %1 Ah").arg(summary.chargedAh, 0, 'f', 3)
+               << tr("Maximum cell imbalance: %1 mV").arg(summary.maximumImbalance);
+
+    painter->setPen(Qt::black);
+    qreal columnWidth = area.width() / 3.0;
+    for (int c = 0; c < 3; c++) {
+        QRectF column(area.left() + c * columnWidth, area.top(), columnWidth, area.height());
+        painter->drawText(column, Qt::AlignLeft | Qt::AlignTop, columns[c].join('\n'));
+    }
+}
+
+static void paintReport(QPainter *painter, const QRectF &page, const ReportOptions &options,
+                        const Sample *samples, qint64 first, qint64 end, qint64 from, qint64 to)
+{
+    qreal fontSize = qMax(page.height() / 55.0, 8.0);
+    qreal lineWidth = qMax(page.width() / 1600.0, 1.0);
+    qreal margin = page.width() * 0.025;
+    qreal labelWidth = fontSize * 5.0;
+
+    QFont font = painter->font();
+    font.setPixelSize(qRound(fontSize));
+    painter->setFont(font);
+
+    painter->fillRect(page, Qt::white);
+
+    //
+    // title, three plots sharing the time axis, heatmap, summary
+    //
+    QRectF content = page.adjusted(margin, margin, -margin, -margin);
+    QRectF title(content.left(), content.top(), content.width(), fontSize * 2.0);
+    QRectF summaryArea(content.left() + labelWidth, content.bottom() - fontSize * 6.5, content.width() - labelWidth, fontSize * 6.5);
+    qreal heatmapHeight = content.height() * 0.14;
+    QRectF heatmap(content.left() + labelWidth, summaryArea.top() - fontSize - heatmapHeight, content.width() - labelWidth, heatmapHeight);
+    QRectF plots(content.left() + labelWidth, title.bottom() + fontSize,
+                 content.width() - labelWidth, heatmap.top() - fontSize * 3.5 - title.bottom() - fontSize);
+
+    QFont titleFont = font;
+    titleFont.setPixelSize(qRound(fontSize * 1.6));
+    titleFont.setBold(true);
+    painter->setFont(titleFont);
+    painter->setPen(Qt::black);
+    painter->drawText(title, Qt::AlignLeft | Qt::AlignVCenter,
+                      options.title.isEmpty() ? tr("Battery pack session report") : options.title);
+    painter->setFont(font);
+
+    int bucketCount = qBound(1, qRound(plots.width()), 8192);
+    QVector<ReportBucket> buckets(bucketCount);
+    ReportSummary summary;
+    reduce(samples, first, end, from, to, &buckets, &summary);
+
+    qreal gap = fontSize * 0.6;
+    qreal paneHeight = (plots.height() - gap * (ReportChannelCount - 1)) / ReportChannelCount;
+    for (int c = 0; c < ReportChannelCount; c++) {
+        QRectF pane(plots.left(), plots.top() + c * (paneHeight + gap), plots.width(), paneHeight);
+        paintPane(painter, pane, labelWidth, lineWidth, buckets, c);
+    }
+
+    paintTimeAxis(painter, plots, fontSize * 1.5, lineWidth, from, to);
+    paintHeatmap(painter, heatmap, labelWidth, lineWidth, buckets);
+    paintSummary(painter, summaryArea, summary);
+}
+
+ReportResult ReportRenderer::render(const QString &snapshotFileName, const ReportOptions &options)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    ReportResult result;
+    result.fileName = options.fileName;
+
+    SessionSnapshot snapshot;
+    if (!snapshot.open(snapshotFileName) || snapshot.count() == 0) {
+        result.errorString = tr("No session data in %1").arg(snapshotFileName);
+        return result;
+    }
+
+    const Sample *samples = snapshot.samples();
+    qint64 count = snapshot.count();
+
+    qint64 from = (options.from > 0) ? options.from : samples[0].timestamp;
+    qint64 to = (options.to > 0) ? options.to : samples[count - 1].timestamp;
+    qint64 first = lowerBound(samples, count, from);
+    qint64 end = lowerBound(samples, count, to + 1);
+
+    if (end <= first) {
+        result.errorString = tr("No samples in the requested time range");
+        return result;
+    }
+
+    if (to <= from) {
+        to = from + 1000000;
+    }
+
+    result.samples = end - first;
+    QString title = options.title.isEmpty() ? tr("Battery pack session report") : options.title;
+    QString suffix = QFileInfo(options.fileName).suffix().toLower();
+    QPainter painter;
+
+    if (suffix == "pdf") {
+        QPdfWriter writer(options.fileName);
+        writer.setPageSize(QPageSize(QPageSize::A4));
+        writer.setPageOrientation(QPageLayout::Landscape);
+        writer.setResolution(200);
+        writer.setTitle(title);
+        writer.setCreator(QCoreApplication::applicationName());
+
+        if (!painter.begin(&writer)) {
+            result.errorString = tr("Could not write %1").arg(options.fileName);
+            return result;
+        }
+        paintReport(&painter, QRectF(0.0, 0.0, writer.width(), writer.height()), options, samples, first, end, from, to);
+        painter.end();
+    }
+    else if (suffix == "svg") {
+        QSvgGenerator generator;
+        generator.setFileName(options.fileName);
+        generator.setSize(options.size);
+        generator.setViewBox(QRect(QPoint(0, 0), options.size));
+        generator.setTitle(title);
+
+        if (!painter.begin(&generator)) {
+            result.errorString = tr("Could not write %1").arg(options.fileName);
+            return result;
+        }
+        paintReport(&painter, QRectF(QPointF(0.0, 0.0), options.size), options, samples, first, end, from, to);
+        painter.end();
+    }
+    else if (suffix == "png") {
+        QImage image(options.size, QImage::Format_ARGB32_Premultiplied);
+        painter.begin(&image);
+        painter.setRenderHint(QPainter::Antialiasing);
+        paintReport(&painter, QRectF(QPointF(0.0, 0.0), options.size), options, samples, first, end, from, to);
+        painter.end();
+
+        if (!image.save(options.fileName, "PNG")) {
+            result.errorString = tr("Could not write %1").arg(options.fileName);
+            return result;
+        }
+    }
+    else {
+        result.errorString = tr("Unsupported report format '%1'; use .png, .pdf or .svg").arg(suffix);
+        return result;
+    }
+
+    result.elapsed = timer.elapsed();
+    return result;
+}
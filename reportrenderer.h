@@ -0,0 +1,47 @@
+#ifndef REPORTRENDERER_H
+#define REPORTRENDERER_H
+
+#include <QSize>
+#include <QString>
+
+//
+// What to render. The format follows the file suffix: .png, .pdf or .svg.
+//
+struct ReportOptions
+{
+    QString fileName;
+    QString title;
+    qint64 from = 0;                // wall clock µs, 0 for the session start
+    qint64 to = 0;                  // wall clock µs, 0 for the session end
+    QSize size = QSize(1600, 1200); // PNG and SVG; PDF is an A4 landscape page
+};
+
+struct ReportResult
+{
+    QString fileName;
+    QString errorString;
+    qint64 samples = 0;
+    qint64 elapsed = 0;             // ms spent rendering
+
+    bool isValid() const { return errorString.isEmpty(); }
+};
+
+//
+// Renders a session report - voltage, current and temperature over the
+// whole session, a heatmap of each cell's deviation from the cell mean,
+// and summary statistics - straight from a session snapshot file. Nothing
+// here touches widgets or the live stores, so render() can run on a
+// worker thread or without a window at all.
+//
+// The snapshot is memory-mapped and read in a single pass that reduces it
+// to one min/max bucket per horizontal device pixel of the plot area, so
+// the cost of drawing depends on the output size rather than on how long
+// the session ran.
+//
+class ReportRenderer
+{
+public:
+    static ReportResult render(const QString &snapshotFileName, const ReportOptions &options);
+};
+
+#endif // REPORTRENDERER_H
@@ -0,0 +1,88 @@
+#include "ricecoder.h"
+
+static const int MaximumRiceParameter = 32;
+
+static qint64 riceCost(quint64 value, int parameter)
+{
+    quint64 quotient = value >> parameter;
+    return (quotient < RiceCoder::EscapeLength) ? static_cast<qint64>(quotient) + 1 + parameter : RiceCoder::MaximumResidualBits;
+}
+
+static void writeRice(BitWriter *writer, quint64 value, int parameter)
+{
+    quint64 quotient = value >> parameter;
+
+    if (quotient < RiceCoder::EscapeLength) {
+        writer->writeOnes(static_cast<int>(quotient));
+        writer->write(0, 1);
+        writer->write(value, parameter);
+    }
+    else {
+        writer->writeOnes(RiceCoder::EscapeLength);
+        writer->write(value, 32);
+        writer->write(value >> 32, 32);
+    }
+}
+
+static quint64 readRice(BitReader *reader, int parameter)
+{
+    int quotient = 0;
+    while (quotient < RiceCoder::EscapeLength && reader->read(1) != 0) {
+        quotient++;
+    }
+
+    if (quotient == RiceCoder::EscapeLength) {
+        quint64 low = reader->read(32);
+        return low | (reader->read(32) << 32);
+    }
+
+    return (static_cast<quint64>(quotient) << parameter) | reader->read(parameter);
+}
+
+//
+// Writes a column of zigzagged residuals with the cheapest Rice parameter
+// and returns the parameter, or ConstantColumn if every residual is zero.
+//
+uchar RiceCoder::writeColumn(BitWriter *writer, const quint64 *residuals, int count)
+{
+    bool constant = true;
+    for (int i = 0; i < count && constant; i++) {
+        constant = (residuals[i] == 0);
+    }
+
+    if (constant) {
+        return ConstantColumn;
+    }
+
+    qint64 costs[MaximumRiceParameter + 1];
+    for (int k = 0; k <= MaximumRiceParameter; k++) {
+        costs[k] = 0;
+    }
+    for (int i = 0; i < count; i++) {
+        for (int k = 0; k <= MaximumRiceParameter; k++) {
+            costs[k] += riceCost(residuals[i], k);
+        }
+    }
+
+    int parameter = 0;
+    for (int k = 1; k <= MaximumRiceParameter; k++) {
+        if (costs[k] < costs[parameter]) {
+            parameter = k;
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        writeRice(writer, residuals[i], parameter);
+    }
+
+    return static_cast<uchar>(parameter);
+}
+
+qint64 RiceCoder::readResidual(BitReader *reader, uchar parameter)
+{
+    if (parameter == ConstantColumn) {
+        return 0;
+    }
+
+    return unzigzag(readRice(reader, parameter));
+}
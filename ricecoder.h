@@ -0,0 +1,103 @@
+#ifndef RICECODER_H
+#define RICECODER_H
+
+#include <QtGlobal>
+
+//
+// Bit-level coding shared by the packed chunks of the sample, estimate and
+// derived channel stores. Residuals are zigzagged and Rice coded with one
+// parameter per column, chosen from the residuals themselves; a quotient
+// of EscapeLength or more is written as the raw 64-bit value instead.
+//
+class BitWriter
+{
+public:
+    explicit BitWriter(uchar *data) : m_data(data) {}
+
+    void write(quint64 value, int count)
+    {
+        m_accumulator |= (value & ((Q_UINT64_C(1) << count) - 1)) << m_bits;
+        m_bits += count;
+
+        while (m_bits >= 8) {
+            *m_data++ = static_cast<uchar>(m_accumulator);
+            m_accumulator >>= 8;
+            m_bits -= 8;
+        }
+    }
+
+    void writeOnes(int count)
+    {
+        while (count > 0) {
+            int bits = qMin(count, 32);
+            write(~Q_UINT64_C(0), bits);
+            count -= bits;
+        }
+    }
+
+    uchar *finish()
+    {
+        if (m_bits > 0) {
+            *m_data++ = static_cast<uchar>(m_accumulator);
+            m_accumulator = 0;
+            m_bits = 0;
+        }
+        return m_data;
+    }
+
+private:
+    uchar *m_data;
+    quint64 m_accumulator = 0;
+    int m_bits = 0;
+};
+
+class BitReader
+{
+public:
+    explicit BitReader(const uchar *data) : m_data(data) {}
+
+    quint64 read(int count)
+    {
+        while (m_bits < count) {
+            m_accumulator |= static_cast<quint64>(*m_data++) << m_bits;
+            m_bits += 8;
+        }
+
+        quint64 value = m_accumulator & ((Q_UINT64_C(1) << count) - 1);
+        m_accumulator >>= count;
+        m_bits -= count;
+        return value;
+    }
+
+private:
+    const uchar *m_data;
+    quint64 m_accumulator = 0;
+    int m_bits = 0;
+};
+
+class RiceCoder
+{
+public:
+    //
+    // Parameter recorded for a column whose residuals are all zero; nothing
+    // is written to the bit stream for it.
+    //
+    static const uchar ConstantColumn = 0xff;
+    static const int EscapeLength = 24;
+    static const int MaximumResidualBits = EscapeLength + 64;
+
+    static quint64 zigzag(qint64 value)
+    {
+        return (static_cast<quint64>(value) << 1) ^ static_cast<quint64>(value >> 63);
+    }
+
+    static qint64 unzigzag(quint64 value)
+    {
+        return static_cast<qint64>(value >> 1) ^ -static_cast<qint64>(value & 1);
+    }
+
+    static uchar writeColumn(BitWriter *writer, const quint64 *residuals, int count);
+    static qint64 readResidual(BitReader *reader, uchar parameter);
+};
+
+#endif // RICECODER_H
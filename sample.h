@@ -0,0 +1,55 @@
+#ifndef SAMPLE_H
+#define SAMPLE_H
+
+#include "statuspacket.h"
+
+#include <QtGlobal>
+#include <QMetaType>
+#include <QVector>
+
+//
+// One decoded status packet as retained in memory and in session
+// snapshots. Values are kept in the pack's raw integer units so the layout
+// is fixed-size and can be written and memory-mapped as-is; the accessors
+// convert to SI units.
+//
+struct Sample
+{
+    qint64 timestamp;               // wall clock, microseconds since epoch
+    qint16 current;                 // mA
+    quint16 temperature;            // m°C
+    quint16 chargeState;            // C
+    quint16 packVoltage;            // mV
+    quint16 cellVoltage[6];         // mV
+    quint8 mode;
+    quint8 reserved[3];
+
+    static Sample fromPacket(const status_packet_t &packet, qint64 timestamp);
+
+    qreal timeMSecs() const { return static_cast<qreal>(timestamp) / 1000.0; }
+    qreal volts() const { return static_cast<qreal>(packVoltage) / 1000.0; }
+    qreal amps() const { return qAbs(static_cast<qreal>(current) / 1000.0); }
+    qreal coulombs() const { return static_cast<qreal>(chargeState); }
+    qreal celsius() const { return static_cast<qreal>(temperature) / 1000.0; }
+    qreal cellVolts(int cell) const { return static_cast<qreal>(cellVoltage[cell]) / 1000.0; }
+};
+
+inline Sample Sample::fromPacket(const status_packet_t &packet, qint64 timestamp)
+{
+    Sample sample;
+    sample.timestamp = timestamp;
+    sample.current = packet.current;
+    sample.temperature = packet.temperature;
+    sample.chargeState = packet.charge_state;
+    sample.packVoltage = packet.pack_voltage;
+    for (int i = 0; i < 6; i++) {
+        sample.cellVoltage[i] = packet.cell_voltage[i];
+    }
+    sample.mode = packet.mode;
+    sample.reserved[0] = sample.reserved[1] = sample.reserved[2] = 0;
+    return sample;
+}
+
+Q_DECLARE_METATYPE(Sample)
+
+#endif // SAMPLE_H
@@ -0,0 +1,64 @@
+#include "sampleclock.h"
+
+#include <QDateTime>
+
+SampleClock::SampleClock()
+{
+    m_clock.start();
+    alignWallClock();
+}
+
+void SampleClock::alignWallClock()
+{
+    QDateTime wallClock = QDateTime::currentDateTime();
+
+    m_steadyOriginNSecs = now();
+    m_wallOriginMSecs = wallClock.toMSecsSinceEpoch();
+    m_localOffsetMSecs = static_cast<qint64>(wallClock.offsetFromUtc()) * 1000;
+}
+
+qreal SampleClock::toWallMSecs(qint64 timestamp) const
+{
+    return static_cast<qreal>(m_wallOriginMSecs)
+            + (static_cast<qreal>(timestamp - m_steadyOriginNSecs) / 1000000.0);
+}
+
+qint64 SampleClock::toWallUSecs(qint64 timestamp) const
+{
+    return (m_wallOriginMSecs * 1000) + ((timestamp - m_steadyOriginNSecs) / 1000);
+}
+
+int SampleClock::localMSecsSinceStartOfDay(qint64 wallUSecs) const
+{
+    qint64 local = (wallUSecs / 1000) + m_localOffsetMSecs;
+    qint64 msecs = local % 86400000;
+    if (msecs < 0) msecs += 86400000;
+    return static_cast<int>(msecs);
+}
+
+//
+// Difference between the system wall clock and the wall time predicted by
+// the stored mapping, in milliseconds. Non-zero values come from NTP slews
+// or manual clock changes since the last alignment.
+//
+qint64 SampleClock::wallClockDrift() const
+{
+    return QDateTime::currentMSecsSinceEpoch() - static_cast<qint64>(toWallMSecs(now()));
+}
+
+//
+// Feeds the frames completed by one read into the interval estimate.
+// Returns the number of frames that appear to have been dropped since the
+// previous read.
+//
+int SampleClock::recordFrames(qint64 timestamp, int frames)
+{
+    int dropped = m_intervalEstimator.record(timestamp, frames);
+    m_droppedSamples += static_cast<quint64>(dropped);
+    return dropped;
+}
+
+void SampleClock::resetIntervalEstimate()
+{
+    m_intervalEstimator.reset();
+}
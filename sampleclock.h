@@ -0,0 +1,44 @@
+#ifndef SAMPLECLOCK_H
+#define SAMPLECLOCK_H
+
+#include "intervalestimator.h"
+
+#include <QtGlobal>
+#include <QElapsedTimer>
+
+//
+// Monotonic sample clock. Frames are stamped with steady-clock nanoseconds
+// at the moment their bytes are read, and a single steady/wall pair is kept
+// so timestamps can be mapped to wall clock time for display and logging
+// without being affected by later NTP adjustments.
+//
+class SampleClock
+{
+public:
+    SampleClock();
+
+    qint64 now() const { return m_clock.nsecsElapsed(); }
+
+    void alignWallClock();
+    qint64 wallClockOrigin() const { return m_wallOriginMSecs; }
+    qint64 localTimeOffset() const { return m_localOffsetMSecs; }
+    qreal toWallMSecs(qint64 timestamp) const;
+    qint64 toWallUSecs(qint64 timestamp) const;
+    int localMSecsSinceStartOfDay(qint64 wallUSecs) const;
+    qint64 wallClockDrift() const;
+
+    int recordFrames(qint64 timestamp, int frames);
+    void resetIntervalEstimate();
+    qreal sampleInterval() const { return m_intervalEstimator.interval(); }
+    quint64 droppedSamples() const { return m_droppedSamples; }
+
+private:
+    QElapsedTimer m_clock;
+    qint64 m_steadyOriginNSecs = 0;
+    qint64 m_wallOriginMSecs = 0;
+    qint64 m_localOffsetMSecs = 0;
+    IntervalEstimator m_intervalEstimator;
+    quint64 m_droppedSamples = 0;
+};
+
+#endif // SAMPLECLOCK_H
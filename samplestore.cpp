@@ -0,0 +1,487 @@
+#include "samplestore.h"
+#include "ricecoder.h"
+
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <stddef.h>
+#include <string.h>
+
+//
+// Sealed chunks are packed column by column. The first sample is stored
+// verbatim, followed by one Rice parameter per field and a bit stream of
+// zigzagged residuals: delta-of-delta for the timestamp, plain deltas for
+// the integer readings. The parameter is chosen per chunk and field from
+// the residuals themselves, so a steady reading costs one bit per sample
+// and a field that never changes within the chunk costs nothing.
+//
+enum Field {
+    FieldTimestamp = 0,
+    FieldCurrent,
+    FieldTemperature,
+    FieldCharge,
+    FieldPackVoltage,
+    FieldCell,
+    FieldMode = FieldCell + 6,
+    FieldCount
+};
+
+static const int MaximumJob = 16;
+
+//
+// Worst case: every residual escaped
+//
+static const int MaximumPackedSize = sizeof(Sample) + FieldCount
+        + ((FieldCount * SampleStore::ChunkSize * RiceCoder::MaximumResidualBits) / 8) + 1;
+
+static qint64 fieldValue(const Sample &sample, int field)
+{
+    switch (field) {
+    case FieldTimestamp:
+        return sample.timestamp;
+    case FieldCurrent:
+        return sample.current;
+    case FieldTemperature:
+        return sample.temperature;
+    case FieldCharge:
+        return sample.chargeState;
+    case FieldPackVoltage:
+        return sample.packVoltage;
+    case FieldMode: {
+        //
+        // mode and the reserved bytes travel as one word so packing is
+        // lossless for anything read back from a snapshot
+        //
+        quint32 word;
+        memcpy(&word, &sample.mode, sizeof(word));
+        return word;
+    }
+    default:
+        return sample.cellVoltage[field - FieldCell];
+    }
+}
+
+static void setFieldValue(Sample *sample, int field, qint64 value)
+{
+    switch (field) {
+    case FieldTimestamp:
+        sample->timestamp = value;
+        break;
+    case FieldCurrent:
+        sample->current = static_cast<qint16>(value);
+        break;
+    case FieldTemperature:
+        sample->temperature = static_cast<quint16>(value);
+        break;
+    case FieldCharge:
+        sample->chargeState = static_cast<quint16>(value);
+        break;
+    case FieldPackVoltage:
+        sample->packVoltage = static_cast<quint16>(value);
+        break;
+    case FieldMode: {
+        quint32 word = static_cast<quint32>(value);
+        memcpy(&sample->mode, &word, sizeof(word));
+        break;
+    }
+    default:
+        sample->cellVoltage[field - FieldCell] = static_cast<quint16>(value);
+        break;
+    }
+}
+
+static int packSamples(const Sample *samples, uchar *data)
+{
+    memcpy(data, &samples[0], sizeof(Sample));
+    uchar *parameters = data + sizeof(Sample);
+    BitWriter writer(parameters + FieldCount);
+
+    quint64 residuals[SampleStore::ChunkSize - 1];
+
+    for (int field = 0; field < FieldCount; field++) {
+        qint64 previous = fieldValue(samples[0], field);
+        qint64 previousDelta = 0;
+
+        for (int i = 1; i < SampleStore::ChunkSize; i++) {
+            qint64 value = fieldValue(samples[i], field);
+            qint64 delta = value - previous;
+
+            residuals[i - 1] = RiceCoder::zigzag((field == FieldTimestamp) ? delta - previousDelta : delta);
+            previous = value;
+            previousDelta = delta;
+        }
+
+        parameters[field] = RiceCoder::writeColumn(&writer, residuals, SampleStore::ChunkSize - 1);
+    }
+
+    return static_cast<int>(writer.finish() - data);
+}
+
+SampleStore::SampleStore()
+{
+    m_slots.reserve(1024);
+    reserveSpare();
+
+    for (CacheEntry &entry : m_cache) {
+        entry.slot = -1;
+        entry.used = 0;
+        entry.chunk = nullptr;
+    }
+}
+
+SampleStore::~SampleStore()
+{
+    clear();
+    delete m_spare;
+
+    for (CacheEntry &entry : m_cache) {
+        delete entry.chunk;
+    }
+}
+
+const Sample &SampleStore::at(qint64 index) const
+{
+    if (index < m_mappedCount) {
+        return m_mapped[index];
+    }
+
+    index -= m_mappedCount;
+    int slot = static_cast<int>(index / ChunkSize);
+    const Chunk *chunk = m_slots[slot].chunk;
+
+    if (chunk == nullptr) {
+        chunk = unpacked(slot);
+    }
+
+    return chunk->samples[index % ChunkSize];
+}
+
+//
+// Index of the first sample at or after the timestamp. Chunks are located
+// from their first timestamps, so at most one packed chunk is unpacked.
+//
+qint64 SampleStore::lowerBound(qint64 timestamp) const
+{
+    qint64 low = 0;
+    qint64 high = m_mappedCount;
+
+    if (m_mappedCount > 0 && m_mapped[m_mappedCount - 1].timestamp >= timestamp) {
+        while (low < high) {
+            qint64 middle = low + ((high - low) / 2);
+            if (m_mapped[middle].timestamp < timestamp) {
+                low = middle + 1;
+            }
+            else {
+                high = middle;
+            }
+        }
+        return low;
+    }
+
+    int lowSlot = 0;
+    int highSlot = m_slots.count();
+
+    while (lowSlot < highSlot) {
+        int middle = lowSlot + ((highSlot - lowSlot) / 2);
+        if (slotTimestamp(middle) < timestamp) {
+            lowSlot = middle + 1;
+        }
+        else {
+            highSlot = middle;
+        }
+    }
+
+    if (lowSlot == 0) {
+        return m_mappedCount;
+    }
+
+    int slot = lowSlot - 1;
+    const Chunk *chunk = (m_slots[slot].chunk != nullptr) ? m_slots[slot].chunk : unpacked(slot);
+    qint64 base = static_cast<qint64>(slot) * ChunkSize;
+
+    low = 0;
+    high = qMin(m_count - base, static_cast<qint64>(ChunkSize));
+
+    while (low < high) {
+        qint64 middle = low + ((high - low) / 2);
+        if (chunk->samples[middle].timestamp < timestamp) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+
+    return m_mappedCount + base + low;
+}
+
+void SampleStore::append(const Sample &sample)
+{
+    int offset = static_cast<int>(m_count % ChunkSize);
+
+    if (offset == 0) {
+        Slot slot;
+        if (m_spare != nullptr) {
+            slot.chunk = m_spare;
+            m_spare = nullptr;
+        }
+        else {
+            slot.chunk = new Chunk;
+        }
+        m_slots.append(slot);
+    }
+
+    m_slots.last().chunk->samples[offset] = sample;
+    m_count++;
+}
+
+//
+// Called from timers outside the per-packet path so the next chunk is
+// ready before the current one fills up.
+//
+void SampleStore::reserveSpare()
+{
+    if (m_spare == nullptr) {
+        m_spare = new Chunk;
+    }
+
+    if (m_slots.count() == m_slots.capacity()) {
+        m_slots.reserve(m_slots.capacity() * 2);
+    }
+}
+
+void SampleStore::releaseSpare()
+{
+    delete m_spare;
+    m_spare = nullptr;
+}
+
+//
+// Frees the chunks unpacked for reading; the next read of packed data
+// unpacks it again.
+//
+void SampleStore::releaseCache()
+{
+    for (CacheEntry &entry : m_cache) {
+        delete entry.chunk;
+        entry.chunk = nullptr;
+        entry.slot = -1;
+        entry.used = 0;
+    }
+}
+
+//
+// Collects a finished packing job and starts the next one. Sealed chunks
+// are never written again, so the worker reads them without locking; the
+// raw chunk is only released here, once its packed copy is installed.
+//
+void SampleStore::compressSealed()
+{
+    if (m_jobCount > 0) {
+        if (!m_job.isFinished()) {
+            return;
+        }
+        installPacked();
+    }
+
+    int sealed = m_slots.count() - HotChunks;
+    if (sealed <= m_packedChunks) {
+        return;
+    }
+
+    int count = qMin(sealed - m_packedChunks, MaximumJob);
+    QVector<const Chunk *> chunks;
+    chunks.reserve(count);
+    for (int i = 0; i < count; i++) {
+        chunks.append(m_slots[m_packedChunks + i].chunk);
+    }
+
+    m_jobCount = count;
+    m_job = QtConcurrent::run(&SampleStore::packChunks, chunks);
+}
+
+void SampleStore::attach(const Sample *samples, qint64 count)
+{
+    m_mapped = samples;
+    m_mappedCount = count;
+}
+
+void SampleStore::clear()
+{
+    if (m_jobCount > 0) {
+        m_job.waitForFinished();
+        m_jobCount = 0;
+    }
+
+    for (Slot &slot : m_slots) {
+        if (slot.chunk != nullptr) {
+            recycle(slot.chunk);
+        }
+    }
+
+    for (CacheEntry &entry : m_cache) {
+        entry.slot = -1;
+    }
+
+    m_slots.clear();
+    m_slots.reserve(1024);
+    m_count = 0;
+    m_packedChunks = 0;
+    m_packedBytes = 0;
+    m_mapped = nullptr;
+    m_mappedCount = 0;
+}
+
+qreal SampleStore::compressionRatio() const
+{
+    if (m_packedBytes == 0) {
+        return 0.0;
+    }
+
+    return static_cast<qreal>(packedSamples() * static_cast<qint64>(sizeof(Sample)))
+            / static_cast<qreal>(m_packedBytes);
+}
+
+//
+// Memory held for the samples on the heap: raw and spare chunks, packed
+// chunks and the unpack cache. The attached prefix is backed by the
+// snapshot file and isn't counted.
+//
+qint64 SampleStore::heapBytes() const
+{
+    qint64 chunks = (m_spare != nullptr) ? 1 : 0;
+
+    for (const Slot &slot : m_slots) {
+        if (slot.chunk != nullptr) {
+            chunks++;
+        }
+    }
+
+    for (const CacheEntry &entry : m_cache) {
+        if (entry.chunk != nullptr) {
+            chunks++;
+        }
+    }
+
+    return chunks * static_cast<qint64>(sizeof(Chunk)) + m_packedBytes;
+}
+
+//
+// Runs on a pool thread.
+//
+QVector<QByteArray> SampleStore::packChunks(const QVector<const Chunk *> &chunks)
+{
+    QVector<QByteArray> packed;
+    packed.reserve(chunks.count());
+
+    QByteArray buffer(MaximumPackedSize, Qt::Uninitialized);
+    uchar *data = reinterpret_cast<uchar *>(buffer.data());
+
+    for (const Chunk *chunk : chunks) {
+        int size = packSamples(chunk->samples, data);
+        packed.append(QByteArray(buffer.constData(), size));
+    }
+
+    return packed;
+}
+
+void SampleStore::unpackChunk(const QByteArray &packed, Chunk *chunk)
+{
+    const uchar *data = reinterpret_cast<const uchar *>(packed.constData());
+    const uchar *parameters = data + sizeof(Sample);
+    BitReader reader(parameters + FieldCount);
+    Sample *samples = chunk->samples;
+
+    memcpy(&samples[0], data, sizeof(Sample));
+
+    for (int field = 0; field < FieldCount; field++) {
+        uchar parameter = parameters[field];
+        qint64 value = fieldValue(samples[0], field);
+        qint64 delta = 0;
+
+        for (int i = 1; i < ChunkSize; i++) {
+            qint64 residual = RiceCoder::readResidual(&reader, parameter);
+
+            if (field == FieldTimestamp) {
+                delta += residual;
+                value += delta;
+            }
+            else {
+                value += residual;
+            }
+
+            setFieldValue(&samples[i], field, value);
+        }
+    }
+}
+
+//
+// Returns the unpacked copy of a packed chunk, unpacking it into the
+// least recently used cache entry if it isn't already cached.
+//
+const SampleStore::Chunk *SampleStore::unpacked(int slot) const
+{
+    CacheEntry *victim = &m_cache[0];
+
+    for (CacheEntry &entry : m_cache) {
+        if (entry.slot == slot) {
+            entry.used = ++m_cacheClock;
+            return entry.chunk;
+        }
+        if (entry.used < victim->used) {
+            victim = &entry;
+        }
+    }
+
+    if (victim->chunk == nullptr) {
+        victim->chunk = new Chunk;
+    }
+
+    unpackChunk(m_slots[slot].packed, victim->chunk);
+    victim->slot = slot;
+    victim->used = ++m_cacheClock;
+    m_cacheMisses++;
+    return victim->chunk;
+}
+
+qint64 SampleStore::slotTimestamp(int slot) const
+{
+    const Slot &entry = m_slots[slot];
+
+    if (entry.chunk != nullptr) {
+        return entry.chunk->samples[0].timestamp;
+    }
+
+    //
+    // a packed chunk starts with its first sample verbatim
+    //
+    qint64 timestamp;
+    memcpy(&timestamp, entry.packed.constData() + offsetof(Sample, timestamp), sizeof(timestamp));
+    return timestamp;
+}
+
+void SampleStore::installPacked()
+{
+    QVector<QByteArray> packed = m_job.result();
+
+    for (int i = 0; i < m_jobCount; i++) {
+        Slot &slot = m_slots[m_packedChunks];
+        slot.packed = packed[i];
+        recycle(slot.chunk);
+        slot.chunk = nullptr;
+
+        m_packedBytes += slot.packed.size();
+        m_packedChunks++;
+    }
+
+    m_jobCount = 0;
+}
+
+void SampleStore::recycle(Chunk *chunk)
+{
+    if (m_spare == nullptr) {
+        m_spare = chunk;
+    }
+    else {
+        delete chunk;
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef SAMPLESTORE_H
+#define SAMPLESTORE_H
+
+#include "sample.h"
+
+#include <QByteArray>
+#include <QFuture>
+#include <QVector>
+
+//
+// In-memory history of the session. Samples are appended into fixed-size
+// chunks; a spare chunk is reserved ahead of time from reserveSpare() so
+// append() itself never allocates. A read-only run of samples (normally a
+// memory-mapped session snapshot) can be attached in front of the chunks.
+//
+// Chunks more than HotChunks behind the newest one are sealed and packed
+// on a worker thread by compressSealed(); the packed form replaces the raw
+// chunk. Reading a packed chunk unpacks it into a small LRU cache, so a
+// reference returned by at() for old data only stays valid until a few
+// other packed chunks have been read.
+//
+class SampleStore
+{
+public:
+    static const int ChunkSize = 4096;
+    static const int HotChunks = 4;
+    static const int CacheSize = 4;
+
+    SampleStore();
+    ~SampleStore();
+
+    qint64 count() const { return m_mappedCount + m_count; }
+    bool isEmpty() const { return count() == 0; }
+    const Sample &at(qint64 index) const;
+    const Sample &last() const { return at(count() - 1); }
+    qint64 lowerBound(qint64 timestamp) const;
+
+    void append(const Sample &sample);
+    void reserveSpare();
+    void releaseSpare();
+    void releaseCache();
+    void compressSealed();
+    void attach(const Sample *samples, qint64 count);
+    void clear();
+
+    qint64 packedSamples() const { return static_cast<qint64>(m_packedChunks) * ChunkSize; }
+    qint64 packedBytes() const { return m_packedBytes; }
+    qreal compressionRatio() const;
+    quint64 cacheMisses() const { return m_cacheMisses; }
+    qint64 heapBytes() const;
+
+private:
+    Q_DISABLE_COPY(SampleStore)
+
+    struct Chunk {
+        Sample samples[ChunkSize];
+    };
+
+    struct Slot {
+        Chunk *chunk;
+        QByteArray packed;
+    };
+
+    struct CacheEntry {
+        int slot;
+        quint64 used;
+        Chunk *chunk;
+    };
+
+    static QVector<QByteArray> packChunks(const QVector<const Chunk *> &chunks);
+    static void unpackChunk(const QByteArray &packed, Chunk *chunk);
+
+    const Chunk *unpacked(int slot) const;
+    qint64 slotTimestamp(int slot) const;
+    void installPacked();
+    void recycle(Chunk *chunk);
+
+    const Sample *m_mapped = nullptr;
+    qint64 m_mappedCount = 0;
+    QVector<Slot> m_slots;
+    Chunk *m_spare = nullptr;
+    qint64 m_count = 0;
+
+    QFuture<QVector<QByteArray>> m_job;
+    int m_jobCount = 0;
+    int m_packedChunks = 0;
+    qint64 m_packedBytes = 0;
+
+    mutable CacheEntry m_cache[CacheSize];
+    mutable quint64 m_cacheClock = 0;
+    mutable quint64 m_cacheMisses = 0;
+};
+
+#endif // SAMPLESTORE_H
@@ -0,0 +1,351 @@
+#include "scrollingplotwidget.h"
+
+#include <QPainter>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <QVarLengthArray>
+#include <QtMath>
+
+#include <limits.h>
+
+ScrollingPlotWidget::ScrollingPlotWidget(QWidget *parent) :
+    QWidget(parent)
+{
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setMinimumSize(200, 100);
+}
+
+void ScrollingPlotWidget::setSampleStore(const SampleStore *store)
+{
+    m_store = store;
+    reset();
+}
+
+void ScrollingPlotWidget::setEstimateStore(const EstimateStore *store)
+{
+    m_estimates = store;
+    redraw();
+}
+
+void ScrollingPlotWidget::setDerivedChannels(const DerivedChannels *channels)
+{
+    m_derived = channels;
+    redraw();
+}
+
+void ScrollingPlotWidget::setTimeSpan(qint64 milliseconds)
+{
+    m_timeSpan = milliseconds;
+    redraw();
+}
+
+void ScrollingPlotWidget::setChannelColor(Channel channel, const QColor &color)
+{
+    m_channels[channel].color = color;
+    redraw();
+}
+
+void ScrollingPlotWidget::setChannelVisible(Channel channel, bool visible)
+{
+    m_channels[channel].visible = visible;
+    redraw();
+}
+
+void ScrollingPlotWidget::setChannelRange(Channel channel, qreal min, qreal max)
+{
+    if (m_channels[channel].min == min && m_channels[channel].max == max) {
+        return;
+    }
+
+    m_channels[channel].min = min;
+    m_channels[channel].max = max;
+    redraw();
+}
+
+void ScrollingPlotWidget::setChannelTransform(Channel channel, qreal scale, qreal offset)
+{
+    m_channels[channel].scale = scale;
+    m_channels[channel].offset = offset;
+    redraw();
+}
+
+void ScrollingPlotWidget::setChannelLeftAligned(Channel channel, bool left)
+{
+    m_channels[channel].leftAligned = left;
+    update();
+}
+
+//
+// Draws whatever arrived since the last call. Only the new segments are
+// painted; if the window has to advance, the existing pixmap is scrolled
+// rather than redrawn.
+//
+void ScrollingPlotWidget::refresh()
+{
+    if (m_store == nullptr || m_pixmap.isNull()) {
+        return;
+    }
+
+    qint64 count = m_store->count();
+
+    if (count < m_drawnCount) {
+        reset();
+        return;
+    }
+
+    if (count == m_drawnCount) {
+        return;
+    }
+
+    qreal latest = m_store->last().timeMSecs();
+
+    if (m_drawnCount == 0 && m_timeEnd == 0.0) {
+        m_timeEnd = m_store->at(0).timeMSecs() + m_timeSpan;
+        if (latest > m_timeEnd) {
+            m_timeEnd = latest;
+        }
+        redraw();
+        return;
+    }
+
+    if (latest > m_timeEnd) {
+        qreal pixelsPerMSec = static_cast<qreal>(m_pixmap.width()) / static_cast<qreal>(m_timeSpan);
+        int dx = qCeil((latest - m_timeEnd) * pixelsPerMSec);
+
+        if (dx >= m_pixmap.width()) {
+            m_timeEnd = latest;
+            redraw();
+            return;
+        }
+
+        m_pixmap.scroll(-dx, 0, m_pixmap.rect());
+        m_timeEnd += static_cast<qreal>(dx) / pixelsPerMSec;
+
+        QPainter painter(&m_pixmap);
+        painter.fillRect(m_pixmap.width() - dx, 0, dx, m_pixmap.height(), palette().color(QPalette::Base));
+    }
+
+    drawSegments(qMax(m_drawnCount - 1, static_cast<qint64>(0)), count);
+    m_drawnCount = count;
+    update();
+}
+
+//
+// Full redraw of the visible window from the sample store.
+//
+void ScrollingPlotWidget::redraw()
+{
+    if (size().isEmpty()) {
+        return;
+    }
+
+    m_pixmap = QPixmap(size());
+    m_pixmap.fill(palette().color(QPalette::Base));
+    m_fullRedraws++;
+
+    if (m_store != nullptr && !m_store->isEmpty()) {
+        qint64 count = m_store->count();
+
+        if (m_timeEnd == 0.0) {
+            m_timeEnd = m_store->at(0).timeMSecs() + m_timeSpan;
+            if (m_store->last().timeMSecs() > m_timeEnd) {
+                m_timeEnd = m_store->last().timeMSecs();
+            }
+        }
+
+        qint64 first = findFirstSample(static_cast<qint64>(m_timeEnd) - m_timeSpan);
+        drawSegments(qMax(first - 1, static_cast<qint64>(0)), count);
+        m_drawnCount = count;
+    }
+    else {
+        m_drawnCount = 0;
+    }
+
+    update();
+}
+
+void ScrollingPlotWidget::reset()
+{
+    m_timeEnd = 0.0;
+    m_drawnCount = 0;
+    redraw();
+}
+
+//
+// Start of the visible time window, in wall clock microseconds.
+//
+qint64 ScrollingPlotWidget::visibleStart() const
+{
+    return static_cast<qint64>((m_timeEnd - static_cast<qreal>(m_timeSpan)) * 1000.0);
+}
+
+void ScrollingPlotWidget::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(this);
+    painter.drawPixmap(event->rect(), m_pixmap, event->rect());
+
+    //
+    // channel ranges are drawn over the pixmap so they never scroll
+    //
+    int leftRow = 0;
+    int rightRow = 0;
+    int lineHeight = fontMetrics().height();
+
+    for (int i = 0; i < ChannelCount; i++) {
+        const ChannelState &channel = m_channels[i];
+        if (!isDrawn(i)) {
+            continue;
+        }
+
+        int row = channel.leftAligned ? leftRow++ : rightRow++;
+        int flags = channel.leftAligned ? Qt::AlignLeft : Qt::AlignRight;
+        QRect top(4, row * lineHeight, width() - 8, lineHeight);
+        QRect bottom(4, height() - ((row + 1) * lineHeight), width() - 8, lineHeight);
+
+        painter.setPen(channel.color);
+        painter.drawText(top, flags, QString::number(channel.max, 'g', 4));
+        painter.drawText(bottom, flags, QString::number(channel.min, 'g', 4));
+    }
+
+    m_framesRendered++;
+}
+
+void ScrollingPlotWidget::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    redraw();
+}
+
+bool ScrollingPlotWidget::isDrawn(int channel) const
+{
+    if (!m_channels[channel].visible) {
+        return false;
+    }
+
+    return channel < ChannelDerived || (m_derived != nullptr && channel - ChannelDerived < m_derived->channelCount());
+}
+
+qreal ScrollingPlotWidget::channelValue(Channel channel, qint64 index) const
+{
+    const Sample &sample = m_store->at(index);
+    qreal value = 0.0;
+
+    switch (channel) {
+    case ChannelPackVoltage:
+        value = sample.volts();
+        break;
+    case ChannelCurrent:
+        value = sample.amps();
+        break;
+    case ChannelCharge:
+        value = sample.coulombs();
+        break;
+    case ChannelTemperature:
+        value = sample.celsius();
+        break;
+    case ChannelStateOfCharge:
+        value = m_estimates->at(index).stateOfCharge;
+        break;
+    case ChannelResistance:
+        value = m_estimates->at(index).resistance;
+        break;
+    default:
+        value = m_derived->value(channel - ChannelDerived, index);
+        break;
+    }
+
+    return (value * m_channels[channel].scale) + m_channels[channel].offset;
+}
+
+qreal ScrollingPlotWidget::mapX(qint64 timestamp) const
+{
+    qreal start = m_timeEnd - static_cast<qreal>(m_timeSpan);
+    return ((static_cast<qreal>(timestamp) / 1000.0) - start) * static_cast<qreal>(m_pixmap.width()) / static_cast<qreal>(m_timeSpan);
+}
+
+qreal ScrollingPlotWidget::mapY(Channel channel, qreal value) const
+{
+    const ChannelState &state = m_channels[channel];
+    qreal span = state.max - state.min;
+    if (span <= 0.0) span = 1.0;
+    return static_cast<qreal>(m_pixmap.height() - 1) * (1.0 - ((value - state.min) / span));
+}
+
+qint64 ScrollingPlotWidget::findFirstSample(qint64 timestamp) const
+{
+    return m_store->lowerBound(timestamp * 1000);
+}
+
+//
+// Draws samples [from, to) as polylines. When several samples land in the
+// same pixel column only their first, min, max and last values are kept,
+// so a full redraw costs O(samples) but paints O(width) points.
+//
+void ScrollingPlotWidget::drawSegments(qint64 from, qint64 to)
+{
+    if (to - from < 1) {
+        return;
+    }
+
+    QPainter painter(&m_pixmap);
+
+    for (int c = 0; c < ChannelCount; c++) {
+        Channel channel = static_cast<Channel>(c);
+        if (!isDrawn(c)) {
+            continue;
+        }
+
+        //
+        // estimates and derived values are index-aligned with the samples
+        // but may not cover a store that is still being recomputed
+        //
+        if ((channel == ChannelStateOfCharge || channel == ChannelResistance)
+                && (m_estimates == nullptr || m_estimates->count() < to)) {
+            continue;
+        }
+
+        if (channel >= ChannelDerived && m_derived->count() < to) {
+            continue;
+        }
+
+        QVarLengthArray<QPointF, 1024> points;
+        int column = INT_MIN;
+        qreal first = 0.0, min = 0.0, max = 0.0, last = 0.0;
+
+        for (qint64 i = from; i < to; i++) {
+            const Sample &sample = m_store->at(i);
+            qreal x = mapX(sample.timestamp);
+            qreal y = mapY(channel, channelValue(channel, i));
+            int sampleColumn = static_cast<int>(x);
+
+            if (sampleColumn != column) {
+                if (column != INT_MIN) {
+                    points.append(QPointF(column, first));
+                    if (min != first) points.append(QPointF(column, min));
+                    if (max != min) points.append(QPointF(column, max));
+                    if (last != max) points.append(QPointF(column, last));
+                }
+                column = sampleColumn;
+                first = min = max = last = y;
+            }
+            else {
+                if (y < min) min = y;
+                if (y > max) max = y;
+                last = y;
+            }
+        }
+
+        points.append(QPointF(column, first));
+        if (min != first) points.append(QPointF(column, min));
+        if (max != min) points.append(QPointF(column, max));
+        if (last != max) points.append(QPointF(column, last));
+
+        painter.setPen(QPen(m_channels[c].color, 1));
+        if (points.count() == 1) {
+            painter.drawPoint(points[0]);
+        }
+        else {
+            painter.drawPolyline(points.constData(), points.count());
+        }
+    }
+}
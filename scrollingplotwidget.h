@@ -0,0 +1,91 @@
+#ifndef SCROLLINGPLOTWIDGET_H
+#define SCROLLINGPLOTWIDGET_H
+
+#include "samplestore.h"
+#include "estimatestore.h"
+#include "derivedchannels.h"
+
+#include <QWidget>
+#include <QPixmap>
+#include <QColor>
+
+//
+// CPU plot backend for machines without a usable OpenGL driver. The plot is
+// kept in a pixmap: new samples are drawn as short segments on the right,
+// the pixmap is blit-scrolled as the time window advances, and the whole
+// window is only redrawn from the sample store on resize or range changes.
+// Derived channels follow the fixed ones, one per channel defined in the
+// DerivedChannels set; the rest are never drawn.
+//
+class ScrollingPlotWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    enum Channel {
+        ChannelPackVoltage = 0,
+        ChannelCurrent,
+        ChannelCharge,
+        ChannelTemperature,
+        ChannelStateOfCharge,
+        ChannelResistance,
+        ChannelDerived,
+        ChannelCount = ChannelDerived + DerivedChannels::MaximumChannels
+    };
+
+    explicit ScrollingPlotWidget(QWidget *parent = nullptr);
+
+    void setSampleStore(const SampleStore *store);
+    void setEstimateStore(const EstimateStore *store);
+    void setDerivedChannels(const DerivedChannels *channels);
+    void setTimeSpan(qint64 milliseconds);
+    void setChannelColor(Channel channel, const QColor &color);
+    void setChannelVisible(Channel channel, bool visible);
+    void setChannelRange(Channel channel, qreal min, qreal max);
+    void setChannelTransform(Channel channel, qreal scale, qreal offset);
+    void setChannelLeftAligned(Channel channel, bool left);
+
+    void refresh();
+    void redraw();
+    void reset();
+
+    qint64 visibleStart() const;
+
+    quint64 framesRendered() const { return m_framesRendered; }
+    quint64 fullRedraws() const { return m_fullRedraws; }
+
+protected:
+    void paintEvent(QPaintEvent *event);
+    void resizeEvent(QResizeEvent *event);
+
+private:
+    struct ChannelState {
+        QColor color;
+        bool visible = true;
+        bool leftAligned = true;
+        qreal min = 0.0;
+        qreal max = 1.0;
+        qreal scale = 1.0;
+        qreal offset = 0.0;
+    };
+
+    bool isDrawn(int channel) const;
+    qreal channelValue(Channel channel, qint64 index) const;
+    qreal mapX(qint64 timestamp) const;
+    qreal mapY(Channel channel, qreal value) const;
+    qint64 findFirstSample(qint64 timestamp) const;
+    void drawSegments(qint64 from, qint64 to);
+
+    const SampleStore *m_store = nullptr;
+    const EstimateStore *m_estimates = nullptr;
+    const DerivedChannels *m_derived = nullptr;
+    ChannelState m_channels[ChannelCount];
+    QPixmap m_pixmap;
+    qint64 m_timeSpan = 300000;
+    qreal m_timeEnd = 0.0;
+    qint64 m_drawnCount = 0;
+    quint64 m_framesRendered = 0;
+    quint64 m_fullRedraws = 0;
+};
+
+#endif // SCROLLINGPLOTWIDGET_H
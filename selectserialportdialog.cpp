@@ -7,10 +7,11 @@
 QSerialPortInfo SelectSerialPortDialog::getSerialPortInfo(QWidget *parent)
 {
     SelectSerialPortDialog dlg(parent);
+    dlg.setAvailablePorts(QSerialPortInfo::availablePorts());
     int result = dlg.exec();
 
     if (result == SelectSerialPortDialog::Accepted) {
-        return dlg.m_serialPortList[dlg.ui->cboSerialPort->currentIndex()];
+        return dlg.selectedPort();
     }
     else {
         return QSerialPortInfo();
@@ -22,15 +23,41 @@ SelectSerialPortDialog::SelectSerialPortDialog(QWidget *parent) :
     ui(new Ui::SelectSerialPortDialog)
 {
     ui->setupUi(this);
+}
+
+SelectSerialPortDialog::~SelectSerialPortDialog()
+{
+    delete ui;
+}
 
-    m_serialPortList = QSerialPortInfo::availablePorts();
+QSerialPortInfo SelectSerialPortDialog::selectedPort() const
+{
+    int index = ui->cboSerialPort->currentIndex();
 
-    for (QSerialPortInfo port : m_serialPortList) {
-        ui->cboSerialPort->addItem(port.portName());
+    if (index < 0 || index >= m_serialPortList.count()) {
+        return QSerialPortInfo();
     }
+
+    return m_serialPortList[index];
 }
 
-SelectSerialPortDialog::~SelectSerialPortDialog()
+//
+// The port list is supplied by the caller (normally the port manager's
+// background watcher) and refreshed while the dialog is open.
+//
+void SelectSerialPortDialog::setAvailablePorts(const QList<QSerialPortInfo> &ports)
 {
-    delete ui;
+    QString currentPortName = ui->cboSerialPort->currentText();
+
+    m_serialPortList = ports;
+
+    ui->cboSerialPort->clear();
+    for (QSerialPortInfo port : m_serialPortList) {
+        ui->cboSerialPort->addItem(port.portName());
+    }
+
+    int index = ui->cboSerialPort->findText(currentPortName);
+    if (index >= 0) {
+        ui->cboSerialPort->setCurrentIndex(index);
+    }
 }
@@ -18,6 +18,10 @@ public:
     static QSerialPortInfo getSerialPortInfo(QWidget *parent = nullptr);
     explicit SelectSerialPortDialog(QWidget *parent = nullptr);
     ~SelectSerialPortDialog();
+    QSerialPortInfo selectedPort() const;
+
+public slots:
+    void setAvailablePorts(const QList<QSerialPortInfo> &ports);
 
 private:
     Ui::SelectSerialPortDialog *ui;
@@ -0,0 +1,198 @@
+#include "sessionsnapshot.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QStandardPaths>
+
+#include <string.h>
+
+static const char SnapshotMagic[8] = { 'P', 'B', 'M', 'S', 'N', 'A', 'P', 0 };
+static const quint32 SnapshotVersion = 1;
+
+SessionSnapshot::SessionSnapshot()
+{
+    memset(&m_header, 0, sizeof(m_header));
+}
+
+SessionSnapshot::~SessionSnapshot()
+{
+    close();
+}
+
+QString SessionSnapshot::defaultPath()
+{
+    QString directory = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(directory);
+    return directory + "/session.pbms";
+}
+
+void SessionSnapshot::initHeader(SnapshotHeader &header, qint64 sessionStart)
+{
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SnapshotMagic, sizeof(header.magic));
+    header.version = SnapshotVersion;
+    header.sampleSize = sizeof(Sample);
+    header.sessionStart = sessionStart;
+    header.axisMin = sessionStart / 1000;
+    header.axisMax = header.axisMin + 300000;
+}
+
+//
+// Maps the snapshot read-only. Only the header is validated; the sample
+// records are used in place.
+//
+bool SessionSnapshot::open(const QString &fileName)
+{
+    close();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    qint64 size = m_file.size();
+    if (size < static_cast<qint64>(sizeof(SnapshotHeader))) {
+        m_file.close();
+        return false;
+    }
+
+    m_map = m_file.map(0, size);
+    if (m_map == nullptr) {
+        m_file.close();
+        return false;
+    }
+
+    memcpy(&m_header, m_map, sizeof(m_header));
+
+    if (memcmp(m_header.magic, SnapshotMagic, sizeof(SnapshotMagic)) != 0
+            || m_header.version != SnapshotVersion
+            || m_header.sampleSize != sizeof(Sample)) {
+        close();
+        return false;
+    }
+
+    //
+    // a crash between appending samples and updating the header leaves
+    // the count short, never long; trust whichever is smaller
+    //
+    qint64 available = (size - static_cast<qint64>(sizeof(SnapshotHeader))) / static_cast<qint64>(sizeof(Sample));
+    m_count = qMin(static_cast<qint64>(m_header.sampleCount), available);
+    m_samples = reinterpret_cast<const Sample *>(m_map + sizeof(SnapshotHeader));
+
+    return true;
+}
+
+void SessionSnapshot::close()
+{
+    if (m_map != nullptr) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+
+    m_samples = nullptr;
+    m_count = 0;
+}
+
+SnapshotWriter::SnapshotWriter(const QString &fileName, QObject *parent) :
+    QObject(parent),
+    m_fileName(fileName)
+{
+    memset(&m_header, 0, sizeof(m_header));
+}
+
+//
+// Continues an existing snapshot. The main window keeps the file mapped
+// for the restored samples, and a mapped file cannot be shrunk on
+// Windows, so a partially written record left behind by a crash is not
+// truncated away: append() seeks to the end of the last whole record and
+// the next batch overwrites it, and open() ignores it until then.
+//
+void SnapshotWriter::resume()
+{
+    m_file.setFileName(m_fileName);
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        qDebug() << "Unable to open session snapshot" << m_fileName << m_file.errorString();
+        return;
+    }
+
+    if (m_file.read(reinterpret_cast<char *>(&m_header), sizeof(m_header)) != sizeof(m_header)
+            || memcmp(m_header.magic, SnapshotMagic, sizeof(SnapshotMagic)) != 0) {
+        m_file.close();
+        return;
+    }
+
+    qint64 available = (m_file.size() - static_cast<qint64>(sizeof(SnapshotHeader))) / static_cast<qint64>(sizeof(Sample));
+    m_header.sampleCount = static_cast<quint64>(qMin(static_cast<qint64>(m_header.sampleCount), available));
+}
+
+void SnapshotWriter::reset(qint64 sessionStart)
+{
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+
+    m_file.setFileName(m_fileName);
+    if (!m_file.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        qDebug() << "Unable to create session snapshot" << m_fileName << m_file.errorString();
+        return;
+    }
+
+    SessionSnapshot::initHeader(m_header, sessionStart);
+    writeHeader();
+}
+
+void SnapshotWriter::append(const QVector<Sample> &samples, qint64 axisMin, qint64 axisMax)
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    qint64 length = static_cast<qint64>(samples.count()) * static_cast<qint64>(sizeof(Sample));
+
+    m_file.seek(static_cast<qint64>(sizeof(SnapshotHeader)) + static_cast<qint64>(m_header.sampleCount) * static_cast<qint64>(sizeof(Sample)));
+    if (m_file.write(reinterpret_cast<const char *>(samples.constData()), length) != length) {
+        qDebug() << "Session snapshot write failed" << m_file.errorString();
+        return;
+    }
+
+    //
+    // samples first, then the header, so a crash never leaves the header
+    // pointing at records that were not written
+    //
+    m_file.flush();
+
+    m_header.sampleCount += static_cast<quint64>(samples.count());
+    m_header.axisMin = axisMin;
+    m_header.axisMax = axisMax;
+    writeHeader();
+}
+
+//
+// Called with a blocking connection by readers of the file, so everything
+// queued before it has been written once it returns.
+//
+void SnapshotWriter::flush()
+{
+    if (m_file.isOpen()) {
+        m_file.flush();
+    }
+}
+
+void SnapshotWriter::finish()
+{
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+}
+
+bool SnapshotWriter::writeHeader()
+{
+    m_file.seek(0);
+    bool result = m_file.write(reinterpret_cast<const char *>(&m_header), sizeof(m_header)) == sizeof(m_header);
+    m_file.flush();
+    return result;
+}
@@ -0,0 +1,78 @@
+#ifndef SESSIONSNAPSHOT_H
+#define SESSIONSNAPSHOT_H
+
+#include "sample.h"
+
+#include <QObject>
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+//
+// Session snapshot file layout: a fixed header followed by raw Sample
+// records. The file is appended to by SnapshotWriter on a worker thread and
+// restored by memory-mapping it, so reopening a session does not depend on
+// its length.
+//
+struct SnapshotHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 sampleSize;
+    qint64 sessionStart;            // wall clock, microseconds since epoch
+    qint64 axisMin;                 // time axis range, milliseconds since epoch
+    qint64 axisMax;
+    quint64 sampleCount;
+    quint8 reserved[16];
+};
+
+class SessionSnapshot
+{
+public:
+    SessionSnapshot();
+    ~SessionSnapshot();
+
+    static QString defaultPath();
+    static void initHeader(SnapshotHeader &header, qint64 sessionStart);
+
+    bool open(const QString &fileName);
+    void close();
+
+    bool isOpen() const { return m_samples != nullptr; }
+    const SnapshotHeader &header() const { return m_header; }
+    const Sample *samples() const { return m_samples; }
+    qint64 count() const { return m_count; }
+
+private:
+    Q_DISABLE_COPY(SessionSnapshot)
+
+    QFile m_file;
+    uchar *m_map = nullptr;
+    SnapshotHeader m_header;
+    const Sample *m_samples = nullptr;
+    qint64 m_count = 0;
+};
+
+class SnapshotWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SnapshotWriter(const QString &fileName, QObject *parent = nullptr);
+
+public slots:
+    void resume();
+    void reset(qint64 sessionStart);
+    void append(const QVector<Sample> &samples, qint64 axisMin, qint64 axisMax);
+    void flush();
+    void finish();
+
+private:
+    bool writeHeader();
+
+    QString m_fileName;
+    QFile m_file;
+    SnapshotHeader m_header;
+};
+
+#endif // SESSIONSNAPSHOT_H
@@ -13,8 +13,8 @@ SettingsDialog::SettingsDialog(QWidget *parent) :
     QSettings settings;
 
     QString autoOpenPortName = settings.value("port/autoOpenPortName").toString();
-    QList<QSerialPortInfo> portList = QSerialPortInfo::availablePorts();
-    for (QSerialPortInfo portInfo : portList) {
+    m_portList = QSerialPortInfo::availablePorts();
+    for (QSerialPortInfo portInfo : m_portList) {
         ui->cboAutoOpenPortName->addItem(portInfo.portName());
     }
 
@@ -31,6 +31,20 @@ SettingsDialog::SettingsDialog(QWidget *parent) :
 
     if (unit_charge == "coulomb") ui->cboUnitCharge->setCurrentIndex(0);
     else if (unit_charge == "amphour") ui->cboUnitCharge->setCurrentIndex(1);
+
+    QString plotBackend = settings.value("chart/backend", "qtcharts").toString();
+
+    if (plotBackend == "qtcharts") ui->cboPlotBackend->setCurrentIndex(0);
+    else if (plotBackend == "software") ui->cboPlotBackend->setCurrentIndex(1);
+
+    int fastBaudRate = settings.value("port/fastBaudRate", 0).toInt();
+    if (fastBaudRate > 0) ui->cboFastBaudRate->setCurrentText(QString::number(fastBaudRate));
+
+    ui->chkAdaptiveTelemetry->setChecked(settings.value("telemetry/adaptiveRate", false).toBool());
+    ui->spnTelemetryFastInterval->setValue(settings.value("telemetry/fastInterval", 100).toInt());
+    ui->spnTelemetryIdleInterval->setValue(settings.value("telemetry/idleInterval", 1000).toInt());
+    ui->spnTelemetryHoldTime->setValue(settings.value("telemetry/holdTime", 60).toInt());
+    ui->spnCaptureSizeLimit->setValue(settings.value("capture/sizeLimit", 64).toInt());
 }
 
 SettingsDialog::~SettingsDialog()
@@ -42,6 +56,29 @@ void SettingsDialog::on_cboAutoOpenPortName_currentIndexChanged(const QString &c
 {
     QSettings settings;
     settings.setValue("port/autoOpenPortName", currentText);
+
+    //
+    // remember the adapter's identity too, so it is found again if it
+    // re-enumerates under a different port name
+    //
+    QString serialNumber;
+    quint16 vendorId = 0;
+    quint16 productId = 0;
+
+    for (const QSerialPortInfo &portInfo : m_portList) {
+        if (portInfo.portName() == currentText) {
+            serialNumber = portInfo.serialNumber();
+            if (portInfo.hasVendorIdentifier() && portInfo.hasProductIdentifier()) {
+                vendorId = portInfo.vendorIdentifier();
+                productId = portInfo.productIdentifier();
+            }
+            break;
+        }
+    }
+
+    settings.setValue("port/autoOpenSerialNumber", serialNumber);
+    settings.setValue("port/autoOpenVendorId", vendorId);
+    settings.setValue("port/autoOpenProductId", productId);
 }
 
 void SettingsDialog::on_chkAutoOpenPortEnabled_stateChanged(int checked)
@@ -65,3 +102,49 @@ void SettingsDialog::on_cboUnitCharge_currentIndexChanged(int index)
     if (index == 0) settings.setValue("units/charge", "coulomb");
     else if (index == 1) settings.setValue("units/charge", "amphour");
 }
+
+void SettingsDialog::on_cboPlotBackend_currentIndexChanged(int index)
+{
+    QSettings settings;
+
+    if (index == 0) settings.setValue("chart/backend", "qtcharts");
+    else if (index == 1) settings.setValue("chart/backend", "software");
+}
+
+void SettingsDialog::on_cboFastBaudRate_currentIndexChanged(int index)
+{
+    QSettings settings;
+
+    if (index == 0) settings.setValue("port/fastBaudRate", 0);
+    else settings.setValue("port/fastBaudRate", ui->cboFastBaudRate->itemText(index).toInt());
+}
+
+void SettingsDialog::on_chkAdaptiveTelemetry_stateChanged(int checked)
+{
+    QSettings settings;
+    settings.setValue("telemetry/adaptiveRate", checked != Qt::Unchecked);
+}
+
+void SettingsDialog::on_spnTelemetryFastInterval_valueChanged(int value)
+{
+    QSettings settings;
+    settings.setValue("telemetry/fastInterval", value);
+}
+
+void SettingsDialog::on_spnTelemetryIdleInterval_valueChanged(int value)
+{
+    QSettings settings;
+    settings.setValue("telemetry/idleInterval", value);
+}
+
+void SettingsDialog::on_spnTelemetryHoldTime_valueChanged(int value)
+{
+    QSettings settings;
+    settings.setValue("telemetry/holdTime", value);
+}
+
+void SettingsDialog::on_spnCaptureSizeLimit_valueChanged(int value)
+{
+    QSettings settings;
+    settings.setValue("capture/sizeLimit", value);
+}
@@ -2,6 +2,8 @@
 #define SETTINGSDIALOG_H
 
 #include <QDialog>
+#include <QList>
+#include <QSerialPortInfo>
 
 namespace Ui {
 class SettingsDialog;
@@ -23,8 +25,18 @@ private slots:
 
     void on_cboUnitCharge_currentIndexChanged(int index);
 
+    void on_cboPlotBackend_currentIndexChanged(int index);
+
+    void on_cboFastBaudRate_currentIndexChanged(int index);
+    void on_chkAdaptiveTelemetry_stateChanged(int checked);
+    void on_spnTelemetryFastInterval_valueChanged(int value);
+    void on_spnTelemetryIdleInterval_valueChanged(int value);
+    void on_spnTelemetryHoldTime_valueChanged(int value);
+    void on_spnCaptureSizeLimit_valueChanged(int value);
+
 private:
     Ui::SettingsDialog *ui;
+    QList<QSerialPortInfo> m_portList;
 };
 
 #endif // SETTINGSDIALOG_H
@@ -0,0 +1,169 @@
+#include "slidingrange.h"
+
+#include <math.h>
+
+static const int InitialCapacity = 256;
+static const qreal ShrinkThreshold = 0.5;
+static const qreal Padding = 0.1;
+
+SlidingRange::Deque::Deque() :
+    m_entries(InitialCapacity),
+    m_mask(InitialCapacity - 1)
+{
+}
+
+void SlidingRange::Deque::pushBack(const Entry &entry)
+{
+    if (m_size == m_entries.size()) {
+        //
+        // unroll into a buffer twice the size; capacity stays a power of two
+        // so indices can be wrapped with a mask
+        //
+        QVector<Entry> entries(m_entries.size() * 2);
+        for (int i = 0; i < m_size; i++) {
+            entries[i] = m_entries[(m_head + i) & m_mask];
+        }
+        m_entries.swap(entries);
+        m_head = 0;
+        m_mask = m_entries.size() - 1;
+    }
+
+    m_entries[(m_head + m_size) & m_mask] = entry;
+    m_size++;
+}
+
+void SlidingRange::Deque::popFront()
+{
+    m_head = (m_head + 1) & m_mask;
+    m_size--;
+}
+
+void SlidingRange::Deque::popBack()
+{
+    m_size--;
+}
+
+void SlidingRange::Deque::clear()
+{
+    m_head = 0;
+    m_size = 0;
+}
+
+SlidingRange::SlidingRange()
+{
+}
+
+void SlidingRange::push(qint64 timestamp, qreal value)
+{
+    Entry entry = { timestamp, value };
+
+    while (!m_min.isEmpty() && m_min.back().value >= value) {
+        m_min.popBack();
+    }
+    m_min.pushBack(entry);
+
+    while (!m_max.isEmpty() && m_max.back().value <= value) {
+        m_max.popBack();
+    }
+    m_max.pushBack(entry);
+}
+
+//
+// Drops everything stamped before the start of the window.
+//
+void SlidingRange::expire(qint64 before)
+{
+    while (!m_min.isEmpty() && m_min.front().timestamp < before) {
+        m_min.popFront();
+    }
+
+    while (!m_max.isEmpty() && m_max.front().timestamp < before) {
+        m_max.popFront();
+    }
+}
+
+void SlidingRange::clear()
+{
+    m_min.clear();
+    m_max.clear();
+}
+
+AxisScale::AxisScale(qreal minimumSpan) :
+    m_minimumSpan(minimumSpan)
+{
+}
+
+void AxisScale::setMinimumSpan(qreal span)
+{
+    m_minimumSpan = span;
+    m_valid = false;
+}
+
+//
+// Returns true when the axis range changed.
+//
+bool AxisScale::update(qreal dataMin, qreal dataMax)
+{
+    qreal span = dataMax - dataMin;
+    if (span < m_minimumSpan) {
+        qreal centre = (dataMin + dataMax) / 2.0;
+        dataMin = centre - (m_minimumSpan / 2.0);
+        dataMax = centre + (m_minimumSpan / 2.0);
+        span = m_minimumSpan;
+    }
+
+    if (m_valid) {
+        bool outside = dataMin < m_min || dataMax > m_max;
+        bool loose = span < ((m_max - m_min) * ShrinkThreshold);
+
+        if (!outside && !loose) {
+            return false;
+        }
+    }
+
+    qreal low = dataMin - (span * Padding);
+    qreal high = dataMax + (span * Padding);
+
+    //
+    // keep non-negative quantities from getting a negative axis
+    //
+    if (dataMin >= 0.0 && low < 0.0) {
+        low = 0.0;
+    }
+
+    qreal step = niceStep(high - low);
+    low = floor(low / step) * step;
+    high = ceil(high / step) * step;
+
+    if (m_valid && low == m_min && high == m_max) {
+        return false;
+    }
+
+    m_min = low;
+    m_max = high;
+    m_valid = true;
+
+    return true;
+}
+
+//
+// 1, 2 or 5 times a power of ten, about a tenth of the span.
+//
+qreal AxisScale::niceStep(qreal span)
+{
+    qreal raw = span / 10.0;
+    qreal magnitude = pow(10.0, floor(log10(raw)));
+    qreal fraction = raw / magnitude;
+
+    if (fraction <= 1.0) {
+        return magnitude;
+    }
+    else if (fraction <= 2.0) {
+        return 2.0 * magnitude;
+    }
+    else if (fraction <= 5.0) {
+        return 5.0 * magnitude;
+    }
+
+    return 10.0 * magnitude;
+}
@@ -0,0 +1,86 @@
+#ifndef SLIDINGRANGE_H
+#define SLIDINGRANGE_H
+
+#include <QtGlobal>
+#include <QVector>
+
+//
+// Minimum and maximum of a value over a sliding time window. Two monotonic
+// deques hold only the samples that can still become the extreme, so each
+// push and expire is O(1) amortised and the history is never rescanned.
+//
+class SlidingRange
+{
+public:
+    SlidingRange();
+
+    void push(qint64 timestamp, qreal value);
+    void expire(qint64 before);
+    void clear();
+
+    bool isEmpty() const { return m_max.isEmpty(); }
+    qreal min() const { return m_min.front().value; }
+    qreal max() const { return m_max.front().value; }
+
+private:
+    struct Entry {
+        qint64 timestamp;
+        qreal value;
+    };
+
+    //
+    // Ring buffer deque; the capacity only grows, so a steady window stops
+    // allocating once it has seen its largest size.
+    //
+    class Deque
+    {
+    public:
+        Deque();
+
+        bool isEmpty() const { return m_size == 0; }
+        const Entry &front() const { return m_entries[m_head]; }
+        const Entry &back() const { return m_entries[(m_head + m_size - 1) & m_mask]; }
+
+        void pushBack(const Entry &entry);
+        void popFront();
+        void popBack();
+        void clear();
+
+    private:
+        QVector<Entry> m_entries;
+        int m_head = 0;
+        int m_size = 0;
+        int m_mask = 0;
+    };
+
+    Deque m_min;
+    Deque m_max;
+};
+
+//
+// Axis range with hysteresis. The range grows as soon as the data leaves
+// it but only shrinks once the data uses less than half of it, and new
+// ranges are padded and rounded so small fluctuations don't move the axis.
+//
+class AxisScale
+{
+public:
+    explicit AxisScale(qreal minimumSpan = 1.0);
+
+    bool update(qreal dataMin, qreal dataMax);
+    void setMinimumSpan(qreal span);
+    void invalidate() { m_valid = false; }
+
+    qreal min() const { return m_min; }
+    qreal max() const { return m_max; }
+
+private:
+    static qreal niceStep(qreal span);
+
+    qreal m_minimumSpan;
+    qreal m_min = 0.0;
+    qreal m_max = 0.0;
+    bool m_valid = false;
+};
+
+#endif // SLIDINGRANGE_H
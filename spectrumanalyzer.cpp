@@ -0,0 +1,246 @@
+#include "spectrumanalyzer.h"
+
+#include <QTimer>
+#include <QMutexLocker>
+#include <QtMath>
+
+#include <math.h>
+
+static const int PollInterval = 50;
+
+SpectrumAnalyzer::SpectrumAnalyzer(QObject *parent) :
+    QObject(parent),
+    m_queueHead(0),
+    m_queueTail(0),
+    m_overflows(0)
+{
+    //
+    // Hann window, twiddle factors and the bit-reversal permutation are
+    // computed once
+    //
+    m_windowGain = 0.0f;
+    for (int i = 0; i < FrameSize; i++) {
+        m_window[i] = static_cast<float>(0.5 - (0.5 * cos((2.0 * M_PI * i) / (FrameSize - 1))));
+        m_windowGain += m_window[i];
+    }
+
+    for (int i = 0; i < FrameSize / 2; i++) {
+        m_cos[i] = static_cast<float>(cos((2.0 * M_PI * i) / FrameSize));
+        m_sin[i] = static_cast<float>(-sin((2.0 * M_PI * i) / FrameSize));
+    }
+
+    int bits = 0;
+    while ((1 << bits) < FrameSize) {
+        bits++;
+    }
+    for (int i = 0; i < FrameSize; i++) {
+        int reversed = 0;
+        for (int b = 0; b < bits; b++) {
+            if (i & (1 << b)) {
+                reversed |= 1 << (bits - 1 - b);
+            }
+        }
+        m_bitReverse[i] = reversed;
+    }
+
+    for (int i = 0; i < BinCount; i++) {
+        m_currentSpectrum[i] = 0.0f;
+        m_voltageSpectrum[i] = 0.0f;
+    }
+}
+
+//
+// Called on the GUI thread for every sample. Never blocks: if the analyzer
+// has fallen a whole queue behind, the sample is dropped and counted.
+//
+void SpectrumAnalyzer::push(const Sample &sample)
+{
+    int head = m_queueHead.loadAcquire();
+    int next = (head + 1) % QueueSize;
+
+    if (next == m_queueTail.loadAcquire()) {
+        m_overflows.fetchAndAddRelaxed(1);
+        return;
+    }
+
+    Entry &entry = m_queue[head];
+    entry.timestamp = sample.timestamp;
+    entry.current = static_cast<float>(sample.current) / 1000.0f;
+    entry.voltage = static_cast<float>(sample.packVoltage) / 1000.0f;
+
+    m_queueHead.storeRelease(next);
+}
+
+void SpectrumAnalyzer::copySpectrum(float *current, float *voltage) const
+{
+    QMutexLocker locker(&m_resultLock);
+
+    for (int i = 0; i < BinCount; i++) {
+        current[i] = m_currentSpectrum[i];
+        voltage[i] = m_voltageSpectrum[i];
+    }
+}
+
+SpectrumMetrics SpectrumAnalyzer::metrics() const
+{
+    QMutexLocker locker(&m_resultLock);
+    return m_metrics;
+}
+
+void SpectrumAnalyzer::start()
+{
+    if (m_pollTimer == nullptr) {
+        m_pollTimer = new QTimer(this);
+        m_pollTimer->setInterval(PollInterval);
+        connect(m_pollTimer, &QTimer::timeout, this, &SpectrumAnalyzer::on_pollTimer_timeout);
+    }
+
+    m_pollTimer->start();
+}
+
+void SpectrumAnalyzer::stop()
+{
+    if (m_pollTimer != nullptr) {
+        m_pollTimer->stop();
+    }
+}
+
+//
+// Discards history and anything still queued, e.g. when the session is
+// cleared.
+//
+void SpectrumAnalyzer::reset()
+{
+    m_queueTail.storeRelease(m_queueHead.loadAcquire());
+    m_historyPosition = 0;
+    m_historyCount = 0;
+    m_sinceLastFrame = 0;
+}
+
+void SpectrumAnalyzer::on_pollTimer_timeout()
+{
+    int tail = m_queueTail.loadAcquire();
+    int head = m_queueHead.loadAcquire();
+
+    while (tail != head) {
+        const Entry &entry = m_queue[tail];
+
+        m_currentHistory[m_historyPosition] = entry.current;
+        m_voltageHistory[m_historyPosition] = entry.voltage;
+        m_timestamps[m_historyPosition] = entry.timestamp;
+        m_historyPosition = (m_historyPosition + 1) % FrameSize;
+        if (m_historyCount < FrameSize) {
+            m_historyCount++;
+        }
+        m_sinceLastFrame++;
+
+        tail = (tail + 1) % QueueSize;
+
+        if (m_historyCount == FrameSize && m_sinceLastFrame >= HopSize) {
+            m_queueTail.storeRelease(tail);
+            analyze();
+            m_sinceLastFrame = 0;
+        }
+    }
+
+    m_queueTail.storeRelease(tail);
+}
+
+void SpectrumAnalyzer::analyze()
+{
+    //
+    // the oldest sample in the frame is the one about to be overwritten
+    //
+    qint64 first = m_timestamps[m_historyPosition];
+    qint64 last = m_timestamps[(m_historyPosition + FrameSize - 1) % FrameSize];
+    if (last <= first) {
+        return;
+    }
+
+    qreal sampleRate = (FrameSize - 1) * 1000000.0 / static_cast<qreal>(last - first);
+
+    SpectrumMetrics metrics;
+    metrics.timestamp = last;
+    metrics.sampleRate = sampleRate;
+
+    transform(m_currentHistory, m_currentScratch, sampleRate, &metrics.currentFrequency, &metrics.currentAmplitude);
+    transform(m_voltageHistory, m_voltageScratch, sampleRate, &metrics.voltageFrequency, &metrics.voltageAmplitude);
+
+    {
+        QMutexLocker locker(&m_resultLock);
+        for (int i = 0; i < BinCount; i++) {
+            m_currentSpectrum[i] = m_currentScratch[i];
+            m_voltageSpectrum[i] = m_voltageScratch[i];
+        }
+        m_metrics = metrics;
+    }
+
+    emit spectrumReady(metrics);
+}
+
+//
+// Mean-removed, windowed radix-2 FFT of one channel's history. Writes the
+// single-sided amplitude spectrum and the strongest non-DC component,
+// refined by parabolic interpolation between neighbouring bins.
+//
+void SpectrumAnalyzer::transform(const float *history, float *spectrum, qreal sampleRate, qreal *peakFrequency, qreal *peakAmplitude)
+{
+    float mean = 0.0f;
+    for (int i = 0; i < FrameSize; i++) {
+        mean += history[i];
+    }
+    mean /= FrameSize;
+
+    for (int i = 0; i < FrameSize; i++) {
+        int source = (m_historyPosition + i) % FrameSize;
+        int target = m_bitReverse[i];
+        m_real[target] = (history[source] - mean) * m_window[i];
+        m_imaginary[target] = 0.0f;
+    }
+
+    for (int size = 2; size <= FrameSize; size *= 2) {
+        int half = size / 2;
+        int step = FrameSize / size;
+
+        for (int start = 0; start < FrameSize; start += size) {
+            for (int k = 0; k < half; k++) {
+                float wr = m_cos[k * step];
+                float wi = m_sin[k * step];
+                int even = start + k;
+                int odd = even + half;
+
+                float tr = (m_real[odd] * wr) - (m_imaginary[odd] * wi);
+                float ti = (m_real[odd] * wi) + (m_imaginary[odd] * wr);
+
+                m_real[odd] = m_real[even] - tr;
+                m_imaginary[odd] = m_imaginary[even] - ti;
+                m_real[even] += tr;
+                m_imaginary[even] += ti;
+            }
+        }
+    }
+
+    float scale = 2.0f / m_windowGain;
+    int peak = 1;
+
+    for (int i = 0; i < BinCount; i++) {
+        spectrum[i] = sqrtf((m_real[i] * m_real[i]) + (m_imaginary[i] * m_imaginary[i])) * scale;
+        if (i > 1 && spectrum[i] > spectrum[peak]) {
+            peak = i;
+        }
+    }
+
+    qreal offset = 0.0;
+    if (peak > 1 && peak < BinCount - 1) {
+        qreal left = spectrum[peak - 1];
+        qreal centre = spectrum[peak];
+        qreal right = spectrum[peak + 1];
+        qreal denominator = left - (2.0 * centre) + right;
+        if (denominator != 0.0) {
+            offset = 0.5 * (left - right) / denominator;
+        }
+    }
+
+    *peakFrequency = (peak + offset) * sampleRate / FrameSize;
+    *peakAmplitude = spectrum[peak];
+}
@@ -0,0 +1,113 @@
+#ifndef SPECTRUMANALYZER_H
+#define SPECTRUMANALYZER_H
+
+#include "sample.h"
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QMetaType>
+
+class QTimer;
+
+//
+// Dominant ripple component of the current and pack voltage over the
+// latest analysis frame.
+//
+struct SpectrumMetrics
+{
+    qint64 timestamp = 0;           // wall clock µs of the newest sample
+    qreal sampleRate = 0.0;         // Hz
+    qreal currentFrequency = 0.0;   // Hz
+    qreal currentAmplitude = 0.0;   // A
+    qreal voltageFrequency = 0.0;   // Hz
+    qreal voltageAmplitude = 0.0;   // V
+};
+
+Q_DECLARE_METATYPE(SpectrumMetrics)
+
+//
+// Streaming spectral analysis of current and pack voltage. The GUI thread
+// hands samples over through a fixed single-producer/single-consumer queue;
+// the analyzer, living on its own thread, keeps a sliding frame of history
+// and runs a Hann-windowed FFT every HopSize samples (75% overlap). All
+// buffers are members, so analysis never allocates and push() is a couple
+// of stores.
+//
+class SpectrumAnalyzer : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int FrameSize = 256;
+    static const int BinCount = FrameSize / 2;
+    static const int HopSize = FrameSize / 4;
+    static const int QueueSize = 4096;
+
+    explicit SpectrumAnalyzer(QObject *parent = nullptr);
+
+    void push(const Sample &sample);
+
+    void copySpectrum(float *current, float *voltage) const;
+    SpectrumMetrics metrics() const;
+    quint64 overflows() const { return static_cast<quint64>(m_overflows.loadAcquire()); }
+
+public slots:
+    void start();
+    void stop();
+    void reset();
+
+signals:
+    void spectrumReady(const SpectrumMetrics &metrics);
+
+private slots:
+    void on_pollTimer_timeout();
+
+private:
+    struct Entry {
+        qint64 timestamp;
+        float current;
+        float voltage;
+    };
+
+    void analyze();
+    void transform(const float *history, float *spectrum, qreal sampleRate, qreal *peakFrequency, qreal *peakAmplitude);
+
+    //
+    // queue shared with the GUI thread
+    //
+    Entry m_queue[QueueSize];
+    QAtomicInt m_queueHead;
+    QAtomicInt m_queueTail;
+    QAtomicInt m_overflows;
+
+    //
+    // analysis state, only touched on the analyzer thread
+    //
+    QTimer *m_pollTimer = nullptr;
+    float m_currentHistory[FrameSize];
+    float m_voltageHistory[FrameSize];
+    qint64 m_timestamps[FrameSize];
+    int m_historyPosition = 0;
+    int m_historyCount = 0;
+    int m_sinceLastFrame = 0;
+    float m_window[FrameSize];
+    float m_windowGain = 0.0f;
+    float m_real[FrameSize];
+    float m_imaginary[FrameSize];
+    float m_cos[FrameSize / 2];
+    float m_sin[FrameSize / 2];
+    int m_bitReverse[FrameSize];
+    float m_currentScratch[BinCount];
+    float m_voltageScratch[BinCount];
+
+    //
+    // latest results, guarded for the GUI thread
+    //
+    mutable QMutex m_resultLock;
+    float m_currentSpectrum[BinCount];
+    float m_voltageSpectrum[BinCount];
+    SpectrumMetrics m_metrics;
+};
+
+#endif // SPECTRUMANALYZER_H
@@ -0,0 +1,55 @@
+#include "spectrumdialog.h"
+#include "ui_spectrumdialog.h"
+
+SpectrumDialog::SpectrumDialog(SpectrumAnalyzer *analyzer, QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::SpectrumDialog),
+    m_analyzer(analyzer)
+{
+    ui->setupUi(this);
+
+    ui->wfCurrent->setBinCount(SpectrumAnalyzer::BinCount);
+    ui->wfVoltage->setBinCount(SpectrumAnalyzer::BinCount);
+}
+
+SpectrumDialog::~SpectrumDialog()
+{
+    delete ui;
+}
+
+//
+// Spectra are only copied and drawn while the dialog is visible; the
+// analyzer keeps running either way.
+//
+void SpectrumDialog::updateSpectrum(const SpectrumMetrics &metrics)
+{
+    if (!isVisible()) {
+        return;
+    }
+
+    m_analyzer->copySpectrum(m_currentSpectrum, m_voltageSpectrum);
+
+    qreal nyquist = metrics.sampleRate / 2.0;
+    ui->wfCurrent->setFrequencyRange(nyquist);
+    ui->wfVoltage->setFrequencyRange(nyquist);
+    ui->wfCurrent->addRow(m_currentSpectrum, SpectrumAnalyzer::BinCount);
+    ui->wfVoltage->addRow(m_voltageSpectrum, SpectrumAnalyzer::BinCount);
+
+    ui->lblCurrentPeak->setText(tr("%1 Hz, %2 A")
+                                .arg(metrics.currentFrequency, 0, 'f', 2)
+                                .arg(metrics.currentAmplitude, 0, 'f', 3));
+    ui->lblVoltagePeak->setText(tr("%1 Hz, %2 V")
+                                .arg(metrics.voltageFrequency, 0, 'f', 2)
+                                .arg(metrics.voltageAmplitude, 0, 'f', 3));
+    ui->lblSampleRate->setText(tr("Sample rate %1 Hz, %2 point frames")
+                               .arg(metrics.sampleRate, 0, 'f', 1)
+                               .arg(SpectrumAnalyzer::FrameSize));
+}
+
+void SpectrumDialog::clear()
+{
+    ui->wfCurrent->clear();
+    ui->wfVoltage->clear();
+    ui->lblCurrentPeak->setText("-");
+    ui->lblVoltagePeak->setText("-");
+}
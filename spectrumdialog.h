@@ -0,0 +1,31 @@
+#ifndef SPECTRUMDIALOG_H
+#define SPECTRUMDIALOG_H
+
+#include "spectrumanalyzer.h"
+
+#include <QDialog>
+
+namespace Ui {
+class SpectrumDialog;
+}
+
+class SpectrumDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit SpectrumDialog(SpectrumAnalyzer *analyzer, QWidget *parent = nullptr);
+    ~SpectrumDialog();
+
+public slots:
+    void updateSpectrum(const SpectrumMetrics &metrics);
+    void clear();
+
+private:
+    Ui::SpectrumDialog *ui;
+    SpectrumAnalyzer *m_analyzer;
+    float m_currentSpectrum[SpectrumAnalyzer::BinCount];
+    float m_voltageSpectrum[SpectrumAnalyzer::BinCount];
+};
+
+#endif // SPECTRUMDIALOG_H
@@ -0,0 +1,67 @@
+#include "startuptrace.h"
+#include "diagnostics.h"
+
+#include <QElapsedTimer>
+#include <QSettings>
+
+static const int MaximumMarks = 16;
+
+struct StartupMark
+{
+    const char *name;
+    qint64 elapsed;
+};
+
+static QElapsedTimer s_timer;
+static StartupMark s_marks[MaximumMarks];
+static int s_markCount = 0;
+static bool s_finished = false;
+
+void StartupTrace::start()
+{
+    s_timer.start();
+    s_markCount = 0;
+    s_finished = false;
+    mark("start");
+}
+
+void StartupTrace::mark(const char *name)
+{
+    if (s_finished || s_markCount == MaximumMarks || !s_timer.isValid()) {
+        return;
+    }
+
+    s_marks[s_markCount].name = name;
+    s_marks[s_markCount].elapsed = s_timer.nsecsElapsed();
+    s_markCount++;
+}
+
+qint64 StartupTrace::elapsed()
+{
+    return s_timer.isValid() ? s_timer.nsecsElapsed() : 0;
+}
+
+bool StartupTrace::isFinished()
+{
+    return s_finished;
+}
+
+void StartupTrace::finish()
+{
+    if (s_finished) {
+        return;
+    }
+
+    s_finished = true;
+
+    QSettings settings;
+    settings.beginGroup("diagnostics/startup");
+
+    for (int i = 0; i < s_markCount; i++) {
+        qreal milliseconds = static_cast<qreal>(s_marks[i].elapsed) / 1000000.0;
+        qCDebug(lcDiagnostics) << "Startup:" << s_marks[i].name << milliseconds << "ms";
+        settings.setValue(QString::fromLatin1(s_marks[i].name), milliseconds);
+    }
+
+    settings.endGroup();
+}
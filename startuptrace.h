@@ -0,0 +1,21 @@
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+#include <QtGlobal>
+
+//
+// Records named milestones relative to process start so time-to-first-
+// sample can be tracked across releases. The trace is printed and the
+// totals stored in QSettings under diagnostics/startup once the first
+// sample has been decoded.
+//
+namespace StartupTrace
+{
+    void start();
+    void mark(const char *name);
+    qint64 elapsed();
+    bool isFinished();
+    void finish();
+}
+
+#endif // STARTUPTRACE_H
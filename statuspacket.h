@@ -7,6 +7,10 @@
 #define MODE_DISCHARGING 1
 #define MODE_CHARGING 2
 
+#define COMMAND_SET_INTERVAL 1
+#define COMMAND_SNAPSHOT 2
+#define COMMAND_SET_BAUD_RATE 3
+
 #pragma pack(push, 1)
 typedef struct status_packet {
   unsigned char a;
@@ -18,6 +22,15 @@ typedef struct status_packet {
   uint16_t cell_voltage[6];
   unsigned char b;
 } status_packet_t;
+
+/* sent to the pack prefixed with 'C','M' */
+typedef struct command_packet {
+  unsigned char a;
+  uint8_t command;
+  uint32_t argument;
+  uint8_t checksum;
+  unsigned char b;
+} command_packet_t;
 #pragma pack(pop)
 
 #endif // STATUSPACKET_H
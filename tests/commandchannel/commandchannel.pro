@@ -0,0 +1,21 @@
+QT       = core serialport testlib
+
+TARGET = tst_commandchannel
+TEMPLATE = app
+
+CONFIG += console c++11 testcase
+CONFIG -= app_bundle
+
+requires(unix)
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+        tst_commandchannel.cpp \
+    ../../commandchannel.cpp
+
+HEADERS += \
+    ../../commandchannel.h \
+    ../../statuspacket.h
@@ -0,0 +1,185 @@
+#include "commandchannel.h"
+
+#include <QtTest>
+#include <QSerialPort>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+//
+// Command channel round trip over a pseudo terminal. The channel writes
+// to the slave side through QSerialPort, as it would to the pack's
+// adapter, and the test reads the frames back from the master side. The
+// expected frames are built byte by byte from the protocol rather than
+// from command_packet_t.
+//
+class TestCommandChannel : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void setTelemetryInterval();
+    void unchangedIntervalIsNotResent();
+    void requestSnapshot();
+    void setBaudRate();
+
+private:
+    static const int FrameSize = 2 + sizeof(command_packet_t);
+
+    static QByteArray expectedFrame(quint8 command, quint32 argument);
+    QByteArray readFrame();
+    bool masterIsEmpty();
+
+    int m_master = -1;
+    QSerialPort *m_port = nullptr;
+};
+
+QByteArray TestCommandChannel::expectedFrame(quint8 command, quint32 argument)
+{
+    QByteArray frame;
+    frame.append('C');
+    frame.append('M');
+    frame.append('A');
+    frame.append(static_cast<char>(command));
+
+    quint8 checksum = command;
+    for (int i = 0; i < 4; i++) {
+        quint8 byte = static_cast<quint8>(argument >> (8 * i));
+        frame.append(static_cast<char>(byte));
+        checksum ^= byte;
+    }
+
+    frame.append(static_cast<char>(checksum));
+    frame.append('B');
+    return frame;
+}
+
+//
+// QSerialPort writes from the event loop, so events are processed while
+// waiting for the bytes on the master side.
+//
+QByteArray TestCommandChannel::readFrame()
+{
+    QByteArray frame;
+    QElapsedTimer timer;
+    timer.start();
+
+    while (frame.size() < FrameSize && timer.elapsed() < 5000) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+
+        char buffer[FrameSize];
+        ssize_t length = ::read(m_master, buffer, static_cast<size_t>(FrameSize - frame.size()));
+        if (length > 0) {
+            frame.append(buffer, static_cast<int>(length));
+        }
+    }
+
+    return frame;
+}
+
+bool TestCommandChannel::masterIsEmpty()
+{
+    QTest::qWait(100);
+
+    char byte;
+    return ::read(m_master, &byte, 1) <= 0;
+}
+
+void TestCommandChannel::init()
+{
+    m_master = posix_openpt(O_RDWR | O_NOCTTY);
+    QVERIFY(m_master >= 0);
+    QVERIFY(grantpt(m_master) == 0);
+    QVERIFY(unlockpt(m_master) == 0);
+    QVERIFY(fcntl(m_master, F_SETFL, fcntl(m_master, F_GETFL) | O_NONBLOCK) == 0);
+
+    m_port = new QSerialPort;
+    m_port->setPortName(QString::fromLocal8Bit(ptsname(m_master)));
+    m_port->setBaudRate(QSerialPort::Baud9600);
+    QVERIFY2(m_port->open(QIODevice::ReadWrite), qPrintable(m_port->errorString()));
+}
+
+void TestCommandChannel::cleanup()
+{
+    delete m_port;
+    m_port = nullptr;
+
+    if (m_master >= 0) {
+        ::close(m_master);
+        m_master = -1;
+    }
+}
+
+void TestCommandChannel::setTelemetryInterval()
+{
+    CommandChannel channel(m_port);
+    QSignalSpy changed(&channel, &CommandChannel::telemetryIntervalChanged);
+
+    channel.setTelemetryInterval(100);
+
+    QCOMPARE(readFrame(), expectedFrame(COMMAND_SET_INTERVAL, 100));
+    QCOMPARE(channel.telemetryInterval(), 100);
+    QCOMPARE(changed.count(), 1);
+    QCOMPARE(changed.at(0).at(0).toInt(), 100);
+}
+
+void TestCommandChannel::unchangedIntervalIsNotResent()
+{
+    CommandChannel channel(m_port);
+    QSignalSpy changed(&channel, &CommandChannel::telemetryIntervalChanged);
+
+    channel.setTelemetryInterval(60000);
+    QCOMPARE(readFrame(), expectedFrame(COMMAND_SET_INTERVAL, 60000));
+
+    channel.setTelemetryInterval(60000);
+    QVERIFY(masterIsEmpty());
+    QCOMPARE(changed.count(), 1);
+
+    //
+    // after the pack has slept the interval has to be sent again
+    //
+    channel.invalidateTelemetryInterval();
+    channel.setTelemetryInterval(60000);
+    QCOMPARE(readFrame(), expectedFrame(COMMAND_SET_INTERVAL, 60000));
+    QCOMPARE(changed.count(), 2);
+}
+
+void TestCommandChannel::requestSnapshot()
+{
+    CommandChannel channel(m_port);
+
+    channel.requestSnapshot();
+
+    QCOMPARE(readFrame(), expectedFrame(COMMAND_SNAPSHOT, 0));
+}
+
+//
+// The whole command goes out at the old rate and only then is the port
+// switched.
+//
+void TestCommandChannel::setBaudRate()
+{
+    CommandChannel channel(m_port);
+    QSignalSpy changed(&channel, &CommandChannel::baudRateChanged);
+
+    channel.setBaudRate(QSerialPort::Baud115200);
+    QCOMPARE(m_port->baudRate(), static_cast<qint32>(QSerialPort::Baud9600));
+
+    QCOMPARE(readFrame(), expectedFrame(COMMAND_SET_BAUD_RATE, QSerialPort::Baud115200));
+    QTRY_COMPARE(changed.count(), 1);
+    QCOMPARE(changed.at(0).at(0).toInt(), static_cast<int>(QSerialPort::Baud115200));
+    QCOMPARE(m_port->baudRate(), static_cast<qint32>(QSerialPort::Baud115200));
+
+    //
+    // already at that rate, nothing to send
+    //
+    channel.setBaudRate(QSerialPort::Baud115200);
+    QVERIFY(masterIsEmpty());
+}
+
+QTEST_GUILESS_MAIN(TestCommandChannel)
+
+#include "tst_commandchannel.moc"
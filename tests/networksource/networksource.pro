@@ -0,0 +1,29 @@
+QT       = core network serialport testlib
+
+TARGET = tst_networksource
+TEMPLATE = app
+
+CONFIG += console c++11 testcase
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+        tst_networksource.cpp \
+    ../../intervalestimator.cpp \
+    ../../networksource.cpp \
+    ../../packetdecoder.cpp \
+    ../../packetsource.cpp \
+    ../../portmanager.cpp \
+    ../../sampleclock.cpp
+
+HEADERS += \
+    ../../intervalestimator.h \
+    ../../networksource.h \
+    ../../packetdecoder.h \
+    ../../packetsource.h \
+    ../../portmanager.h \
+    ../../sampleclock.h \
+    ../../statuspacket.h
@@ -0,0 +1,204 @@
+#include "networksource.h"
+#include "packetdecoder.h"
+
+#include <QtTest>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUdpSocket>
+
+#include <string.h>
+
+//
+// Bridge sources against the loopback interface. Everything a source
+// returns goes through a PacketDecoder, as in the main window, and the
+// frames are told apart by their pack voltage.
+//
+class TestNetworkSource : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void udpFrames();
+    void udpDropsMalformedDatagrams();
+    void tcpFramesSplitAcrossReads();
+    void tcpReconnects();
+
+private:
+    static const int FrameSize = 2 + sizeof(status_packet_t);
+
+    static QByteArray frame(quint16 packVoltage);
+    static quint16 freeUdpPort();
+    void watch(PacketSource *source);
+
+    PacketDecoder m_decoder;
+    QList<quint16> m_decoded;
+};
+
+QByteArray TestNetworkSource::frame(quint16 packVoltage)
+{
+    status_packet_t packet;
+    memset(&packet, 0, sizeof(packet));
+    packet.a = 'A';
+    packet.mode = MODE_DISCHARGING;
+    packet.pack_voltage = packVoltage;
+    packet.b = 'B';
+
+    QByteArray bytes("DE");
+    bytes.append(reinterpret_cast<const char *>(&packet), sizeof(packet));
+    return bytes;
+}
+
+quint16 TestNetworkSource::freeUdpPort()
+{
+    QUdpSocket socket;
+    if (!socket.bind(QHostAddress::LocalHost, 0)) {
+        return 0;
+    }
+
+    return socket.localPort();
+}
+
+//
+// Drains the source into the decoder whenever it has bytes, in the same
+// fixed-size chunks the main window reads.
+//
+void TestNetworkSource::watch(PacketSource *source)
+{
+    m_decoder.reset();
+    m_decoded.clear();
+
+    connect(source, &PacketSource::readyRead, this, [this, source]() {
+        char buffer[4096];
+        qint64 timestamp;
+        qint64 length;
+
+        while ((length = source->read(buffer, sizeof(buffer), &timestamp)) > 0) {
+            for (qint64 i = 0; i < length; i++) {
+                if (m_decoder.push(buffer[i])) {
+                    m_decoded.append(m_decoder.packet().pack_voltage);
+                }
+            }
+        }
+    });
+}
+
+void TestNetworkSource::udpFrames()
+{
+    quint16 port = freeUdpPort();
+    QVERIFY(port != 0);
+
+    SampleClock clock;
+    UdpPacketSource source("127.0.0.1", port, &clock);
+    QSignalSpy opened(&source, &PacketSource::opened);
+    watch(&source);
+    source.start();
+
+    QUdpSocket sender;
+    sender.writeDatagram(frame(1), QHostAddress::LocalHost, port);
+    sender.writeDatagram(frame(2) + frame(3), QHostAddress::LocalHost, port);
+
+    QTRY_COMPARE(m_decoded.count(), 3);
+    QCOMPARE(m_decoded, QList<quint16>() << 1 << 2 << 3);
+    QCOMPARE(opened.count(), 1);
+    QVERIFY(source.isOpen());
+    QCOMPARE(source.statistics().malformed(), static_cast<quint64>(0));
+    QCOMPARE(source.statistics().bytes(), static_cast<quint64>(3 * FrameSize));
+}
+
+//
+// A truncated datagram must not leave the decoder part way through a
+// frame, or the good datagram after it is lost too.
+//
+void TestNetworkSource::udpDropsMalformedDatagrams()
+{
+    quint16 port = freeUdpPort();
+    QVERIFY(port != 0);
+
+    SampleClock clock;
+    UdpPacketSource source("127.0.0.1", port, &clock);
+    watch(&source);
+    source.start();
+
+    QUdpSocket sender;
+    sender.writeDatagram(frame(1), QHostAddress::LocalHost, port);
+    sender.writeDatagram(frame(2).left(FrameSize - 4), QHostAddress::LocalHost, port);
+    sender.writeDatagram(frame(3), QHostAddress::LocalHost, port);
+    sender.writeDatagram(QByteArray(FrameSize, 'x'), QHostAddress::LocalHost, port);
+    sender.writeDatagram(frame(4), QHostAddress::LocalHost, port);
+
+    QTRY_COMPARE(m_decoded.count(), 3);
+    QCOMPARE(m_decoded, QList<quint16>() << 1 << 3 << 4);
+    QTRY_COMPARE(source.statistics().malformed(), static_cast<quint64>(2));
+    QCOMPARE(source.statistics().bytes(), static_cast<quint64>(3 * FrameSize));
+}
+
+//
+// TCP is a byte stream; frames written in odd pieces still decode.
+//
+void TestNetworkSource::tcpFramesSplitAcrossReads()
+{
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost, 0));
+
+    SampleClock clock;
+    TcpPacketSource source("127.0.0.1", server.serverPort(), &clock);
+    QSignalSpy opened(&source, &PacketSource::opened);
+    watch(&source);
+    source.start();
+
+    QTRY_VERIFY(server.hasPendingConnections());
+    QTcpSocket *bridge = server.nextPendingConnection();
+    QTRY_COMPARE(opened.count(), 1);
+
+    QByteArray stream = frame(1) + frame(2) + frame(3);
+    bridge->write(stream.left(7));
+    bridge->flush();
+    QTRY_COMPARE(source.statistics().bytes(), static_cast<quint64>(7));
+
+    bridge->write(stream.mid(7, FrameSize));
+    bridge->write(stream.mid(7 + FrameSize));
+    bridge->flush();
+
+    QTRY_COMPARE(m_decoded.count(), 3);
+    QCOMPARE(m_decoded, QList<quint16>() << 1 << 2 << 3);
+    QCOMPARE(source.statistics().bytes(), static_cast<quint64>(stream.size()));
+}
+
+//
+// A dropped bridge connection is reported once and retried.
+//
+void TestNetworkSource::tcpReconnects()
+{
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost, 0));
+
+    SampleClock clock;
+    TcpPacketSource source("127.0.0.1", server.serverPort(), &clock);
+    QSignalSpy opened(&source, &PacketSource::opened);
+    QSignalSpy lost(&source, &PacketSource::lost);
+    watch(&source);
+    source.start();
+
+    QTRY_VERIFY(server.hasPendingConnections());
+    QTcpSocket *bridge = server.nextPendingConnection();
+    QTRY_COMPARE(opened.count(), 1);
+
+    bridge->disconnectFromHost();
+    QTRY_COMPARE(lost.count(), 1);
+    QVERIFY(!source.isOpen());
+    QCOMPARE(source.statistics().disconnects(), 1);
+
+    QTRY_VERIFY(server.hasPendingConnections());
+    bridge = server.nextPendingConnection();
+    QTRY_COMPARE(opened.count(), 2);
+
+    bridge->write(frame(5));
+    bridge->flush();
+    QTRY_COMPARE(m_decoded, QList<quint16>() << 5);
+
+    source.close();
+}
+
+QTEST_GUILESS_MAIN(TestNetworkSource)
+
+#include "tst_networksource.moc"
@@ -0,0 +1,12 @@
+#-------------------------------------------------
+#
+# Protocol tests that run against a pseudo terminal or the loopback
+# interface instead of a pack. Build and run with qmake && make check.
+#
+#-------------------------------------------------
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    commandchannel \
+    networksource
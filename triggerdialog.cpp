@@ -0,0 +1,370 @@
+#include "triggerdialog.h"
+#include "ui_triggerdialog.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QPen>
+#include <QtCharts/QChartView>
+
+#include <float.h>
+
+static const QColor s_cellColors[6] = {
+    Qt::darkRed, Qt::darkGreen, Qt::darkBlue, Qt::darkMagenta, Qt::darkCyan, Qt::darkYellow
+};
+
+TriggerDialog::TriggerDialog(QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::TriggerDialog)
+{
+    ui->setupUi(this);
+
+    m_chart = new QChart();
+    m_chart->legend()->setVisible(true);
+    m_chart->legend()->setAlignment(Qt::AlignBottom);
+
+    m_axisTime = new QValueAxis;
+    m_axisTime->setTitleText(tr("Time from trigger (s)"));
+    m_chart->addAxis(m_axisTime, Qt::AlignBottom);
+
+    m_axisVoltage = new QValueAxis;
+    m_axisVoltage->setTitleText(tr("Pack (V)"));
+    m_chart->addAxis(m_axisVoltage, Qt::AlignLeft);
+
+    m_axisCell = new QValueAxis;
+    m_axisCell->setTitleText(tr("Cells (V)"));
+    m_chart->addAxis(m_axisCell, Qt::AlignLeft);
+
+    m_axisCurrent = new QValueAxis;
+    m_axisCurrent->setTitleText(tr("Current (A)"));
+    m_chart->addAxis(m_axisCurrent, Qt::AlignRight);
+
+    m_seriesVoltage = new QLineSeries;
+    m_seriesVoltage->setName(tr("Pack voltage"));
+    m_seriesVoltage->setColor(Qt::red);
+    m_chart->addSeries(m_seriesVoltage);
+    m_seriesVoltage->attachAxis(m_axisTime);
+    m_seriesVoltage->attachAxis(m_axisVoltage);
+
+    m_seriesCurrent = new QLineSeries;
+    m_seriesCurrent->setName(tr("Current"));
+    m_seriesCurrent->setColor(Qt::blue);
+    m_chart->addSeries(m_seriesCurrent);
+    m_seriesCurrent->attachAxis(m_axisTime);
+    m_seriesCurrent->attachAxis(m_axisCurrent);
+
+    for (int cell = 0; cell < 6; cell++) {
+        m_seriesCells[cell] = new QLineSeries;
+        m_seriesCells[cell]->setName(tr("Cell %1").arg(cell + 1));
+        m_seriesCells[cell]->setColor(s_cellColors[cell]);
+        m_chart->addSeries(m_seriesCells[cell]);
+        m_seriesCells[cell]->attachAxis(m_axisTime);
+        m_seriesCells[cell]->attachAxis(m_axisCell);
+    }
+
+    //
+    // vertical line at the trigger, spanning the pack voltage axis
+    //
+    m_seriesMarker = new QLineSeries;
+    m_seriesMarker->setName(tr("Trigger"));
+    QPen pen(Qt::black);
+    pen.setStyle(Qt::DashLine);
+    m_seriesMarker->setPen(pen);
+    m_chart->addSeries(m_seriesMarker);
+    m_seriesMarker->attachAxis(m_axisTime);
+    m_seriesMarker->attachAxis(m_axisVoltage);
+
+    ui->chartView->setChart(m_chart);
+    ui->chartView->setRubberBand(QChartView::RectangleRubberBand);
+
+    on_cboCondition_currentIndexChanged(ui->cboCondition->currentIndex());
+}
+
+TriggerDialog::~TriggerDialog()
+{
+    delete ui;
+}
+
+void TriggerDialog::setSettings(const TriggerSettings &settings)
+{
+    ui->cboCondition->setCurrentIndex(qBound(0, settings.condition, static_cast<int>(TriggerEngine::ConditionCount) - 1));
+    ui->spnThreshold->setValue(settings.threshold);
+    ui->spnHysteresis->setValue(settings.hysteresis);
+    ui->spnPreTrigger->setValue(settings.preTrigger);
+    ui->spnPostTrigger->setValue(settings.postTrigger);
+    ui->spnHoldoff->setValue(settings.holdoff);
+    ui->spnMaximumCaptures->setValue(settings.maximumCaptures);
+
+    m_maximumCaptures = qMax(1, settings.maximumCaptures);
+    removeOldCaptures();
+}
+
+void TriggerDialog::addCapture(const TriggerCapture &capture)
+{
+    m_captures.append(capture);
+
+    QListWidgetItem *item = new QListWidgetItem(capture.name);
+    item->setFlags(item->flags() | Qt::ItemIsEditable);
+    item->setToolTip(tr("%1, %n sample(s)", "", capture.samples.count()).arg(capture.reason));
+
+    ui->lstCaptures->blockSignals(true);
+    ui->lstCaptures->addItem(item);
+    ui->lstCaptures->blockSignals(false);
+
+    if (ui->lstCaptures->currentRow() < 0) {
+        ui->lstCaptures->setCurrentRow(0);
+    }
+
+    removeOldCaptures();
+}
+
+void TriggerDialog::on_btnApply_clicked()
+{
+    TriggerSettings settings;
+    settings.condition = ui->cboCondition->currentIndex();
+    settings.threshold = ui->spnThreshold->value();
+    settings.hysteresis = ui->spnHysteresis->value();
+    settings.preTrigger = ui->spnPreTrigger->value();
+    settings.postTrigger = ui->spnPostTrigger->value();
+    settings.holdoff = ui->spnHoldoff->value();
+    settings.maximumCaptures = ui->spnMaximumCaptures->value();
+
+    m_maximumCaptures = qMax(1, settings.maximumCaptures);
+    removeOldCaptures();
+
+    emit settingsApplied(settings);
+}
+
+void TriggerDialog::on_cboCondition_currentIndexChanged(int index)
+{
+    bool hasThreshold = (index == TriggerEngine::ConditionCurrentAbove || index == TriggerEngine::ConditionCellBelow);
+    ui->spnThreshold->setEnabled(hasThreshold);
+    ui->spnThreshold->setSuffix((index == TriggerEngine::ConditionCellBelow) ? tr(" V") : tr(" A"));
+    ui->spnHysteresis->setEnabled(hasThreshold);
+    ui->spnHysteresis->setSuffix(ui->spnThreshold->suffix());
+    ui->btnApply->setText((index == TriggerEngine::ConditionOff) ? tr("Apply") : tr("Arm"));
+}
+
+void TriggerDialog::on_lstCaptures_currentRowChanged(int row)
+{
+    showCapture(row);
+}
+
+void TriggerDialog::on_lstCaptures_itemChanged(QListWidgetItem *item)
+{
+    int row = ui->lstCaptures->row(item);
+    if (row >= 0 && row < m_captures.count()) {
+        m_captures[row].name = item->text();
+    }
+}
+
+void TriggerDialog::on_btnExport_clicked()
+{
+    int row = ui->lstCaptures->currentRow();
+    if (row < 0 || row >= m_captures.count()) {
+        return;
+    }
+
+    QString fileName = QFileDialog::getSaveFileName(
+                this,
+                tr("Export Capture"),
+                m_captures[row].name + ".csv",
+                tr("CSV Files (*.csv)"));
+
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    if (!exportCapture(m_captures[row], fileName)) {
+        QMessageBox::critical(
+                    this,
+                    tr("File Error"),
+                    tr("Could not open file %1 for writing!").arg(fileName));
+    }
+}
+
+void TriggerDialog::on_btnRemove_clicked()
+{
+    int row = ui->lstCaptures->currentRow();
+    if (row < 0 || row >= m_captures.count()) {
+        return;
+    }
+
+    m_captures.removeAt(row);
+    delete ui->lstCaptures->takeItem(row);
+
+    if (m_captures.isEmpty()) {
+        showCapture(-1);
+    }
+}
+
+//
+// Drops the oldest captures beyond the maximum, keeping the selection on
+// the capture it was on if that one stays.
+//
+void TriggerDialog::removeOldCaptures()
+{
+    int excess = m_captures.count() - m_maximumCaptures;
+    if (excess <= 0) {
+        return;
+    }
+
+    int row = ui->lstCaptures->currentRow();
+
+    ui->lstCaptures->blockSignals(true);
+    for (int i = 0; i < excess; i++) {
+        m_captures.removeFirst();
+        delete ui->lstCaptures->takeItem(0);
+    }
+    ui->lstCaptures->blockSignals(false);
+
+    if (row >= excess) {
+        ui->lstCaptures->setCurrentRow(row - excess);
+    }
+    else {
+        ui->lstCaptures->setCurrentRow(m_captures.isEmpty() ? -1 : 0);
+        showCapture(ui->lstCaptures->currentRow());
+    }
+}
+
+void TriggerDialog::on_btnResetZoom_clicked()
+{
+    m_chart->zoomReset();
+}
+
+//
+// Captures are at most TriggerEngine::RingSize samples, so every sample
+// is handed to the chart.
+//
+void TriggerDialog::showCapture(int row)
+{
+    m_chart->zoomReset();
+
+    QVector<QPointF> voltage;
+    QVector<QPointF> current;
+    QVector<QPointF> cells[6];
+
+    if (row < 0 || row >= m_captures.count()) {
+        m_seriesVoltage->clear();
+        m_seriesCurrent->clear();
+        for (int cell = 0; cell < 6; cell++) {
+            m_seriesCells[cell]->clear();
+        }
+        m_seriesMarker->clear();
+        m_chart->setTitle(QString());
+        return;
+    }
+
+    const TriggerCapture &capture = m_captures[row];
+    int count = capture.samples.count();
+
+    voltage.reserve(count);
+    current.reserve(count);
+    for (int cell = 0; cell < 6; cell++) {
+        cells[cell].reserve(count);
+    }
+
+    qreal minimumVoltage = DBL_MAX;
+    qreal maximumVoltage = -DBL_MAX;
+    qreal minimumCurrent = DBL_MAX;
+    qreal maximumCurrent = -DBL_MAX;
+    qreal minimumCell = DBL_MAX;
+    qreal maximumCell = -DBL_MAX;
+
+    for (const Sample &sample : capture.samples) {
+        qreal t = static_cast<qreal>(sample.timestamp - capture.triggerTimestamp) / 1000000.0;
+
+        voltage.append(QPointF(t, sample.volts()));
+        current.append(QPointF(t, sample.amps()));
+        minimumVoltage = qMin(minimumVoltage, sample.volts());
+        maximumVoltage = qMax(maximumVoltage, sample.volts());
+        minimumCurrent = qMin(minimumCurrent, sample.amps());
+        maximumCurrent = qMax(maximumCurrent, sample.amps());
+
+        for (int cell = 0; cell < 6; cell++) {
+            cells[cell].append(QPointF(t, sample.cellVolts(cell)));
+            if (sample.cellVoltage[cell] != 0) {
+                minimumCell = qMin(minimumCell, sample.cellVolts(cell));
+                maximumCell = qMax(maximumCell, sample.cellVolts(cell));
+            }
+        }
+    }
+
+    m_seriesVoltage->replace(voltage);
+    m_seriesCurrent->replace(current);
+    for (int cell = 0; cell < 6; cell++) {
+        m_seriesCells[cell]->replace(cells[cell]);
+    }
+
+    auto padded = [](QValueAxis *axis, qreal minimum, qreal maximum) {
+        if (minimum <= maximum) {
+            qreal padding = qMax((maximum - minimum) * 0.05, 0.01);
+            axis->setRange(minimum - padding, maximum + padding);
+        }
+    };
+    padded(m_axisVoltage, minimumVoltage, maximumVoltage);
+    padded(m_axisCurrent, minimumCurrent, maximumCurrent);
+    padded(m_axisCell, minimumCell, maximumCell);
+
+    QVector<QPointF> marker;
+    marker << QPointF(0.0, m_axisVoltage->min()) << QPointF(0.0, m_axisVoltage->max());
+    m_seriesMarker->replace(marker);
+
+    if (count > 0) {
+        qreal from = voltage.first().x();
+        qreal to = voltage.last().x();
+        m_axisTime->setRange(from, (to > from) ? to : from + 1.0);
+    }
+
+    m_chart->setTitle(tr("%1 - %2").arg(capture.reason,
+                                        QDateTime::fromMSecsSinceEpoch(capture.triggerTimestamp / 1000).toString("yyyy-MM-dd hh:mm:ss.zzz")));
+}
+
+//
+// Same columns and "# start" line as the data log, with elapsed measured
+// from the first captured sample, so exported captures can be replayed and
+// compared like any other log. Where the trigger fell goes in the comment.
+//
+bool TriggerDialog::exportCapture(const TriggerCapture &capture, const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    qint64 start = capture.samples.isEmpty() ? capture.triggerTimestamp : capture.samples.first().timestamp;
+    QByteArray startTime = QDateTime::fromMSecsSinceEpoch(start / 1000, Qt::UTC).toString(Qt::ISODate).toLatin1();
+
+    char line[256];
+    int length = qsnprintf(line, sizeof(line), "# start %lld %s\n", static_cast<long long>(start), startTime.constData());
+    file.write(line, length);
+
+    file.write(QString("# %1: %2, trigger at %3 s\n").arg(capture.name, capture.reason)
+               .arg(static_cast<qreal>(capture.triggerTimestamp - start) / 1000000.0, 0, 'f', 6).toUtf8());
+    file.write("time,elapsed,voltage,current,charge,temperature,mode,cell1,cell2,cell3,cell4,cell5,cell6\n");
+
+    for (const Sample &sample : capture.samples) {
+        QByteArray time = QDateTime::fromMSecsSinceEpoch(sample.timestamp / 1000).toString("hh:mm:ss.zzz").toLatin1();
+        length = qsnprintf(
+                    line,
+                    sizeof(line),
+                    "%s,%.6f,%g,%g,%g,%g,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+                    time.constData(),
+                    static_cast<qreal>(sample.timestamp - start) / 1000000.0,
+                    sample.volts(),
+                    sample.amps(),
+                    sample.coulombs(),
+                    sample.celsius(),
+                    sample.mode,
+                    sample.cellVolts(0),
+                    sample.cellVolts(1),
+                    sample.cellVolts(2),
+                    sample.cellVolts(3),
+                    sample.cellVolts(4),
+                    sample.cellVolts(5));
+        file.write(line, length);
+    }
+
+    return true;
+}
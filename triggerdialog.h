@@ -0,0 +1,70 @@
+#ifndef TRIGGERDIALOG_H
+#define TRIGGERDIALOG_H
+
+#include "triggerengine.h"
+
+#include <QDialog>
+#include <QList>
+#include <QtCharts/QChart>
+#include <QtCharts/QValueAxis>
+#include <QtCharts/QLineSeries>
+
+QT_CHARTS_USE_NAMESPACE
+
+class QListWidgetItem;
+
+namespace Ui {
+class TriggerDialog;
+}
+
+//
+// Trigger settings and the captures taken so far. The selected capture is
+// drawn at full resolution against time from the trigger, so it can be
+// zoomed into without any decimation; captures can be renamed in the list
+// and exported in the data log format. Only the newest maximumCaptures
+// are kept; each can hold TriggerEngine::RingSize samples.
+//
+class TriggerDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit TriggerDialog(QWidget *parent = nullptr);
+    ~TriggerDialog();
+
+    void setSettings(const TriggerSettings &settings);
+    void addCapture(const TriggerCapture &capture);
+    int captureCount() const { return m_captures.count(); }
+
+signals:
+    void settingsApplied(const TriggerSettings &settings);
+
+private slots:
+    void on_btnApply_clicked();
+    void on_cboCondition_currentIndexChanged(int index);
+    void on_lstCaptures_currentRowChanged(int row);
+    void on_lstCaptures_itemChanged(QListWidgetItem *item);
+    void on_btnExport_clicked();
+    void on_btnRemove_clicked();
+    void on_btnResetZoom_clicked();
+
+private:
+    void showCapture(int row);
+    void removeOldCaptures();
+    bool exportCapture(const TriggerCapture &capture, const QString &fileName);
+
+    Ui::TriggerDialog *ui;
+    QChart *m_chart = nullptr;
+    QValueAxis *m_axisTime = nullptr;
+    QValueAxis *m_axisVoltage = nullptr;
+    QValueAxis *m_axisCurrent = nullptr;
+    QValueAxis *m_axisCell = nullptr;
+    QLineSeries *m_seriesVoltage = nullptr;
+    QLineSeries *m_seriesCurrent = nullptr;
+    QLineSeries *m_seriesCells[6];
+    QLineSeries *m_seriesMarker = nullptr;
+    QList<TriggerCapture> m_captures;
+    int m_maximumCaptures = 1;
+};
+
+#endif // TRIGGERDIALOG_H
@@ -0,0 +1,143 @@
+#include "triggerengine.h"
+
+#include <QCoreApplication>
+
+#include <string.h>
+
+TriggerEngine::TriggerEngine()
+{
+    m_ringStorage.resize(RingSize);
+    m_frozenStorage.resize(RingSize);
+    m_ring = m_ringStorage.data();
+}
+
+//
+// Applies a new condition and re-arms; a capture being collected or
+// waiting to be taken is dropped.
+//
+void TriggerEngine::setSettings(const TriggerSettings &settings)
+{
+    m_settings = settings;
+    m_condition = (settings.condition > ConditionOff && settings.condition < ConditionCount) ? settings.condition : ConditionOff;
+    m_thresholdRaw = qRound(settings.threshold * 1000.0);
+    m_hysteresisRaw = qRound(qMax(settings.hysteresis, 0.0) * 1000.0);
+    m_preTriggerUSecs = qRound64(qMax(settings.preTrigger, 0.0) * 1000000.0);
+    m_postTriggerUSecs = qRound64(qMax(settings.postTrigger, 0.0) * 1000000.0);
+    m_holdoffUSecs = qRound64(qMax(settings.holdoff, 0.0) * 1000000.0);
+
+    m_state = (m_condition == ConditionOff) ? StateOff : StateArmed;
+    m_latched = false;
+    m_holdoffUntil = 0;
+}
+
+//
+// Forgets the ring for a new session.
+//
+void TriggerEngine::reset()
+{
+    m_count = 0;
+    m_previousMode = -1;
+    m_latched = false;
+    m_holdoffUntil = 0;
+    m_state = (m_condition == ConditionOff) ? StateOff : StateArmed;
+}
+
+//
+// Copies the frozen window out and re-arms. Called from a timer, so the
+// allocation stays off the read path.
+//
+TriggerCapture TriggerEngine::takeCapture()
+{
+    TriggerCapture capture;
+    capture.triggerTimestamp = m_triggerTimestamp;
+    capture.reason = describe();
+    capture.samples.resize(m_frozenCount);
+    memcpy(capture.samples.data(), m_frozenStorage.constData(), static_cast<size_t>(m_frozenCount) * sizeof(Sample));
+
+    m_frozenCount = 0;
+    m_state = (m_condition == ConditionOff) ? StateOff : StateArmed;
+    return capture;
+}
+
+//
+// Records what fired and finds how far back the pre-trigger window
+// reaches in the ring. Runs once per trigger, so walking back is fine.
+//
+void TriggerEngine::start(const Sample &sample)
+{
+    m_triggerTimestamp = sample.timestamp;
+    m_stopTimestamp = sample.timestamp + m_postTriggerUSecs;
+    m_holdoffUntil = m_stopTimestamp + m_holdoffUSecs;
+    m_triggerCount++;
+
+    switch (m_condition) {
+    case ConditionModeChange:
+        m_triggerFrom = m_previousMode;
+        m_triggerValue = sample.mode;
+        break;
+    case ConditionCurrentAbove:
+        m_triggerValue = sample.current;
+        break;
+    case ConditionCellBelow:
+        m_triggerCell = 0;
+        for (int cell = 0; cell < 6; cell++) {
+            if (sample.cellVoltage[cell] != 0 && sample.cellVoltage[cell] < m_thresholdRaw) {
+                m_triggerCell = cell;
+                break;
+            }
+        }
+        m_triggerValue = sample.cellVoltage[m_triggerCell];
+        break;
+    default:
+        break;
+    }
+
+    qint64 oldest = qMax(static_cast<qint64>(0), m_count - RingSize);
+    qint64 from = sample.timestamp - m_preTriggerUSecs;
+
+    m_firstIndex = m_count - 1;
+    while (m_firstIndex > oldest && m_ring[(m_firstIndex - 1) & RingMask].timestamp >= from) {
+        m_firstIndex--;
+    }
+
+    m_state = StateTriggered;
+    if (m_postTriggerUSecs == 0) {
+        freeze();
+    }
+}
+
+void TriggerEngine::freeze()
+{
+    Sample *frozen = m_frozenStorage.data();
+    m_frozenCount = static_cast<int>(m_count - m_firstIndex);
+
+    for (int i = 0; i < m_frozenCount; i++) {
+        frozen[i] = m_ring[(m_firstIndex + i) & RingMask];
+    }
+
+    m_state = StateFrozen;
+}
+
+QString TriggerEngine::describe() const
+{
+    static const char *modeNames[] = {
+        QT_TRANSLATE_NOOP("TriggerEngine", "load test"),
+        QT_TRANSLATE_NOOP("TriggerEngine", "discharging"),
+        QT_TRANSLATE_NOOP("TriggerEngine", "charging")
+    };
+
+    auto modeName = [](int mode) {
+        return (mode >= 0 && mode < 3) ? QCoreApplication::translate("TriggerEngine", modeNames[mode]) : QString::number(mode);
+    };
+
+    switch (m_condition) {
+    case ConditionModeChange:
+        return QCoreApplication::translate("TriggerEngine", "Mode %1 to %2").arg(modeName(m_triggerFrom), modeName(m_triggerValue));
+    case ConditionCurrentAbove:
+        return QCoreApplication::translate("TriggerEngine", "Current %1 A").arg(m_triggerValue / 1000.0, 0, 'f', 3);
+    case ConditionCellBelow:
+        return QCoreApplication::translate("TriggerEngine", "Cell %1 at %2 V").arg(m_triggerCell + 1).arg(m_triggerValue / 1000.0, 0, 'f', 3);
+    default:
+        return QString();
+    }
+}
@@ -0,0 +1,197 @@
+#ifndef TRIGGERENGINE_H
+#define TRIGGERENGINE_H
+
+#include "sample.h"
+
+#include <QString>
+#include <QVector>
+
+//
+// Trigger condition as stored in the settings. The threshold and its
+// hysteresis are in A for current triggers and V for cell triggers; the
+// window and the holdoff are in seconds.
+//
+struct TriggerSettings
+{
+    int condition = 0;
+    qreal threshold = 0.0;
+    qreal hysteresis = 0.05;
+    qreal preTrigger = 10.0;
+    qreal postTrigger = 10.0;
+    qreal holdoff = 5.0;
+    int maximumCaptures = 20;
+};
+
+//
+// Full-resolution samples frozen around one trigger.
+//
+struct TriggerCapture
+{
+    QString name;
+    QString reason;
+    qint64 triggerTimestamp;        // wall clock, microseconds since epoch
+    QVector<Sample> samples;
+};
+
+//
+// Oscilloscope-style trigger over the decoded samples. Every sample goes
+// into a fixed ring of the most recent RingSize samples, independent of
+// how the session is stored or plotted. When the armed condition becomes
+// true the engine keeps collecting until the post-trigger time has passed
+// (or the ring would start overwriting the pre-trigger samples), then
+// copies the window into a second preallocated buffer and holds off until
+// takeCapture() is called from outside the read path. Conditions are
+// edge-triggered, so a level that stays past the threshold fires once;
+// it only counts as having cleared once it is back past the threshold by
+// the hysteresis, so noise around the threshold doesn't fire again. After
+// a capture the engine also holds off for the holdoff time from the end
+// of its post-trigger window, and edges in that time are ignored.
+//
+// push() is inline, works on the raw integer fields and never allocates:
+// a 32-byte store into the ring and a few compares per sample.
+//
+class TriggerEngine
+{
+public:
+    enum Condition {
+        ConditionOff = 0,
+        ConditionModeChange,
+        ConditionCurrentAbove,
+        ConditionCellBelow,
+        ConditionCount
+    };
+
+    static const int RingSize = 8192;
+
+    TriggerEngine();
+
+    void setSettings(const TriggerSettings &settings);
+    const TriggerSettings &settings() const { return m_settings; }
+
+    inline void push(const Sample &sample);
+    void reset();
+
+    bool isArmed() const { return m_state == StateArmed; }
+    bool isTriggered() const { return m_state == StateTriggered; }
+    bool hasCapture() const { return m_state == StateFrozen; }
+    TriggerCapture takeCapture();
+    quint64 triggerCount() const { return m_triggerCount; }
+
+private:
+    static const int RingMask = RingSize - 1;
+
+    enum State {
+        StateOff = 0,
+        StateArmed,
+        StateTriggered,
+        StateFrozen
+    };
+
+    inline bool isActive(const Sample &sample) const;
+    inline bool isClear(const Sample &sample) const;
+    void start(const Sample &sample);
+    void freeze();
+    QString describe() const;
+
+    TriggerSettings m_settings;
+    int m_condition = ConditionOff;
+    int m_thresholdRaw = 0;         // mA or mV
+    int m_hysteresisRaw = 0;        // mA or mV
+    qint64 m_preTriggerUSecs = 0;
+    qint64 m_postTriggerUSecs = 0;
+    qint64 m_holdoffUSecs = 0;
+
+    QVector<Sample> m_ringStorage;
+    QVector<Sample> m_frozenStorage;
+    Sample *m_ring = nullptr;
+    qint64 m_count = 0;
+    int m_state = StateOff;
+    bool m_latched = false;
+    int m_previousMode = -1;
+    qint64 m_holdoffUntil = 0;      // wall clock, microseconds since epoch
+
+    qint64 m_firstIndex = 0;
+    qint64 m_triggerTimestamp = 0;
+    qint64 m_stopTimestamp = 0;
+    int m_triggerFrom = 0;          // mode before a mode change
+    int m_triggerValue = 0;         // new mode, mA or mV at the trigger
+    int m_triggerCell = 0;
+    int m_frozenCount = 0;
+    quint64 m_triggerCount = 0;
+};
+
+inline bool TriggerEngine::isActive(const Sample &sample) const
+{
+    switch (m_condition) {
+    case ConditionModeChange:
+        return m_previousMode >= 0 && sample.mode != m_previousMode;
+    case ConditionCurrentAbove:
+        return qAbs(static_cast<int>(sample.current)) > m_thresholdRaw;
+    case ConditionCellBelow:
+        //
+        // a cell reading zero isn't fitted
+        //
+        for (int cell = 0; cell < 6; cell++) {
+            if (sample.cellVoltage[cell] != 0 && sample.cellVoltage[cell] < m_thresholdRaw) {
+                return true;
+            }
+        }
+        return false;
+    default:
+        return false;
+    }
+}
+
+//
+// Whether the condition has gone back past the threshold by the
+// hysteresis. A mode change has no level, so it clears as soon as the
+// mode holds.
+//
+inline bool TriggerEngine::isClear(const Sample &sample) const
+{
+    switch (m_condition) {
+    case ConditionCurrentAbove:
+        return qAbs(static_cast<int>(sample.current)) <= m_thresholdRaw - m_hysteresisRaw;
+    case ConditionCellBelow:
+        for (int cell = 0; cell < 6; cell++) {
+            if (sample.cellVoltage[cell] != 0 && sample.cellVoltage[cell] < m_thresholdRaw + m_hysteresisRaw) {
+                return false;
+            }
+        }
+        return true;
+    default:
+        return true;
+    }
+}
+
+inline void TriggerEngine::push(const Sample &sample)
+{
+    m_ring[m_count & RingMask] = sample;
+    m_count++;
+
+    if (m_state != StateOff) {
+        bool active = isActive(sample);
+
+        if (m_state == StateArmed) {
+            if (active && !m_latched && sample.timestamp >= m_holdoffUntil) {
+                start(sample);
+            }
+        }
+        else if (m_state == StateTriggered) {
+            if (sample.timestamp >= m_stopTimestamp || m_count - m_firstIndex >= RingSize) {
+                freeze();
+            }
+        }
+
+        if (active) {
+            m_latched = true;
+        }
+        else if (m_latched && isClear(sample)) {
+            m_latched = false;
+        }
+    }
+
+    m_previousMode = sample.mode;
+}
+
+#endif // TRIGGERENGINE_H
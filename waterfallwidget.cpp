@@ -0,0 +1,105 @@
+#include "waterfallwidget.h"
+
+#include <QPainter>
+#include <QPaintEvent>
+
+#include <math.h>
+#include <string.h>
+
+//
+// Rows are scaled against a slowly decaying peak so the colours stay
+// stable while the ripple level drifts.
+//
+static const float DynamicRange = 60.0f;
+static const float ReferenceDecay = 0.99f;
+
+WaterfallWidget::WaterfallWidget(QWidget *parent) :
+    QWidget(parent)
+{
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setMinimumSize(256, 120);
+
+    //
+    // black, blue, red, yellow, white
+    //
+    for (int i = 0; i < 256; i++) {
+        int r = qBound(0, (i - 64) * 3, 255);
+        int g = qBound(0, (i - 160) * 3, 255);
+        int b = 0;
+        if (i < 64) {
+            b = i * 4;
+        }
+        else if (i < 128) {
+            b = 255 - ((i - 64) * 4);
+        }
+        else if (i >= 192) {
+            b = qMin((i - 192) * 4, 255);
+        }
+        m_palette[i] = qRgb(r, g, b);
+    }
+
+    setBinCount(128);
+}
+
+void WaterfallWidget::setBinCount(int count)
+{
+    m_image = QImage(count, RowCount, QImage::Format_RGB32);
+    clear();
+}
+
+void WaterfallWidget::setFrequencyRange(qreal maximum)
+{
+    m_maximumFrequency = maximum;
+}
+
+void WaterfallWidget::addRow(const float *magnitudes, int count)
+{
+    int width = qMin(count, m_image.width());
+    int bytesPerLine = m_image.bytesPerLine();
+
+    memmove(m_image.scanLine(0), m_image.scanLine(1), static_cast<size_t>(bytesPerLine) * (RowCount - 1));
+
+    float peak = 0.0f;
+    for (int i = 1; i < width; i++) {
+        if (magnitudes[i] > peak) {
+            peak = magnitudes[i];
+        }
+    }
+
+    m_reference = qMax(peak, m_reference * ReferenceDecay);
+
+    QRgb *row = reinterpret_cast<QRgb *>(m_image.scanLine(RowCount - 1));
+
+    for (int i = 0; i < width; i++) {
+        int index = 0;
+        if (m_reference > 0.0f && magnitudes[i] > 0.0f) {
+            float decibels = 20.0f * log10f(magnitudes[i] / m_reference);
+            index = qBound(0, static_cast<int>((decibels + DynamicRange) * 255.0f / DynamicRange), 255);
+        }
+        row[i] = m_palette[index];
+    }
+
+    update();
+}
+
+void WaterfallWidget::clear()
+{
+    m_image.fill(m_palette[0]);
+    m_reference = 0.0f;
+    update();
+}
+
+void WaterfallWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    QPainter painter(this);
+    painter.drawImage(rect(), m_image);
+
+    painter.setPen(Qt::white);
+    painter.drawText(rect().adjusted(4, 0, -4, -2), Qt::AlignLeft | Qt::AlignBottom, tr("0 Hz"));
+    if (m_maximumFrequency > 0.0) {
+        painter.drawText(rect().adjusted(4, 0, -4, -2), Qt::AlignRight | Qt::AlignBottom,
+                         tr("%1 Hz").arg(m_maximumFrequency, 0, 'f', 1));
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef WATERFALLWIDGET_H
+#define WATERFALLWIDGET_H
+
+#include <QWidget>
+#include <QImage>
+
+//
+// Scrolling spectrogram. Each addRow() shifts the image up one line and
+// paints the new spectrum along the bottom on a log scale; the image is
+// allocated once, so adding a row never allocates.
+//
+class WaterfallWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    static const int RowCount = 240;
+
+    explicit WaterfallWidget(QWidget *parent = nullptr);
+
+    void setBinCount(int count);
+    void setFrequencyRange(qreal maximum);
+    void addRow(const float *magnitudes, int count);
+    void clear();
+
+protected:
+    void paintEvent(QPaintEvent *event);
+
+private:
+    QImage m_image;
+    QRgb m_palette[256];
+    float m_reference = 0.0f;
+    qreal m_maximumFrequency = 0.0;
+};
+
+#endif // WATERFALLWIDGET_H